@@ -0,0 +1,47 @@
+// include/arrival.h
+#ifndef ARRIVAL_H
+#define ARRIVAL_H
+
+#include <stdbool.h>
+
+#include "poste.h"
+
+// Where in the day users walk in and which services they ask for.
+// arrival_profile gives a relative weight to each hour of the shift from
+// worker_shift_open (hours past the end of the list weigh as the last one),
+// service_mix a relative weight to each service. Both are sampled through
+// alias tables, built again only when the weights change, so a draw costs
+// two array lookups whatever the number of hours or services. Left unset,
+// arrivals are flat over the shift and services equally likely, drawn as
+// before with rand().
+
+#define ALIAS_MAX_SIZE 32
+
+// Walker's alias table: index i is kept with probability prob[i],
+// otherwise alias[i] is taken instead
+struct S_alias_table {
+    int size;
+    double prob[ALIAS_MAX_SIZE];
+    int alias[ALIAS_MAX_SIZE];
+};
+
+// Builds the table of n weights (Vose). False if n is out of range or no
+// weight is positive.
+bool alias_build(struct S_alias_table *table, const double weights[], int n);
+
+// Index drawn with probability proportional to its weight, u uniform in [0, 1)
+int alias_sample(const struct S_alias_table *table, double u);
+
+// Service of a request, by service_mix
+int arrival_service(void);
+
+// Walk-in minute in (shift_start, shift_start + window], by arrival_profile
+int arrival_walk_in(int shift_start, int window);
+
+// Share of the requests going to each service
+void arrival_service_shares(const struct poste_config *config, double shares[NUM_SERVICE_TYPES]);
+
+// Share of the arrivals in each hour of the shift. Returns the hours.
+int arrival_hour_shares(const struct poste_config *config, double shares[MAX_PROFILE_HOURS]);
+
+#endif
@@ -0,0 +1,64 @@
+// include/branch.h
+#ifndef BRANCH_H
+#define BRANCH_H
+
+#include <stddef.h>
+
+#include "poste.h"
+
+// A run can hold several branches (offices) under one director and one clock.
+// Each branch has its own stats and stations segments, with their own locks
+// and events, its own ticket queue and its own erogatore, so the branches only
+// share the clock. Branch 0 keeps the usual names: the tools that know a single
+// office (poste_top, poste_loadgen, new_users) see branch 0.
+//
+// Branches sit evenly spaced on a line [0, 1). Operators are dealt to the
+// branches in turn, num_worker_seats is per branch. Every user has a home on
+// the line and waits for the day on the events of the nearest branch; when it
+// walks in it picks the branch to visit by branch_routing. Branches are grouped
+// in num_regions regions of neighbours for the stats.
+
+typedef enum BRANCH_POLICY {
+    BRANCH_ROUTING_DISTANCE, // Always the nearest branch
+    BRANCH_ROUTING_LOAD      // Nearest once the queues are counted, see branch_route
+} BRANCH_POLICY;
+
+extern const char *branch_routing_names[];
+
+// Segment name of a branch: "/poste_stats" -> "/poste_stats_b2", unchanged for branch 0
+void branch_shm_name(const char *name, int branch, char *out, size_t size);
+
+// proj_id of the ticket queue of a branch, for poste_key(KEY_TICKET_MSG, ...)
+int branch_ticket_proj_id(int branch);
+
+// Where the branch sits on the line
+double branch_position(int branch, int num_branches);
+
+// Home of the index-th user started: a low-discrepancy sequence, so users
+// cover the line evenly whatever their number
+double branch_user_home(int index);
+
+// Branch closest to a home
+int branch_nearest(double home, int num_branches);
+
+// Region of a branch, regions hold neighbouring branches
+int branch_region(int branch, int num_branches, int num_regions);
+
+// Operators started on a branch, and users homed there, out of the totals
+int branch_operators(int branch, int num_operators, int num_branches);
+int branch_users(int branch, int num_users, int num_branches);
+
+// Live load of a branch: users waiting for a seat per staffed seat, counting
+// the one about to walk in. Negative if no seat is staffed.
+double branch_load(struct S_poste_stats *stats, struct S_poste_stations *stations);
+
+// Branch to visit from home. By load, a branch costs its distance in branch
+// spacings plus its load: one more user waiting per staffed seat is worth
+// walking to the next branch. Branches without staffed seats are skipped.
+int branch_route(BRANCH_POLICY routing, double home, int num_branches, const double load[]);
+
+// Adds the counters of a branch to a total over several branches: services,
+// days, utilization, wait histogram, queues and messages
+void branch_stats_add(struct S_poste_stats *total, const struct S_poste_stats *branch);
+
+#endif
@@ -0,0 +1,50 @@
+// include/checkpoint.h
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "poste.h"
+
+// Simulation state saved by the director at a day boundary, when the poste is
+// closed and every actor waits for the next day: the shared segments, the
+// config and the director PRNG seed. Operators publish their own state
+// (service, pauses taken) in operator_states of /poste_stations, so it comes
+// with the stations image. Users carry nothing from one day to the next.
+
+#define CHECKPOINT_MAGIC   "POSTECKP"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_FILE_FORMAT "%scheckpoint_day_%d.bin" // Output directory, day
+
+struct S_checkpoint {
+    int day;            // Days completed, the run resumes at the start of day + 1
+    unsigned int seed;  // Director PRNG, reseeded with seed + day at each new day
+    struct poste_config config;
+    struct S_poste_stats stats;
+    struct S_poste_stations stations;
+};
+
+// Copies the live segments, taking stats_lock and stations_lock
+void checkpoint_capture(struct S_checkpoint *ck,
+                        struct S_poste_stats *stats,
+                        struct S_poste_stations *stations);
+
+// Writes the checkpoint followed by extra_size bytes of director state.
+// The file is written next to path and renamed, a crash never leaves half a checkpoint.
+bool checkpoint_write(const char *path, const struct S_checkpoint *ck,
+                      const void *extra, size_t extra_size);
+
+// Reads a checkpoint written with the same layout and extra_size. false if the
+// file is missing, truncated, or from another version or build.
+bool checkpoint_read(const char *path, struct S_checkpoint *ck,
+                     void *extra, size_t extra_size);
+
+// Loads the images into freshly created segments, before the semaphores are
+// initialized. Seats, skills and operator states are cleared: the respawned
+// operators publish them again.
+void checkpoint_restore(const struct S_checkpoint *ck,
+                        struct S_poste_stats *stats,
+                        struct S_poste_stations *stations);
+
+#endif
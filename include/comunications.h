@@ -1,9 +1,13 @@
 #ifndef COMUNICATIONS_H
 #define COMUNICATIONS_H
 
+#include <stddef.h>
 #include <sys/types.h>
 #include <msg_queue.h>
 
+#include "poste.h"
+#include "ramp.h"
+
 #define KEY_TICKET_MSG "./msg/ticket"
 #define KEY_NEW_USERS "./msg/new_users"
 #define PROJ_ID  'P'
@@ -13,11 +17,13 @@ enum MESSAGE_TYPES {
     MSG_TYPE_TICKET_REQUEST = 1,
     MSG_TYPE_TICKET_RESPONSE,
     MSG_TYPE_SERVICE_REQUEST,
-    MSG_TYPE_SERVICE_DONE
+    MSG_TYPE_SERVICE_DONE,
+    MSG_TYPE_TICKET_BUNDLE_REQUEST // The generator takes every type up to this one
 };
 
 #define MSG_TYPE_TICKET_REQUEST_MULT * 10000
 #define MSG_TYPE_ADD_USERS_REQUEST 10
+#define MSG_TYPE_RAMP_REQUEST 11 // poste_ramp, on the new_users queue
 
 struct S_ticket_request {
     pid_t sender_pid;
@@ -29,6 +35,23 @@ struct S_ticket_response {
     int ticket_number;
 };
 
+// Every ticket of a user's day in one round trip: tickets come back in the
+// order of service_ids. Only the first count entries go on the queue.
+struct S_ticket_bundle_request {
+    pid_t sender_pid;
+    int count;
+    int service_ids[MAX_N_REQUESTS_COMPILE];
+};
+
+struct S_ticket_bundle_response {
+    pid_t generator_pid;
+    int count; // 0 if the bundle was malformed
+    int ticket_numbers[MAX_N_REQUESTS_COMPILE];
+};
+
+// Bytes sent for a bundle request or response of count entries
+#define TICKET_BUNDLE_SIZE(count) (offsetof(struct S_ticket_bundle_request, service_ids) + (size_t)(count) * sizeof(int))
+
 struct S_service_request {
     pid_t sender_pid;
     int ticket_number;
@@ -50,4 +73,22 @@ struct S_new_users_done {
     int status; // 0 -> error - 1 -> success
 };
 
+enum RAMP_REQUEST_KIND {
+    RAMP_SUBMIT,  // Append the steps to the schedule
+    RAMP_QUERY    // Only the status of the schedule
+};
+
+struct S_ramp_request {
+    pid_t sender_pid;
+    int kind;
+    int count;
+    struct S_ramp_step steps[RAMP_MAX_STEPS];
+};
+
+// Answer to both kinds: the whole schedule
+struct S_ramp_reply {
+    int first;  // Index of the first step submitted, -1 if refused or a query
+    struct S_ramp_schedule schedule;
+};
+
 #endif
@@ -12,11 +12,35 @@
 #define MAX_N_REQUESTS 10 // Maximum number of requests a user can make in a day
 #define NOF_PAUSE 3 // Number of times the operator can finish the day early
 
+#define AUTOSCALE 0 // Director adds/retires operators during the day (0 = off)
+#define AUTOSCALE_MIN_OPERATORS 1 // Never retire below this number of operators
+#define AUTOSCALE_MAX_OPERATORS 30 // Never spawn above this number of operators
+#define AUTOSCALE_COOLDOWN 30 // Minutes between two scaling decisions
+#define AUTOSCALE_QUEUE_HIGH 2 // Waiting users per staffed seat that trigger a new operator
+
+#define SEAT_ALLOCATION 0 // Seat policy of start_new_day: 0 = random, 1 = demand (see seat_policy.h)
+#define TIME_WARP 0 // Director jumps the clock over minutes where every actor is idle (see sim_clock.h)
+#define FAST_FORWARD_CLOSED 0 // Same as TIME_WARP, only while the poste is closed
+#define CHECKPOINT 0 // Director writes a checkpoint at each day boundary (see checkpoint.h)
+#define SAMPLE_INTERVAL 1 // Minutes between two samples of the queues, 0 = off (see sampler.h)
+#define USAGE_INTERVAL 60 // Minutes between two /proc samples of the children, 0 = off (see proc_usage.h)
+#define NUM_BRANCHES 1 // Offices simulated by one director (see branch.h)
+#define NUM_REGIONS 1 // Regions the branches are grouped in for the stats
+#define BRANCH_ROUTING 0 // Branch a user visits: 0 = nearest, 1 = nearest once queues are counted
+#define TICKET_BUNDLE 1 // Users take all the tickets of their day in one request (see comunications.h)
+#define RAMP_SPAWN_RATE 20 // Users a ramp step spawns a minute when not spread over a window (see ramp.h)
+
 #define MAX_N_REQUESTS_COMPILE 50 // Maximum number of requests a user can make in a day for compile time
 #define MAX_WORKER_SEATS 30 // Maximum number of worker seats
+#define MAX_OPERATOR_STATES 256 // Operators whose state is kept for checkpoints
+#define MAX_BRANCHES 16 // Maximum number of branches in a run
+#define MAX_PROFILE_HOURS 24 // Maximum number of hours in arrival_profile
+#define TRACE_PATH_LENGTH 256 // Longest trace_file path
 
 #define CSV_FILE_PATH "./tmp/"
 
+#define NUM_SERVICE_TYPES 6  // From Table 1 in specs
+
 struct poste_config {
     int num_operators; // Number of operators in the simulation
     int num_users; // Number of users in the simulation
@@ -30,10 +54,29 @@ struct poste_config {
     int explode_max; // Maximum number of users that can still waiting at the end of the day, otherwise the process explodes
     int max_n_requests; // Maximum number of requests a user can make in a day
     int nof_pause; // Number of times the operator can finish the day early
+    int autoscale; // 1 if the director scales operators on live queue pressure
+    int autoscale_min_operators; // Lower bound on operators when autoscaling
+    int autoscale_max_operators; // Upper bound on operators when autoscaling
+    int autoscale_cooldown; // Minutes between two scaling decisions
+    int autoscale_queue_high; // Waiting users per staffed seat that trigger a scale up
+    int seat_policy; // How seats get their service each day, a SEAT_POLICY
+    int time_warp; // 1 if the clock jumps to the next wakeup when every actor is idle
+    int fast_forward_closed; // 1 if the clock jumps only outside the worker shift
+    int checkpoint; // 1 if the director writes a checkpoint at each day boundary
+    int sample_interval; // Simulated minutes between two samples of the queues, 0 if off
+    int usage_interval; // Simulated minutes between two /proc samples of the children, 0 if off
+    int num_branches; // Offices in the run, each with its own seats, stations and ticket queue
+    int num_regions; // Groups of neighbouring branches in the stats
+    int branch_routing; // How users pick the branch to visit, a BRANCH_POLICY
+    int ticket_bundle; // 1 if users take every ticket of the day in one round trip
+    int ramp_spawn_rate; // Users spawned a minute by a ramp step without a window
+    int arrival_profile[MAX_PROFILE_HOURS]; // Relative arrivals from worker_shift_open, hour by hour
+    int num_profile_hours; // Hours given in arrival_profile, 0 if arrivals are flat
+    int service_mix[NUM_SERVICE_TYPES]; // Relative popularity of the services, all 0 if equal
+    char trace_file[TRACE_PATH_LENGTH]; // Recorded arrivals replayed by the users, "" if none (see trace.h)
+    int trace_users; // Users the trace is dealt to, set by the director
 };
 
-#define NUM_SERVICE_TYPES 6  // From Table 1 in specs
-
 extern struct poste_config g_config;
 extern char *services[NUM_SERVICE_TYPES]; // List of available services
 extern int services_duration[NUM_SERVICE_TYPES];// List of durations (Minutes) referenced to services
@@ -0,0 +1,53 @@
+// include/config_shm.h
+#ifndef CONFIG_SHM_H
+#define CONFIG_SHM_H
+
+#include <stdbool.h>
+
+#include "poste.h"
+
+// Parsed configuration published by the director. Children map it read-only
+// instead of re-parsing the file, so they all see what the director loaded.
+// version is a seqlock counter: odd while the director rewrites the segment,
+// bumped by 2 for every published change (new users, autoscaling, SIGHUP reload).
+
+#define SHM_CONFIG_NAME "/poste_config"
+#define CONFIG_SHM_RESERVED_PARAMS 8 // Free slots per service for future parameters
+
+struct S_service_params {
+    int duration;                                // Minutes, copied to services_duration
+    int reserved[CONFIG_SHM_RESERVED_PARAMS];    // 0 until used
+};
+
+struct S_config_segment {
+    CACHE_ALIGNED unsigned int version;  // Polled by every child, alone on its line
+
+    CACHE_ALIGNED struct poste_config config;
+    struct S_service_params services[NUM_SERVICE_TYPES];
+};
+
+#define SHM_CONFIG_SIZE sizeof(struct S_config_segment)
+
+// --- Director side ---
+
+// Creates the segment, to be removed with cleanup_shared_memory
+struct S_config_segment *config_shm_create(int *open_shm, int *open_shm_index);
+
+// Publishes g_config and services_duration if they differ from the segment.
+// Returns true if a new version was published.
+bool config_shm_publish(void);
+
+// --- Children side ---
+
+// Maps the segment and loads it into g_config and services_duration.
+// false if the director did not create it, the caller falls back to load_config.
+bool config_shm_attach(void);
+
+// Reloads g_config if the director published a new version since the last load.
+// Returns true if it changed.
+bool config_shm_refresh(void);
+
+// Version last loaded (or published), 0 if none
+unsigned int config_shm_version(void);
+
+#endif
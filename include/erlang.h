@@ -0,0 +1,46 @@
+// include/erlang.h
+#ifndef ERLANG_H
+#define ERLANG_H
+
+#include <stdbool.h>
+
+#include "poste.h"
+
+// Analytic capacity model used by poste_plan. Each service is an M/M/c queue:
+// requests arrive at a constant rate over the open hours, `seats` staffed
+// seats serve them in services_duration minutes on average. Erlang C gives
+// the probability that a request has to wait and the mean wait in queue.
+// Service times are really uniform in [0.5, 1.5] x duration (see
+// process_service), so the M/M/c wait is also scaled by (1 + cs^2) / 2,
+// Allen-Cunneen, with cs^2 = 1/12 the squared coefficient of variation.
+
+#define ERLANG_SERVICE_CV2 (1.0 / 12.0)
+
+struct S_queue_prediction {
+    int seats;
+    double arrival_rate;   // Requests per open minute
+    double offered_load;   // Erlangs: arrival_rate * mean service minutes
+    double utilization;    // Busy share of each seat, offered_load / seats
+    double p_wait;         // Erlang C, 1 if the queue is unstable
+    double mean_wait;      // Minutes in queue, M/M/c
+    double mean_wait_mg;   // Same, corrected for the uniform service times
+    double mean_queue;     // Users waiting, arrival_rate * mean_wait_mg
+    bool stable;           // offered_load < seats
+};
+
+// Probability of waiting with servers seats and offered_load Erlangs
+double erlang_c(int servers, double offered_load);
+
+// Prediction for one service
+void erlang_predict(double arrival_rate, double service_minutes, int seats,
+                    struct S_queue_prediction *out);
+
+// Expected requests per day of each service, from the user behaviour of
+// utente.c: a user goes with probability (p_serv_max - p_serv_min) / p_serv_max,
+// asks for 1..max_n_requests services, each drawn by service_mix (see arrival.h).
+void erlang_daily_requests(const struct poste_config *config, double requests[NUM_SERVICE_TYPES]);
+
+// Minutes the poste is open each day
+int erlang_open_minutes(const struct poste_config *config);
+
+#endif
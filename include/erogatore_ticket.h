@@ -1,10 +1,13 @@
 #ifndef EROGATORE_TICKET_H
 #define EROGATORE_TICKET_H
 
+#include <stdbool.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <semaphore.h>
 
+#include "msg_queue.h"
+
 #define SERVICE_TIME_SPREAD 50
 #define QUEUE_SIZE 1000
 
@@ -33,6 +36,10 @@ struct S_ticket_queue {
     sem_t ticket_lock;  // Semaphore index for atomic updates
 };
 
+// Takes the next ticket request off the queue, a single one or a bundle, and
+// answers it with the next ticket numbers. False if the queue is gone.
+bool dispense_ticket(mq_id qid, int *ticket_counter);
+
 #define SHM_TICKET_NAME   "/poste_tickets"
 #define SHM_TICKETS_SIZE   sizeof(struct S_ticket_queue)
 
@@ -0,0 +1,48 @@
+// include/frame.h
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Length-prefixed frames of the socket transport (see msg_queue.h and
+// mq_broker.h). A frame is a 32-bit length followed by that many bytes of
+// records, each a 16-bit kind, a 16-bit size and size bytes of payload, in
+// host byte order since both ends run on the same host. A frame carries as
+// many records as fit, so a process sends its held back stats updates and
+// its next queue request with a single write.
+
+#define FRAME_MAX_SIZE     65536 // Bytes of records in one frame
+#define FRAME_HEADER_SIZE  sizeof(uint32_t)
+#define RECORD_HEADER_SIZE (2 * sizeof(uint16_t))
+
+struct S_frame {
+    uint32_t length; // Bytes of records used in data
+    unsigned char data[FRAME_MAX_SIZE];
+};
+
+// Empties the frame
+void frame_reset(struct S_frame *frame);
+
+// Appends a record. False if it does not fit, the frame is left as it was.
+bool frame_add(struct S_frame *frame, int kind, const void *payload, size_t size);
+
+// Walks the records: *cursor starts at 0. False after the last record.
+// payload points inside the frame.
+bool frame_next(const struct S_frame *frame, size_t *cursor, int *kind, const void **payload, size_t *size);
+
+// Writes the whole frame, going on after signals. Returns 0, or -1 with errno.
+int frame_write(int fd, const struct S_frame *frame);
+
+// Reads one frame. Returns 1, 0 if the peer closed the socket, -1 with errno.
+// A signal before the first byte returns -1 with EINTR, once a frame has
+// started it is read to the end.
+int frame_read(int fd, struct S_frame *frame);
+
+// Takes one frame from the front of a buffer of len bytes received so far.
+// Returns the bytes it used, 0 if the frame is not complete yet, -1 if the
+// length is out of range.
+long frame_parse(const unsigned char *buffer, size_t len, struct S_frame *frame);
+
+#endif
@@ -0,0 +1,44 @@
+// include/instance.h
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+
+// Several simulations can run side by side on one machine, each under its own
+// instance name taken from the POSTE_INSTANCE environment variable. Children
+// inherit it from the director. An instance gets its own shared segments
+// (/poste_stats_<instance>, ...), its own message queue keys and its own
+// output directory (./tmp/<instance>/). Unset, names are the usual ones.
+
+#define POSTE_INSTANCE_ENV  "POSTE_INSTANCE"
+#define MAX_INSTANCE_LENGTH 48
+
+// Instance of this process, "" if POSTE_INSTANCE is unset.
+// Exits if it is not made of letters, digits, '_' and '-'.
+const char *poste_instance(void);
+
+// Letters, digits, '_' and '-', at most MAX_INSTANCE_LENGTH
+bool instance_valid(const char *instance);
+
+// Segment name of an instance: "/poste_stats" -> "/poste_stats_<instance>"
+void instance_shm_name(const char *instance, const char *name, char *out, size_t size);
+
+// Output directory of an instance, with a trailing '/', created if missing
+void instance_output_dir(const char *instance, char *out, size_t size);
+
+// System V key of an instance: ftok on path, or on a key file in the
+// instance directory named after path
+key_t instance_key(const char *instance, const char *path, int proj_id);
+
+// Same for the instance of this process
+key_t poste_key(const char *path, int proj_id);
+
+// Opens <output dir><name>.csv for writing, or <name>_N.csv with the first
+// free N so earlier runs are kept. filename receives the path.
+FILE *open_csv(const char *name, char *filename, size_t size);
+
+#endif
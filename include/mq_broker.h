@@ -0,0 +1,84 @@
+// include/mq_broker.h
+#ifndef MQ_BROKER_H
+#define MQ_BROKER_H
+
+#include <signal.h>
+#include <stdint.h>
+
+// Broker of the socket transport. With POSTE_MQ_SOCKET set (see msg_queue.h)
+// the msg_queue.h calls and the stats updates (see stats_update) of a process
+// travel as records in frames (see frame.h) over a Unix domain socket to
+// poste_broker, which keeps the queues in its own memory and applies the
+// updates to the stats segments. The processes of a run can then sit in
+// separate containers that share the socket and /dev/shm, without sharing
+// the System V IPC namespace.
+//
+// Sends and stats updates need no answer: the client holds them in its
+// outgoing frame and writes them all at once before it blocks, so a user
+// that sends a request and waits for the answer costs one write and one
+// read. Open, close and receive are answered with a REPLY record.
+//
+// Queues are bounded as msgsnd bounds them: a send that does not fit in the
+// bytes or messages of kernel.msgmnb waits in the broker, which stops reading
+// the client until a receive makes room, so the client blocks in its next
+// write. A send to a queue that is gone fails: the broker counts it and tells
+// the client with its next reply (see mq_failed_sends).
+
+#define MQ_SOCKET_ENV "POSTE_MQ_SOCKET"
+
+typedef enum MQ_RECORD {
+    MQ_RECORD_OPEN = 1, // struct S_mq_open           -> REPLY with the queue id
+    MQ_RECORD_SEND,     // struct S_mq_send + message
+    MQ_RECORD_RECEIVE,  // struct S_mq_receive        -> REPLY with the message
+    MQ_RECORD_CANCEL,   // Drop the parked receive    -> REPLY with EINTR
+    MQ_RECORD_CLOSE,    // struct S_mq_close          -> REPLY
+    MQ_RECORD_STATS,    // struct S_stats_update, see stats.h
+    MQ_RECORD_REPLY     // struct S_mq_reply + message
+} MQ_RECORD;
+
+struct S_mq_open {
+    int32_t key;
+    int32_t flags; // IPC_CREAT, IPC_EXCL
+};
+
+struct S_mq_send {
+    int32_t qid;
+    int64_t mtype;
+};
+
+struct S_mq_receive {
+    int32_t qid;
+    int64_t mtype;  // As msgrcv: 0 any, > 0 that type, < 0 lowest type up to -mtype
+    int32_t length; // Longest message accepted, E2BIG past it
+    int32_t flags;  // IPC_NOWAIT
+};
+
+struct S_mq_close {
+    int32_t qid;
+};
+
+struct S_mq_reply {
+    int32_t result; // Queue id, message length or 0; -1 on error
+    int32_t error;  // errno when result is -1
+    int64_t mtype;  // Of the message received
+    int32_t failed_sends; // Sends of the client refused since its last reply
+    int32_t send_error;   // errno of the last of them
+};
+
+// What the broker has done since it started
+struct S_mq_broker_counters {
+    unsigned long long clients;
+    unsigned long long frames;
+    unsigned long long records;
+    unsigned long long messages;
+    unsigned long long failed_sends;  // To a queue that was gone
+    unsigned long long waits;         // Sends that waited for room in a full queue
+    unsigned long long stats_updates;
+};
+
+// Serves the socket at path until *stop is set (by a signal handler).
+// counters, if not NULL, is kept up to date. Returns 0, or -1 with errno
+// if the socket cannot be set up.
+int mq_broker_run(const char *path, volatile sig_atomic_t *stop, struct S_mq_broker_counters *counters);
+
+#endif
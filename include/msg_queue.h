@@ -6,11 +6,35 @@
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/msg.h>
-#include <stddef.h> 
+#include <stddef.h>
+#include <stdbool.h>
+
+// Longest message a queue carries
+#define MQ_MAX_MESSAGE 4096
 
 // Opaque handle
 typedef int mq_id;
 
+// Queues are System V message queues, unless the POSTE_MQ_SOCKET environment
+// variable names the socket of a poste_broker (see mq_broker.h): then every
+// call goes to the broker. Sends are held in a frame and written together
+// with the next call that waits for an answer, or by mq_flush.
+
+// Uses the broker at path from now on, or the native queues if NULL.
+// Overrides POSTE_MQ_SOCKET for this process.
+void mq_transport(const char *path);
+
+// True if the calls go to a broker
+bool mq_is_remote(void);
+
+// Adds a record for the broker to the outgoing frame (see mq_broker.h).
+// Returns false if the broker cannot be reached.
+bool mq_post(int kind, const void *data, size_t size);
+
+// Writes what is held in the outgoing frame. Called before a process blocks,
+// so the messages it sent reach the broker before it waits for an answer.
+void mq_flush(void);
+
 // Initialize or connect to a message queue.
 // Returns queue ID on success, or -1 on error.
 mq_id mq_open(key_t key, int flags, int perms);
@@ -24,6 +48,15 @@ int mq_send(mq_id msqid, long mtype, const void *data, size_t length);
 // Returns -1 on error.
 ssize_t mq_receive(mq_id msqid, long mtype, void *buffer, size_t length, int flags);
 
+// Count every message this process sends from now on into `counter`, a
+// counter in shared memory summed over all processes (NULL stops counting).
+void mq_count_sends(unsigned long long *counter);
+
+// Sends of this process the broker refused so far, told by its replies, with
+// the errno of the last one in *error if not NULL. A remote mq_send returns
+// before the broker sees the message; native sends fail at once instead.
+unsigned long long mq_failed_sends(int *error);
+
 // Remove (destroy) the message queue identified by `msqid`.
 // Returns 0 on success, or -1 on error.
 int mq_close(mq_id msqid);
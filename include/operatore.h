@@ -0,0 +1,22 @@
+// include/operatore.h
+#ifndef OPERATORE_H
+#define OPERATORE_H
+
+#include "poste.h"
+#include "msg_queue.h"
+
+// Hot paths of the operator process, exposed for tests and benchmarks
+void update_requests_stats(struct S_poste_stats *shared_stats, int user_service);
+void update_pause_stats(struct S_poste_stats *shared_stats);
+void update_busy_stats(struct S_poste_stats *shared_stats, int seat, int user_service, double minutes);
+void update_seated_stats(struct S_poste_stats *shared_stats, int seat, int user_service, double minutes);
+int find_seat(struct S_poste_stations *shared_stations, int user_service);
+void take_seat(struct S_poste_stations *shared_stations, int i);
+void release_seat(struct S_poste_stations *shared_stations, int seat_index);
+void leave_seat(struct S_poste_stats *shared_stats, struct S_poste_stations *shared_stations, mq_id qid,
+                int seat, int user_service);
+void update_operator_skills(struct S_poste_stations *shared_stations, int user_service, int delta);
+void publish_operator_state(struct S_poste_stations *shared_stations, int user_service, int pauses_done);
+void clear_operator_state(struct S_poste_stations *shared_stations);
+
+#endif
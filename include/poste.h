@@ -6,12 +6,25 @@
 #include <semaphore.h>
 
 #include <config.h>
+#include "shm_mutex.h"
 
 #define MAX_PATH_LENGTH 256
+#define WAIT_HISTOGRAM_BINS 721 // One per minute waited for a seat, the last one for 720 and more
+
+// Layout of the shared segments: every process maps them on its own core, so
+// fields written often are kept away from fields read often. Building with
+// -DPOSTE_PACKED_LAYOUT drops the alignment, to compare against the packed layout.
+#define CACHE_LINE_SIZE 64
+#ifdef POSTE_PACKED_LAYOUT
+#define CACHE_ALIGNED
+#else
+#define CACHE_ALIGNED __attribute__((aligned(CACHE_LINE_SIZE)))
+#endif
 
 typedef enum SEAT_STATUS {
     FREE,
-    OCCUPIED
+    OCCUPIED,
+    CLOSING   // Operator side only: leaving, no user may take the seat
 } SEAT_STATUS;
 
 struct S_service_stats {
@@ -23,52 +36,134 @@ struct S_service_stats {
     int late_users;              // To count late users
 };
 
+// Time a worker seat had an operator seated and serving, in simulated minutes
+struct S_seat_utilization {
+    double seated_minutes;  // From take_seat to release_seat
+    double busy_minutes;    // Inside process_service
+    int services;
+};
+
+// Same for one operator, slots are taken by pid and kept for the whole table
+struct S_operator_utilization {
+    pid_t pid;              // 0 if the slot is free
+    int service;
+    double seated_minutes;
+    double busy_minutes;
+    int services;
+};
+
+// Fixed arrays, so they can live in the shared segment (see utilization.h)
+struct S_utilization {
+    struct S_seat_utilization seats[MAX_WORKER_SEATS];
+    struct S_operator_utilization operators[MAX_OPERATOR_STATES];
+    int untracked_operators; // Operators that found the table full
+};
+
 struct S_daily_stats {
     struct S_service_stats global;
     struct S_service_stats services[NUM_SERVICE_TYPES];
     int active_operators;
     int total_pauses;
     int late_users;
-    int *operator_counter_ratios;  // Per counter
+    struct S_utilization usage;  // Per seat and per operator, reset each day
 };
 
 struct S_poste_stats {
+    // Simulated clock, read in a loop by every user and operator and written
+    // once a minute by the director: alone on its line so counter updates
+    // do not invalidate it
+    CACHE_ALIGNED int current_minute;
+    int current_day;
+
+    // Messages sent by every process of the run, see mq_count_sends
+    CACHE_ALIGNED unsigned long long messages_sent;
+
+    // Write-heavy counters, updated by every service completion under stats_lock
+    CACHE_ALIGNED unsigned int stats_seq; // Odd while a writer is updating the counters (see stats.h)
+
     // Cumulative simulation statistics
     struct S_service_stats simulation_global;
     struct S_service_stats simulation_services[NUM_SERVICE_TYPES];
     
     // Daily statistics (reset each day)
     struct S_daily_stats today;
+
+    // Seat and operator utilization over the whole run
+    struct S_utilization simulation_usage;
+
+    // Requests by minutes waited from ticket to seat, over the whole run
+    int wait_histogram[WAIT_HISTOGRAM_BINS];
     
     // Simulation-wide counters
     int total_active_operators;
     int total_simulation_pauses;
+    int waiting_users[NUM_SERVICE_TYPES]; // Users holding a ticket and waiting for a seat, right now
+    int trace_delayed;       // Replayed arrivals a user reached late, busy with an earlier one (see trace.h)
+    int trace_delay_minutes; // Minutes they were late by, in total
+    
+    // Synchronization, each semaphore on its own line
+    CACHE_ALIGNED struct S_shm_mutex stats_lock;  // Robust mutex for atomic updates
+    CACHE_ALIGNED sem_t open_poste_event; // Semaphore that tells processes when the poste opens
+    CACHE_ALIGNED sem_t close_poste_event; // Semaphore that tells processes when the poste closes
+    CACHE_ALIGNED sem_t day_update_event; // Semaphore that tells processes when a new day starts
+
+    // Cold, written once at startup
+    CACHE_ALIGNED char configuration_file[MAX_PATH_LENGTH]; // Path to the configuration file
+    int branch; // Branch of the segment, see branch.h
+};
+
+// Consistent copy of the counters of S_poste_stats, taken without locking
+struct S_stats_snapshot {
+    struct S_service_stats simulation_global;
+    struct S_service_stats simulation_services[NUM_SERVICE_TYPES];
+    struct S_daily_stats today;
+    int total_active_operators;
+    int total_simulation_pauses;
     int current_day;
     int current_minute;
-    
-    // Synchronization
-    sem_t stats_lock;  // Semaphore index for atomic updates
-    sem_t open_poste_event; // Semaphore that tells processes when the poste opens
-    sem_t close_poste_event; // Semaphore that tells processes when the poste closes
-    sem_t day_update_event; // Semaphore that tells processes when a new day starts
-    char configuration_file[MAX_PATH_LENGTH]; // Path to the configuration file
+    int waiting_users[NUM_SERVICE_TYPES];
 };
 
+// One seat per cache line: taking or releasing a seat does not invalidate
+// the neighbouring seats that other processes are scanning
 struct S_worker_seat {
     pid_t operator_process;
     SEAT_STATUS operator_status;
     SEAT_STATUS user_status;
+    pid_t user_process; // User seated, 0 if the user side is free
     int service_id; //Id of the service, inside the service table
+} CACHE_ALIGNED;
+
+// What an operator carries from one day to the next, published for checkpoints
+struct S_operator_state {
+    pid_t pid;       // 0 if the slot is free
+    int service;
+    int pauses_done;
+};
+
+// Processes blocked until another one hands them something (a seat), first
+// come first served. Linked through their clock slots (see sim_clock.h) and
+// guarded by the lock of the structure holding the queue. Zeroed is empty.
+struct S_actor_queue {
+    int first;   // Clock slot index + 1, 0 if empty
+    int last;
+    int length;
 };
 
 struct S_poste_stations {
     //Array of worker seats
     struct S_worker_seat NOF_WORKER_SEATS[MAX_WORKER_SEATS]; // 30 maximum seats
+    CACHE_ALIGNED int operator_skills[NUM_SERVICE_TYPES]; // Operators alive that know each service
+    CACHE_ALIGNED struct S_operator_state operator_states[MAX_OPERATOR_STATES]; // Under stations_lock
+
+    // Synchronization, each semaphore on its own line
+    CACHE_ALIGNED struct S_shm_mutex stations_lock;  // Robust mutex for atomic updates
 
-    // Synchronization
-    sem_t stations_lock;  // Semaphore index for atomic updates
-    sem_t stations_event; // Semaphore that tells workers when a station opens up
-    sem_t stations_freed_event; // Semaphore that tells users when a station is freed
+    // Waiting for a seat of each service, under stations_lock. A freed seat is
+    // handed to the first operator waiting for its service, the user side of a
+    // staffed seat to the first user waiting: one wakeup per seat.
+    CACHE_ALIGNED struct S_actor_queue operator_queue[NUM_SERVICE_TYPES];
+    CACHE_ALIGNED struct S_actor_queue user_queue[NUM_SERVICE_TYPES];
 };
 
 #define SHM_STATS_NAME   "/poste_stats"
@@ -0,0 +1,50 @@
+// include/proc_usage.h
+#ifndef PROC_USAGE_H
+#define PROC_USAGE_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+// What the processes of one role (erogatore, operatore, utente) cost. Totals
+// come from the rusage of each child when it is reaped with wait4, so they
+// cover whole lifetimes. Peaks come from /proc/<pid>/stat samples of the live
+// children, taken by the director every usage_interval simulated minutes:
+// wait4 only knows the peak of each process, not of the role as a whole.
+
+struct S_role_usage {
+    int processes;                  // Children reaped
+    double user_seconds;
+    double sys_seconds;
+    long max_rss_kb;                // Largest peak RSS of a single process
+    long long rss_kb_total;         // Peak RSS summed over the processes, for the average
+    long long voluntary_switches;   // Blocked: messages, semaphores, sleeps
+    long long involuntary_switches; // Preempted
+    int samples;
+    int peak_alive;                 // Most processes of the role alive at one sample
+    long long peak_rss_kb;          // Largest resident total of the role at one sample
+    double peak_cpu_percent;        // Largest CPU use of the role between two samples, 100 = one core
+};
+
+// Live figures of a process
+struct S_proc_sample {
+    double cpu_seconds; // User + system so far
+    long rss_kb;
+};
+
+// Adds a reaped process
+void role_usage_add_rusage(struct S_role_usage *usage, const struct rusage *ru);
+
+// Reads /proc/<pid>/stat, false if the process is gone
+bool proc_sample_read(pid_t pid, struct S_proc_sample *out);
+
+// Adds one sample of the role: processes alive, their resident total and
+// their CPU use since the previous sample
+void role_usage_add_sample(struct S_role_usage *usage, int alive, long long rss_kb, double cpu_percent);
+
+// CPU milliseconds and peak RSS of the average reaped process, 0 if none
+double role_usage_cpu_ms_per_process(const struct S_role_usage *usage);
+double role_usage_avg_rss_kb(const struct S_role_usage *usage);
+
+#endif
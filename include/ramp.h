@@ -0,0 +1,94 @@
+// include/ramp.h
+#ifndef RAMP_H
+#define RAMP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "poste.h"
+
+// Load ramps: a schedule of steps adding or retiring users while the
+// simulation runs, submitted to the director by poste_ramp. A step reads
+//
+//     day HH:MM +N [over M]     or     day HH:MM -N
+//
+// with day the day of the run (from 1). Users added are spawned from the
+// minute of the step, spread evenly over M minutes, or ramp_spawn_rate a
+// minute without it, and join the day under way like users added with
+// new_users: counted in its events from then on, walking in after the
+// minute they were spawned, or at the next day once the poste closed. Users
+// retired, the most recently added first, finish their day and leave when
+// the next one starts. The director only answers requests: poste_ramp asks
+// for the status of its steps.
+
+#define RAMP_MAX_STEPS 32
+#define RAMP_MAX_USERS 100000     // Users a single step may add or retire
+#define RAMP_DESCRIBE_LENGTH 128
+
+enum RAMP_STATE {
+    RAMP_PENDING,   // Before its minute
+    RAMP_RUNNING,   // Spawning, or retiring at the end of the day
+    RAMP_DONE,
+    RAMP_REJECTED   // Malformed, never run
+};
+
+struct S_ramp_step {
+    int day;      // Of the run, from 1
+    int minute;   // Of the day
+    int users;    // Added if positive, retired if negative
+    int over;     // Minutes the spawns are spread over, 0 for ramp_spawn_rate a minute
+};
+
+// A step as the director runs it
+struct S_ramp_status {
+    struct S_ramp_step step;
+    int state;      // RAMP_STATE
+    int done;       // Users spawned or retired so far
+    int started;    // Minute of the run it started, -1 before
+    int finished;   // Minute of the run it ended, -1 before
+};
+
+// Every step submitted to the director, in order
+struct S_ramp_schedule {
+    int count;
+    int spawned;    // Users spawned by all the steps
+    int retired;
+    struct S_ramp_status steps[RAMP_MAX_STEPS];
+};
+
+extern const char *ramp_state_names[];
+
+// Minute of the run of a day and minute of the day, as the clock counts them
+int ramp_minute(int day, int minute);
+
+// Parses a step from line: 1 for a step, 0 for a blank or '#' comment line,
+// -1 if malformed
+int ramp_parse_step(const char *line, struct S_ramp_step *step);
+
+// Reads the steps of a schedule file. Returns the steps, or -1 if the file
+// cannot be read or holds more than RAMP_MAX_STEPS steps or a malformed line,
+// whose number goes to *bad_line (0 if it was not a line).
+int ramp_read_file(const char *path, struct S_ramp_step steps[RAMP_MAX_STEPS], int *bad_line);
+
+// True if the step can run
+bool ramp_step_valid(const struct S_ramp_step *step);
+
+// Appends n steps to the schedule, invalid ones as RAMP_REJECTED. Returns the
+// index of the first one, or -1 if they do not fit.
+int ramp_submit(struct S_ramp_schedule *schedule, const struct S_ramp_step steps[], int n);
+
+// Starts the steps due at minute now of the run and returns the users to spawn
+// in this minute, counted as done
+int ramp_spawns(struct S_ramp_schedule *schedule, int now, int spawn_rate);
+
+// At the start of a day: starts the steps due and returns the users to retire
+// out of the present ones, counted as done. Retire steps only end here.
+int ramp_retirements(struct S_ramp_schedule *schedule, int now, int present);
+
+// First minute of the run after now the schedule has work in, INT_MAX if none
+int ramp_next_minute(const struct S_ramp_schedule *schedule, int now);
+
+// One line about a step, as "day 2 10:00 +500 over 120 min: running, 250/500 spawned"
+void ramp_describe(const struct S_ramp_status *status, char *buffer, size_t size);
+
+#endif
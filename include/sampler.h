@@ -0,0 +1,76 @@
+// include/sampler.h
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "poste.h"
+
+// Time series of the queues. Every sample_interval simulated minutes the
+// director samples the users waiting, the seats staffed and serving and the
+// operators present per service into a fixed ring in /poste_samples. It drains
+// the ring to a CSV file at each new day and at the end of the run, so the ring
+// only has to hold one day of samples; older samples are overwritten.
+// The director is the only writer: a sample is written before head is bumped,
+// readers copy a slot and check head did not lap it meanwhile.
+
+#define SHM_SAMPLES_NAME "/poste_samples"
+#define SAMPLER_RING_SIZE 2048 // One day at one sample a minute, with room to spare
+
+struct S_sample {
+    int day;
+    int minute;                        // Of the day
+    int waiting[NUM_SERVICE_TYPES];    // Users holding a ticket for the service
+    int staffed[NUM_SERVICE_TYPES];    // Seats of the service with an operator
+    int serving[NUM_SERVICE_TYPES];    // Staffed seats with a user too
+    int operators[NUM_SERVICE_TYPES];  // Operators alive that know the service
+};
+
+struct S_sample_ring {
+    CACHE_ALIGNED unsigned int head;  // Samples ever written, slot head % SAMPLER_RING_SIZE is next
+    int interval;                     // Minutes between samples, 0 if sampling is off
+
+    CACHE_ALIGNED struct S_sample samples[SAMPLER_RING_SIZE];
+};
+
+#define SHM_SAMPLES_SIZE sizeof(struct S_sample_ring)
+
+// Built by the director while draining: when the queues peak
+struct S_sample_summary {
+    unsigned int drained;  // Samples written to the CSV so far
+    unsigned int lost;     // Overwritten before they were drained
+    double hour_waiting[24];  // Sum of the users waiting, over the samples of each hour
+    double hour_staffed[24];  // Same for the staffed seats
+    int hour_samples[24];
+    int peak_waiting[NUM_SERVICE_TYPES];  // Longest queue of each service...
+    int peak_day[NUM_SERVICE_TYPES];      // ...and when it was first seen
+    int peak_minute[NUM_SERVICE_TYPES];
+    int peak_staffed[NUM_SERVICE_TYPES];  // Seats staffed at that moment
+};
+
+// Creates the ring, to be removed with cleanup_shared_memory
+struct S_sample_ring *sampler_create(int interval, int *open_shm, int *open_shm_index);
+
+// Reads the live queues and seats into sample
+void sampler_take(struct S_sample *sample, int day, int minute,
+                  struct S_poste_stats *stats, struct S_poste_stations *stations);
+
+// true if a sample is due at this minute of the day
+bool sampler_due(const struct S_sample_ring *ring, int minute);
+
+// Appends sample to the ring
+void sampler_record(struct S_sample_ring *ring, const struct S_sample *sample);
+
+// Appends sample for every sampling minute in [from, to) jumped over by the
+// time warp: nobody moves during a jump, the queues are those of sample
+void sampler_skip(struct S_sample_ring *ring, const struct S_sample *sample, int from, int to);
+
+// Writes the samples not drained yet to fp (header if fp is at its start) and
+// adds them to summary. Returns the number of samples written.
+int sampler_drain(struct S_sample_ring *ring, FILE *fp, struct S_sample_summary *summary);
+
+// Hour of the day with the most users waiting on average, -1 without samples
+int sampler_peak_hour(const struct S_sample_summary *summary);
+
+#endif
@@ -0,0 +1,41 @@
+// include/seat_policy.h
+#ifndef SEAT_POLICY_H
+#define SEAT_POLICY_H
+
+#include "poste.h"
+
+// How start_new_day assigns a service to each worker seat
+typedef enum SEAT_POLICY {
+    SEAT_POLICY_RANDOM, // rand() % NUM_SERVICE_TYPES for every seat
+    SEAT_POLICY_DEMAND  // Proportional to the expected load, capped by the operator skills
+} SEAT_POLICY;
+
+extern const char *seat_policy_names[];
+
+// Expected requests per day of each service, from the cumulative history
+// of the previous days (served + failed). All 0 on the first day.
+void seat_policy_demand(const struct S_service_stats history[NUM_SERVICE_TYPES],
+                        int days, double demand[NUM_SERVICE_TYPES]);
+
+// Fills seat_services[0..num_seats) with a service for each seat.
+// skills[s] is the number of operators that know service s.
+void allocate_seats(SEAT_POLICY policy,
+                    const struct S_service_stats history[NUM_SERVICE_TYPES],
+                    const int skills[NUM_SERVICE_TYPES],
+                    int num_seats,
+                    int seat_services[]);
+
+// Users per day the seats can serve at most: each staffed seat serves
+// open_minutes / services_duration users, never more than the demand.
+double seat_policy_expected_served(const int seat_counts[NUM_SERVICE_TYPES],
+                                   const int skills[NUM_SERVICE_TYPES],
+                                   const double demand[NUM_SERVICE_TYPES],
+                                   int open_minutes);
+
+// Same estimate averaged over every random allocation of num_seats seats
+double seat_policy_expected_served_random(int num_seats,
+                                          const int skills[NUM_SERVICE_TYPES],
+                                          const double demand[NUM_SERVICE_TYPES],
+                                          int open_minutes);
+
+#endif
@@ -0,0 +1,32 @@
+// include/seat_queue.h
+#ifndef SEAT_QUEUE_H
+#define SEAT_QUEUE_H
+
+#include "poste.h"
+
+// Seats are handed over instead of announced: whoever frees or staffs a seat
+// gives it, under stations_lock, to the first operator (free seat) or the
+// first user (free user side of a staffed seat) queued for its service.
+// The one woken finds the seat already taken on its behalf, nobody else
+// wakes up and nobody polls. Processes without a clock slot poll every minute.
+
+// Under stations_lock. Hands a seat to the operator, then to the user,
+// waiting for its service, if it is free on their side.
+void seat_queue_offer(struct S_poste_stations *stations, int seat);
+
+// Takes stations_lock. If its holder died with it, relinks the queues first.
+// Returns true in that case, as shm_mutex_lock.
+bool seat_queue_lock(struct S_poste_stations *stations);
+
+// Under stations_lock, for a process that died: removes it from the queues
+// and frees the seats it held, handing them over again. The users seated at
+// a seat it staffed are put in seated (their number is returned): they wait
+// for a service that will not come.
+int seat_queue_forget(struct S_poste_stations *stations, pid_t pid, pid_t seated[MAX_WORKER_SEATS]);
+
+// Called with stations_lock held, returns with it held. Waits in queue for at
+// most minutes (simulated) or until a signal. Returns the seat handed over,
+// -1 if none: the caller checks again for a free seat and why it woke up.
+int seat_queue_wait(struct S_poste_stations *stations, struct S_actor_queue *queue, int minutes);
+
+#endif
@@ -5,3 +5,10 @@ void* init_shared_memory(const char *name, size_t size, int *open_shm, int *open
 
 // Cleans up shared_stats;
 void cleanup_shared_memory(const char *name, size_t size, int shm_info, void* shared_info);
+
+// Maps an existing segment without creating it, prot is PROT_READ or PROT_READ|PROT_WRITE
+// Returns mapped pointer or NULL if the segment does not exist
+void* attach_shared_memory(const char *name, size_t size, int prot);
+
+// Unmaps a segment obtained with attach_shared_memory
+void detach_shared_memory(size_t size, void* shared_info);
@@ -0,0 +1,45 @@
+// include/shm_mutex.h
+#ifndef SHM_MUTEX_H
+#define SHM_MUTEX_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+// Lock of a shared segment: a process-shared robust pthread mutex. A process
+// that dies holding it (SIGKILL, crash) does not block the others, the next
+// one to lock it takes it over. Before sleeping in the kernel a locker spins
+// on trylock for about as long as recent lockers needed to get it, never
+// on a single core. The counters are written by the holder.
+
+#define SHM_MUTEX_MAX_SPINS 200 // Trylock rounds before sleeping, at most
+
+struct S_lock_counters {
+    unsigned long long acquisitions;
+    unsigned long long contended;   // Busy at the first try
+    unsigned long long sleeps;      // Still busy after spinning, waited in the kernel
+    unsigned long long recoveries;  // Taken over from a process that died holding it
+};
+
+struct S_shm_mutex {
+    pthread_mutex_t mutex;
+    int spin;                       // More than one core online
+    int spin_estimate;              // Average rounds that got the lock times 8, sets the spin limit
+    struct S_lock_counters counters;
+};
+
+// Initializes an unused mutex in a shared segment, counters at 0.
+// Returns 0 or the pthread error.
+int shm_mutex_init(struct S_shm_mutex *m);
+
+// Takes the mutex. Returns true if its previous holder died with it: the
+// data it guards may be half updated, callers that can repair it do.
+bool shm_mutex_lock(struct S_shm_mutex *m);
+
+void shm_mutex_unlock(struct S_shm_mutex *m);
+
+void shm_mutex_destroy(struct S_shm_mutex *m);
+
+// Copy of the counters, taken under the mutex
+void shm_mutex_counters(struct S_shm_mutex *m, struct S_lock_counters *out);
+
+#endif
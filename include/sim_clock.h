@@ -0,0 +1,178 @@
+// include/sim_clock.h
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <semaphore.h>
+
+#include "poste.h"
+#include "msg_queue.h"
+
+// Simulated clock shared by the director and the actors (users, operators,
+// ticket dispenser). With time_warp on, every actor publishes whether it is
+// running, sleeping until a simulated minute, or blocked on another actor.
+// When nobody is running and no message or event token is in flight, the
+// director jumps the clock to the next wakeup instead of sleeping.
+// With fast_forward_closed the actors are tracked the same way, but the
+// director only jumps while the poste is closed and service times stay real.
+// With both off the helpers fall back to the usual real-time sleeps.
+//
+// Every sleep of an actor also records its scheduling lag: how long after
+// the moment it meant to act at it actually ran, in monotonic time. That
+// moment is the end of the sleep in real time, or the director posting the
+// wakeup of the minute it waits for on the shared clock. Lags are kept per
+// role in the segment, a run whose actors wake up late by a good part of a
+// minute has its wait and service times distorted.
+
+#define SHM_CLOCK_NAME "/poste_clock"
+#define MAX_ACTORS 16384
+
+typedef enum ACTOR_STATE {
+    ACTOR_FREE,
+    ACTOR_RUNNING,
+    ACTOR_SLEEPING, // Waiting for wake_minute
+    ACTOR_BLOCKED   // Waiting for a message or an event from another process
+} ACTOR_STATE;
+
+// Roles whose scheduling lag is kept, in the order of the director's children
+typedef enum ACTOR_ROLE {
+    ACTOR_TICKET,
+    ACTOR_OPERATOR,
+    ACTOR_USER,
+    NUM_ACTOR_ROLES
+} ACTOR_ROLE;
+
+#define LAG_BUCKETS 32 // Bucket b holds lags in [2^(b-1), 2^b) microseconds, 0 below 1us
+
+// Scheduling lags of the actors of a role, updated atomically by each of them
+struct S_lag_histogram {
+    unsigned long long samples;
+    unsigned long long total_ns;
+    unsigned long long max_ns;
+    unsigned long long late;   // By more than a tenth of minute_duration
+    unsigned long long buckets[LAG_BUCKETS];
+} CACHE_ALIGNED;
+
+struct S_actor_slot {
+    pid_t pid;
+    int state;        // ACTOR_STATE, accessed atomically
+    int wake_minute;  // Absolute minute a sleeping actor waits for
+    sem_t wake;       // Posted by the director once wake_minute is reached, or by sim_queue_wake
+
+    // Place in a struct S_actor_queue, under the lock of the queue
+    int queued;       // Accessed atomically, cleared by sim_queue_wake
+    int next;         // Slot index + 1, 0 at the end
+    int prev;
+    int handoff;      // Value handed over by sim_queue_wake, -1 once taken
+
+    long long woken_ns; // Monotonic time the director posted wake for wake_minute
+} CACHE_ALIGNED;
+
+struct S_sim_clock {
+    CACHE_ALIGNED int time_warp;  // Set by the director at startup
+    int fast_forward_closed;      // Actors tracked, jumps only outside the shift
+    int overflow;                 // More actors than slots: some are not tracked, never warp
+    sem_t slots_lock;             // Slot registration only
+
+    CACHE_ALIGNED int now;        // Absolute simulated minute, day * 1440 + minute
+    CACHE_ALIGNED int pending;    // Messages and event tokens sent but not received yet
+    CACHE_ALIGNED int n_slots;    // Slots ever used, the director scans up to here
+
+    struct S_lag_histogram lag[NUM_ACTOR_ROLES];
+
+    struct S_actor_slot actors[MAX_ACTORS];
+};
+
+#define SHM_CLOCK_SIZE sizeof(struct S_sim_clock)
+
+// --- Director side ---
+
+// Creates the clock segment, to be removed with cleanup_shared_memory
+struct S_sim_clock *sim_clock_create(bool time_warp, bool fast_forward_closed,
+                                     int *open_shm, int *open_shm_index);
+
+// Reserves a running slot for a freshly spawned child, before it can go idle
+void sim_actor_register(pid_t pid);
+
+// Frees the slot of a child that exited, dropping the wakeup of a value it
+// was handed by sim_queue_wake and never took
+void sim_actor_forget(pid_t pid);
+
+// Publishes the current absolute minute and wakes the actors sleeping until it
+void sim_clock_publish(int now);
+
+// Waits up to timeout_ns for every actor to be idle. Returns true if they are,
+// with the earliest wakeup in *next_wake (INT_MAX if nobody sleeps).
+// With jump false it just sleeps timeout_ns and returns false.
+bool sim_clock_wait_idle(long timeout_ns, bool jump, int *next_wake);
+
+// --- Actor side ---
+
+// Maps the clock segment if the director created it
+bool sim_clock_attach(void);
+
+// Takes (or finds) the slot of this process, marked running. Its sleeps
+// count in the lag of role.
+void sim_actor_join(ACTOR_ROLE role);
+
+// Releases the slot of this process before exiting
+void sim_actor_leave(void);
+
+// True if the clock may jump over idle time (time warp or fast forward)
+bool sim_time_warp(void);
+
+// Sleeps for simulated time: on the shared clock when tracked, in real time otherwise.
+// Sub-minute sleeps (service times) use the clock in time warp only, rounded
+// to whole minutes: sim_sleep_nanos returns the time slept, in nanoseconds.
+void sim_sleep_minutes(int minutes);
+long long sim_sleep_nanos(long long nanos);
+
+// Around a blocking receive or semaphore wait. consumed tells whether a
+// message or token accounted with sim_expect_wakeups was taken.
+void sim_block(void);
+void sim_unblock(bool consumed);
+
+// --- Actor queues (struct S_actor_queue), with the lock of the queue held ---
+
+// Appends this actor. False if it has no slot: the caller polls instead.
+bool sim_queue_push(struct S_actor_queue *queue);
+
+// Pops the first actor, hands it value (>= 0) and wakes it. Returns its pid, 0 if empty.
+pid_t sim_queue_wake(struct S_actor_queue *queue, int value);
+
+// Removes this actor if still queued. Returns the value it was handed, -1 if none.
+int sim_queue_leave(struct S_actor_queue *queue);
+
+// Removes the actor of pid, which died, if it is queued. True if it was.
+bool sim_queue_remove(struct S_actor_queue *queue, pid_t pid);
+
+// Relinks a queue its lock was recovered from a dead holder for: keeps the
+// actors still queued and alive, in order, drops the others
+void sim_queue_repair(struct S_actor_queue *queue);
+
+// Without the lock, after sim_queue_push: blocks until sim_queue_wake, for at
+// most minutes of simulated time, or until a signal. Idle for the time warp.
+void sim_queue_wait(int minutes);
+
+// Lag under which the fraction-th sample of a histogram falls, in microseconds
+double sim_lag_percentile_us(const struct S_lag_histogram *lag, double fraction);
+
+// After a non-blocking receive took an accounted message
+void sim_received(void);
+
+// After a process without a clock slot, as the director, dropped n accounted
+// messages left for an actor that died. sim_received only counts for actors.
+void sim_drop_wakeups(int n);
+
+// Called by the sender before sending n messages or posting n event tokens
+// that will wake blocked actors. Negative n cancels a failed send.
+void sim_expect_wakeups(int n);
+
+// Sends an accounted answer of type pid to the actor pid. If it died in the
+// meantime, one message left for it is taken back: whoever drains the queue
+// of a dead actor may have done so before this one arrived. Returns 0, or
+// -1 with errno if the send failed.
+int sim_reply(mq_id qid, pid_t pid, const void *data, size_t length);
+
+#endif
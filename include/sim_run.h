@@ -0,0 +1,32 @@
+// include/sim_run.h
+#ifndef SIM_RUN_H
+#define SIM_RUN_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+// Headless simulations for the tools that run many of them (poste_search,
+// poste_scale). Each run is bin/direttore under its own POSTE_INSTANCE, in its
+// own process group so it can be killed with every actor it started.
+
+#define DIRECTOR_PATH "bin/direttore"
+
+// Starts the director on config_path. Its output goes to direttore.log in the
+// instance directory if keep_log, else it is discarded. Returns its pid, -1 on error.
+pid_t sim_run_launch(const char *instance, const char *config_path, bool keep_log);
+
+// Removes what a killed director could not: segments, message queues, and
+// unless keep the instance directory with its files
+void sim_run_cleanup(const char *instance, bool keep);
+
+// final_stats.csv of the instance, NULL if the run wrote none
+FILE *sim_run_results(const char *instance);
+
+// Copies the config file (if any) to out, so lines written after it override it
+bool sim_run_copy_config(const char *config_file, FILE *out);
+
+// Splits a CSV line in place, returns the number of fields
+int csv_split_fields(char *line, char *fields[], int max);
+
+#endif
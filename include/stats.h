@@ -0,0 +1,66 @@
+// include/stats.h
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+
+#include "poste.h"
+
+// Seqlock on the counters of S_poste_stats.
+// Writers still serialise on stats_lock, and bump stats_seq around their
+// updates so readers can take a consistent copy without blocking them.
+
+// Takes stats_lock and marks the counters as being updated. If the previous
+// writer died inside its update, the update is closed first.
+void stats_write_begin(struct S_poste_stats *stats);
+
+// Publishes the update and releases stats_lock
+void stats_write_end(struct S_poste_stats *stats);
+
+// Copies the counters without locking, retrying while a writer is active.
+// Works on read-only mappings of the segment.
+void stats_snapshot(const struct S_poste_stats *stats, struct S_stats_snapshot *snap);
+
+// One change to the counters, as the users and operators make them. Applied
+// in place on the segment, or sent to poste_broker over the socket transport
+// (see mq_broker.h) which applies it on the segment of the branch.
+typedef enum STATS_UPDATE {
+    STATS_SERVED = 1,       // service served, wait_time and minutes of service
+    STATS_FAILED,           // service failed
+    STATS_WAITING,          // delta users waiting for a seat of service
+    STATS_SEAT_WAIT,        // A request waited delta minutes for a seat
+    STATS_LATE,             // A user of service was still queued at closing
+    STATS_REQUEST,          // An operator took a request for service
+    STATS_PAUSE,            // An operator paused
+    STATS_BUSY,             // minutes of service by operator pid at seat
+    STATS_SEATED,           // minutes seated by operator pid at seat
+    STATS_ACTIVE_OPERATOR,  // An operator worked today
+    STATS_TRACE_DELAYED     // A replayed arrival was reached delta minutes late
+} STATS_UPDATE;
+
+struct S_stats_update {
+    int32_t kind;   // STATS_UPDATE
+    int32_t branch; // Segment it is for, set by stats_update
+    int32_t service;
+    int32_t seat;
+    int32_t pid;
+    int32_t delta;
+    double wait_time;
+    double minutes;
+};
+
+// Applies an update to the counters, under the seqlock
+void stats_apply(struct S_poste_stats *stats, const struct S_stats_update *update);
+
+// Applies an update to the counters of stats, or posts it to the broker when
+// the socket transport is used: the broker applies it once the process
+// flushes its frame, at the latest before it blocks
+void stats_update(struct S_poste_stats *stats, struct S_stats_update update);
+
+// Minutes under which fraction of the requests got a seat, -1 if none did
+int stats_wait_percentile(const int histogram[WAIT_HISTOGRAM_BINS], double fraction);
+
+// Requests counted in the histogram
+int stats_wait_count(const int histogram[WAIT_HISTOGRAM_BINS]);
+
+#endif
@@ -0,0 +1,105 @@
+// include/trace.h
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "poste.h"
+
+// Replay of recorded arrivals. With trace_file set, users stop drawing their
+// days (will_go_to_poste, generate_service_list, generate_walk_in_time) and
+// follow the recorded customers instead.
+//
+// A trace is read as CSV, one arrival per line:
+//
+//     day,minute,service
+//
+// where minute is the minute of the day (0-1439) or HH:MM and service the
+// index in the services table. Blank lines, '#' comments and a header line
+// are skipped; the first day of the trace is day 1 of the simulation, days
+// missing from it have no arrivals. The director compiles the CSV once into
+// a binary trace (TRACE_FILE_NAME in the instance directory): the records
+// sorted by day and minute, with the offset where each day starts. A binary
+// trace can be given as trace_file directly.
+//
+// Every user maps the binary trace read only, so all of them share the page
+// cache, and takes the arrivals k, k + n, k + 2n... of the day, k its index
+// and n the users the trace is dealt to: a day costs a user its own arrivals,
+// whatever the size of the trace.
+
+#define TRACE_FILE_NAME "trace.bin"
+#define TRACE_MAGIC     "POSTETRC"
+#define TRACE_VERSION   1
+#define TRACE_MAX_DAYS  100000
+
+// Head of a binary trace, followed by day_start[days + 1] and the records
+struct S_trace_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t days;       // From the first to the last day of the trace
+    uint32_t records;
+    int32_t first_day;   // Day of the CSV that became day 1
+};
+
+// An arrival, its day given by the day_start offsets
+struct S_trace_record {
+    uint16_t minute;
+    uint8_t service;
+    uint8_t reserved;
+};
+
+// Mapped binary trace
+struct S_trace {
+    void *map;
+    size_t size;
+    const struct S_trace_header *header;
+    const uint32_t *day_start;
+    const struct S_trace_record *records;
+};
+
+// Arrivals of one user on one day
+struct S_trace_cursor {
+    const struct S_trace_record *records;
+    uint32_t next;
+    uint32_t end;
+    uint32_t stride;
+};
+
+// What compiling and opening a trace found
+struct S_trace_info {
+    int records;
+    int days;
+    int first_day;
+    int busiest_day;       // Day of the simulation, from 1
+    int busiest_records;
+    int skipped_lines;     // Malformed lines of the CSV
+    int first_skipped;     // Line number of the first of them, 0 if none
+};
+
+// True if path starts as a binary trace
+bool trace_is_binary(const char *path);
+
+// Parses the CSV at source and writes the binary trace to output. False if
+// the file cannot be read or written or has no arrival.
+bool trace_compile(const char *source, const char *output, struct S_trace_info *info);
+
+// Maps a binary trace and checks its layout
+bool trace_open(const char *path, struct S_trace *trace);
+
+void trace_close(struct S_trace *trace);
+
+// Records, days and busiest day of an open trace
+void trace_info(const struct S_trace *trace, struct S_trace_info *info);
+
+// Arrivals of day (from 1) dealt to user out of users, in time order
+void trace_deal(const struct S_trace *trace, int day, int user, int users, struct S_trace_cursor *cursor);
+
+// Next arrival of the cursor, NULL once the user has none left
+const struct S_trace_record *trace_next(struct S_trace_cursor *cursor);
+
+// Arrivals of an open trace at or after the closing minute, users skip them
+int trace_after_close(const struct S_trace *trace, int close_minute);
+
+#endif
@@ -0,0 +1,33 @@
+// include/utente.h
+#ifndef UTENTE_H
+#define UTENTE_H
+
+#include "poste.h"
+#include "msg_queue.h"
+
+typedef enum SERVICE_OUTCOME {
+    SERVICE_SERVED,  // The operator completed the request
+    SERVICE_FAILED,  // No operator for the service or an IPC error
+    SERVICE_LATE     // The shift ended while waiting for a seat
+} service_outcome;
+
+// Hot paths of the user process, exposed for tests and benchmarks
+void update_fails_stats(struct S_poste_stats *shared_stats, int service_id);
+void update_success_stats(struct S_poste_stats *shared_stats, int service_id, double wait_time, double service_time);
+int find_valid_seats(struct S_poste_stations *shared_stations, int service_id, int valid_seats[MAX_WORKER_SEATS]);
+int attempt_take_seat(struct S_poste_stations *shared_stations, int valid_seats[MAX_WORKER_SEATS], int n_valid_seats);
+void release_user_seat(struct S_poste_stations *shared_stations, int seat_index);
+int wait_for_seat(struct S_poste_stats *shared_stats, struct S_poste_stations *shared_stations, int service_id);
+void update_waiting_stats(struct S_poste_stats *shared_stats, int service_id, int delta);
+void update_seat_wait_stats(struct S_poste_stats *shared_stats, int minutes);
+
+// Full ticket -> seat -> service round trip for one request
+service_outcome handle_service(int service_id, mq_id qid, struct S_poste_stats *stats, struct S_poste_stations *stations);
+
+// Seat -> service for a ticket already taken
+service_outcome serve_ticket(int service_id, int ticket_number, mq_id qid, struct S_poste_stats *stats, struct S_poste_stations *stations);
+
+// Tickets for every service of a day in one message each way
+bool request_ticket_bundle(mq_id qid, const int service_list[], int n_services, int tickets[]);
+
+#endif
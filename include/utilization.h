@@ -0,0 +1,28 @@
+// include/utilization.h
+#ifndef UTILIZATION_H
+#define UTILIZATION_H
+
+#include "poste.h"
+
+// Busy and idle time of every worker seat and operator. Operators add to the
+// tables of S_poste_stats under stats_write_begin/end: busy time after each
+// process_service, seated time when they release their seat. Busy time is the
+// simulated service time, seated time is counted in simulated minutes.
+
+// Slot of an operator, taken on first use. NULL if the table is full.
+struct S_operator_utilization *utilization_operator(struct S_utilization *usage, pid_t pid, int service);
+
+// One service done at a seat
+void utilization_add_busy(struct S_utilization *usage, int seat, pid_t pid, int service, double minutes);
+
+// A seat left after minutes seated
+void utilization_add_seated(struct S_utilization *usage, int seat, pid_t pid, int service, double minutes);
+
+// Busy minutes of the operators of a service, and the minutes they sat
+void utilization_service_totals(const struct S_utilization *usage, int service,
+                                double *busy_minutes, double *seated_minutes);
+
+// Percentage, 0 if nothing was available
+double utilization_percent(double busy_minutes, double available_minutes);
+
+#endif
@@ -10,10 +10,26 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <limits.h>
 
 #include <direttore.h>
 #include <poste.h>
 #include <shared_mem.h>
+#include <instance.h>
+#include <stats.h>
+#include <seat_policy.h>
+#include <sim_clock.h>
+#include <checkpoint.h>
+#include <config_shm.h>
+#include <utilization.h>
+#include <sampler.h>
+#include <proc_usage.h>
+#include <branch.h>
+#include <trace.h>
+#include <ramp.h>
+#include <seat_queue.h>
 #include <comunications.h>
 
 #define DIRETTORE_PREFIX "\033[31m[DIRETTORE]:\033[0m"
@@ -30,15 +46,35 @@ typedef struct S_daily_stats      daily_stats;
 typedef struct S_service_stats    service_stats;
 typedef struct S_poste_stations   poste_stations;
 typedef struct S_worker_seat      worker_seat;
+typedef struct S_seat_utilization seat_utilization;
+typedef struct S_operator_utilization operator_utilization;
 typedef struct S_new_users_request new_users_request;
 typedef struct S_new_users_done new_users_done;
+typedef struct S_ramp_request  ramp_request;
+typedef struct S_ramp_reply    ramp_reply;
+typedef struct S_lock_counters lock_counters;
+typedef struct S_role_usage role_usage;
+typedef struct S_proc_sample proc_sample;
+
+#define NUM_SHM_LOCKS 2 // stats_lock, stations_lock
 
 typedef enum PROCESS_INDEXES {
     TICKET,
     OPERATORE,
-    UTENTE
+    UTENTE,
+    NUM_PROCESS_TYPES
 } PROCESS_INDEXES;
 
+#define NUM_ROLES (NUM_PROCESS_TYPES + 1) // Children by type, then the director itself
+#define DIRECTOR_ROLE NUM_PROCESS_TYPES
+
+static const char *ROLE_NAMES[NUM_ROLES] = {
+    "erogatore",
+    "operatore",
+    "utente",
+    "direttore"
+};
+
 static const char *PROCESS_TYPES[] = {
     "erogatore ticket",
     "NOF WORKERS",
@@ -55,7 +91,119 @@ int day_to_minutes(int days) {
     return days * 24 * 60;
 }
 
-pid_t start_process(PROCESS_INDEXES type) {
+// Minutes the poste stays open in a day
+int shift_minutes(void) {
+    return (g_config.worker_shift_close - g_config.worker_shift_open) * 60;
+}
+
+// Expected served users of the seat policy against random seats, summed over the days
+struct S_seat_policy_report {
+    int days;
+    double expected_served;
+    double expected_served_random;
+};
+
+static struct S_seat_policy_report seat_report;
+
+// Trace given in trace_file and what it holds, for the report
+static char trace_source[TRACE_PATH_LENGTH];
+static struct S_trace_info trace_report;
+static int trace_after_closing = 0;
+
+// Load ramps submitted by poste_ramp, see ramp.h
+static struct S_ramp_schedule ramp;
+
+#define MAX_PROCESS_ARGS 8
+
+// Every process spawned by the director, retired ones stay listed until reaped
+struct S_child {
+    pid_t pid;
+    PROCESS_INDEXES type;
+    bool alive;
+    bool retiring; // Asked to leave, waiting for it to finish its ticket
+    double sampled_cpu; // CPU seconds at the previous /proc sample
+};
+
+struct S_children {
+    struct S_child *list;
+    int count;
+    int capacity;
+    struct S_role_usage usage[NUM_ROLES]; // Reaped children by type, see proc_usage.h
+    struct timespec last_sample;          // Wall time of the previous /proc sample
+    double director_cpu;                  // CPU seconds of the director at that sample
+};
+
+// State of the operator autoscaler, see autoscale_operators
+struct S_autoscaler {
+    int last_decision;                        // Absolute minute of the last scaling
+    int last_failed[NUM_SERVICE_TYPES];       // Failed services seen at the last decision
+    int previous_day_late;                    // Late users at the end of the previous day
+    int spawned;
+    int retired;
+    int min_operators;
+    int max_operators;
+    long long operator_minutes;               // Operators present, summed over open minutes
+    int open_minutes;
+};
+
+// Time warp counters, see sim_clock.h
+struct S_warp_stats {
+    int jumps;
+    int skipped_minutes;
+    struct timespec started;
+    double wall_seconds;
+};
+
+#define TICK_BUCKETS 32 // Bucket b holds lateness in [2^(b-1), 2^b) microseconds, 0 below 1us
+
+// How late the minutes of the director run: time a minute took past
+// minute_duration, over the minutes it slept in full (not cut short by the warp)
+struct S_tick_stats {
+    long long ticks;
+    long long late_ticks;   // Late by more than a tenth of a minute
+    double total_lateness_us;
+    double max_lateness_us;
+    long long buckets[TICK_BUCKETS];
+};
+
+// Director state saved after the shared segments in a checkpoint
+struct S_director_checkpoint {
+    struct S_autoscaler scaler;
+    struct S_seat_policy_report seat_report;
+};
+
+typedef struct S_child       child;
+typedef struct S_children    children_table;
+typedef struct S_autoscaler  autoscaler;
+typedef struct S_warp_stats  warp_stats;
+typedef struct S_tick_stats  tick_stats;
+typedef struct S_checkpoint  checkpoint;
+typedef struct S_operator_state operator_state;
+typedef struct S_sample        sample;
+typedef struct S_sample_summary sample_summary;
+
+// One office of the run, see branch.h. Branch 0 holds the usual segments.
+struct S_branch_office {
+    poste_stats *stats;
+    poste_stations *stations;
+    mq_id ticket_qid;
+    int stats_shm;    // Descriptors in open_shm
+    int stations_shm;
+};
+
+typedef struct S_branch_office branch_office;
+
+// Starts a process, args is a NULL terminated list of extra arguments (or NULL)
+pid_t start_process(PROCESS_INDEXES type, const char *args[]) {
+    char *argv[MAX_PROCESS_ARGS + 2];
+    int argc = 0;
+    argv[argc++] = (char *)PROCESS_PATHS[type];
+    for (int i = 0; args != NULL && args[i] != NULL && argc <= MAX_PROCESS_ARGS; i++) {
+        argv[argc++] = (char *)args[i];
+    }
+    argv[argc] = NULL;
+
+    fflush(stdout);
     pid_t pid = fork();
     if (pid < 0) {
         perror("fork");
@@ -63,13 +211,130 @@ pid_t start_process(PROCESS_INDEXES type) {
     }
     if (pid == 0) {
         printf(DIRETTORE_PREFIX " %s running\n", PROCESS_TYPES[type]);
-        execl(PROCESS_PATHS[type], PROCESS_PATHS[type], (char *)NULL);
+        execv(PROCESS_PATHS[type], argv);
         perror("execl failed");
         _exit(EXIT_FAILURE);
     }
     return pid;
 }
 
+// Starts a process and keeps track of it
+pid_t add_child(children_table *children, PROCESS_INDEXES type, const char *args[]) {
+    if (children->count == children->capacity) {
+        children->capacity = children->capacity > 0 ? children->capacity * 2 : 16;
+        children->list = realloc(children->list, sizeof(child) * children->capacity);
+        if (children->list == NULL) {
+            perror("realloc children");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    child *c = &children->list[children->count++];
+    c->pid      = start_process(type, args);
+    sim_actor_register(c->pid); // Counted as running until it joins, no warp before it starts
+    c->type     = type;
+    c->alive    = true;
+    c->retiring = false;
+    c->sampled_cpu = 0.0;
+    return c->pid;
+}
+
+// Answers a user whose service will not come, as an operator does for a failed one
+static void fail_service(mq_id qid, pid_t user_pid) {
+    struct S_service_done res = { .sender_pid = getpid(), .ticket_number = -1, .service_id = -1 };
+    if (sim_reply(qid, user_pid, &res, sizeof(res)) < 0) {
+        perror("mq_send failed service");
+    }
+}
+
+// Takes a child that died out of the seats and queues of every branch, so no
+// seat is handed to it any more. The users waiting at a seat it staffed get a
+// failed service, the messages left for it are dropped.
+static void forget_child(branch_office branches[], pid_t pid) {
+    for (int b = 0; b < g_config.num_branches; b++) {
+        pid_t seated[MAX_WORKER_SEATS];
+        seat_queue_lock(branches[b].stations);
+        int n_seated = seat_queue_forget(branches[b].stations, pid, seated);
+        shm_mutex_unlock(&branches[b].stations->stations_lock);
+
+        mq_id qid = branches[b].ticket_qid;
+        struct S_service_request req;
+        long request_type = (MSG_TYPE_SERVICE_REQUEST MSG_TYPE_TICKET_REQUEST_MULT) + pid;
+        while (mq_receive(qid, request_type, &req, sizeof(req), IPC_NOWAIT) >= 0) {
+            sim_drop_wakeups(1);
+            for (int i = 0; i < n_seated; i++) {
+                if (seated[i] == req.sender_pid) seated[i] = 0;
+            }
+            fail_service(qid, req.sender_pid);
+        }
+        for (int i = 0; i < n_seated; i++) {
+            if (seated[i] != 0) fail_service(qid, seated[i]);
+        }
+
+        char message[MQ_MAX_MESSAGE];
+        while (mq_receive(qid, pid, message, sizeof(message), IPC_NOWAIT) >= 0) sim_drop_wakeups(1);
+    }
+}
+
+// Marks a child as reaped and adds what it cost to its role
+static void child_reaped(children_table *children, branch_office branches[], pid_t pid, const struct rusage *ru) {
+    for (int i = 0; i < children->count; i++) {
+        if (children->list[i].pid == pid) {
+            children->list[i].alive = false;
+            role_usage_add_rusage(&children->usage[children->list[i].type], ru);
+            forget_child(branches, pid); // Before its clock slot, the queues link through it
+            sim_actor_forget(pid);
+            break;
+        }
+    }
+}
+
+// Collects children that already exited: retired operators and users, or
+// ones that died
+void reap_children(children_table *children, branch_office branches[]) {
+    int status;
+    struct rusage ru;
+    pid_t pid;
+    while ((pid = wait4(-1, &status, WNOHANG, &ru)) > 0) {
+        child_reaped(children, branches, pid, &ru);
+    }
+}
+
+// Samples /proc for every live child and the director: processes alive,
+// resident memory and CPU use since the previous sample, per role
+void sample_children_usage(children_table *children) {
+    int alive[NUM_ROLES] = {0};
+    long long rss_kb[NUM_ROLES] = {0};
+    double cpu_seconds[NUM_ROLES] = {0};
+    proc_sample s;
+
+    for (int i = 0; i < children->count; i++) {
+        child *c = &children->list[i];
+        if (!c->alive || !proc_sample_read(c->pid, &s)) continue;
+        alive[c->type]++;
+        rss_kb[c->type] += s.rss_kb;
+        cpu_seconds[c->type] += s.cpu_seconds - c->sampled_cpu;
+        c->sampled_cpu = s.cpu_seconds;
+    }
+    if (proc_sample_read(getpid(), &s)) {
+        alive[DIRECTOR_ROLE] = 1;
+        rss_kb[DIRECTOR_ROLE] = s.rss_kb;
+        cpu_seconds[DIRECTOR_ROLE] = s.cpu_seconds - children->director_cpu;
+        children->director_cpu = s.cpu_seconds;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double wall = (now.tv_sec - children->last_sample.tv_sec) +
+                  (now.tv_nsec - children->last_sample.tv_nsec) / 1e9;
+    children->last_sample = now;
+
+    for (int r = 0; r < NUM_ROLES; r++) {
+        role_usage_add_sample(&children->usage[r], alive[r], rss_kb[r],
+                              wall > 0 ? 100.0 * cpu_seconds[r] / wall : 0.0);
+    }
+}
+
 void print_day_stats(daily_stats today) {
     printf("\n" DIRETTORE_PREFIX " === Daily Statistics ===\n");
 
@@ -102,12 +367,45 @@ void print_day_stats(daily_stats today) {
         }
         printf("  Late users: %d\n", today.services[i].late_users);
 
-        printf("  Ratio between worker seats and working operators: %.2f\n",
-               g_config.num_worker_seats > 0 ? (float)today.active_operators / g_config.num_worker_seats : 0.0f);
+        double busy, seated;
+        utilization_service_totals(&today.usage, i, &busy, &seated);
+        printf("  Operators busy: %.1f of %.1f seated minutes (%.1f%%)\n",
+               busy, seated, utilization_percent(busy, seated));
     }
     printf("\n" DIRETTORE_PREFIX " ========================\n");
 }
 
+// Function that prints busy and idle time of each seat and operator, over open_minutes of opening
+void print_usage(const struct S_utilization *usage, double open_minutes) {
+    printf("\n" DIRETTORE_PREFIX " === Seat Utilization ===\n");
+    int busiest = -1, idlest = -1;
+    for (int i = 0; i < g_config.num_worker_seats && i < MAX_WORKER_SEATS; i++) {
+        const seat_utilization *seat = &usage->seats[i];
+        printf("  Seat %2d: busy %.1f min, seated %.1f min, %d services, busy %.1f%% of opening\n",
+               i, seat->busy_minutes, seat->seated_minutes, seat->services,
+               utilization_percent(seat->busy_minutes, open_minutes));
+
+        if (busiest == -1 || seat->busy_minutes > usage->seats[busiest].busy_minutes) busiest = i;
+        if (idlest == -1 || seat->busy_minutes < usage->seats[idlest].busy_minutes) idlest = i;
+    }
+    if (busiest != -1) {
+        printf(DIRETTORE_PREFIX " Busiest seat %d (%.1f%%), idlest seat %d (%.1f%%)\n",
+               busiest, utilization_percent(usage->seats[busiest].busy_minutes, open_minutes),
+               idlest, utilization_percent(usage->seats[idlest].busy_minutes, open_minutes));
+    }
+
+    printf("\n" DIRETTORE_PREFIX " === Operator Utilization ===\n");
+    for (int i = 0; i < MAX_OPERATOR_STATES && usage->operators[i].pid != 0; i++) {
+        const operator_utilization *op = &usage->operators[i];
+        printf("  Operator %d (%s): busy %.1f of %.1f seated min (%.1f%%), %d services\n",
+               op->pid, services[op->service], op->busy_minutes, op->seated_minutes,
+               utilization_percent(op->busy_minutes, op->seated_minutes), op->services);
+    }
+    if (usage->untracked_operators > 0) {
+        PRINT_STAT("Operators not tracked (table full)", usage->untracked_operators);
+    }
+}
+
 void print_final_stats(poste_stats *shared_stats) {
     printf("\n" DIRETTORE_PREFIX " === Final Statistics ===\n");
 
@@ -145,56 +443,416 @@ void print_final_stats(poste_stats *shared_stats) {
             printf("  Avg service wait time: N/A\n");
         }
     }
+
+    printf("\n" DIRETTORE_PREFIX " === Wait for a Seat (minutes) ===\n");
+    PRINT_STAT("Requests", stats_wait_count(shared_stats->wait_histogram));
+    PRINT_STAT("p50",      stats_wait_percentile(shared_stats->wait_histogram, 0.50));
+    PRINT_STAT("p90",      stats_wait_percentile(shared_stats->wait_histogram, 0.90));
+    PRINT_STAT("p99",      stats_wait_percentile(shared_stats->wait_histogram, 0.99));
     printf("\n" DIRETTORE_PREFIX " ========================\n");
 }
 
+// Function that compares today's seats with random seats, on the demand of the previous days
+void report_seat_policy(int day,
+                        const service_stats history[NUM_SERVICE_TYPES],
+                        const int skills[NUM_SERVICE_TYPES],
+                        const int seat_services[])
+{
+    if (day <= 1) return; // No demand seen yet
+
+    double demand[NUM_SERVICE_TYPES];
+    int seat_counts[NUM_SERVICE_TYPES] = {0};
+    int open_minutes = (g_config.worker_shift_close - g_config.worker_shift_open) * 60;
+
+    seat_policy_demand(history, day - 1, demand);
+    for (int i = 0; i < g_config.num_worker_seats; i++) {
+        seat_counts[seat_services[i]]++;
+    }
+
+    double served = seat_policy_expected_served(seat_counts, skills, demand, open_minutes);
+    double served_random = seat_policy_expected_served_random(g_config.num_worker_seats,
+                                                              skills, demand, open_minutes);
+    seat_report.days++;
+    seat_report.expected_served        += served;
+    seat_report.expected_served_random += served_random;
+
+    printf(DIRETTORE_PREFIX " Seat policy %s: up to %.1f users/day served, random seats %.1f (%+.1f%%)\n",
+           seat_policy_names[g_config.seat_policy], served, served_random,
+           served_random > 0 ? 100.0 * (served - served_random) / served_random : 0.0);
+}
+
+// Minutes where the director posts events (open, close, new day)
+bool is_event_minute(int minute) {
+    return (minute == g_config.worker_shift_open * 60 && minute != 0) ||
+           (minute == g_config.worker_shift_close * 60 && minute != 0) ||
+           minute % 1440 == 0;
+}
+
+// First minute after the given one with a director event
+int next_event_minute(int minute) {
+    int next = 1440;
+    int events[] = { g_config.worker_shift_open * 60, g_config.worker_shift_close * 60 };
+    for (int i = 0; i < 2; i++) {
+        if (events[i] > minute && events[i] < next) next = events[i];
+    }
+    return next;
+}
+
+void print_warp_stats(warp_stats *warp) {
+    printf("\n" DIRETTORE_PREFIX " === Time warp (%s) ===\n",
+           g_config.time_warp ? "on" : g_config.fast_forward_closed ? "closed hours" : "off");
+    PRINT_STAT("Jumps", warp->jumps);
+    PRINT_STAT("Minutes skipped", warp->skipped_minutes);
+    printf(DIRETTORE_PREFIX " Wall time: %.3f s\n", warp->wall_seconds);
+}
+
+void print_process_usage(const role_usage usage[NUM_ROLES]) {
+    printf("\n" DIRETTORE_PREFIX " === Process Usage ===\n");
+    for (int r = 0; r < NUM_ROLES; r++) {
+        const role_usage *u = &usage[r];
+        if (u->processes == 0) continue;
+        printf(DIRETTORE_PREFIX " %s: %d processes, %.2f s user, %.2f s sys, %.1f ms CPU each\n",
+               ROLE_NAMES[r], u->processes, u->user_seconds, u->sys_seconds,
+               role_usage_cpu_ms_per_process(u));
+        printf("  Max RSS: %ld KB, avg %.0f KB per process\n", u->max_rss_kb, role_usage_avg_rss_kb(u));
+        printf("  Context switches: %lld voluntary, %lld involuntary\n",
+               u->voluntary_switches, u->involuntary_switches);
+        if (u->samples > 0) {
+            printf("  Peak over %d samples: %d alive, %lld KB resident, %.1f%% CPU\n",
+                   u->samples, u->peak_alive, u->peak_rss_kb, u->peak_cpu_percent);
+        }
+    }
+}
+
+void tick_record(tick_stats *ticks, long long lateness_ns) {
+    if (lateness_ns < 0) lateness_ns = 0;
+    double us = lateness_ns / 1e3;
+    int bucket = 0;
+    while (bucket < TICK_BUCKETS - 1 && (1LL << bucket) <= (long long)us) bucket++;
+
+    ticks->ticks++;
+    ticks->buckets[bucket]++;
+    ticks->total_lateness_us += us;
+    if (us > ticks->max_lateness_us) ticks->max_lateness_us = us;
+    if (lateness_ns * 10 > g_config.minute_duration) ticks->late_ticks++;
+}
+
+// Upper bound of the bucket holding the fraction-th tick, in microseconds
+double tick_percentile_us(const tick_stats *ticks, double fraction) {
+    long long seen = 0;
+    for (int b = 0; b < TICK_BUCKETS; b++) {
+        seen += ticks->buckets[b];
+        if (seen > 0 && seen >= fraction * ticks->ticks) return (double)(1LL << b);
+    }
+    return 0.0;
+}
+
+void print_runtime_stats(const tick_stats *ticks, unsigned long long messages, double wall_seconds) {
+    printf("\n" DIRETTORE_PREFIX " === Runtime ===\n");
+    printf(DIRETTORE_PREFIX " Minute ticks: %lld, lateness avg %.0f us, p99 < %.0f us, max %.0f us, %lld late by > 10%%\n",
+           ticks->ticks, ticks->ticks > 0 ? ticks->total_lateness_us / ticks->ticks : 0.0,
+           tick_percentile_us(ticks, 0.99), ticks->max_lateness_us, ticks->late_ticks);
+    printf(DIRETTORE_PREFIX " Messages sent: %llu, %.0f per second\n",
+           messages, wall_seconds > 0 ? messages / wall_seconds : 0.0);
+}
+
+// Wakeups of each role and how late they ran, then whether the machine keeps
+// up with minute_duration: a p99 lag over a tenth of a minute distorts the times
+void print_lag_stats(const struct S_lag_histogram lag[NUM_ACTOR_ROLES]) {
+    printf("\n" DIRETTORE_PREFIX " === Scheduling lag ===\n");
+    bool distorted = false;
+    for (int r = 0; r < NUM_ACTOR_ROLES; r++) {
+        const struct S_lag_histogram *l = &lag[r];
+        if (l->samples == 0) continue;
+        double p99 = sim_lag_percentile_us(l, 0.99);
+        printf(DIRETTORE_PREFIX " %s: %llu wakeups, lag avg %.0f us, p50 < %.0f us, p99 < %.0f us, max %.0f us, %llu late by > 10%%\n",
+               ROLE_NAMES[r], l->samples, l->total_ns / 1e3 / l->samples, sim_lag_percentile_us(l, 0.50),
+               p99, l->max_ns / 1e3, l->late);
+        if (p99 * 1000 * 10 > g_config.minute_duration) distorted = true;
+    }
+    if (distorted) {
+        printf(DIRETTORE_PREFIX " WARNING: actors run late by more than a tenth of a minute at p99, "
+               "minute_duration=%ld ns is too short for this machine and the times are distorted\n",
+               g_config.minute_duration);
+    }
+}
+
+static const char *LOCK_NAMES[NUM_SHM_LOCKS] = { "stats_lock", "stations_lock" };
+
+void print_lock_stats(const lock_counters locks[NUM_SHM_LOCKS]) {
+    printf("\n" DIRETTORE_PREFIX " === Locks ===\n");
+    for (int i = 0; i < NUM_SHM_LOCKS; i++) {
+        const lock_counters *l = &locks[i];
+        printf(DIRETTORE_PREFIX " %s: %llu acquisitions, %.2f%% contended, %llu slept, %llu recovered from dead holders\n",
+               LOCK_NAMES[i], l->acquisitions,
+               l->acquisitions > 0 ? 100.0 * l->contended / l->acquisitions : 0.0,
+               l->sleeps, l->recoveries);
+    }
+}
+
+// Compiles a CSV trace_file into the instance directory and points the users
+// at the binary trace. False if there is no usable trace.
+bool prepare_trace(void) {
+    memcpy(trace_source, g_config.trace_file, sizeof(trace_source));
+    struct S_trace_info parsed = {0};
+    if (!trace_is_binary(g_config.trace_file)) {
+        char output[MAX_PATH_LENGTH + 16];
+        instance_output_dir(poste_instance(), output, MAX_PATH_LENGTH);
+        strcat(output, TRACE_FILE_NAME);
+        if (strlen(output) >= TRACE_PATH_LENGTH || !trace_compile(g_config.trace_file, output, &parsed)) {
+            fprintf(stderr, DIRETTORE_PREFIX " Cannot read a trace with arrivals from %s\n", g_config.trace_file);
+            return false;
+        }
+        strcpy(g_config.trace_file, output);
+    }
+
+    struct S_trace trace;
+    if (!trace_open(g_config.trace_file, &trace)) {
+        fprintf(stderr, DIRETTORE_PREFIX " %s is not a valid binary trace\n", g_config.trace_file);
+        return false;
+    }
+    trace_info(&trace, &trace_report);
+    trace_report.skipped_lines = parsed.skipped_lines;
+    trace_report.first_skipped = parsed.first_skipped;
+    trace_after_closing = trace_after_close(&trace, g_config.worker_shift_close * 60);
+    trace_close(&trace);
+
+    // Kept when resumed, users added at runtime do not change the deal
+    if (g_config.trace_users <= 0) g_config.trace_users = g_config.num_users;
+
+    printf(DIRETTORE_PREFIX " Replaying %s: %d arrivals over %d days, busiest day %d with %d (%.1f per user)\n",
+           trace_source, trace_report.records, trace_report.days, trace_report.busiest_day,
+           trace_report.busiest_records, (double)trace_report.busiest_records / g_config.trace_users);
+    if (trace_report.skipped_lines > 0) {
+        printf(DIRETTORE_PREFIX " %d malformed lines skipped, the first one is line %d\n",
+               trace_report.skipped_lines, trace_report.first_skipped);
+    }
+    if (trace_after_closing > 0) {
+        printf(DIRETTORE_PREFIX " %d arrivals at or after closing are not replayed\n", trace_after_closing);
+    }
+    if (trace_report.days < g_config.sim_duration) {
+        printf(DIRETTORE_PREFIX " The trace covers %d of the %d days, the others have no arrivals\n",
+               trace_report.days, g_config.sim_duration);
+    }
+    return true;
+}
+
+void print_trace_stats(const poste_stats *network) {
+    printf("\n" DIRETTORE_PREFIX " === Trace replay ===\n");
+    PRINT_STAT("Arrivals in the trace", trace_report.records);
+    PRINT_STAT("Users replaying them", g_config.trace_users);
+    PRINT_STAT("Arrivals reached late", network->trace_delayed);
+    PRINT_FLOAT_STAT("Avg minutes late", network->trace_delay_minutes, network->trace_delayed);
+}
+
+void print_ramp_stats(void) {
+    printf("\n" DIRETTORE_PREFIX " === Load ramps ===\n");
+    char line[RAMP_DESCRIBE_LENGTH];
+    for (int i = 0; i < ramp.count; i++) {
+        ramp_describe(&ramp.steps[i], line, sizeof(line));
+        printf(DIRETTORE_PREFIX " Step %d: %s\n", i + 1, line);
+    }
+    PRINT_STAT("Users spawned", ramp.spawned);
+    PRINT_STAT("Users retired", ramp.retired);
+}
+
+void print_seat_policy_stats(void) {
+    printf("\n" DIRETTORE_PREFIX " === Seat policy (%s) ===\n", seat_policy_names[g_config.seat_policy]);
+    PRINT_FLOAT_STAT("Expected served users/day", seat_report.expected_served, seat_report.days);
+    PRINT_FLOAT_STAT("Expected with random seats", seat_report.expected_served_random, seat_report.days);
+    printf(DIRETTORE_PREFIX " Expected gain over random seats: %+.1f%%\n",
+           seat_report.expected_served_random > 0 ?
+               100.0 * (seat_report.expected_served - seat_report.expected_served_random) /
+                   seat_report.expected_served_random : 0.0);
+}
+
 void start_new_day(int day,
                    poste_stats    *shared_stats,
                    poste_stations *shared_stations)
 {
     printf(DIRETTORE_PREFIX " New day beginning, current day = %d\n\n", day);
     printf(DIRETTORE_PREFIX " Showing stats for the day:\n");
-    print_day_stats(shared_stats->today);
+    struct S_stats_snapshot snapshot;
+    stats_snapshot(shared_stats, &snapshot);
+    print_day_stats(snapshot.today);
+    if (day > 1) print_usage(&snapshot.today.usage, shift_minutes());
 
-    sem_wait(&shared_stats->stats_lock);
+    stats_write_begin(shared_stats);
     shared_stats->current_day = day;
     shared_stats->today = (daily_stats){0};
-    sem_post(&shared_stats->stats_lock);
+    stats_write_end(shared_stats);
 
     printf(DIRETTORE_PREFIX " === Available Worker Seats ===\n");
     fflush(stdout);
 
-    sem_wait(&shared_stations->stations_lock);
+    int skills[NUM_SERVICE_TYPES];
+    int seat_services[MAX_WORKER_SEATS];
+
+    seat_queue_lock(shared_stations);
+    memcpy(skills, shared_stations->operator_skills, sizeof(skills));
+    allocate_seats(g_config.seat_policy, snapshot.simulation_services, skills,
+                   g_config.num_worker_seats, seat_services);
+
     for (int i = 0; i < g_config.num_worker_seats; i++) {
         shared_stations->NOF_WORKER_SEATS[i].operator_process = 0;
         shared_stations->NOF_WORKER_SEATS[i].operator_status  = FREE;
         shared_stations->NOF_WORKER_SEATS[i].user_status      = FREE;
-        shared_stations->NOF_WORKER_SEATS[i].service_id       = rand() % NUM_SERVICE_TYPES;
+        shared_stations->NOF_WORKER_SEATS[i].user_process     = 0;
+        shared_stations->NOF_WORKER_SEATS[i].service_id       = seat_services[i];
 
         printf(DIRETTORE_PREFIX " Worker seat %d: service=%s\n", i, services[shared_stations->NOF_WORKER_SEATS[i].service_id]);
     }
-    sem_post(&shared_stations->stations_lock);
+    shm_mutex_unlock(&shared_stations->stations_lock);
 
     printf("\n" DIRETTORE_PREFIX " ========================\n");
+    report_seat_policy(day, snapshot.simulation_services, skills, seat_services);
     fflush(stdout);
+}
+
+// Actors waiting on the events of a branch: its operators, and its users unless only_operators
+int branch_actors(int branch, bool only_operators) {
+    int actors = branch_operators(branch, g_config.num_operators, g_config.num_branches);
+    if (!only_operators) actors += branch_users(branch, g_config.num_users, g_config.num_branches);
+    return actors;
+}
+
+// Posts an event once for each actor waiting on it
+void post_event(sem_t *event, int actors) {
+    for (int i = 0; i < actors; i++) {
+        sem_post(event);
+    }
+}
+
+// Late users of the day over every branch, explode_max holds for the whole run
+int network_late_users(branch_office branches[]) {
+    int late = 0;
+    for (int b = 0; b < g_config.num_branches; b++) {
+        late += branches[b].stats->today.late_users;
+    }
+    return late;
+}
+
+// One sample of the queues and seats of every branch, summed
+void sample_branches(sample *now, int day, int minute, branch_office branches[]) {
+    sampler_take(now, day, minute, branches[0].stats, branches[0].stations);
+    for (int b = 1; b < g_config.num_branches; b++) {
+        sample part;
+        sampler_take(&part, day, minute, branches[b].stats, branches[b].stations);
+        for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+            now->waiting[s]   += part.waiting[s];
+            now->staffed[s]   += part.staffed[s];
+            now->serving[s]   += part.serving[s];
+            now->operators[s] += part.operators[s];
+        }
+    }
+}
+
+// Function that saves the state at the end of a day, see checkpoint.h
+void write_checkpoint(int day, unsigned int seed,
+                      poste_stats *shared_stats, poste_stations *shared_stations,
+                      struct S_director_checkpoint *director)
+{
+    checkpoint ck;
+    ck.day    = day;
+    ck.seed   = seed;
+    ck.config = g_config;
+    checkpoint_capture(&ck, shared_stats, shared_stations);
+
+    char dir[MAX_PATH_LENGTH];
+    char path[MAX_PATH_LENGTH + 32];
+    instance_output_dir(poste_instance(), dir, sizeof(dir));
+    snprintf(path, sizeof(path), CHECKPOINT_FILE_FORMAT, dir, day);
+    if (checkpoint_write(path, &ck, director, sizeof(*director))) {
+        printf(DIRETTORE_PREFIX " Checkpoint of day %d written to %s\n", day, path);
+    }
+}
 
-    for (int i = 0; i < g_config.num_users + g_config.num_operators; i++) {
-        sem_post(&shared_stats->day_update_event);
+// Function that starts again the operators of a checkpoint, with their service and pauses
+void respawn_operators(children_table *children, const checkpoint *ck) {
+    int respawned = 0;
+    for (int i = 0; i < MAX_OPERATOR_STATES; i++) {
+        const operator_state *state = &ck->stations.operator_states[i];
+        if (state->pid == 0) continue;
+
+        char service[16], pauses[16];
+        snprintf(service, sizeof(service), "%d", state->service);
+        snprintf(pauses,  sizeof(pauses),  "%d", state->pauses_done);
+        const char *args[] = { "--service", service, "--pauses", pauses, NULL };
+        add_child(children, OPERATORE, args);
+        respawned++;
     }
+    g_config.num_operators = respawned;
+    printf(DIRETTORE_PREFIX " Respawned %d operators from the checkpoint\n", respawned);
+}
+
+// Function that re-reads the configuration file after a SIGHUP and publishes it.
+// The process counts and the clock mode belong to the running simulation and are kept.
+void reload_config(poste_stats *shared_stats) {
+    char path[MAX_PATH_LENGTH];
+    memcpy(path, shared_stats->configuration_file, MAX_PATH_LENGTH);
+    path[MAX_PATH_LENGTH - 1] = '\0';
+
+    FILE *fp = path[0] != '\0' ? fopen(path, "r") : NULL;
+    if (fp == NULL) {
+        printf(DIRETTORE_PREFIX " Reload ignored, no readable configuration file\n");
+        return;
+    }
+    fclose(fp);
+
+    struct poste_config previous = g_config;
+    load_config(path);
+    g_config.num_operators       = previous.num_operators;
+    g_config.num_users           = previous.num_users;
+    g_config.num_worker_seats    = previous.num_worker_seats;
+    g_config.time_warp           = previous.time_warp;
+    g_config.fast_forward_closed = previous.fast_forward_closed;
+    g_config.num_branches        = previous.num_branches;
+    g_config.num_regions         = previous.num_regions;
+    g_config.trace_users         = previous.trace_users;
+    memcpy(g_config.trace_file, previous.trace_file, sizeof(g_config.trace_file)); // The compiled trace
+    if (g_config.num_branches > 1) {
+        // Still off, as at the start of the run
+        g_config.autoscale  = previous.autoscale;
+        g_config.checkpoint = previous.checkpoint;
+    }
+
+    if (config_shm_publish()) {
+        printf(DIRETTORE_PREFIX " Configuration reloaded from %s, version %u\n", path, config_shm_version());
+    } else {
+        printf(DIRETTORE_PREFIX " Configuration reloaded from %s, unchanged\n", path);
+    }
+}
+
+// Starts the index-th user, its home follows from the index (see branch.h).
+// join is the flag of a user joining the day under way, NULL for none.
+void spawn_user(children_table *children, int index, const char *join) {
+    char index_arg[16];
+    snprintf(index_arg, sizeof(index_arg), "%d", index);
+    const char *args[] = { "--index", index_arg, join, NULL };
+    add_child(children, UTENTE, args);
+}
+
+// Starts a user during the run, counted from now in the events posted to the
+// users. Before the poste opens it joins today (--join-day), while it is open
+// it walks in later today (--join), once closed it waits for the next day.
+static void spawn_joining_user(children_table *children, int minute) {
+    const char *join = NULL;
+    if (minute < g_config.worker_shift_open * 60) {
+        join = "--join-day";  // Today's day_update is posted, the open event not yet
+    } else if (minute < g_config.worker_shift_close * 60) {
+        join = "--join";      // Both posted already
+    }
+    spawn_user(children, g_config.num_users++, join);
 }
 
 // Function that handles the new_users message queue and add new users
-void check_new_users_queue(mq_id qid, pid_t *children, int *idx) {
+void check_new_users_queue(mq_id qid, children_table *children, int minute) {
     new_users_request req;
     ssize_t n = mq_receive(qid, MSG_TYPE_ADD_USERS_REQUEST, &req, sizeof(req), IPC_NOWAIT);
     if (n >= 0) {
         // Found message
-        g_config.num_users += req.N_NEW_USERS;
-
-        children = realloc(children, sizeof(int) * (1 + g_config.num_operators + g_config.num_users));
-
         for (int i = 0; i < req.N_NEW_USERS; i++) {
-            children[(*idx)++] = start_process(UTENTE);
+            spawn_joining_user(children, minute);
         }
 
         new_users_done res;
@@ -218,40 +876,321 @@ void check_new_users_queue(mq_id qid, pid_t *children, int *idx) {
     }
 }
 
-// Function that write stats to a CSV file
-// ...existing code...
-void write_stats(poste_stats *shared_stats) {
-    char filename[MAX_PATH_LENGTH + 32];
-    int counter = 0;
-    FILE *fp = NULL;
+// Prints the ramp steps whose state changed since states was taken
+static void print_ramp_changes(const int states[RAMP_MAX_STEPS]) {
+    char line[RAMP_DESCRIBE_LENGTH];
+    for (int i = 0; i < ramp.count; i++) {
+        if (ramp.steps[i].state == states[i]) continue;
+        ramp_describe(&ramp.steps[i], line, sizeof(line));
+        printf(DIRETTORE_PREFIX " Ramp step %d: %s\n", i + 1, line);
+    }
+}
+
+static void save_ramp_states(int states[RAMP_MAX_STEPS]) {
+    for (int i = 0; i < ramp.count; i++) states[i] = ramp.steps[i].state;
+}
+
+// Answers every poste_ramp request waiting on the new_users queue
+void check_ramp_queue(mq_id qid) {
+    ramp_request req;
+    while (mq_receive(qid, MSG_TYPE_RAMP_REQUEST, &req, sizeof(req), IPC_NOWAIT) >= 0) {
+        ramp_reply reply;
+        reply.first = -1;
+        if (req.kind == RAMP_SUBMIT) {
+            reply.first = req.count > 0 && req.count <= RAMP_MAX_STEPS ?
+                          ramp_submit(&ramp, req.steps, req.count) : -1;
+            if (reply.first < 0) {
+                printf(DIRETTORE_PREFIX " Ramp: %d steps from PID %d refused, the schedule is full\n",
+                       req.count, req.sender_pid);
+            } else {
+                printf(DIRETTORE_PREFIX " Ramp: %d steps submitted by PID %d\n", req.count, req.sender_pid);
+            }
+        }
+        reply.schedule = ramp;
+
+        if (mq_send(qid, req.sender_pid, &reply, sizeof(reply)) < 0) {
+            perror("mq_send ramp reply");
+        }
+    }
+    if (errno != ENOMSG && errno != EINTR) perror("mqreceive ramp");
+}
+
+// Spawns the users of the ramp steps due at minute now of the run
+void ramp_tick(children_table *children, int now) {
+    int states[RAMP_MAX_STEPS];
+    save_ramp_states(states);
+    int spawns = ramp_spawns(&ramp, now, g_config.ramp_spawn_rate);
+    for (int i = 0; i < spawns; i++) {
+        spawn_joining_user(children, now % 1440);
+    }
+    print_ramp_changes(states);
+}
+
+// Asks the most recently added users to leave, LIFO keeps the indexes of the
+// users still there from 0 to num_users - 1. They are waiting for the day
+// that starts, not counted in its events any more.
+static int retire_users(children_table *children, int count) {
+    int retired = 0;
+    for (int i = children->count - 1; i >= 0 && retired < count; i--) {
+        child *c = &children->list[i];
+        if (c->type != UTENTE || !c->alive || c->retiring) continue;
+        c->retiring = true;
+        kill(c->pid, SIGUSR1);
+        retired++;
+    }
+    g_config.num_users -= retired;
+    return retired;
+}
+
+// At the start of a day, before the users are told: the users of the retire
+// steps due leave
+void ramp_new_day(children_table *children, int now) {
+    int states[RAMP_MAX_STEPS];
+    save_ramp_states(states);
+    int retire = ramp_retirements(&ramp, now, g_config.num_users);
+    if (retire > 0) {
+        int retired = retire_users(children, retire);
+        printf(DIRETTORE_PREFIX " Ramp: retired %d users (now %d users)\n", retired, g_config.num_users);
+    }
+    print_ramp_changes(states);
+}
+
+// Function that checks if an operator pid is sitting at a seat
+static bool is_seated(poste_stations *shared_stations, pid_t pid) {
+    for (int i = 0; i < g_config.num_worker_seats; i++) {
+        if (shared_stations->NOF_WORKER_SEATS[i].operator_status == OCCUPIED &&
+            shared_stations->NOF_WORKER_SEATS[i].operator_process == pid) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Spawns an operator for a service, joining the poste that is already open
+static void spawn_operator(children_table *children, int service_id) {
+    char service_arg[16];
+    snprintf(service_arg, sizeof(service_arg), "%d", service_id);
+    const char *args[] = { "--service", service_arg, "--join", NULL };
+
+    pid_t pid = add_child(children, OPERATORE, args);
+    g_config.num_operators++;
+
+    printf(DIRETTORE_PREFIX " Autoscaler: added operator %d for %s (now %d operators)\n",
+           pid, services[service_id], g_config.num_operators);
+}
+
+// Asks an operator to leave after its current ticket, idle ones first
+static bool retire_operator(children_table *children, poste_stations *shared_stations) {
+    int victim = -1;
+
+    seat_queue_lock(shared_stations);
+    for (int i = children->count - 1; i >= 0; i--) {
+        child *c = &children->list[i];
+        if (c->type != OPERATORE || !c->alive || c->retiring) continue;
+
+        if (!is_seated(shared_stations, c->pid)) {
+            victim = i;
+            break;
+        }
+        if (victim == -1) victim = i; // Most recent seated operator as fallback
+    }
+    shm_mutex_unlock(&shared_stations->stations_lock);
+
+    if (victim == -1) return false;
+
+    children->list[victim].retiring = true;
+    kill(children->list[victim].pid, SIGUSR1);
+    g_config.num_operators--;
+
+    printf(DIRETTORE_PREFIX " Autoscaler: retired operator %d (now %d operators)\n",
+           children->list[victim].pid, g_config.num_operators);
+    return true;
+}
 
-    // Ensure folder exists
-    struct stat st = {0};
-    if (stat(CSV_FILE_PATH, &st) == -1) {
-        if (mkdir(CSV_FILE_PATH, 0755) == -1) {
-            perror("mkdir for CSV_FILE_PATH");
-            return;
+// Clears the per-day baselines of the autoscaler, the daily counters restart from 0
+void autoscaler_new_day(autoscaler *scaler, int late_users_yesterday) {
+    scaler->previous_day_late = late_users_yesterday;
+    memset(scaler->last_failed, 0, sizeof(scaler->last_failed));
+}
+
+// Function that adds or retires operators based on live queue pressure.
+// Called once per open minute: a service whose users pile up (more than
+// autoscale_queue_high per staffed seat), that failed requests since the last
+// decision, or a previous day close to explode_max, gets a new operator if it
+// has an unstaffed seat. With nothing waiting and nothing failing, one
+// operator is retired. Decisions are spaced by autoscale_cooldown minutes.
+void autoscale_operators(poste_stats *shared_stats, poste_stations *shared_stations,
+                         children_table *children, autoscaler *scaler, int now) {
+    scaler->operator_minutes += g_config.num_operators;
+    scaler->open_minutes++;
+
+    if (now - scaler->last_decision < g_config.autoscale_cooldown) return;
+
+    struct S_stats_snapshot snap;
+    stats_snapshot(shared_stats, &snap);
+
+    int staffed[NUM_SERVICE_TYPES] = {0};
+    int free_seats[NUM_SERVICE_TYPES] = {0};
+    seat_queue_lock(shared_stations);
+    for (int i = 0; i < g_config.num_worker_seats; i++) {
+        worker_seat *seat = &shared_stations->NOF_WORKER_SEATS[i];
+        if (seat->operator_status == OCCUPIED) staffed[seat->service_id]++;
+        else free_seats[seat->service_id]++;
+    }
+    shm_mutex_unlock(&shared_stations->stations_lock);
+
+    // Late users close to the explode threshold: any queue is worth a new operator
+    bool late_pressure = scaler->previous_day_late * 2 > g_config.explode_max;
+
+    int total_waiting = 0, total_failed = 0;
+    int best = -1;
+    double best_score = 0.0;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        int waiting = snap.waiting_users[s];
+        int failed  = snap.today.services[s].failed_services - scaler->last_failed[s];
+        int seats   = staffed[s] > 0 ? staffed[s] : 1;
+        total_waiting += waiting;
+        total_failed  += failed;
+
+        bool pressured = waiting >= g_config.autoscale_queue_high * seats ||
+                         failed > 0 ||
+                         (late_pressure && waiting > 0);
+        if (!pressured || free_seats[s] == 0) continue;
+
+        double score = (double)waiting / (staffed[s] + 1) + failed;
+        if (best == -1 || score > best_score) {
+            best = s;
+            best_score = score;
         }
     }
 
-    do {
-        if (counter == 0)
-            snprintf(filename, sizeof(filename), "%sfinal_stats.csv", CSV_FILE_PATH);
-        else
-            snprintf(filename, sizeof(filename), "%sfinal_stats_%d.csv", CSV_FILE_PATH, counter);
+    bool decided = false;
+    if (best != -1 && g_config.num_operators < g_config.autoscale_max_operators) {
+        spawn_operator(children, best);
+        scaler->spawned++;
+        decided = true;
+    } else if (total_waiting == 0 && total_failed == 0 && !late_pressure &&
+               g_config.num_operators > g_config.autoscale_min_operators) {
+        decided = retire_operator(children, shared_stations);
+        if (decided) scaler->retired++;
+    }
 
-        fp = fopen(filename, "r");
-        if (fp) {
-            fclose(fp);
-            counter++;
+    if (decided) {
+        scaler->last_decision = now;
+        for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+            scaler->last_failed[s] = snap.today.services[s].failed_services;
         }
-    } while (fp != NULL);
+    }
+
+    if (g_config.num_operators < scaler->min_operators) scaler->min_operators = g_config.num_operators;
+    if (g_config.num_operators > scaler->max_operators) scaler->max_operators = g_config.num_operators;
+}
+
+// Accounts the open minutes in (from, to) jumped over by the time warp
+void autoscaler_skip(autoscaler *scaler, int from, int to) {
+    int open  = g_config.worker_shift_open * 60;
+    int close = g_config.worker_shift_close * 60;
+    for (int minute = from + 1; minute < to; minute++) {
+        if (minute >= open && minute < close) {
+            scaler->operator_minutes += g_config.num_operators;
+            scaler->open_minutes++;
+        }
+    }
+}
+
+void print_autoscaler_stats(autoscaler *scaler) {
+    printf("\n" DIRETTORE_PREFIX " === Autoscaler ===\n");
+    PRINT_STAT("Operators spawned",  scaler->spawned);
+    PRINT_STAT("Operators retired",  scaler->retired);
+    PRINT_STAT("Min operators",      scaler->min_operators);
+    PRINT_STAT("Max operators",      scaler->max_operators);
+    PRINT_FLOAT_STAT("Avg operators during open hours", scaler->operator_minutes, scaler->open_minutes);
+}
 
-    fp = fopen(filename, "w");
-    if (!fp) {
-        perror("fopen for stats CSV");
+// Longest queue of each service and the hour with the most users waiting
+void print_queue_peaks(const sample_summary *queues) {
+    printf("\n" DIRETTORE_PREFIX " === Queue Peaks ===\n");
+    if (queues->drained == 0) {
+        printf(DIRETTORE_PREFIX " No samples (sample_interval=0)\n");
         return;
     }
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        if (queues->peak_waiting[s] == 0) continue;
+        printf(DIRETTORE_PREFIX " %-40s %3d waiting on day %d at %02d:%02d with %d seats staffed\n",
+               services[s], queues->peak_waiting[s], queues->peak_day[s],
+               queues->peak_minute[s] / 60, queues->peak_minute[s] % 60, queues->peak_staffed[s]);
+    }
+
+    int peak = sampler_peak_hour(queues);
+    printf(DIRETTORE_PREFIX " Peak hour %02d:00-%02d:00: %.2f users waiting, %.2f seats staffed on average\n",
+           peak, peak + 1,
+           queues->hour_waiting[peak] / queues->hour_samples[peak],
+           queues->hour_staffed[peak] / queues->hour_samples[peak]);
+    if (queues->lost > 0) {
+        printf(DIRETTORE_PREFIX " %u samples overwritten before they were written\n", queues->lost);
+    }
+}
+
+// Number of regions the branches are grouped in
+int network_regions(void) {
+    return branch_region(g_config.num_branches - 1, g_config.num_branches, g_config.num_regions) + 1;
+}
+
+// Whole-run totals of the branches of a region, returns how many branches it has
+int region_totals(branch_office branches[], int region, service_stats *total) {
+    int count = 0;
+    *total = (service_stats){0};
+    for (int b = 0; b < g_config.num_branches; b++) {
+        if (branch_region(b, g_config.num_branches, g_config.num_regions) != region) continue;
+        const service_stats *global = &branches[b].stats->simulation_global;
+        total->served_users       += global->served_users;
+        total->failed_services    += global->failed_services;
+        total->total_wait_time    += global->total_wait_time;
+        total->total_service_time += global->total_service_time;
+        total->total_requests     += global->total_requests;
+        total->late_users         += global->late_users;
+        count++;
+    }
+    return count;
+}
+
+// Served, failed and late users of each branch, then of each region
+void print_branch_stats(branch_office branches[]) {
+    printf("\n" DIRETTORE_PREFIX " === Branches (%s routing) ===\n",
+           branch_routing_names[g_config.branch_routing]);
+    for (int b = 0; b < g_config.num_branches; b++) {
+        const poste_stats *stats = branches[b].stats;
+        printf(DIRETTORE_PREFIX " Branch %d (region %d): %d operators, %d users homed, %d served, %d failed, %d late, p90 seat wait %d min\n",
+               b, branch_region(b, g_config.num_branches, g_config.num_regions),
+               branch_operators(b, g_config.num_operators, g_config.num_branches),
+               branch_users(b, g_config.num_users, g_config.num_branches),
+               stats->simulation_global.served_users, stats->simulation_global.failed_services,
+               stats->simulation_global.late_users, stats_wait_percentile(stats->wait_histogram, 0.90));
+    }
+    for (int r = 0; r < network_regions(); r++) {
+        service_stats total;
+        int count = region_totals(branches, r, &total);
+        printf(DIRETTORE_PREFIX " Region %d: %d branches, %d served, %d failed, %d late\n",
+               r, count, total.served_users, total.failed_services, total.late_users);
+    }
+}
+
+// Function that write stats to a CSV file
+// Writes name,w1 w2 ... or name,unset when no weight was given
+static void write_weights(FILE *fp, const char *name, const int weights[], int n, const char *unset) {
+    fprintf(fp, "%s,", name);
+    if (n == 0) fprintf(fp, "%s", unset);
+    for (int i = 0; i < n; i++) fprintf(fp, i > 0 ? " %d" : "%d", weights[i]);
+    fprintf(fp, "\n");
+}
+
+void write_stats(poste_stats *shared_stats, autoscaler *scaler, warp_stats *warp, const tick_stats *ticks, int days_run,
+                 const lock_counters locks[NUM_SHM_LOCKS], const role_usage roles[NUM_ROLES],
+                 const sample_summary *queues, branch_office branches[],
+                 const struct S_lag_histogram lag[NUM_ACTOR_ROLES]) {
+    char filename[MAX_PATH_LENGTH + 32];
+    FILE *fp = open_csv("final_stats", filename, sizeof(filename));
+    if (!fp) return;
 
     // --- Write simulation summary ---
     // Determine exit mode
@@ -260,12 +1199,21 @@ void write_stats(poste_stats *shared_stats) {
     fprintf(fp, "ExitMode,%s\n", exit_mode);
     fprintf(fp, "ConfigFile,%s\n", shared_stats->configuration_file);
     fprintf(fp, "SimDuration(days),%d\n", g_config.sim_duration);
+    fprintf(fp, "DaysRun,%d\n", days_run);
     fprintf(fp, "MinuteDuration(ns),%ld\n", g_config.minute_duration);
     fprintf(fp, "NumOperators,%d\n", g_config.num_operators);
     fprintf(fp, "NumUsers,%d\n", g_config.num_users);
     fprintf(fp, "NumWorkerSeats,%d\n", g_config.num_worker_seats);
+    fprintf(fp, "NumBranches,%d\n", g_config.num_branches);
+    fprintf(fp, "NumRegions,%d\n", network_regions());
+    fprintf(fp, "BranchRouting,%s\n", branch_routing_names[g_config.branch_routing]);
+    fprintf(fp, "TicketBundle,%d\n", g_config.ticket_bundle);
     fprintf(fp, "WorkerShiftOpen(hour),%d\n", g_config.worker_shift_open);
     fprintf(fp, "WorkerShiftClose(hour),%d\n", g_config.worker_shift_close);
+    write_weights(fp, "ArrivalProfile", g_config.arrival_profile, g_config.num_profile_hours, "flat");
+    bool mix_set = false;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) mix_set |= g_config.service_mix[s] > 0;
+    write_weights(fp, "ServiceMix", g_config.service_mix, mix_set ? NUM_SERVICE_TYPES : 0, "equal");
     fprintf(fp, "ExplodeMaxLateUsers,%d\n", g_config.explode_max);
     fprintf(fp, "\n");
 
@@ -306,34 +1254,230 @@ void write_stats(poste_stats *shared_stats) {
     fprintf(fp, "TotalWaitTime,%.2f\n", (float)shared_stats->simulation_global.total_wait_time);
     fprintf(fp, "TotalServiceTime,%.2f\n", (float)shared_stats->simulation_global.total_service_time);
 
+    fprintf(fp, "\nSeatPolicy\n");
+    fprintf(fp, "Policy,%s\n", seat_policy_names[g_config.seat_policy]);
+    fprintf(fp, "ExpectedServedPerDay,%.2f\n",
+            seat_report.days > 0 ? seat_report.expected_served / seat_report.days : 0.0);
+    fprintf(fp, "ExpectedServedPerDayRandom,%.2f\n",
+            seat_report.days > 0 ? seat_report.expected_served_random / seat_report.days : 0.0);
+
+    // --- Write the ticket-to-seat wait distribution ---
+    fprintf(fp, "\nSeatWait\n");
+    fprintf(fp, "Requests,%d\n", stats_wait_count(shared_stats->wait_histogram));
+    fprintf(fp, "P50(minutes),%d\n", stats_wait_percentile(shared_stats->wait_histogram, 0.50));
+    fprintf(fp, "P90(minutes),%d\n", stats_wait_percentile(shared_stats->wait_histogram, 0.90));
+    fprintf(fp, "P99(minutes),%d\n", stats_wait_percentile(shared_stats->wait_histogram, 0.99));
+    fprintf(fp, "Max(minutes),%d\n", stats_wait_percentile(shared_stats->wait_histogram, 1.0));
+
+    // --- Write seat and operator utilization over the run ---
+    const struct S_utilization *usage = &shared_stats->simulation_usage;
+    double open_minutes = (double)days_run * shift_minutes();
+    fprintf(fp, "\nSeatUtilization\n");
+    fprintf(fp, "Seat,BusyMinutes,SeatedMinutes,Services,BusyPctOfOpening\n");
+    for (int i = 0; i < g_config.num_worker_seats && i < MAX_WORKER_SEATS; i++) {
+        fprintf(fp, "%d,%.2f,%.2f,%d,%.2f\n", i,
+                usage->seats[i].busy_minutes, usage->seats[i].seated_minutes, usage->seats[i].services,
+                utilization_percent(usage->seats[i].busy_minutes, open_minutes));
+    }
+
+    fprintf(fp, "\nOperatorUtilization\n");
+    fprintf(fp, "Pid,Service,BusyMinutes,SeatedMinutes,Services,BusyPctOfSeated\n");
+    for (int i = 0; i < MAX_OPERATOR_STATES && usage->operators[i].pid != 0; i++) {
+        const operator_utilization *op = &usage->operators[i];
+        fprintf(fp, "%d,%s,%.2f,%.2f,%d,%.2f\n", op->pid, services[op->service],
+                op->busy_minutes, op->seated_minutes, op->services,
+                utilization_percent(op->busy_minutes, op->seated_minutes));
+    }
+
+    // --- Write when the queues peak, from the samples ---
+    fprintf(fp, "\nQueuePeaks\n");
+    fprintf(fp, "Service,PeakWaiting,Day,Minute,StaffedSeatsAtPeak\n");
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        fprintf(fp, "%s,%d,%d,%d,%d\n", services[s], queues->peak_waiting[s],
+                queues->peak_day[s], queues->peak_minute[s], queues->peak_staffed[s]);
+    }
+
+    fprintf(fp, "\nHourlyQueue\n");
+    fprintf(fp, "Hour,AvgWaiting,AvgStaffedSeats,Samples\n");
+    for (int h = 0; h < 24; h++) {
+        if (queues->hour_samples[h] == 0) continue;
+        fprintf(fp, "%d,%.2f,%.2f,%d\n", h,
+                queues->hour_waiting[h] / queues->hour_samples[h],
+                queues->hour_staffed[h] / queues->hour_samples[h],
+                queues->hour_samples[h]);
+    }
+
+    fprintf(fp, "\nTimeWarp\n");
+    fprintf(fp, "Enabled,%d\n", g_config.time_warp);
+    fprintf(fp, "FastForwardClosed,%d\n", g_config.fast_forward_closed);
+    fprintf(fp, "Jumps,%d\n", warp->jumps);
+    fprintf(fp, "SkippedMinutes,%d\n", warp->skipped_minutes);
+    fprintf(fp, "WallTime(s),%.3f\n", warp->wall_seconds);
+
+    unsigned long long messages = shared_stats->messages_sent; // Summed over the branches
+    fprintf(fp, "\nRuntime\n");
+    fprintf(fp, "Ticks,%lld\n", ticks->ticks);
+    fprintf(fp, "AvgTickLateness(us),%.1f\n", ticks->ticks > 0 ? ticks->total_lateness_us / ticks->ticks : 0.0);
+    fprintf(fp, "P99TickLateness(us),%.0f\n", tick_percentile_us(ticks, 0.99));
+    fprintf(fp, "MaxTickLateness(us),%.1f\n", ticks->max_lateness_us);
+    fprintf(fp, "LateTicks,%lld\n", ticks->late_ticks);
+    fprintf(fp, "MessagesSent,%llu\n", messages);
+    fprintf(fp, "MessagesPerSecond,%.1f\n", warp->wall_seconds > 0 ? messages / warp->wall_seconds : 0.0);
+
+    fprintf(fp, "\nSchedulingLag\n");
+    fprintf(fp, "Role,Wakeups,AvgLag(us),P50Lag(us),P99Lag(us),MaxLag(us),LateWakeups\n");
+    for (int r = 0; r < NUM_ACTOR_ROLES; r++) {
+        const struct S_lag_histogram *l = &lag[r];
+        fprintf(fp, "%s,%llu,%.1f,%.0f,%.0f,%.1f,%llu\n", ROLE_NAMES[r], l->samples,
+                l->samples > 0 ? l->total_ns / 1e3 / l->samples : 0.0,
+                sim_lag_percentile_us(l, 0.50), sim_lag_percentile_us(l, 0.99), l->max_ns / 1e3, l->late);
+    }
+
+    fprintf(fp, "\nLocks\n");
+    fprintf(fp, "Lock,Acquisitions,Contended,Sleeps,Recoveries\n");
+    for (int i = 0; i < NUM_SHM_LOCKS; i++) {
+        fprintf(fp, "%s,%llu,%llu,%llu,%llu\n", LOCK_NAMES[i], locks[i].acquisitions,
+                locks[i].contended, locks[i].sleeps, locks[i].recoveries);
+    }
+
+    // --- Write the stats of each branch, then of each region ---
+    fprintf(fp, "\nBranches\n");
+    fprintf(fp, "Branch,Region,Operators,Users,ServedUsers,FailedServices,LateUsers,AvgGeneralWaitTime,SeatWaitP90(minutes),MessagesSent\n");
+    for (int b = 0; b < g_config.num_branches; b++) {
+        const poste_stats *stats = branches[b].stats;
+        const service_stats *global = &stats->simulation_global;
+        fprintf(fp, "%d,%d,%d,%d,%d,%d,%d,%.2f,%d,%llu\n", b,
+                branch_region(b, g_config.num_branches, g_config.num_regions),
+                branch_operators(b, g_config.num_operators, g_config.num_branches),
+                branch_users(b, g_config.num_users, g_config.num_branches),
+                global->served_users, global->failed_services, global->late_users,
+                global->total_requests > 0 ? global->total_wait_time / global->total_requests : 0.0,
+                stats_wait_percentile(stats->wait_histogram, 0.90),
+                __atomic_load_n(&stats->messages_sent, __ATOMIC_RELAXED));
+    }
+
+    fprintf(fp, "\nRegions\n");
+    fprintf(fp, "Region,Branches,ServedUsers,FailedServices,LateUsers,AvgGeneralWaitTime\n");
+    for (int r = 0; r < network_regions(); r++) {
+        service_stats total;
+        int count = region_totals(branches, r, &total);
+        fprintf(fp, "%d,%d,%d,%d,%d,%.2f\n", r, count, total.served_users, total.failed_services,
+                total.late_users, total.total_requests > 0 ? total.total_wait_time / total.total_requests : 0.0);
+    }
+
+    fprintf(fp, "\nProcessUsage\n");
+    fprintf(fp, "Role,Processes,UserSeconds,SysSeconds,CpuMsPerProcess,MaxRssKB,AvgMaxRssKB,"
+                "VoluntarySwitches,InvoluntarySwitches,Samples,PeakAlive,PeakRssKB,PeakCpuPercent\n");
+    for (int r = 0; r < NUM_ROLES; r++) {
+        const role_usage *u = &roles[r];
+        fprintf(fp, "%s,%d,%.3f,%.3f,%.2f,%ld,%.0f,%lld,%lld,%d,%d,%lld,%.1f\n", ROLE_NAMES[r],
+                u->processes, u->user_seconds, u->sys_seconds, role_usage_cpu_ms_per_process(u),
+                u->max_rss_kb, role_usage_avg_rss_kb(u), u->voluntary_switches, u->involuntary_switches,
+                u->samples, u->peak_alive, u->peak_rss_kb, u->peak_cpu_percent);
+    }
+
+    if (g_config.trace_file[0] != '\0') {
+        fprintf(fp, "\nTrace\n");
+        fprintf(fp, "Source,%s\n", trace_source);
+        fprintf(fp, "Arrivals,%d\n", trace_report.records);
+        fprintf(fp, "Days,%d\n", trace_report.days);
+        fprintf(fp, "FirstDay,%d\n", trace_report.first_day);
+        fprintf(fp, "BusiestDay,%d\n", trace_report.busiest_day);
+        fprintf(fp, "BusiestDayArrivals,%d\n", trace_report.busiest_records);
+        fprintf(fp, "Users,%d\n", g_config.trace_users);
+        fprintf(fp, "AfterClosing,%d\n", trace_after_closing);
+        fprintf(fp, "SkippedLines,%d\n", trace_report.skipped_lines);
+        fprintf(fp, "DelayedArrivals,%d\n", shared_stats->trace_delayed);
+        fprintf(fp, "AvgDelay(minutes),%.2f\n", shared_stats->trace_delayed > 0 ?
+                (double)shared_stats->trace_delay_minutes / shared_stats->trace_delayed : 0.0);
+    }
+
+    if (ramp.count > 0) {
+        fprintf(fp, "\nRamp\n");
+        fprintf(fp, "SpawnRate(users/minute),%d\n", g_config.ramp_spawn_rate);
+        fprintf(fp, "Step,Day,Minute,Users,Over(minutes),State,Done,StartedDay,StartedMinute,FinishedDay,FinishedMinute\n");
+        for (int i = 0; i < ramp.count; i++) {
+            const struct S_ramp_status *st = &ramp.steps[i];
+            fprintf(fp, "%d,%d,%d,%d,%d,%s,%d,%d,%d,%d,%d\n", i + 1, st->step.day, st->step.minute,
+                    st->step.users, st->step.over, ramp_state_names[st->state], st->done,
+                    st->started >= 0 ? st->started / 1440 : -1, st->started >= 0 ? st->started % 1440 : -1,
+                    st->finished >= 0 ? st->finished / 1440 : -1, st->finished >= 0 ? st->finished % 1440 : -1);
+        }
+        fprintf(fp, "UsersSpawned,%d\n", ramp.spawned);
+        fprintf(fp, "UsersRetired,%d\n", ramp.retired);
+    }
+
+    if (g_config.autoscale) {
+        fprintf(fp, "\nAutoscaler\n");
+        fprintf(fp, "MinOperatorsBound,%d\n", g_config.autoscale_min_operators);
+        fprintf(fp, "MaxOperatorsBound,%d\n", g_config.autoscale_max_operators);
+        fprintf(fp, "Cooldown(minutes),%d\n", g_config.autoscale_cooldown);
+        fprintf(fp, "OperatorsSpawned,%d\n", scaler->spawned);
+        fprintf(fp, "OperatorsRetired,%d\n", scaler->retired);
+        fprintf(fp, "MinOperators,%d\n", scaler->min_operators);
+        fprintf(fp, "MaxOperators,%d\n", scaler->max_operators);
+        fprintf(fp, "AvgOperatorsOpenHours,%.2f\n",
+                scaler->open_minutes > 0 ? (float)scaler->operator_minutes / scaler->open_minutes : 0.0f);
+    }
+
     fclose(fp);
     printf(DIRETTORE_PREFIX " Statistics written to %s\n", filename);
 }
 
 #ifndef UNIT_TEST
+static volatile sig_atomic_t reload_requested = 0;
+
+static void on_reload(int sig) {
+    (void)sig;
+    reload_requested = 1;
+}
+
 int main(const int argc, const char *argv[]) {
     char *config_file = NULL;
-    if (argc > 1) {
-        if (strcmp(argv[1], "--config") == 0 && argc == 3) {
-            config_file = (char *)argv[2];
+    const char *resume_file = NULL;
+    int resume_days = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            config_file = (char *)argv[++i];
+        } else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+            resume_file = argv[++i];
+        } else if (strcmp(argv[i], "--days") == 0 && i + 1 < argc) {
+            resume_days = atoi(argv[++i]); // Extends a resumed run
         }
     }
 
-    int open_shm[2];
+    checkpoint resume = {0};
+    struct S_director_checkpoint resume_director = {0};
+    if (resume_file != NULL &&
+        !checkpoint_read(resume_file, &resume, &resume_director, sizeof(resume_director))) {
+        fprintf(stderr, DIRETTORE_PREFIX " Cannot resume from %s: missing or incompatible checkpoint\n",
+                resume_file);
+        return 1;
+    }
+
+    int open_shm[5 + 2 * MAX_BRANCHES];
     int open_shm_index = 0;
 
-    key_t key_ticket = ftok(KEY_TICKET_MSG, PROJ_ID);
-    if (key_ticket == -1) { perror("ftok"); return 1; }
+    key_t key_ticket = poste_key(KEY_TICKET_MSG, PROJ_ID);
+    if (key_ticket == -1) { perror("poste_key"); return 1; }
     mq_id qid_ticket = mq_open(key_ticket, IPC_CREAT, 0666);
 
-    key_t key = ftok(KEY_NEW_USERS, proj_ID_USERS);
-    if (key == -1) { perror("ftok"); return 1; }
+    key_t key = poste_key(KEY_NEW_USERS, proj_ID_USERS);
+    if (key == -1) { perror("poste_key"); return 1; }
     mq_id qid = mq_open(key, IPC_CREAT, 0666);
     if (qid < 0) {
         perror("mq_open");
         return 1;
     }
 
+    if (resume_file != NULL) {
+        // Messages left by the crashed run would reach the new actors
+        mq_close(qid_ticket);
+        mq_close(qid);
+        qid_ticket = mq_open(key_ticket, IPC_CREAT, 0666);
+        qid = mq_open(key, IPC_CREAT, 0666);
+    }
+
     printf(DIRETTORE_PREFIX "Add_Users message queue running on queue %d \n", qid);
 
     poste_stats    *shared_stats;
@@ -342,7 +1486,9 @@ int main(const int argc, const char *argv[]) {
     int minutes_elapsed = 0;
     int days_elapsed    = 0;
 
-    srand(getpid() * time(NULL));
+    unsigned int seed = getpid() * time(NULL);
+    if (resume_file != NULL) seed = resume.seed;
+    srand(seed);
 
     shared_stats = init_shared_memory(SHM_STATS_NAME,
                                          SHM_STATS_SIZE,
@@ -352,98 +1498,334 @@ int main(const int argc, const char *argv[]) {
                                          SHM_STATIONS_SIZE,
                                          open_shm,
                                          &open_shm_index);
+    mq_count_sends(&shared_stats->messages_sent);
+
+    if (resume_file != NULL) {
+        checkpoint_restore(&resume, shared_stats, shared_stations);
+        days_elapsed = resume.day;
+    }
 
     // Initialize semaphores...
-    sem_init(&shared_stats->stats_lock,       1, 1);
+    shm_mutex_init(&shared_stats->stats_lock);
     sem_init(&shared_stats->open_poste_event, 1, 0);
     sem_init(&shared_stats->close_poste_event,1, 0);
     sem_init(&shared_stats->day_update_event, 1, 0);
-    sem_init(&shared_stations->stations_lock, 1, 1);
-    sem_init(&shared_stations->stations_event,1, 0);
-    sem_init(&shared_stations->stations_freed_event,1,0);
-
-    load_config(config_file);
-    if (config_file != NULL) {
-        sem_wait(&shared_stats->stats_lock);
+    shm_mutex_init(&shared_stations->stations_lock);
+
+    if (resume_file != NULL) {
+        // Config of the checkpoint, the file path comes with the stats image
+        g_config = resume.config;
+        if (resume_days > 0) g_config.sim_duration = resume_days;
+        printf(DIRETTORE_PREFIX " Resuming from %s after day %d of %d\n",
+               resume_file, resume.day, g_config.sim_duration);
+    } else {
+        load_config(config_file);
+    }
+    if (config_file != NULL && resume_file == NULL) {
+        shm_mutex_lock(&shared_stats->stats_lock);
         for (int i = 0; i < MAX_PATH_LENGTH && config_file[i] != '\0'; i++) {
             shared_stats->configuration_file[i] = config_file[i];
         }
         shared_stats->configuration_file[strlen(config_file)] = '\0';
-        sem_post(&shared_stats->stats_lock);
+        shm_mutex_unlock(&shared_stats->stats_lock);
     }
+    shared_stats->branch = 0;
+    if (g_config.trace_file[0] != '\0' && !prepare_trace()) return 1;
     
-    pid_t *children = malloc(sizeof(int) * (1 + g_config.num_operators + g_config.num_users));
-    int idx = 0;
+    struct S_config_segment *config_segment = config_shm_create(open_shm, &open_shm_index);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_reload;
+    sigaction(SIGHUP, &sa, NULL);
 
-    struct timespec t1 = { .tv_sec = 0, .tv_nsec = g_config.minute_duration };
-    struct timespec t2;
+    struct S_sim_clock *sim_clock = sim_clock_create(g_config.time_warp, g_config.fast_forward_closed,
+                                                     open_shm, &open_shm_index);
 
-    children[idx++] = start_process(TICKET);
+    struct S_sample_ring *sampler = sampler_create(g_config.sample_interval, open_shm, &open_shm_index);
+
+    // Branch 0 is the office above, the others get segments and queues of their own
+    if (g_config.num_branches > 1 && (g_config.autoscale || g_config.checkpoint)) {
+        printf(DIRETTORE_PREFIX " Autoscale and checkpoints handle one branch, off with %d branches\n",
+               g_config.num_branches);
+        g_config.autoscale  = 0;
+        g_config.checkpoint = 0;
+    }
+    branch_office branches[MAX_BRANCHES] = {
+        { shared_stats, shared_stations, qid_ticket, 0, 1 }
+    };
+    for (int b = 1; b < g_config.num_branches; b++) {
+        char name[64];
+        branch_office *office = &branches[b];
+        branch_shm_name(SHM_STATS_NAME, b, name, sizeof(name));
+        office->stats_shm = open_shm_index;
+        office->stats = init_shared_memory(name, SHM_STATS_SIZE, open_shm, &open_shm_index);
+        branch_shm_name(SHM_STATIONS_NAME, b, name, sizeof(name));
+        office->stations_shm = open_shm_index;
+        office->stations = init_shared_memory(name, SHM_STATIONS_SIZE, open_shm, &open_shm_index);
+
+        memset(office->stats, 0, SHM_STATS_SIZE); // Left over by a killed run
+        memset(office->stations, 0, SHM_STATIONS_SIZE);
+        office->stats->branch = b;
+        shm_mutex_init(&office->stats->stats_lock);
+        sem_init(&office->stats->open_poste_event, 1, 0);
+        sem_init(&office->stats->close_poste_event, 1, 0);
+        sem_init(&office->stats->day_update_event, 1, 0);
+        shm_mutex_init(&office->stations->stations_lock);
+
+        key_t branch_key = poste_key(KEY_TICKET_MSG, branch_ticket_proj_id(b));
+        if (branch_key == -1) { perror("poste_key"); return 1; }
+        office->ticket_qid = mq_open(branch_key, IPC_CREAT, 0666);
+        mq_close(office->ticket_qid); // Messages of a killed run would reach the new actors
+        office->ticket_qid = mq_open(branch_key, IPC_CREAT, 0666);
+    }
+    sample_summary queues = {0};
+    sample now;
+    char timeseries_file[MAX_PATH_LENGTH + 32];
+    FILE *timeseries = g_config.sample_interval > 0 ?
+        open_csv("timeseries", timeseries_file, sizeof(timeseries_file)) : NULL;
+
+    children_table children = {0};
+
+    autoscaler scaler = {0};
+    scaler.last_decision = -g_config.autoscale_cooldown;
+    scaler.min_operators = g_config.num_operators;
+    scaler.max_operators = g_config.num_operators;
+    if (resume_file != NULL) {
+        scaler      = resume_director.scaler;
+        seat_report = resume_director.seat_report;
+    }
+
+    char branch_arg[MAX_BRANCHES][16];
+    for (int b = 0; b < g_config.num_branches; b++) {
+        snprintf(branch_arg[b], sizeof(branch_arg[b]), "%d", b);
+        const char *args[] = { "--branch", branch_arg[b], NULL };
+        add_child(&children, TICKET, args);
+    }
     sleep(1);
-    for (int i = 0; i < g_config.num_operators; i++)
-        children[idx++] = start_process(OPERATORE);
+    if (resume_file != NULL) {
+        respawn_operators(&children, &resume);
+    } else {
+        // Dealt in turn, as branch_operators counts them
+        for (int i = 0; i < g_config.num_operators; i++) {
+            const char *args[] = { "--branch", branch_arg[i % g_config.num_branches], NULL };
+            add_child(&children, OPERATORE, args);
+        }
+    }
     for (int i = 0; i < g_config.num_users; i++)
-        children[idx++] = start_process(UTENTE);
+        spawn_user(&children, i, NULL);
 
     printf(DIRETTORE_PREFIX " Waiting for children to start\n");
     sleep(3);
 
+    warp_stats warp = {0};
+    tick_stats ticks = {0};
+    clock_gettime(CLOCK_MONOTONIC, &warp.started);
+    children.last_sample = warp.started;
+
     while (days_elapsed < g_config.sim_duration) {
-        if (nanosleep(&t1, &t2) != 0) {
-            perror("nanosleep");
-            exit(EXIT_FAILURE);
+        // A minute lasts minute_duration, less in time warp once every actor is idle
+        bool closed = minutes_elapsed <  g_config.worker_shift_open * 60 ||
+                      minutes_elapsed >= g_config.worker_shift_close * 60;
+        bool may_jump = g_config.time_warp || (g_config.fast_forward_closed && closed);
+        int next_wake;
+        struct timespec tick_started;
+        clock_gettime(CLOCK_MONOTONIC, &tick_started);
+        bool idle = sim_clock_wait_idle(g_config.minute_duration, may_jump, &next_wake);
+        if (idle && !is_event_minute(minutes_elapsed)) {
+            // Nothing can happen before the next wakeup or director event: jump there
+            int target = next_event_minute(minutes_elapsed);
+            if (next_wake != INT_MAX && next_wake - day_to_minutes(days_elapsed) < target) {
+                target = next_wake - day_to_minutes(days_elapsed);
+            }
+            int ramp_next = ramp_next_minute(&ramp, day_to_minutes(days_elapsed) + minutes_elapsed);
+            if (ramp_next != INT_MAX && ramp_next - day_to_minutes(days_elapsed) < target) {
+                target = ramp_next - day_to_minutes(days_elapsed);
+            }
+
+            if (target - 1 > minutes_elapsed) {
+                if (g_config.autoscale) autoscaler_skip(&scaler, minutes_elapsed, target - 1);
+                sample_branches(&now, days_elapsed, minutes_elapsed, branches);
+                sampler_skip(sampler, &now, minutes_elapsed, target - 1);
+                warp.jumps++;
+                warp.skipped_minutes += target - 1 - minutes_elapsed;
+                minutes_elapsed = target - 1;
+            }
         }
 
         if (minutes_elapsed == g_config.worker_shift_open * 60 && minutes_elapsed != 0) {
-            for (int i = 0; i < g_config.num_operators + g_config.num_users; i++) {
-                sem_post(&shared_stats->open_poste_event);
+            for (int b = 0; b < g_config.num_branches; b++) {
+                int actors = branch_actors(b, false);
+                sim_expect_wakeups(actors);
+                post_event(&branches[b].stats->open_poste_event, actors);
             }
         }
 
         if (minutes_elapsed == g_config.worker_shift_close * 60 && minutes_elapsed != 0) {
-            for (int i = 0; i < g_config.num_operators; i++) {
-                sem_post(&shared_stats->close_poste_event);
-            }   
+            // Polled by the operators, nobody blocks on it
+            for (int b = 0; b < g_config.num_branches; b++) {
+                post_event(&branches[b].stats->close_poste_event, branch_actors(b, true));
+            }
         }
 
         if (minutes_elapsed % 1440 == 0) {
             days_elapsed++;
+            sampler_drain(sampler, timeseries, &queues);
 
-            if (shared_stats->today.late_users > g_config.explode_max) {
+            if (network_late_users(branches) > g_config.explode_max) {
                 printf(DIRETTORE_PREFIX " Too many late users today, exploding!\n");
                 break;
             }
 
-            start_new_day(days_elapsed, shared_stats, shared_stations);
+            if (g_config.checkpoint && days_elapsed > 1 && days_elapsed - 1 != resume.day) {
+                struct S_director_checkpoint director = { .scaler = scaler, .seat_report = seat_report };
+                write_checkpoint(days_elapsed - 1, seed, shared_stats, shared_stations, &director);
+            }
+            srand(seed + days_elapsed); // Same draws from here on when resumed
+
+            // A SIGHUP waits for the day to end: the director and the actors,
+            // which refresh their config as the day starts, switch together
+            if (reload_requested) {
+                reload_requested = 0;
+                reload_config(shared_stats);
+                sampler->interval = g_config.sample_interval;
+            }
+
+            autoscaler_new_day(&scaler, shared_stats->today.late_users);
+            for (int b = 0; b < g_config.num_branches; b++) {
+                if (g_config.num_branches > 1) printf(DIRETTORE_PREFIX " --- Branch %d ---\n", b);
+                start_new_day(days_elapsed, branches[b].stats, branches[b].stations);
+            }
+            ramp_new_day(&children, day_to_minutes(days_elapsed));
+            for (int b = 0; b < g_config.num_branches; b++) {
+                int actors = branch_actors(b, false);
+                sim_expect_wakeups(actors);
+                post_event(&branches[b].stats->day_update_event, actors);
+            }
             minutes_elapsed = 0;
         }
 
-        check_new_users_queue(qid, children, &idx);
+        check_new_users_queue(qid, &children, minutes_elapsed);
+        check_ramp_queue(qid);
+        ramp_tick(&children, day_to_minutes(days_elapsed) + minutes_elapsed);
+
+        if (sampler_due(sampler, minutes_elapsed)) {
+            sample_branches(&now, days_elapsed, minutes_elapsed, branches);
+            sampler_record(sampler, &now);
+        }
+
+        if (g_config.usage_interval > 0 && minutes_elapsed % g_config.usage_interval == 0) {
+            sample_children_usage(&children);
+        }
+
+        reap_children(&children, branches);
+        if (g_config.autoscale) {
+            if (minutes_elapsed >= g_config.worker_shift_open * 60 &&
+                minutes_elapsed <  g_config.worker_shift_close * 60) {
+                autoscale_operators(shared_stats, shared_stations, &children, &scaler,
+                                    day_to_minutes(days_elapsed) + minutes_elapsed);
+            }
+        }
 
         minutes_elapsed++;
-        sem_wait(&shared_stats->stats_lock);
-        shared_stats->current_minute = minutes_elapsed;
-        sem_post(&shared_stats->stats_lock);
+        for (int b = 0; b < g_config.num_branches; b++) {
+            stats_write_begin(branches[b].stats);
+            branches[b].stats->current_minute = minutes_elapsed;
+            stats_write_end(branches[b].stats);
+        }
+        sim_clock_publish(day_to_minutes(days_elapsed) + minutes_elapsed);
+        config_shm_publish(); // New users, autoscaled operators, reloads
+
+        if (!idle) {
+            struct timespec tick_done;
+            clock_gettime(CLOCK_MONOTONIC, &tick_done);
+            tick_record(&ticks, (tick_done.tv_sec - tick_started.tv_sec) * 1000000000LL +
+                                (tick_done.tv_nsec - tick_started.tv_nsec) - g_config.minute_duration);
+        }
     }
 
+    struct timespec finished;
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    warp.wall_seconds = (finished.tv_sec - warp.started.tv_sec) +
+                        (finished.tv_nsec - warp.started.tv_nsec) / 1e9;
+
     // Terminate children and clean up...
-    for (int i = 0; i < idx; i++)
-        kill(children[i], SIGKILL);
-    for (int i = 0; i < idx; i++) {
+    for (int i = 0; i < children.count; i++)
+        if (children.list[i].alive) kill(children.list[i].pid, SIGKILL);
+    for (int i = 0; i < children.count; i++) {
         int status;
-        waitpid(children[i], &status, 0);
+        struct rusage ru;
+        if (children.list[i].alive && wait4(children.list[i].pid, &status, 0, &ru) > 0) {
+            role_usage_add_rusage(&children.usage[children.list[i].type], &ru);
+        }
+    }
+    free(children.list);
+    children.list = NULL;
+    children.count = 0;
+    struct rusage self;
+    getrusage(RUSAGE_SELF, &self);
+    role_usage_add_rusage(&children.usage[DIRECTOR_ROLE], &self);
+
+    sampler_drain(sampler, timeseries, &queues);
+    if (timeseries != NULL) {
+        fclose(timeseries);
+        printf(DIRETTORE_PREFIX " Queue samples written to %s\n", timeseries_file);
     }
 
-    print_final_stats(shared_stats);
-    write_stats(shared_stats);
+    // Totals over the branches, a single branch adds up to itself
+    poste_stats *network = calloc(1, sizeof(poste_stats));
+    if (network == NULL) {
+        perror("calloc network stats");
+        return 1;
+    }
+    lock_counters locks[NUM_SHM_LOCKS] = {0};
+    for (int b = 0; b < g_config.num_branches; b++) {
+        branch_stats_add(network, branches[b].stats);
+        lock_counters branch_locks[NUM_SHM_LOCKS];
+        shm_mutex_counters(&branches[b].stats->stats_lock, &branch_locks[0]);
+        shm_mutex_counters(&branches[b].stations->stations_lock, &branch_locks[1]);
+        for (int i = 0; i < NUM_SHM_LOCKS; i++) {
+            locks[i].acquisitions += branch_locks[i].acquisitions;
+            locks[i].contended    += branch_locks[i].contended;
+            locks[i].sleeps       += branch_locks[i].sleeps;
+            locks[i].recoveries   += branch_locks[i].recoveries;
+        }
+    }
+
+    print_final_stats(network);
+    print_process_usage(children.usage);
+    int days_run = days_elapsed - 1; // The loop stops right after starting the next day
+    print_usage(&network->simulation_usage, (double)days_run * shift_minutes());
+    print_seat_policy_stats();
+    print_warp_stats(&warp);
+    print_runtime_stats(&ticks, network->messages_sent, warp.wall_seconds);
+    print_lag_stats(sim_clock->lag);
+    print_lock_stats(locks);
+    print_queue_peaks(&queues);
+    if (g_config.num_branches > 1) print_branch_stats(branches);
+    if (g_config.autoscale) print_autoscaler_stats(&scaler);
+    if (g_config.trace_file[0] != '\0') print_trace_stats(network);
+    if (ramp.count > 0) print_ramp_stats();
+    write_stats(network, &scaler, &warp, &ticks, days_run, locks, children.usage, &queues, branches, sim_clock->lag);
+    free(network);
 
     sleep(1);
 
     mq_close(qid);
     mq_close(qid_ticket);
+    for (int b = 1; b < g_config.num_branches; b++) {
+        char name[64];
+        mq_close(branches[b].ticket_qid);
+        shm_mutex_destroy(&branches[b].stats->stats_lock);
+        shm_mutex_destroy(&branches[b].stations->stations_lock);
+        branch_shm_name(SHM_STATS_NAME, b, name, sizeof(name));
+        cleanup_shared_memory(name, SHM_STATS_SIZE, open_shm[branches[b].stats_shm], branches[b].stats);
+        branch_shm_name(SHM_STATIONS_NAME, b, name, sizeof(name));
+        cleanup_shared_memory(name, SHM_STATIONS_SIZE, open_shm[branches[b].stations_shm], branches[b].stations);
+    }
 
-    sem_destroy(&shared_stats->stats_lock);
-    sem_destroy(&shared_stations->stations_lock);
+    shm_mutex_destroy(&shared_stats->stats_lock);
+    shm_mutex_destroy(&shared_stations->stations_lock);
     cleanup_shared_memory(SHM_STATS_NAME,
                           SHM_STATS_SIZE,
                           open_shm[0],
@@ -452,6 +1834,18 @@ int main(const int argc, const char *argv[]) {
                           SHM_STATIONS_SIZE,
                           open_shm[1],
                           shared_stations);
+    cleanup_shared_memory(SHM_CONFIG_NAME,
+                          SHM_CONFIG_SIZE,
+                          open_shm[2],
+                          config_segment);
+    cleanup_shared_memory(SHM_CLOCK_NAME,
+                          SHM_CLOCK_SIZE,
+                          open_shm[3],
+                          sim_clock);
+    cleanup_shared_memory(SHM_SAMPLES_NAME,
+                          SHM_SAMPLES_SIZE,
+                          open_shm[4],
+                          sampler);
 
     return EXIT_SUCCESS;
 }
@@ -1,16 +1,22 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <erogatore_ticket.h>
 #include <comunications.h>
 #include <shared_mem.h>
+#include <instance.h>
 #include <stdbool.h>
 #include <errno.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #include <poste.h>
+#include <sim_clock.h>
+#include <config_shm.h>
+#include <branch.h>
 
 // Types
 typedef struct S_ticket_queue ticket_queue;
@@ -18,40 +24,94 @@ typedef struct S_ticket ticket;
 typedef enum SERVICE_ID service_id;
 typedef struct S_ticket_request ticket_request;
 typedef struct S_ticket_response ticket_response;
+typedef struct S_ticket_bundle_request  ticket_bundle_request;
+typedef struct S_ticket_bundle_response ticket_bundle_response;
+
+#define PREFIX "\e[1;33m[EROGATORE TICKET]:\033[0m"
+
+// Answers a bundle in one message, tickets numbered in the order of the services
+static void answer_bundle(mq_id qid, const ticket_bundle_request *req, ssize_t size, int *ticket_counter) {
+    ticket_bundle_response resp;
+    resp.generator_pid = getpid();
+    resp.count = 0;
+    if (req->count > 0 && req->count <= MAX_N_REQUESTS_COMPILE && (size_t)size == TICKET_BUNDLE_SIZE(req->count)) {
+        resp.count = req->count;
+    } else {
+        fprintf(stderr, PREFIX " Malformed ticket bundle from PID %d, refused\n", req->sender_pid);
+    }
+
+    printf(PREFIX " Received a bundle of %d requests from PID %d\n", resp.count, req->sender_pid);
+    for (int i = 0; i < resp.count; i++) {
+        resp.ticket_numbers[i] = (*ticket_counter)++;
+    }
+
+    if (sim_reply(qid, req->sender_pid, &resp, TICKET_BUNDLE_SIZE(resp.count)) < 0) {
+        perror("mq_send bundle response");
+    }
+}
+
+bool dispense_ticket(mq_id qid, int *ticket_counter) {
+    // Lowest type first: single requests, then bundles
+    union {
+        ticket_request single;
+        ticket_bundle_request bundle;
+    } req;
+    sim_block();
+    ssize_t n = mq_receive(qid, -MSG_TYPE_TICKET_BUNDLE_REQUEST, &req, sizeof(req), 0);
+    sim_unblock(n >= 0);
+    if (n < 0) {
+        if (errno == EINTR) return true;  // interrupted by signal
+        perror("msgrcv");
+        return false;
+    }
+
+    if ((size_t)n != sizeof(ticket_request)) {
+        answer_bundle(qid, &req.bundle, n, ticket_counter);
+        return true;
+    }
+
+    int service = req.single.service_id;
+    printf(PREFIX " Received request from PID %d for service %s\n", req.single.sender_pid,
+           service >= 0 && service < NUM_SERVICE_TYPES ? services[service] : "unknown");
+
+    ticket_response resp;
+    resp.generator_pid  = getpid();
+    resp.ticket_number  = (*ticket_counter)++;
+
+    if (sim_reply(qid, req.single.sender_pid, &resp, sizeof(resp)) < 0) {
+        perror("mq_send response");
+    }
+    return true;
+}
 
 #ifndef UNIT_TEST
-int main() {
-    bool running = true;
+int main(int argc, char *argv[]) {
+    int branch = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--branch") == 0 && i + 1 < argc) {
+            branch = atoi(argv[++i]);
+        }
+    }
 
-    key_t key = ftok(KEY_TICKET_MSG, PROJ_ID);
-    if (key == -1) { perror("ftok"); return 1; }
+    key_t key = poste_key(KEY_TICKET_MSG, branch_ticket_proj_id(branch));
+    if (key == -1) { perror("poste_key"); return 1; }
     mq_id qid = mq_open(key, 0, 0666);
     srand(time(NULL));
 
-    int ticket_counter = 0;
+    char stats_name[64];
+    branch_shm_name(SHM_STATS_NAME, branch, stats_name, sizeof(stats_name));
+    struct S_poste_stats *stats = attach_shared_memory(stats_name, SHM_STATS_SIZE, PROT_READ | PROT_WRITE);
+    if (stats != NULL) mq_count_sends(&stats->messages_sent);
 
-    printf("\e[1;33m[EROGATORE TICKET]:\033[0m Ticket generator running on queue %d\n", qid);
-    while(running) {
-        ticket_request req;
-        ssize_t n = mq_receive(qid, MSG_TYPE_TICKET_REQUEST, &req, sizeof(req), 0);
-        if (n < 0) {
-            if (errno == EINTR) continue;  // interrupted by signal
-            perror("msgrcv");
-            break;
-        }
+    config_shm_attach();
+    sim_clock_attach();
+    sim_actor_join(ACTOR_TICKET);
 
-        printf("\e[1;33m[EROGATORE TICKET]:\033[0m Received request from PID %d for service %s\n", req.sender_pid, services[req.service_id]);
-        
-        ticket_response resp;
-        resp.generator_pid  = getpid();
-        resp.ticket_number  = ticket_counter;
+    int ticket_counter = 0;
 
-        if (mq_send(qid, req.sender_pid, &resp, sizeof(resp)) < 0) {
-            perror("mq_send response");
-        }
-        
-        ticket_counter++;
-    }
+    printf(PREFIX " Ticket generator of branch %d running on queue %d\n", branch, qid);
+    while (dispense_ticket(qid, &ticket_counter));
 
     return 0;
 }
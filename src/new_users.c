@@ -7,6 +7,7 @@
 #include <unistd.h>
 
 #include <comunications.h>
+#include <instance.h>
 
 #define PREFIX "\e[1;36m[N-NEW-USERS]:\e[0m"
 
@@ -29,8 +30,8 @@ int main(const int argc, const char *argv[]) {
         N_NEW_USERS = 1;
     }
 
-    key_t key = ftok(KEY_NEW_USERS, proj_ID_USERS);
-    if (key == -1) { perror("ftok"); return 1; }
+    key_t key = poste_key(KEY_NEW_USERS, proj_ID_USERS);
+    if (key == -1) { perror("poste_key"); return 1; }
 
     //printf("ftok key: %d\n", key);
 
@@ -11,10 +11,19 @@
 #include <sys/ipc.h>
 #include <sys/msg.h>
 #include <semaphore.h>
+#include <signal.h>
 
 #include <comunications.h>
 #include <shared_mem.h>
+#include <instance.h>
+#include <stats.h>
+#include <sim_clock.h>
+#include <config_shm.h>
+#include <utilization.h>
+#include <seat_queue.h>
+#include <branch.h>
 #include <poste.h>
+#include <operatore.h>
 
 // TYPES
 typedef struct S_poste_stats       poste_stats;
@@ -24,25 +33,84 @@ typedef struct S_poste_stations    poste_stations;
 typedef struct S_worker_seat       worker_seat;
 typedef struct S_service_request   service_request;
 typedef struct S_service_done      service_done;
+typedef struct S_operator_state    operator_state;
 
 #define PREFIX "\033[34m[OPERATORE(%d)]:\033[0m"
 
-// Centralized function to release a seat and signal waiting operators
+// Set by SIGUSR1 when the director retires this operator
+static volatile sig_atomic_t retire_requested = 0;
+
+// Centralized function to release a seat and hand it to the next operator waiting for it
 void release_seat(poste_stations *shared_stations, int seat_index) {
-    sem_wait(&shared_stations->stations_lock);
+    seat_queue_lock(shared_stations);
     shared_stations->NOF_WORKER_SEATS[seat_index].operator_status = FREE;
     shared_stations->NOF_WORKER_SEATS[seat_index].operator_process = 0;
-    sem_post(&shared_stations->stations_lock);
-    sem_post(&shared_stations->stations_event);
+    seat_queue_offer(shared_stations, seat_index);
+    shm_mutex_unlock(&shared_stations->stations_lock);
     
     printf(PREFIX " Released seat %d\n", getpid(), seat_index);
     fflush(stdout);
 }
 
-// function to handle operators taking seats
+// Function that accounts a finished service to the seat and the operator, today and for the run
+void update_busy_stats(poste_stats *shared_stats, int seat, int user_service, double minutes) {
+    stats_update(shared_stats, (struct S_stats_update){
+        .kind = STATS_BUSY, .seat = seat, .pid = getpid(), .service = user_service, .minutes = minutes
+    });
+}
+
+// Function that accounts the time spent at a seat once it is released
+void update_seated_stats(poste_stats *shared_stats, int seat, int user_service, double minutes) {
+    stats_update(shared_stats, (struct S_stats_update){
+        .kind = STATS_SEATED, .seat = seat, .pid = getpid(), .service = user_service, .minutes = minutes
+    });
+}
+
+// Function that publishes which services the operators know, for the seat allocation
+void update_operator_skills(poste_stations *shared_stations, int user_service, int delta) {
+    seat_queue_lock(shared_stations);
+    shared_stations->operator_skills[user_service] += delta;
+    shm_mutex_unlock(&shared_stations->stations_lock);
+}
+
+// Function that publishes what this operator carries to the next day, for the checkpoints
+void publish_operator_state(poste_stations *shared_stations, int user_service, int pauses_done) {
+    pid_t pid = getpid();
+    seat_queue_lock(shared_stations);
+    operator_state *slot = NULL;
+    for (int i = 0; i < MAX_OPERATOR_STATES; i++) {
+        operator_state *state = &shared_stations->operator_states[i];
+        if (state->pid == pid) {
+            slot = state;
+            break;
+        }
+        if (state->pid == 0 && slot == NULL) slot = state;
+    }
+    if (slot != NULL) {
+        slot->pid         = pid;
+        slot->service     = user_service;
+        slot->pauses_done = pauses_done;
+    }
+    shm_mutex_unlock(&shared_stations->stations_lock);
+}
+
+// Function that removes a retiring operator from the published states
+void clear_operator_state(poste_stations *shared_stations) {
+    pid_t pid = getpid();
+    seat_queue_lock(shared_stations);
+    for (int i = 0; i < MAX_OPERATOR_STATES; i++) {
+        if (shared_stations->operator_states[i].pid == pid) {
+            shared_stations->operator_states[i] = (operator_state){0};
+        }
+    }
+    shm_mutex_unlock(&shared_stations->stations_lock);
+}
+
+// function to handle operators taking seats, the user side goes to the next user waiting
 void take_seat(poste_stations *shared_stations, int i) {
     shared_stations->NOF_WORKER_SEATS[i].operator_process = getpid();
     shared_stations->NOF_WORKER_SEATS[i].operator_status = OCCUPIED;
+    seat_queue_offer(shared_stations, i);
 
     printf(PREFIX " Taking seat %d for service %s\n",
            getpid(), i, services[shared_stations->NOF_WORKER_SEATS[i].service_id]);
@@ -51,21 +119,13 @@ void take_seat(poste_stations *shared_stations, int i) {
 
 // Function that updates requests statistics
 void update_requests_stats(poste_stats *shared_stats, int user_service) {
-    sem_wait(&shared_stats->stats_lock);
-    shared_stats->simulation_services[user_service].total_requests++;
-    shared_stats->simulation_global.total_requests++;
-    shared_stats->today.services[user_service].total_requests++;
-    shared_stats->today.global.total_requests++;
-    sem_post(&shared_stats->stats_lock);
+    stats_update(shared_stats, (struct S_stats_update){ .kind = STATS_REQUEST, .service = user_service });
 }
 
 
 // Function that updates pause statistics
 void update_pause_stats(poste_stats *shared_stats) {
-    sem_wait(&shared_stats->stats_lock);
-    shared_stats->total_simulation_pauses++;
-    shared_stats->today.total_pauses++;
-    sem_post(&shared_stats->stats_lock);
+    stats_update(shared_stats, (struct S_stats_update){ .kind = STATS_PAUSE });
 }
 
 // await service request from users - non blocking version
@@ -90,6 +150,7 @@ service_request await_service_request_nb(mq_id qid) {
             res.ticket_number = -1;
         }
     } else {
+        sim_received();
         printf(PREFIX " Received response, ticket_number=%d\n", getpid(), res.ticket_number);
         fflush(stdout);
     }
@@ -108,10 +169,7 @@ int send_service_done(mq_id qid, int ticket_number, pid_t user_pid, int service_
     printf(PREFIX " Sending service done message for ticket %d\n", getpid(), ticket_number);
     fflush(stdout);
 
-    if (mq_send(qid,
-                user_pid,
-                &req,
-                sizeof(req)) < 0) {
+    if (sim_reply(qid, user_pid, &req, sizeof(req)) < 0) {
         fprintf(stderr, PREFIX " ERROR mq_send service request: %s\n", getpid(), strerror(errno));
         fflush(stderr);
         return 0;
@@ -136,30 +194,9 @@ long long process_service(poste_stats *shared_stats, service_request service_req
     long long span      = max_nano - min_nano + 1;
     long long rand_nano = min_nano + (rand() % span);
 
-    // Handle sleep duration properly
-    struct timespec service_time;
-    if (rand_nano >= 1000000000LL) {
-        service_time.tv_sec  = rand_nano / 1000000000LL;
-        service_time.tv_nsec = rand_nano % 1000000000LL;
-    } else {
-        service_time.tv_sec = 0;
-        service_time.tv_nsec = rand_nano;
-    }
-
-    struct timespec remaining;
-    int ret;
-    do {
-        errno = 0;
-        ret = nanosleep(&service_time, &remaining);
-        if (ret == -1 && errno == EINTR) {
-            service_time = remaining;
-        }
-    } while (ret == -1 && errno == EINTR);
-
-    if (ret == -1) {
-        fprintf(stderr, PREFIX " nanosleep failed: %s\n", getpid(), strerror(errno));
-        exit(EXIT_FAILURE);
-    }
+    // Real time, or whole simulated minutes on the shared clock in time warp:
+    // the time reported is the one slept
+    rand_nano = sim_sleep_nanos(rand_nano);
 
     printf(PREFIX " [%02d:%02d] Finished service for ticket %d, service time: %lld minutes\n",
         getpid(),
@@ -170,6 +207,53 @@ long long process_service(poste_stats *shared_stats, service_request service_req
     return rand_nano;
 }
 
+// Serves a request received at the seat: statistics, service, answer
+void serve_request(poste_stats *shared_stats, mq_id qid, int seat, int user_service, service_request service_req) {
+    update_requests_stats(shared_stats, user_service);
+
+    printf(PREFIX " [%02d:%02d] Received service request for ticket %d\n",
+                   getpid(),
+                   shared_stats->current_minute / 60,
+                   shared_stats->current_minute % 60,
+                   service_req.ticket_number);
+    fflush(stdout);
+
+    long long time_taken = process_service(shared_stats, service_req, user_service);
+    update_busy_stats(shared_stats, seat, user_service, (double)time_taken / g_config.minute_duration);
+
+    if (!send_service_done(qid, service_req.ticket_number, service_req.sender_pid, user_service, (double)time_taken / g_config.minute_duration)) {
+        printf(PREFIX " Failed to send service done message for ticket %d\n",
+            getpid(), service_req.ticket_number);
+        fflush(stdout);
+    }
+}
+
+// Leaves the seat without stranding a user. The seat is closed first, so no
+// user takes it from now on; a user already holding its user side has sent,
+// or is about to send, a request to this operator, or was just served and
+// is about to release it. Requests are served until the user side is free,
+// then the seat is released.
+void leave_seat(poste_stats *shared_stats, poste_stations *shared_stations, mq_id qid, int seat, int user_service) {
+    worker_seat *s = &shared_stations->NOF_WORKER_SEATS[seat];
+    seat_queue_lock(shared_stations);
+    s->operator_status = CLOSING;
+    bool user_seated = s->user_status == OCCUPIED;
+    shm_mutex_unlock(&shared_stations->stations_lock);
+
+    while (user_seated) {
+        service_request service_req = await_service_request_nb(qid);
+        if (service_req.ticket_number >= 0) {
+            serve_request(shared_stats, qid, seat, user_service, service_req);
+        } else if (service_req.ticket_number == -2) {
+            seat_queue_lock(shared_stations);
+            user_seated = s->user_status == OCCUPIED;
+            shm_mutex_unlock(&shared_stations->stations_lock);
+            if (user_seated) sim_sleep_minutes(1);
+        }
+    }
+    release_seat(shared_stations, seat);
+}
+
 // Function that finds a free seat for a specific service
 int find_seat(poste_stations *shared_stations, int user_service) {
     for (int i = 0; i < g_config.num_worker_seats; i++) {
@@ -195,26 +279,29 @@ bool did_poste_close(poste_stats *shared_stats) {
     return sem_trywait(&shared_stats->close_poste_event) == 0;
 }
 
-// Function that handles the waiting for a station, return station index or -1 if the day finished while searching a seat
+// Function that handles the waiting for a station, return station index or -1 if the day finished while searching a seat.
+// Called with stations_lock held. A seat handed over by release_seat is already taken for this operator.
 int wait_for_station(poste_stats *shared_stats, poste_stations *shared_stations, int user_service) {
-    // Wait for a free station, doesn't complettly yield and checks for poste closed to make sure the operator doesn't get stuck
-    struct timespec timeout;
-    timeout.tv_nsec = g_config.minute_duration * 5; // Check every 5 minutes if poste is closed
-    timeout.tv_sec = 0;
     while (true) {
-        while (sem_timedwait(&shared_stations->stations_event, &timeout) != 0) {
-            if (did_poste_close(shared_stats)) {
-                // Poste closed while waiting
-                return -1;
-            }
-        }
-
         int available_seat = find_seat(shared_stations, user_service);
         if (available_seat != -1) {
+            take_seat(shared_stations, available_seat);
             return available_seat;
         }
+        if (retire_requested || did_poste_close(shared_stats)) {
+            // Poste closed (or retired by the director) while waiting
+            return -1;
+        }
 
-        sem_post(&shared_stations->stations_event); // No seat found, re-signal and wait again
+        // Queued until a seat of the service is freed, or the poste closes
+        int minutes_left = g_config.worker_shift_close * 60 - shared_stats->current_minute;
+        available_seat = seat_queue_wait(shared_stations, &shared_stations->operator_queue[user_service],
+                                         minutes_left > 0 ? minutes_left : 1);
+        if (available_seat != -1) {
+            printf(PREFIX " Handed seat %d for service %s\n", getpid(), available_seat, services[user_service]);
+            fflush(stdout);
+            return available_seat;
+        }
     }
 }
 
@@ -231,39 +318,41 @@ bool work_loop(poste_stats *shared_stats, poste_stations *shared_stations, mq_id
 
     bool on_shift = true;
     int current_seat = -1;
-
-    // Search for a free station
-    sem_wait(&shared_stations->stations_lock);
-    int available_seat = find_seat(shared_stations, user_service);
-    if (available_seat != -1) {
-        take_seat(shared_stations, available_seat);
-        current_seat = available_seat;
-
-        sem_post(&shared_stations->stations_lock);
+    int seated_at = 0; // Minute the seat was taken, for the utilization stats
+
+    // Search for a free station, waiting for one if needed
+    seat_queue_lock(shared_stations);
+    int available_seat = wait_for_station(shared_stats, shared_stations, user_service);
+    shm_mutex_unlock(&shared_stations->stations_lock);
+    if (available_seat == -1) {
+        // Day ended while waiting
+        return false;
     }
-    else {
-        sem_post(&shared_stations->stations_lock);
+    current_seat = available_seat;
+    seated_at = shared_stats->current_minute;
 
-        available_seat = wait_for_station(shared_stats, shared_stations, user_service);
-        if (available_seat == -1) {
-            // Day ended while waiting
-            return false;
-        }
-
-        sem_wait(&shared_stations->stations_lock);
+    // Each iteration is a ticket being solved and worked on
+    while (on_shift) {
+        // Retired by the director, the current ticket is already done.
+        // Checked before the close event: the director no longer counts this
+        // operator, so it must not take a close token meant for another one
+        if (retire_requested) {
+            on_shift = false;
+            leave_seat(shared_stats, shared_stations, qid, current_seat, user_service);
 
-        take_seat(shared_stations, available_seat);
-        current_seat = available_seat;
+            printf(PREFIX " [%02d:%02d] Retired by the director, going home\n",
+                    getpid(),
+                    shared_stats->current_minute / 60,
+                    shared_stats->current_minute % 60);
+            fflush(stdout);
 
-        sem_post(&shared_stations->stations_lock);
-    }
+            continue;
+        }
 
-    // Each iteration is a ticket being solved and worked on
-    while (on_shift) {
         // Check if the poste closed while working on the previous ticket
         if (did_poste_close(shared_stats)) {
             on_shift = false;
-            release_seat(shared_stations, current_seat);
+            leave_seat(shared_stats, shared_stations, qid, current_seat, user_service);
             
             printf(PREFIX " [%02d:%02d] Shift ended, going home\n",
                     getpid(),
@@ -278,8 +367,7 @@ bool work_loop(poste_stats *shared_stats, poste_stations *shared_stations, mq_id
         service_request service_req = await_service_request_nb(qid);
         if (service_req.ticket_number == -2) {
             // No message available, short sleep ( 3 simulation minutes ) and continue
-            struct timespec short_sleep = { .tv_sec = 0, .tv_nsec = g_config.minute_duration * 3 };
-            nanosleep(&short_sleep, NULL);
+            sim_sleep_minutes(3);
             continue;
         }
 
@@ -289,25 +377,8 @@ bool work_loop(poste_stats *shared_stats, poste_stations *shared_stations, mq_id
             continue;
         }
 
-        // Service request received, update statistics
-        update_requests_stats(shared_stats, user_service);
-
-        printf(PREFIX " [%02d:%02d] Received service request for ticket %d\n",
-                       getpid(),
-                       shared_stats->current_minute / 60,
-                       shared_stats->current_minute % 60,
-                       service_req.ticket_number);
-        fflush(stdout);
-
-        // Handle the service
-        long long time_taken = process_service(shared_stats, service_req, user_service);
-
-        // Send back the response
-        if (!send_service_done(qid, service_req.ticket_number, service_req.sender_pid, user_service, (double)time_taken / g_config.minute_duration)) {
-            printf(PREFIX " Failed to send service done message for ticket %d\n",
-                getpid(), service_req.ticket_number);
-            fflush(stdout);
-        }
+        // Service request received: serve it and answer
+        serve_request(shared_stats, qid, current_seat, user_service, service_req);
 
         // Should i go home early?
         if (rand() % 100 < 1 && (*pauses_done) < g_config.nof_pause) {
@@ -315,7 +386,7 @@ bool work_loop(poste_stats *shared_stats, poste_stations *shared_stations, mq_id
             // 1% Because on config_explode.conf so many ticket happens that having a higher percentage is too risky
             on_shift = false;
             (*pauses_done)++;
-            release_seat(shared_stations, current_seat);
+            leave_seat(shared_stats, shared_stations, qid, current_seat, user_service);
 
             update_pause_stats(shared_stats);
 
@@ -328,16 +399,55 @@ bool work_loop(poste_stats *shared_stats, poste_stations *shared_stations, mq_id
         }
     }
 
+    // Every way out of the loop released the seat
+    update_seated_stats(shared_stats, current_seat, user_service, shared_stats->current_minute - seated_at);
     return true;
 }
 
-int main() {
-    int open_shm[] = {};
+#ifndef UNIT_TEST
+static void on_retire(int sig) {
+    (void)sig;
+    retire_requested = 1;
+}
+
+// Waits for an event posted by the director, idle for the time warp.
+// Returns false if interrupted (retired by the director)
+static bool wait_event(sem_t *event) {
+    sim_block();
+    bool taken = sem_wait(event) == 0;
+    sim_unblock(taken);
+    return taken;
+}
+
+int main(const int argc, const char *argv[]) {
+    int user_service = -1; // Service chosen by the director, random if not given
+    int pauses_done = 0;
+    bool join_open_poste = false; // Spawned during the day, the poste is already open
+    int branch = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--service") == 0 && i + 1 < argc) {
+            user_service = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--join") == 0) {
+            join_open_poste = true;
+        } else if (strcmp(argv[i], "--pauses") == 0 && i + 1 < argc) {
+            pauses_done = atoi(argv[++i]); // Resumed from a checkpoint
+        } else if (strcmp(argv[i], "--branch") == 0 && i + 1 < argc) {
+            branch = atoi(argv[++i]);
+        }
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_retire;
+    sigaction(SIGUSR1, &sa, NULL);
+
+    int open_shm[2] = {};
     int open_shm_index = 0;
 
-    key_t key = ftok(KEY_TICKET_MSG, PROJ_ID);
+    key_t key = poste_key(KEY_TICKET_MSG, branch_ticket_proj_id(branch));
     if (key == -1) {
-        fprintf(stderr, PREFIX " ERROR ftok: %s\n", getpid(), strerror(errno));
+        fprintf(stderr, PREFIX " ERROR poste_key: %s\n", getpid(), strerror(errno));
         fflush(stderr);
         return 1;
     }
@@ -348,29 +458,49 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
+    // Everything an operator touches belongs to its branch, see branch.h
+    char stats_name[64], stations_name[64];
+    branch_shm_name(SHM_STATS_NAME, branch, stats_name, sizeof(stats_name));
+    branch_shm_name(SHM_STATIONS_NAME, branch, stations_name, sizeof(stations_name));
     poste_stats *shared_stats = (poste_stats*) init_shared_memory(
-        SHM_STATS_NAME, SHM_STATS_SIZE, open_shm, &open_shm_index);
+        stats_name, SHM_STATS_SIZE, open_shm, &open_shm_index);
+    mq_count_sends(&shared_stats->messages_sent);
     poste_stations *shared_stations = (poste_stations*) init_shared_memory(
-        SHM_STATIONS_NAME, SHM_STATIONS_SIZE, open_shm, &open_shm_index);
+        stations_name, SHM_STATIONS_SIZE, open_shm, &open_shm_index);
 
-    load_config(shared_stats->configuration_file);
+    if (!config_shm_attach()) load_config(shared_stats->configuration_file);
 
-    srand((unsigned)getpid());
+    sim_clock_attach();
+    sim_actor_join(ACTOR_OPERATOR);
 
-    sem_wait(&shared_stats->day_update_event);
+    srand((unsigned)getpid());
 
-    int pauses_done = 0;
-    int user_service = rand() % NUM_SERVICE_TYPES; // Choose a service for the operator on creation
+    if (user_service < 0 || user_service >= NUM_SERVICE_TYPES) {
+        user_service = rand() % NUM_SERVICE_TYPES; // Choose a service for the operator on creation
+    }
     printf(PREFIX " Assigned service %s to operator\n", getpid(), services[user_service]);
     fflush(stdout);
+    // Published before the first day, so the director can allocate seats on it
+    update_operator_skills(shared_stations, user_service, 1);
+    publish_operator_state(shared_stations, user_service, pauses_done);
 
-    while (true) {
-        printf(PREFIX " Starting work for the day\n", getpid());
-        fflush(stdout);
-        sleep(1);
+    if (!join_open_poste) {
+        wait_event(&shared_stats->day_update_event);
+    }
 
-        // Wait for the poste to open
-        sem_wait(&shared_stats->open_poste_event);
+    while (!retire_requested) {
+        if (join_open_poste) {
+            // Joining an open poste, start working right away
+            join_open_poste = false;
+        } else {
+            printf(PREFIX " Starting work for the day\n", getpid());
+            fflush(stdout);
+            config_shm_refresh(); // Reloaded by the director since yesterday
+            if (!sim_time_warp()) sleep(1);
+
+            // Wait for the poste to open
+            if (!wait_event(&shared_stats->open_poste_event)) continue;
+        }
 
         printf(PREFIX " Entering the poste at %02d:%02d\n",
                getpid(),
@@ -379,22 +509,26 @@ int main() {
         fflush(stdout);
 
        bool worked_today = work_loop(shared_stats, shared_stations, qid, user_service, &pauses_done);
+        publish_operator_state(shared_stations, user_service, pauses_done);
 
         // update stats if the operator worked today
         if (worked_today) {
-            sem_wait(&shared_stats->stats_lock);
-            shared_stats->total_active_operators++;
-            shared_stats->today.active_operators++;
-            sem_post(&shared_stats->stats_lock);
+            stats_update(shared_stats, (struct S_stats_update){ .kind = STATS_ACTIVE_OPERATOR });
         }
 
         printf(PREFIX " Waiting for next day signal\n", getpid());
         fflush(stdout);
-        sem_wait(&shared_stats->day_update_event);
+        if (!wait_event(&shared_stats->day_update_event)) continue;
         printf(PREFIX " Next day signal received\n", getpid());
         fflush(stdout);
-        sleep(1);
+        if (!sim_time_warp()) sleep(1);
     }
 
+    update_operator_skills(shared_stations, user_service, -1);
+    clear_operator_state(shared_stations);
+    sim_actor_leave();
+    printf(PREFIX " Retired by the director\n", getpid());
+    fflush(stdout);
     return 0;
-}
\ No newline at end of file
+}
+#endif // UNIT_TEST
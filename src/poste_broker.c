@@ -0,0 +1,64 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <poste.h>
+#include <mq_broker.h>
+#include <instance.h>
+
+#define PREFIX "\e[1;35m[POSTE BROKER]:\e[0m"
+
+// Broker of the socket transport, see mq_broker.h. Start it before the
+// director and run the simulation with POSTE_MQ_SOCKET set to its socket:
+//   ./bin/poste_broker &
+//   POSTE_MQ_SOCKET=./tmp/broker.sock ./bin/direttore
+// One broker serves one run at a time, it holds the queues of that run.
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_interrupt(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+#ifndef UNIT_TEST
+int main(int argc, char *argv[]) {
+    char path[MAX_PATH_LENGTH];
+    instance_output_dir(poste_instance(), path, sizeof(path));
+    strncat(path, "broker.sock", sizeof(path) - strlen(path) - 1);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            snprintf(path, sizeof(path), "%s", argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--socket PATH]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_interrupt;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    printf(PREFIX " Serving %s, run the simulation with %s=%s\n", path, MQ_SOCKET_ENV, path);
+    fflush(stdout);
+
+    struct S_mq_broker_counters counters = {0};
+    if (mq_broker_run(path, &stop, &counters) < 0) {
+        fprintf(stderr, PREFIX " Cannot serve %s: %s\n", path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    printf(PREFIX " %llu client(s), %llu frame(s), %llu record(s): %llu message(s), %llu stats update(s)\n",
+           counters.clients, counters.frames, counters.records, counters.messages, counters.stats_updates);
+    printf(PREFIX " %llu send(s) refused, %llu waited for room in a full queue\n",
+           counters.failed_sends, counters.waits);
+    return EXIT_SUCCESS;
+}
+#endif // UNIT_TEST
@@ -0,0 +1,407 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include <comunications.h>
+#include <poste.h>
+#include <utente.h>
+#include <shared_mem.h>
+#include <instance.h>
+#include <sim_clock.h>
+#include <seat_queue.h>
+#include <config_shm.h>
+
+#define PREFIX "\e[1;35m[LOADGEN]:\e[0m"
+
+#define DEFAULT_RATE 30.0       // Arrivals per simulated hour, over all services
+#define DEFAULT_MAX_INFLIGHT 500 // Customer processes alive at the same time
+
+// Open-loop Poisson load generator for a running simulation.
+// Every arrival forks a short-lived customer that runs the real user protocol
+// (handle_service: S_ticket_request -> seat -> S_service_request) once and
+// reports its outcome and end-to-end latency back through a pipe.
+
+typedef struct S_poste_stats     poste_stats;
+typedef struct S_poste_stations  poste_stations;
+
+// Written by each customer into the results pipe, smaller than PIPE_BUF
+struct S_arrival_result {
+    int service_id;
+    service_outcome outcome;
+    long long latency_ns;
+};
+
+typedef struct S_arrival_result arrival_result;
+
+struct S_service_report {
+    int arrivals;
+    int dropped;   // Arrivals over the in-flight cap
+    int served;
+    int failed;
+    int late;
+    int latencies_count;
+    int latencies_capacity;
+    long long *latencies_ns;
+};
+
+typedef struct S_service_report service_report;
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void on_interrupt(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void sleep_ns(long long ns) {
+    if (ns <= 0) return;
+    struct timespec ts = { .tv_sec = ns / 1000000000LL, .tv_nsec = ns % 1000000000LL };
+    nanosleep(&ts, NULL);
+}
+
+// Exponential inter-arrival gap (in simulated minutes) for a rate per minute
+static double exponential_gap(double rate_per_minute) {
+    double u = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    return -log(u) / rate_per_minute;
+}
+
+static bool poste_is_open(poste_stats *stats) {
+    int minute = stats->current_minute;
+    return minute >= g_config.worker_shift_open * 60 && minute < g_config.worker_shift_close * 60;
+}
+
+// Body of one customer process, never returns
+static void run_customer(int service_id, int result_fd, mq_id qid, poste_stats *stats, poste_stations *stations) {
+    if (freopen("/dev/null", "w", stdout) == NULL) {
+        _exit(EXIT_FAILURE);
+    }
+    srand((unsigned)getpid());
+    sim_actor_join(ACTOR_USER); // Keeps the time warp accounting of the real user protocol balanced
+
+    arrival_result res;
+    long long start = now_ns();
+    res.service_id = service_id;
+    res.outcome    = handle_service(service_id, qid, stats, stations);
+    res.latency_ns = now_ns() - start;
+    sim_actor_leave();
+
+    if (write(result_fd, &res, sizeof(res)) != sizeof(res)) {
+        _exit(EXIT_FAILURE);
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+static void record_result(service_report reports[NUM_SERVICE_TYPES], arrival_result *res) {
+    service_report *rep = &reports[res->service_id];
+    switch (res->outcome) {
+        case SERVICE_SERVED: rep->served++; break;
+        case SERVICE_FAILED: rep->failed++; break;
+        case SERVICE_LATE:   rep->late++;   break;
+    }
+
+    if (res->outcome != SERVICE_SERVED) return;
+
+    if (rep->latencies_count == rep->latencies_capacity) {
+        rep->latencies_capacity = rep->latencies_capacity > 0 ? rep->latencies_capacity * 2 : 64;
+        rep->latencies_ns = realloc(rep->latencies_ns, sizeof(long long) * rep->latencies_capacity);
+        if (rep->latencies_ns == NULL) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    rep->latencies_ns[rep->latencies_count++] = res->latency_ns;
+}
+
+// Reads every complete result available and reaps finished customers
+static void collect(int result_fd, service_report reports[NUM_SERVICE_TYPES], pid_t *customers, int max_inflight, int *inflight) {
+    arrival_result res;
+    while (read(result_fd, &res, sizeof(res)) == sizeof(res)) {
+        record_result(reports, &res);
+    }
+
+    pid_t pid;
+    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+        for (int i = 0; i < max_inflight; i++) {
+            if (customers[i] == pid) {
+                customers[i] = 0;
+                (*inflight)--;
+                break;
+            }
+        }
+    }
+}
+
+// Takes a customer killed in flight out of the poste: its place in the seat
+// queues, the user side of its seat, the messages left for it and its clock
+// slot, which the queues link through
+static void forget_customer(pid_t pid, mq_id qid, poste_stations *stations) {
+    pid_t seated[MAX_WORKER_SEATS]; // Only for operators
+    seat_queue_lock(stations);
+    seat_queue_forget(stations, pid, seated);
+    shm_mutex_unlock(&stations->stations_lock);
+
+    char message[MQ_MAX_MESSAGE];
+    while (mq_receive(qid, pid, message, sizeof(message), IPC_NOWAIT) >= 0) sim_drop_wakeups(1);
+    sim_actor_forget(pid);
+}
+
+static int compare_ll(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_minutes(long long *sorted, int count, double p) {
+    if (count == 0) return 0.0;
+    int idx = (int)(p * (count - 1) + 0.5);
+    return (double)sorted[idx] / g_config.minute_duration;
+}
+
+static void print_report(service_report reports[NUM_SERVICE_TYPES], double rates[NUM_SERVICE_TYPES],
+                         double open_minutes, long long wall_ns, int abandoned) {
+    printf("\n" PREFIX " === Load Generator Report ===\n");
+    printf(PREFIX " Open time driven: %.0f simulated minutes (%.2f s wall)\n", open_minutes, wall_ns / 1e9);
+    printf("%-40s %8s %8s %8s %8s %6s %6s %9s %9s %9s %9s\n",
+           "Service", "rate/h", "arrived", "thru/h", "served", "failed", "late",
+           "mean", "p50", "p90", "p99");
+
+    service_report total = {0};
+    double total_rate = 0.0;
+    for (int i = 0; i < NUM_SERVICE_TYPES; i++) {
+        service_report *rep = &reports[i];
+        qsort(rep->latencies_ns, rep->latencies_count, sizeof(long long), compare_ll);
+
+        double mean = 0.0;
+        for (int k = 0; k < rep->latencies_count; k++) mean += rep->latencies_ns[k];
+        mean = rep->latencies_count > 0 ? mean / rep->latencies_count / g_config.minute_duration : 0.0;
+
+        printf("%-40s %8.1f %8d %8.1f %8d %6d %6d %9.2f %9.2f %9.2f %9.2f\n",
+               services[i], rates[i] * 60.0, rep->arrivals,
+               open_minutes > 0 ? rep->served / open_minutes * 60.0 : 0.0,
+               rep->served, rep->failed, rep->late, mean,
+               percentile_minutes(rep->latencies_ns, rep->latencies_count, 0.50),
+               percentile_minutes(rep->latencies_ns, rep->latencies_count, 0.90),
+               percentile_minutes(rep->latencies_ns, rep->latencies_count, 0.99));
+
+        total.arrivals += rep->arrivals;
+        total.dropped  += rep->dropped;
+        total.served   += rep->served;
+        total.failed   += rep->failed;
+        total.late     += rep->late;
+        total_rate     += rates[i];
+    }
+
+    printf("%-40s %8.1f %8d %8.1f %8d %6d %6d\n", "Total", total_rate * 60.0, total.arrivals,
+           open_minutes > 0 ? total.served / open_minutes * 60.0 : 0.0,
+           total.served, total.failed, total.late);
+    printf(PREFIX " Latencies are end-to-end (ticket request to service done) in simulated minutes\n");
+    printf(PREFIX " Dropped over in-flight cap: %d, still in flight at exit: %d\n", total.dropped, abandoned);
+}
+
+static void usage(const char *prog) {
+    printf("usage: %s [--rate R] [--service-rate ID=R]... [--minutes M] [--max-inflight K] [--seed S]\n", prog);
+    printf("  --rate R            total arrivals per simulated hour, split evenly (default %.0f)\n", DEFAULT_RATE);
+    printf("  --service-rate ID=R arrivals per simulated hour for service ID (0..%d)\n", NUM_SERVICE_TYPES - 1);
+    printf("  --minutes M         simulated open minutes to drive (default: one shift)\n");
+    printf("  --max-inflight K    cap on concurrent customers (default %d)\n", DEFAULT_MAX_INFLIGHT);
+}
+
+#ifndef UNIT_TEST
+int main(const int argc, const char *argv[]) {
+    double rates[NUM_SERVICE_TYPES];
+    bool rate_set[NUM_SERVICE_TYPES] = {false};
+    double total_rate = DEFAULT_RATE;
+    int minutes = -1;
+    int max_inflight = DEFAULT_MAX_INFLIGHT;
+    unsigned seed = (unsigned)time(NULL);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            total_rate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--service-rate") == 0 && i + 1 < argc) {
+            int id;
+            double rate;
+            if (sscanf(argv[++i], "%d=%lf", &id, &rate) != 2 || id < 0 || id >= NUM_SERVICE_TYPES || rate < 0) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            rates[id] = rate / 60.0;
+            rate_set[id] = true;
+        } else if (strcmp(argv[i], "--minutes") == 0 && i + 1 < argc) {
+            minutes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-inflight") == 0 && i + 1 < argc) {
+            max_inflight = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned)atol(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    for (int i = 0; i < NUM_SERVICE_TYPES; i++) {
+        if (!rate_set[i]) rates[i] = total_rate / 60.0 / NUM_SERVICE_TYPES;
+    }
+    if (max_inflight < 1) max_inflight = DEFAULT_MAX_INFLIGHT;
+
+    double rate_per_minute = 0.0;
+    for (int i = 0; i < NUM_SERVICE_TYPES; i++) rate_per_minute += rates[i];
+    if (rate_per_minute <= 0.0) {
+        printf(PREFIX " Arrival rate must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    key_t key = poste_key(KEY_TICKET_MSG, PROJ_ID);
+    if (key == -1) { perror("poste_key"); return 1; }
+    mq_id qid = mq_open(key, 0, 0666);
+    if (qid < 0) {
+        printf(PREFIX " Ticket queue not found, is the simulation running?\n");
+        return EXIT_FAILURE;
+    }
+
+    poste_stats *stats = attach_shared_memory(SHM_STATS_NAME, SHM_STATS_SIZE, PROT_READ | PROT_WRITE);
+    poste_stations *stations = attach_shared_memory(SHM_STATIONS_NAME, SHM_STATIONS_SIZE, PROT_READ | PROT_WRITE);
+    if (stats == NULL || stations == NULL) {
+        printf(PREFIX " Shared memory not found, is the simulation running?\n");
+        return EXIT_FAILURE;
+    }
+    mq_count_sends(&stats->messages_sent); // Customers inherit it
+
+    if (!config_shm_attach()) load_config(stats->configuration_file);
+    sim_clock_attach();
+    if (minutes < 1) minutes = (g_config.worker_shift_close - g_config.worker_shift_open) * 60;
+
+    int pipe_fds[2];
+    if (pipe(pipe_fds) < 0) {
+        perror("pipe");
+        return EXIT_FAILURE;
+    }
+    fcntl(pipe_fds[0], F_SETFL, O_NONBLOCK);
+
+    signal(SIGINT, on_interrupt);
+    srand(seed);
+
+    service_report reports[NUM_SERVICE_TYPES];
+    memset(reports, 0, sizeof(reports));
+
+    printf(PREFIX " Driving %.1f arrivals per simulated hour for %d open minutes (seed %u)\n",
+           rate_per_minute * 60.0, minutes, seed);
+    fflush(stdout);
+
+    pid_t *customers = calloc(max_inflight, sizeof(pid_t));
+    if (customers == NULL) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+
+    long long minute_ns = g_config.minute_duration;
+    long long open_ns = 0;          // Wall time spent with the poste open
+    long long started = now_ns();
+    long long last = started;
+    long long next_arrival = started + (long long)(exponential_gap(rate_per_minute) * minute_ns);
+    int inflight = 0;
+
+    while (!interrupted && open_ns < (long long)minutes * minute_ns) {
+        collect(pipe_fds[0], reports, customers, max_inflight, &inflight);
+
+        long long now = now_ns();
+        if (!poste_is_open(stats)) {
+            // Arrival process is paused while closed, the gap restarts at opening
+            sleep_ns(minute_ns);
+            last = now_ns();
+            next_arrival = last + (long long)(exponential_gap(rate_per_minute) * minute_ns);
+            continue;
+        }
+        open_ns += now - last;
+        last = now;
+
+        if (now < next_arrival) {
+            long long gap = next_arrival - now;
+            sleep_ns(gap < minute_ns ? gap : minute_ns);
+            continue;
+        }
+
+        // Pick the service proportionally to its share of the total rate
+        double pick = (rand() / ((double)RAND_MAX + 1.0)) * rate_per_minute;
+        int service_id = 0;
+        while (service_id < NUM_SERVICE_TYPES - 1 && pick >= rates[service_id]) {
+            pick -= rates[service_id];
+            service_id++;
+        }
+        reports[service_id].arrivals++;
+
+        if (inflight >= max_inflight) {
+            reports[service_id].dropped++;
+        } else {
+            fflush(stdout);
+            pid_t pid = fork();
+            if (pid < 0) {
+                perror("fork");
+                reports[service_id].dropped++;
+            } else if (pid == 0) {
+                close(pipe_fds[0]);
+                run_customer(service_id, pipe_fds[1], qid, stats, stations);
+            } else {
+                for (int i = 0; i < max_inflight; i++) {
+                    if (customers[i] == 0) {
+                        customers[i] = pid;
+                        break;
+                    }
+                }
+                inflight++;
+            }
+        }
+
+        // Open loop: the next arrival does not depend on completions
+        next_arrival += (long long)(exponential_gap(rate_per_minute) * minute_ns);
+    }
+
+    // Drain customers still in the poste until they finish or the shift closes
+    while (!interrupted && inflight > 0 && poste_is_open(stats)) {
+        collect(pipe_fds[0], reports, customers, max_inflight, &inflight);
+        sleep_ns(minute_ns);
+    }
+    sleep_ns(minute_ns * 2);
+    collect(pipe_fds[0], reports, customers, max_inflight, &inflight);
+
+    int abandoned = inflight;
+    if (abandoned > 0) {
+        // Customers blocked on a queue whose operator left, do not wait for them
+        for (int i = 0; i < max_inflight; i++) {
+            if (customers[i] != 0) kill(customers[i], SIGKILL);
+        }
+        for (int i = 0; i < max_inflight; i++) {
+            if (customers[i] == 0) continue;
+            waitpid(customers[i], NULL, 0);
+            forget_customer(customers[i], qid, stations);
+        }
+    }
+
+    print_report(reports, rates, (double)open_ns / minute_ns, now_ns() - started, abandoned);
+
+    for (int i = 0; i < NUM_SERVICE_TYPES; i++) free(reports[i].latencies_ns);
+    free(customers);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    detach_shared_memory(SHM_STATS_SIZE, stats);
+    detach_shared_memory(SHM_STATIONS_SIZE, stations);
+
+    return EXIT_SUCCESS;
+}
+#endif  // UNIT_TEST
@@ -0,0 +1,278 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include <poste.h>
+#include <erlang.h>
+#include <arrival.h>
+#include <sim_run.h>
+
+#define PREFIX "\e[1;33m[POSTE PLAN]:\e[0m"
+
+#define PLAN_TIMING_ROUNDS 1000 // Plans computed to time one
+
+// What-if capacity planner: predicts, without running the simulation, how a
+// seat split copes with the demand of a configuration (see erlang.h).
+// With --check it compares its predictions with the CSV of a simulated run
+// of the same configuration.
+
+typedef struct S_queue_prediction queue_prediction;
+
+// What a simulated run measured, read back from final_stats.csv
+struct S_observed_run {
+    int days;
+    double requests[NUM_SERVICE_TYPES];  // Served + failed over the run
+    double busy[NUM_SERVICE_TYPES];      // Operator minutes in process_service
+    double seated[NUM_SERVICE_TYPES];    // Operator minutes at a seat
+    double waiting_sum;                  // Users waiting, summed over open-hour samples
+    int waiting_samples;
+};
+
+typedef struct S_observed_run observed_run;
+
+static int service_index(const char *name) {
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        if (strcmp(services[s], name) == 0) return s;
+    }
+    return -1;
+}
+
+// "2,2,2,3,3,3": staffed seats of each service
+static bool parse_seats(const char *arg, int seats[NUM_SERVICE_TYPES]) {
+    char copy[128];
+    snprintf(copy, sizeof(copy), "%s", arg);
+    char *fields[NUM_SERVICE_TYPES + 1];
+    if (csv_split_fields(copy, fields, NUM_SERVICE_TYPES + 1) != NUM_SERVICE_TYPES) return false;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        seats[s] = atoi(fields[s]);
+        if (seats[s] < 0) return false;
+    }
+    return true;
+}
+
+// Staffed seats spread evenly, never more than the operators
+static void even_seats(int seats[NUM_SERVICE_TYPES]) {
+    int staffed = g_config.num_worker_seats < g_config.num_operators ?
+                  g_config.num_worker_seats : g_config.num_operators;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        seats[s] = staffed / NUM_SERVICE_TYPES + (s < staffed % NUM_SERVICE_TYPES ? 1 : 0);
+    }
+}
+
+static void plan(const int seats[NUM_SERVICE_TYPES], queue_prediction out[NUM_SERVICE_TYPES]) {
+    double requests[NUM_SERVICE_TYPES];
+    erlang_daily_requests(&g_config, requests);
+    int open_minutes = erlang_open_minutes(&g_config);
+
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        double rate = open_minutes > 0 ? requests[s] / open_minutes : 0.0;
+        erlang_predict(rate, services_duration[s], seats[s], &out[s]);
+    }
+}
+
+// Microseconds to compute one plan
+static double time_plan(const int seats[NUM_SERVICE_TYPES]) {
+    queue_prediction out[NUM_SERVICE_TYPES];
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < PLAN_TIMING_ROUNDS; i++) plan(seats, out);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double us = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+    return us / PLAN_TIMING_ROUNDS;
+}
+
+static void print_plan(const queue_prediction out[NUM_SERVICE_TYPES]) {
+    int open_minutes = erlang_open_minutes(&g_config);
+    printf(PREFIX " %d users, %d operators, %d seats, open %02d:00-%02d:00\n\n",
+           g_config.num_users, g_config.num_operators, g_config.num_worker_seats,
+           g_config.worker_shift_open, g_config.worker_shift_close);
+    printf("%-40s %5s %8s %7s %6s %7s %9s %9s %7s\n",
+           "Service", "seats", "req/day", "load", "util", "P(wait)", "Wq M/M/c", "Wq M/G/c", "Lq");
+
+    double total_queue = 0.0;
+    bool all_stable = true;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        const queue_prediction *p = &out[s];
+        printf("%-40s %5d %8.1f %7.2f %5.0f%% %7.3f ", services[s], p->seats,
+               p->arrival_rate * open_minutes, p->offered_load, 100.0 * p->utilization, p->p_wait);
+        if (p->stable) {
+            printf("%9.2f %9.2f %7.2f\n", p->mean_wait, p->mean_wait_mg, p->mean_queue);
+            total_queue += p->mean_queue;
+        } else {
+            printf("%9s %9s %7s\n", "unstable", "unstable", "-");
+            all_stable = false;
+        }
+    }
+
+    printf("\n" PREFIX " Users waiting on average during open hours: ");
+    if (all_stable) printf("%.2f\n", total_queue);
+    else            printf("grows until closing (a service has load >= seats)\n");
+
+    // The averages hide the peak of an arrival profile
+    double shares[MAX_PROFILE_HOURS];
+    int hours = arrival_hour_shares(&g_config, shares);
+    if (g_config.num_profile_hours == 0 || hours == 0) return;
+    int peak = 0;
+    for (int h = 1; h < hours; h++) {
+        if (shares[h] > shares[peak]) peak = h;
+    }
+    double factor = shares[peak] * hours;
+    printf(PREFIX " Peak hour %02d:00-%02d:00 gets %.2fx the average arrival rate, services with load >= seats then:",
+           g_config.worker_shift_open + peak, g_config.worker_shift_open + peak + 1, factor);
+    bool any = false;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        if (out[s].offered_load * factor >= out[s].seats && out[s].offered_load > 0) {
+            printf(" %s (%.2f/%d)", services[s], out[s].offered_load * factor, out[s].seats);
+            any = true;
+        }
+    }
+    printf("%s\n", any ? "" : " none");
+}
+
+static bool read_observed(const char *path, observed_run *obs) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        perror("fopen for --check");
+        return false;
+    }
+
+    enum { NONE, SERVICES, OPERATORS, HOURLY } section = NONE;
+    char line[512];
+    char *fields[16];
+    memset(obs, 0, sizeof(*obs));
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        int n = csv_split_fields(line, fields, 16);
+        if (n == 1 && fields[0][0] == '\0') {
+            section = NONE;
+        } else if (strcmp(fields[0], "DaysRun") == 0 && n == 2) {
+            obs->days = atoi(fields[1]);
+        } else if (strcmp(fields[0], "Service") == 0 && n > 1 && strcmp(fields[1], "ServedUsers") == 0) {
+            section = SERVICES;
+        } else if (strcmp(fields[0], "Pid") == 0) {
+            section = OPERATORS;
+        } else if (strcmp(fields[0], "Hour") == 0) {
+            section = HOURLY;
+        } else if (section == SERVICES && n >= 3) {
+            int s = service_index(fields[0]);
+            if (s >= 0) obs->requests[s] = atof(fields[1]) + atof(fields[2]);
+        } else if (section == OPERATORS && n >= 4) {
+            int s = service_index(fields[1]);
+            if (s >= 0) {
+                obs->busy[s]   += atof(fields[2]);
+                obs->seated[s] += atof(fields[3]);
+            }
+        } else if (section == HOURLY && n >= 4) {
+            int hour = atoi(fields[0]);
+            int samples = atoi(fields[3]);
+            if (hour >= g_config.worker_shift_open && hour < g_config.worker_shift_close) {
+                obs->waiting_sum     += atof(fields[1]) * samples;
+                obs->waiting_samples += samples;
+            }
+        }
+    }
+    fclose(fp);
+
+    if (obs->days <= 0) {
+        fprintf(stderr, PREFIX " %s has no DaysRun row, not a final_stats.csv\n", path);
+        return false;
+    }
+    return true;
+}
+
+static double relative_error(double planned, double observed) {
+    return observed != 0.0 ? 100.0 * (planned - observed) / observed : 0.0;
+}
+
+// Predictions on the seats the run actually staffed, next to what it measured
+static void print_check(const char *path, const observed_run *obs) {
+    double open_minutes = (double)obs->days * erlang_open_minutes(&g_config);
+    int seats[NUM_SERVICE_TYPES];
+    double staffed[NUM_SERVICE_TYPES];
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        staffed[s] = open_minutes > 0 ? obs->seated[s] / open_minutes : 0.0;
+        seats[s] = (int)(staffed[s] + 0.5);
+        if (seats[s] == 0 && obs->seated[s] > 0) seats[s] = 1;
+    }
+
+    queue_prediction out[NUM_SERVICE_TYPES];
+    plan(seats, out);
+    int day_minutes = erlang_open_minutes(&g_config);
+
+    printf("\n" PREFIX " Check against %s (%d days, queues on the seats staffed on average, rounded)\n\n", path, obs->days);
+    printf("%-40s %6s %9s %9s %6s %8s %8s\n",
+           "Service", "seats", "req/day", "sim", "err", "util", "sim");
+
+    double planned_queue = 0.0;
+    bool all_stable = true;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        double planned  = out[s].arrival_rate * day_minutes;
+        double observed = obs->requests[s] / obs->days;
+        double sim_util = obs->seated[s] > 0 ? obs->busy[s] / obs->seated[s] : 0.0;
+        double util     = staffed[s] > 0 ? out[s].offered_load / staffed[s] : 0.0;
+        printf("%-40s %6.2f %9.1f %9.1f %5.0f%% %7.0f%% %7.0f%%\n", services[s], staffed[s],
+               planned, observed, relative_error(planned, observed),
+               100.0 * util, 100.0 * sim_util);
+        if (out[s].stable) planned_queue += out[s].mean_queue;
+        else all_stable = false;
+    }
+
+    printf("\n" PREFIX " Users waiting during open hours: planned ");
+    if (all_stable) printf("%.2f", planned_queue);
+    else            printf("unstable");
+    if (obs->waiting_samples > 0) printf(", simulated %.2f\n", obs->waiting_sum / obs->waiting_samples);
+    else                          printf(", simulated n/a (run with sample_interval > 0)\n");
+}
+
+static void usage(const char *prog) {
+    printf("usage: %s [--config FILE] [--seats S0,S1,S2,S3,S4,S5] [--check FINAL_STATS_CSV]\n", prog);
+}
+
+#ifndef UNIT_TEST
+int main(const int argc, const char *argv[]) {
+    char *config_file = NULL;
+    const char *check_file = NULL;
+    const char *seats_arg = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            config_file = (char *)argv[++i];
+        } else if (strcmp(argv[i], "--seats") == 0 && i + 1 < argc) {
+            seats_arg = argv[++i];
+        } else if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) {
+            check_file = argv[++i];
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    load_config(config_file);
+
+    int seats[NUM_SERVICE_TYPES];
+    if (seats_arg != NULL) {
+        if (!parse_seats(seats_arg, seats)) {
+            fprintf(stderr, PREFIX " --seats needs %d non-negative counts\n", NUM_SERVICE_TYPES);
+            return EXIT_FAILURE;
+        }
+    } else {
+        even_seats(seats);
+    }
+
+    queue_prediction out[NUM_SERVICE_TYPES];
+    plan(seats, out);
+    print_plan(out);
+    printf(PREFIX " Computed in %.2f us\n", time_plan(seats));
+
+    if (check_file != NULL) {
+        observed_run obs;
+        if (!read_observed(check_file, &obs)) return EXIT_FAILURE;
+        print_check(check_file, &obs);
+    }
+    return EXIT_SUCCESS;
+}
+#endif  // UNIT_TEST
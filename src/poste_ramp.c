@@ -0,0 +1,149 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <comunications.h>
+#include <instance.h>
+#include <ramp.h>
+
+#define PREFIX "\e[1;34m[RAMP]:\e[0m"
+
+// Control client of the load ramps (see ramp.h). Submits a schedule of steps
+// to the director over the new_users queue and, with --follow, asks for their
+// status until every step ended, printing each change.
+
+typedef struct S_ramp_request ramp_request;
+typedef struct S_ramp_reply   ramp_reply;
+
+// One request, one reply addressed to this process
+static bool ask_director(mq_id qid, ramp_request *req, ramp_reply *reply) {
+    req->sender_pid = getpid();
+    if (mq_send(qid, MSG_TYPE_RAMP_REQUEST, req, sizeof(*req)) < 0) {
+        perror("mq_send ramp request");
+        return false;
+    }
+    ssize_t n;
+    while ((n = mq_receive(qid, getpid(), reply, sizeof(*reply), 0)) < 0 && errno == EINTR);
+    if (n < 0) {
+        // The queue goes away with the director at the end of the run
+        printf(PREFIX " The director is gone: %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// Prints the steps from first to first + count whose state or progress
+// changed since seen, true once all of them ended
+static bool print_steps(const struct S_ramp_schedule *schedule, int first, int count,
+                        struct S_ramp_status seen[RAMP_MAX_STEPS]) {
+    char line[RAMP_DESCRIBE_LENGTH];
+    bool ended = true;
+    for (int i = first; i < first + count && i < schedule->count; i++) {
+        const struct S_ramp_status *status = &schedule->steps[i];
+        if (status->state != RAMP_DONE && status->state != RAMP_REJECTED) ended = false;
+        if (seen != NULL && status->state == seen[i].state && status->done == seen[i].done) continue;
+        ramp_describe(status, line, sizeof(line));
+        printf(PREFIX " Step %d: %s\n", i + 1, line);
+        if (seen != NULL) seen[i] = *status;
+    }
+    fflush(stdout);
+    return ended;
+}
+
+#ifndef UNIT_TEST
+int main(int argc, char *argv[]) {
+    ramp_request req;
+    memset(&req, 0, sizeof(req));
+    req.kind = RAMP_SUBMIT;
+    bool follow = false;
+    double interval = 0.5;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--schedule") == 0 && i + 1 < argc) {
+            int bad_line;
+            int n = ramp_read_file(argv[++i], req.steps + req.count, &bad_line);
+            if (n < 0 || req.count + n > RAMP_MAX_STEPS) {
+                if (bad_line > 0) printf(PREFIX " %s:%d: malformed step\n", argv[i], bad_line);
+                else printf(PREFIX " Cannot read %s or more than %d steps\n", argv[i], RAMP_MAX_STEPS);
+                return EXIT_FAILURE;
+            }
+            req.count += n;
+        } else if (strcmp(argv[i], "--step") == 0 && i + 1 < argc) {
+            if (req.count == RAMP_MAX_STEPS || ramp_parse_step(argv[++i], &req.steps[req.count]) != 1) {
+                printf(PREFIX " Malformed step \"%s\", expected \"day HH:MM +N [over M]\" or \"day HH:MM -N\"\n",
+                       argv[i]);
+                return EXIT_FAILURE;
+            }
+            req.count++;
+        } else if (strcmp(argv[i], "--status") == 0) {
+            req.kind = RAMP_QUERY;
+        } else if (strcmp(argv[i], "--follow") == 0) {
+            follow = true;
+        } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            interval = atof(argv[++i]);
+        } else {
+            printf("usage: %s [--schedule FILE] [--step \"day HH:MM +N [over M]\"]... [--follow] [--interval SECONDS]\n"
+                   "       %s --status\n", argv[0], argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (req.kind == RAMP_SUBMIT && req.count == 0) {
+        printf(PREFIX " No step to submit, give --schedule or --step\n");
+        return EXIT_FAILURE;
+    }
+    if (interval <= 0.0) interval = 0.5;
+
+    key_t key = poste_key(KEY_NEW_USERS, proj_ID_USERS);
+    if (key == -1) { perror("poste_key"); return EXIT_FAILURE; }
+    mq_id qid = mq_open(key, 0, 0666);
+    if (qid < 0) {
+        perror("mq_open");
+        return EXIT_FAILURE;
+    }
+
+    ramp_reply reply;
+    if (!ask_director(qid, &req, &reply)) return EXIT_FAILURE;
+
+    if (req.kind == RAMP_QUERY) {
+        if (reply.schedule.count == 0) printf(PREFIX " No step submitted\n");
+        print_steps(&reply.schedule, 0, reply.schedule.count, NULL);
+        printf(PREFIX " Users spawned %d, retired %d\n", reply.schedule.spawned, reply.schedule.retired);
+        return EXIT_SUCCESS;
+    }
+    if (reply.first < 0) {
+        printf(PREFIX " The director refused the schedule: at most %d steps per run\n", RAMP_MAX_STEPS);
+        return EXIT_FAILURE;
+    }
+
+    int first = reply.first;
+    int rejected = 0;
+    for (int i = first; i < first + req.count; i++) rejected += reply.schedule.steps[i].state == RAMP_REJECTED;
+    printf(PREFIX " %d steps accepted as steps %d to %d, %d rejected\n",
+           req.count - rejected, first + 1, first + req.count, rejected);
+
+    struct S_ramp_status seen[RAMP_MAX_STEPS];
+    memset(seen, 0xff, sizeof(seen)); // No state yet, the first reply prints every step
+    bool ended = print_steps(&reply.schedule, first, req.count, seen);
+
+    struct timespec pause = {
+        .tv_sec  = (time_t)interval,
+        .tv_nsec = (long)((interval - (time_t)interval) * 1e9)
+    };
+    req.kind = RAMP_QUERY;
+    while (follow && !ended) {
+        nanosleep(&pause, NULL);
+        if (!ask_director(qid, &req, &reply)) {
+            printf(PREFIX " Run ended before every step did\n");
+            return EXIT_FAILURE;
+        }
+        ended = print_steps(&reply.schedule, first, req.count, seen);
+    }
+    return rejected == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#endif  // UNIT_TEST
@@ -0,0 +1,495 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE // wait4
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include <poste.h>
+#include <instance.h>
+#include <sim_run.h>
+
+#define PREFIX "\e[1;36m[POSTE SCALE]:\e[0m"
+
+#define MAX_POINTS 1024
+#define MAX_VALUES 16
+#define MAX_SETTINGS 32
+#define POLL_NS 100000000L   // Checks finished runs every 0.1s
+#define TICK_NOISE_US 1000.0 // Tick p99 changes below this are noise, not regressions
+
+// Where does the process-per-actor design fall over? Runs the simulation
+// headless over a grid of num_users, num_operators, num_worker_seats and
+// minute_duration, and records for every point the wall time per simulated
+// day, how late the director's minute ticks ran, the IPC messages per second,
+// the CPU of the director and all its actors, and their peak resident memory.
+// Points run one at a time unless --jobs says otherwise, so they do not
+// compete for cores. The table is a CSV; with --compare it is checked against
+// an earlier one and every metric that got worse by more than the tolerance
+// is reported as a regression.
+
+typedef enum POINT_STATUS {
+    POINT_PENDING,
+    POINT_OK,
+    POINT_EXPLODE,
+    POINT_TIMEOUT,
+    POINT_FAILED
+} POINT_STATUS;
+
+static const char *STATUS_NAMES[] = { "pending", "ok", "explode", "timeout", "failed" };
+
+struct S_point {
+    int users;
+    int operators;
+    int seats;
+    long minute_ns;
+
+    char instance[MAX_INSTANCE_LENGTH + 1];
+    pid_t pid;               // Director, also its process group
+    struct timespec started;
+    POINT_STATUS status;
+
+    int days_run;
+    double wall_per_day;     // Seconds of the director's run per simulated day
+    double tick_avg_us;
+    double tick_p99_us;
+    double tick_max_us;
+    long long late_ticks;
+    unsigned long long messages;
+    double messages_per_second;
+    double cpu_seconds;      // Director and every actor it reaped, from wait4
+    double cpu_per_day;
+    long long peak_rss_kb;   // Resident peaks of the roles, summed
+    int served;
+};
+
+struct S_scale {
+    const char *config_file;
+    const char *settings[MAX_SETTINGS]; // key=value lines added to every point
+    int n_settings;
+    long users[MAX_VALUES], operators[MAX_VALUES], seats[MAX_VALUES], minute_ns[MAX_VALUES];
+    int n_users, n_operators, n_seats, n_minute_ns;
+    int days;
+    int jobs;
+    int timeout;             // Seconds before a point is killed
+    bool keep;               // Keep the instance directories and logs
+    double tolerance;        // Percent a metric may get worse before it is a regression
+
+    struct S_point points[MAX_POINTS];
+    int count;
+};
+
+typedef struct S_point point;
+typedef struct S_scale scale;
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void on_interrupt(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+static double elapsed_seconds(const struct timespec *since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) + (now.tv_nsec - since->tv_nsec) / 1e9;
+}
+
+// Base config, then the point, then the --set overrides: the last line wins
+static bool write_point_config(const scale *s, const point *p, const char *path) {
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        perror("fopen for point config");
+        return false;
+    }
+    if (!sim_run_copy_config(s->config_file, out)) {
+        fclose(out);
+        return false;
+    }
+
+    fprintf(out, "num_users=%d\n", p->users);
+    fprintf(out, "num_operators=%d\n", p->operators);
+    fprintf(out, "num_worker_seats=%d\n", p->seats);
+    fprintf(out, "minute_duration=%ld\n", p->minute_ns);
+    fprintf(out, "sim_duration=%d\n", s->days + 1); // The director stops as the last day starts
+    fprintf(out, "fast_forward_closed=1\n");
+    for (int i = 0; i < s->n_settings; i++) fprintf(out, "%s\n", s->settings[i]);
+
+    fclose(out);
+    return true;
+}
+
+static bool launch(const scale *s, point *p, int index) {
+    char dir[MAX_PATH_LENGTH];
+    char config_path[MAX_PATH_LENGTH + 32];
+    snprintf(p->instance, sizeof(p->instance), "scale%d_%d", (int)getpid(), index);
+    instance_output_dir(p->instance, dir, sizeof(dir));
+    snprintf(config_path, sizeof(config_path), "%spoint.conf", dir);
+    if (!write_point_config(s, p, config_path)) return false;
+
+    p->pid = sim_run_launch(p->instance, config_path, s->keep);
+    if (p->pid < 0) return false;
+    clock_gettime(CLOCK_MONOTONIC, &p->started);
+    printf(PREFIX " Running %5d users, %3d operators, %2d seats, %ld ns minutes\n",
+           p->users, p->operators, p->seats, p->minute_ns);
+    return true;
+}
+
+static void read_results(point *p) {
+    FILE *fp = sim_run_results(p->instance);
+    if (fp == NULL) {
+        p->status = POINT_FAILED;
+        return;
+    }
+
+    char line[512];
+    char *fields[16];
+    bool global_row = false, role_rows = false;
+    double wall_seconds = 0.0;
+    p->status = POINT_OK;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        int n = csv_split_fields(line, fields, 16);
+        if (global_row && n >= 6) {
+            p->served = atoi(fields[4]);
+            global_row = false;
+        } else if (strcmp(fields[0], "Day") == 0 && n > 1 && strcmp(fields[1], "Minute") == 0) {
+            global_row = true;
+        } else if (strcmp(fields[0], "Role") == 0) {
+            role_rows = true;
+        } else if (role_rows && n >= 13) {
+            p->peak_rss_kb += atoll(fields[11]);
+        } else if (n == 2) {
+            role_rows = false;
+            if      (strcmp(fields[0], "ExitMode") == 0 && strcmp(fields[1], "explode") == 0) p->status = POINT_EXPLODE;
+            else if (strcmp(fields[0], "DaysRun") == 0)             p->days_run = atoi(fields[1]);
+            else if (strcmp(fields[0], "WallTime(s)") == 0)         wall_seconds = atof(fields[1]);
+            else if (strcmp(fields[0], "AvgTickLateness(us)") == 0) p->tick_avg_us = atof(fields[1]);
+            else if (strcmp(fields[0], "P99TickLateness(us)") == 0) p->tick_p99_us = atof(fields[1]);
+            else if (strcmp(fields[0], "MaxTickLateness(us)") == 0) p->tick_max_us = atof(fields[1]);
+            else if (strcmp(fields[0], "LateTicks") == 0)           p->late_ticks = atoll(fields[1]);
+            else if (strcmp(fields[0], "MessagesSent") == 0)        p->messages = strtoull(fields[1], NULL, 10);
+            else if (strcmp(fields[0], "MessagesPerSecond") == 0)   p->messages_per_second = atof(fields[1]);
+        } else {
+            role_rows = false;
+        }
+    }
+    fclose(fp);
+
+    int days = p->days_run > 0 ? p->days_run : 1;
+    p->wall_per_day = wall_seconds / days;
+    p->cpu_per_day  = p->cpu_seconds / days;
+}
+
+// Kills what is left of the run, reads its results and removes its instance
+static void finish(scale *s, point *p, bool timed_out, const struct rusage *ru) {
+    kill(-p->pid, SIGKILL); // Actors the director left behind, or all of them on timeout
+    if (timed_out) {
+        waitpid(p->pid, NULL, 0);
+        p->status = POINT_TIMEOUT;
+    } else {
+        // The director waited its actors, so its rusage covers them too
+        p->cpu_seconds = ru->ru_utime.tv_sec + ru->ru_utime.tv_usec / 1e6 +
+                         ru->ru_stime.tv_sec + ru->ru_stime.tv_usec / 1e6;
+        read_results(p);
+    }
+    sim_run_cleanup(p->instance, s->keep);
+
+    if (p->status != POINT_OK && p->status != POINT_EXPLODE) {
+        printf(PREFIX " %5d users: %s after %.1fs\n", p->users, STATUS_NAMES[p->status], elapsed_seconds(&p->started));
+        return;
+    }
+    printf(PREFIX " %5d users: %.2fs/day, tick p99 < %.0f us, %.0f msg/s, %.1f CPU s, %lld KB peak%s\n",
+           p->users, p->wall_per_day, p->tick_p99_us, p->messages_per_second, p->cpu_seconds,
+           p->peak_rss_kb, p->status == POINT_EXPLODE ? ", exploded" : "");
+}
+
+// Runs every point, at most jobs at a time
+static void run_points(scale *s) {
+    int next = 0, running = 0;
+    struct timespec poll = { .tv_sec = 0, .tv_nsec = POLL_NS };
+
+    while (next < s->count || running > 0) {
+        while (!interrupted && running < s->jobs && next < s->count) {
+            if (launch(s, &s->points[next], next)) running++;
+            else s->points[next].status = POINT_FAILED;
+            next++;
+        }
+        if (interrupted) next = s->count; // Launch nothing more, stop what runs
+
+        nanosleep(&poll, NULL);
+        for (int i = 0; i < next; i++) {
+            point *p = &s->points[i];
+            if (p->status != POINT_PENDING || p->pid <= 0) continue;
+
+            struct rusage ru;
+            if (wait4(p->pid, NULL, WNOHANG, &ru) == p->pid) {
+                finish(s, p, false, &ru);
+                running--;
+            } else if (interrupted || (s->timeout > 0 && elapsed_seconds(&p->started) > s->timeout)) {
+                finish(s, p, true, NULL);
+                running--;
+            }
+        }
+    }
+}
+
+#define TABLE_HEADER "Users,Operators,Seats,MinuteNs,Status,DaysRun,WallPerDay(s),TickAvg(us),TickP99(us)," \
+                     "TickMax(us),LateTicks,Messages,MessagesPerSec,CpuSeconds,CpuPerDay(s),PeakRssKB,ServedUsers"
+#define TABLE_COLUMNS 17
+
+static void write_table(const scale *s, FILE *fp) {
+    fprintf(fp, TABLE_HEADER "\n");
+    for (int i = 0; i < s->count; i++) {
+        const point *p = &s->points[i];
+        if (p->status == POINT_PENDING) continue;
+        fprintf(fp, "%d,%d,%d,%ld,%s,%d,%.3f,%.1f,%.0f,%.1f,%lld,%llu,%.1f,%.3f,%.3f,%lld,%d\n",
+                p->users, p->operators, p->seats, p->minute_ns, STATUS_NAMES[p->status], p->days_run,
+                p->wall_per_day, p->tick_avg_us, p->tick_p99_us, p->tick_max_us, p->late_ticks,
+                p->messages, p->messages_per_second, p->cpu_seconds, p->cpu_per_day,
+                p->peak_rss_kb, p->served);
+    }
+}
+
+// Reads a table written by write_table, false if it is missing or not one
+static bool load_table(const char *path, scale *out) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        perror("fopen for table");
+        return false;
+    }
+
+    char line[512];
+    char *f[TABLE_COLUMNS + 1];
+    bool header = fgets(line, sizeof(line), fp) != NULL &&
+                  strncmp(line, TABLE_HEADER, strlen(TABLE_HEADER)) == 0;
+    out->count = 0;
+    while (header && out->count < MAX_POINTS && fgets(line, sizeof(line), fp) != NULL) {
+        if (csv_split_fields(line, f, TABLE_COLUMNS + 1) != TABLE_COLUMNS) continue;
+        point *p = &out->points[out->count++];
+        memset(p, 0, sizeof(*p));
+        p->users     = atoi(f[0]);
+        p->operators = atoi(f[1]);
+        p->seats     = atoi(f[2]);
+        p->minute_ns = atol(f[3]);
+        p->status    = POINT_FAILED;
+        for (int k = 0; k < (int)(sizeof(STATUS_NAMES) / sizeof(STATUS_NAMES[0])); k++) {
+            if (strcmp(f[4], STATUS_NAMES[k]) == 0) p->status = (POINT_STATUS)k;
+        }
+        p->days_run            = atoi(f[5]);
+        p->wall_per_day        = atof(f[6]);
+        p->tick_avg_us         = atof(f[7]);
+        p->tick_p99_us         = atof(f[8]);
+        p->tick_max_us         = atof(f[9]);
+        p->late_ticks          = atoll(f[10]);
+        p->messages            = strtoull(f[11], NULL, 10);
+        p->messages_per_second = atof(f[12]);
+        p->cpu_seconds         = atof(f[13]);
+        p->cpu_per_day         = atof(f[14]);
+        p->peak_rss_kb         = atoll(f[15]);
+        p->served              = atoi(f[16]);
+    }
+    fclose(fp);
+
+    if (!header) printf(PREFIX " %s is not a poste_scale table\n", path);
+    return header;
+}
+
+static const point *find_point(const scale *s, const point *like) {
+    for (int i = 0; i < s->count; i++) {
+        const point *p = &s->points[i];
+        if (p->users == like->users && p->operators == like->operators &&
+            p->seats == like->seats && p->minute_ns == like->minute_ns) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// Percent the metric got worse, negative if it improved
+static double worse_pct(double before, double now, bool lower_is_better) {
+    if (before <= 0.0) return 0.0;
+    double change = 100.0 * (now - before) / before;
+    return lower_is_better ? change : -change;
+}
+
+static int check_metric(const point *p, const char *name, double before, double now,
+                        bool lower_is_better, double tolerance) {
+    double worse = worse_pct(before, now, lower_is_better);
+    if (worse <= tolerance) return 0;
+    printf(PREFIX " REGRESSION %5d users, %3d operators, %2d seats, %ld ns: %s %.3f -> %.3f (%+.1f%%)\n",
+           p->users, p->operators, p->seats, p->minute_ns, name, before, now, worse);
+    return 1;
+}
+
+// Checks the points of current against baseline, returns the regressions found
+static int compare(const scale *baseline, const scale *current, double tolerance) {
+    printf("\n" PREFIX " === Compared with the baseline (tolerance %.0f%%) ===\n", tolerance);
+    int regressions = 0, compared = 0;
+    for (int i = 0; i < current->count; i++) {
+        const point *now = &current->points[i];
+        const point *before = find_point(baseline, now);
+        if (before == NULL) continue;
+        compared++;
+
+        if (before->status == POINT_OK && now->status != POINT_OK) {
+            printf(PREFIX " REGRESSION %5d users, %3d operators, %2d seats, %ld ns: %s -> %s\n",
+                   now->users, now->operators, now->seats, now->minute_ns,
+                   STATUS_NAMES[before->status], STATUS_NAMES[now->status]);
+            regressions++;
+            continue;
+        }
+        if (before->status != POINT_OK || now->status != POINT_OK) continue;
+
+        regressions += check_metric(now, "wall s/day", before->wall_per_day, now->wall_per_day, true, tolerance);
+        regressions += check_metric(now, "CPU s/day", before->cpu_per_day, now->cpu_per_day, true, tolerance);
+        regressions += check_metric(now, "peak RSS KB", (double)before->peak_rss_kb, (double)now->peak_rss_kb,
+                                    true, tolerance);
+        regressions += check_metric(now, "msg/s", before->messages_per_second, now->messages_per_second,
+                                    false, tolerance);
+        if (now->tick_p99_us > TICK_NOISE_US) {
+            regressions += check_metric(now, "tick p99 us", before->tick_p99_us, now->tick_p99_us, true, tolerance);
+        }
+    }
+    printf(PREFIX " %d points compared, %d regressions\n", compared, regressions);
+    return regressions;
+}
+
+// Comma separated positive values
+static bool parse_list(const char *arg, long values[], int *n) {
+    *n = 0;
+    const char *p = arg;
+    while (*p != '\0' && *n < MAX_VALUES) {
+        char *end;
+        long v = strtol(p, &end, 10);
+        if (end == p || v <= 0) return false;
+        values[(*n)++] = v;
+        if (*end == '\0') return true;
+        if (*end != ',') return false;
+        p = end + 1;
+    }
+    return false;
+}
+
+static void usage(const char *prog) {
+    printf("usage: %s [--config FILE] [--users N,N,...] [--operators N,...] [--seats N,...]\n"
+           "          [--minute-ns N,...] [--days N] [--jobs N] [--timeout SECONDS]\n"
+           "          [--set KEY=VALUE]... [--keep] [--out FILE]\n"
+           "          [--compare BASELINE.csv [--current TABLE.csv] [--tolerance PCT]]\n", prog);
+}
+
+#ifndef UNIT_TEST
+int main(const int argc, const char *argv[]) {
+    static scale s;
+    static scale baseline;
+    s.users[0] = 10; s.users[1] = 100; s.users[2] = 1000; s.users[3] = 10000;
+    s.n_users = 4;
+    s.operators[0] = NUM_OPERATORS;    s.n_operators = 1;
+    s.seats[0]     = NUM_WORKER_SEATS; s.n_seats     = 1;
+    s.minute_ns[0] = N_NANO_SECS;      s.n_minute_ns = 1;
+    s.days      = 1;
+    s.jobs      = 1;
+    s.timeout   = 600;
+    s.tolerance = 10.0;
+    const char *out_path = NULL, *baseline_path = NULL, *current_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        bool ok = true;
+        if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            s.config_file = argv[++i];
+        } else if (strcmp(argv[i], "--users") == 0 && i + 1 < argc) {
+            ok = parse_list(argv[++i], s.users, &s.n_users);
+        } else if (strcmp(argv[i], "--operators") == 0 && i + 1 < argc) {
+            ok = parse_list(argv[++i], s.operators, &s.n_operators);
+        } else if (strcmp(argv[i], "--seats") == 0 && i + 1 < argc) {
+            ok = parse_list(argv[++i], s.seats, &s.n_seats);
+            for (int k = 0; ok && k < s.n_seats; k++) ok = s.seats[k] <= MAX_WORKER_SEATS;
+        } else if (strcmp(argv[i], "--minute-ns") == 0 && i + 1 < argc) {
+            ok = parse_list(argv[++i], s.minute_ns, &s.n_minute_ns);
+        } else if (strcmp(argv[i], "--days") == 0 && i + 1 < argc) {
+            s.days = atoi(argv[++i]);
+            ok = s.days > 0;
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            s.jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            s.timeout = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--set") == 0 && i + 1 < argc && s.n_settings < MAX_SETTINGS) {
+            s.settings[s.n_settings++] = argv[++i];
+        } else if (strcmp(argv[i], "--keep") == 0) {
+            s.keep = true;
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--current") == 0 && i + 1 < argc) {
+            current_path = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            s.tolerance = atof(argv[++i]);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (s.jobs < 1) s.jobs = 1;
+    if (current_path != NULL && baseline_path == NULL) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (baseline_path != NULL && !load_table(baseline_path, &baseline)) return EXIT_FAILURE;
+
+    // Compare two tables without running anything
+    if (current_path != NULL) {
+        if (!load_table(current_path, &s)) return EXIT_FAILURE;
+        return compare(&baseline, &s, s.tolerance) > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    if (access(DIRECTOR_PATH, X_OK) != 0) {
+        printf(PREFIX " %s not found, run make all from the repository root\n", DIRECTOR_PATH);
+        return EXIT_FAILURE;
+    }
+
+    for (int m = 0; m < s.n_minute_ns; m++)
+        for (int k = 0; k < s.n_seats; k++)
+            for (int o = 0; o < s.n_operators; o++)
+                for (int u = 0; u < s.n_users && s.count < MAX_POINTS; u++) {
+                    point *p = &s.points[s.count++];
+                    p->users     = (int)s.users[u];
+                    p->operators = (int)s.operators[o];
+                    p->seats     = (int)s.seats[k];
+                    p->minute_ns = s.minute_ns[m];
+                }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_interrupt;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    printf(PREFIX " %d points, %d day(s) each, %d job(s)\n", s.count, s.days, s.jobs);
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    run_points(&s);
+
+    char filename[MAX_PATH_LENGTH + 32];
+    FILE *fp = out_path != NULL ? fopen(out_path, "w") : open_csv("scale", filename, sizeof(filename));
+    if (fp == NULL) {
+        perror("fopen for --out");
+    } else {
+        write_table(&s, fp);
+        fclose(fp);
+        printf(PREFIX " Table written to %s\n", out_path != NULL ? out_path : filename);
+    }
+    printf(PREFIX " %d simulations in %.1fs\n", s.count, elapsed_seconds(&started));
+
+    int regressions = baseline_path != NULL ? compare(&baseline, &s, s.tolerance) : 0;
+    return interrupted || regressions > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif  // UNIT_TEST
@@ -0,0 +1,416 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <poste.h>
+#include <instance.h>
+#include <sim_run.h>
+
+#define PREFIX "\e[1;32m[POSTE SEARCH]:\e[0m"
+
+#define MAX_CANDIDATES 1024
+#define MAX_SETTINGS 32
+#define MAX_SEAT_VALUES MAX_WORKER_SEATS
+#define POLL_NS 100000000L // Checks finished candidates every 0.1s
+
+// Finds the fewest operators and seats that meet service level objectives.
+// Every candidate is a full simulation (bin/direttore) run under its own
+// POSTE_INSTANCE, so candidates run side by side, one per core. For each seat
+// count the operators are bisected: all seat counts advance one bisection step
+// per round, in parallel. A candidate that misses the objectives also rules out
+// its operator count for fewer seats. Feasible candidates are reported with
+// their Pareto frontier over operators, seats and p90 wait.
+
+struct S_slo {
+    int p90_wait;          // Minutes from ticket to seat, 90th percentile
+    double max_failed_pct; // Failed services over all requests
+};
+
+struct S_candidate {
+    int operators;
+    int seats;
+    char instance[MAX_INSTANCE_LENGTH + 1];
+    pid_t pid;             // Director, also its process group
+    struct timespec started;
+
+    bool finished;         // Director exited and its CSV was read
+    bool ran;              // final_stats.csv found
+    bool explode;
+    bool timed_out;
+    int p90_wait;
+    int served;
+    int failed;
+    double failed_pct;
+    double wall_seconds;
+    bool feasible;
+};
+
+struct S_search {
+    const char *config_file;
+    const char *settings[MAX_SETTINGS]; // key=value lines added to every candidate
+    int n_settings;
+    int operators_lo, operators_hi;
+    int seats_lo, seats_hi, seats_step;
+    int days;              // sim_duration of the candidates, 0 for the config one
+    int jobs;
+    int timeout;           // Seconds before a candidate is killed
+    bool keep;             // Keep the candidate directories
+    struct S_slo slo;
+
+    struct S_candidate candidates[MAX_CANDIDATES];
+    int count;
+};
+
+typedef struct S_candidate candidate;
+typedef struct S_search    search;
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void on_interrupt(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+static double elapsed_seconds(const struct timespec *since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) + (now.tv_nsec - since->tv_nsec) / 1e9;
+}
+
+static candidate *find_candidate(search *s, int operators, int seats) {
+    for (int i = 0; i < s->count; i++) {
+        if (s->candidates[i].operators == operators && s->candidates[i].seats == seats) {
+            return &s->candidates[i];
+        }
+    }
+    return NULL;
+}
+
+// Base config, then the candidate values, then the --set overrides: the last line wins
+static bool write_candidate_config(const search *s, const candidate *c, const char *path) {
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        perror("fopen for candidate config");
+        return false;
+    }
+
+    if (!sim_run_copy_config(s->config_file, out)) {
+        fclose(out);
+        return false;
+    }
+
+    fprintf(out, "num_operators=%d\n", c->operators);
+    fprintf(out, "num_worker_seats=%d\n", c->seats);
+    fprintf(out, "fast_forward_closed=1\n");
+    if (s->days > 0) fprintf(out, "sim_duration=%d\n", s->days);
+    for (int i = 0; i < s->n_settings; i++) fprintf(out, "%s\n", s->settings[i]);
+
+    fclose(out);
+    return true;
+}
+
+static bool launch(const search *s, candidate *c) {
+    char dir[MAX_PATH_LENGTH];
+    char config_path[MAX_PATH_LENGTH + 32];
+    snprintf(c->instance, sizeof(c->instance), "search%d_o%d_s%d", (int)getpid(), c->operators, c->seats);
+    instance_output_dir(c->instance, dir, sizeof(dir));
+    snprintf(config_path, sizeof(config_path), "%scandidate.conf", dir);
+    if (!write_candidate_config(s, c, config_path)) return false;
+
+    c->pid = sim_run_launch(c->instance, config_path, s->keep);
+    if (c->pid < 0) return false;
+    clock_gettime(CLOCK_MONOTONIC, &c->started);
+    printf(PREFIX " Running %2d operators, %2d seats\n", c->operators, c->seats);
+    return true;
+}
+
+static void read_results(candidate *c) {
+    FILE *fp = sim_run_results(c->instance);
+    if (fp == NULL) return;
+
+    char line[512];
+    char *fields[16];
+    bool global_row = false;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        int n = csv_split_fields(line, fields, 16);
+        if (global_row && n >= 6) {
+            c->served = atoi(fields[4]);
+            c->failed = atoi(fields[5]);
+            global_row = false;
+        } else if (strcmp(fields[0], "Day") == 0 && n > 1 && strcmp(fields[1], "Minute") == 0) {
+            global_row = true;
+        } else if (n == 2 && strcmp(fields[0], "ExitMode") == 0) {
+            c->explode = strcmp(fields[1], "explode") == 0;
+        } else if (n == 2 && strcmp(fields[0], "P90(minutes)") == 0) {
+            c->p90_wait = atoi(fields[1]);
+        }
+    }
+    fclose(fp);
+
+    c->ran = true;
+    int requests = c->served + c->failed;
+    c->failed_pct = requests > 0 ? 100.0 * c->failed / requests : 0.0;
+}
+
+// Kills what is left of the candidate, reads its results and removes its instance
+static void finish(search *s, candidate *c, bool timed_out) {
+    kill(-c->pid, SIGKILL); // Children the director left behind, or all of them on timeout
+    if (timed_out) waitpid(c->pid, NULL, 0);
+
+    c->timed_out    = timed_out;
+    c->wall_seconds = elapsed_seconds(&c->started);
+    if (!timed_out) read_results(c);
+    c->feasible = c->ran && !c->explode &&
+                  c->p90_wait <= s->slo.p90_wait &&
+                  c->failed_pct <= s->slo.max_failed_pct;
+    c->finished = true;
+    sim_run_cleanup(c->instance, s->keep);
+
+    if (!c->ran) {
+        printf(PREFIX " %2d operators, %2d seats: %s\n", c->operators, c->seats,
+               timed_out ? "timed out" : "no results");
+    } else {
+        printf(PREFIX " %2d operators, %2d seats: p90 wait %d min, failed %.1f%%%s -> %s (%.1fs)\n",
+               c->operators, c->seats, c->p90_wait, c->failed_pct, c->explode ? ", exploded" : "",
+               c->feasible ? "meets" : "misses", c->wall_seconds);
+    }
+}
+
+// Runs the candidates from first to s->count, at most jobs at a time
+static void run_batch(search *s, int first) {
+    int next = first, running = 0;
+    struct timespec poll = { .tv_sec = 0, .tv_nsec = POLL_NS };
+
+    while (next < s->count || running > 0) {
+        while (!interrupted && running < s->jobs && next < s->count) {
+            if (launch(s, &s->candidates[next])) running++;
+            else s->candidates[next].finished = true;
+            next++;
+        }
+        if (interrupted) {
+            // Launch nothing more, stop what runs
+            for (int i = next; i < s->count; i++) s->candidates[i].finished = true;
+            next = s->count;
+        }
+
+        nanosleep(&poll, NULL);
+        for (int i = first; i < next; i++) {
+            candidate *c = &s->candidates[i];
+            if (c->finished) continue;
+
+            if (waitpid(c->pid, NULL, WNOHANG) == c->pid) {
+                finish(s, c, false);
+                running--;
+            } else if (interrupted || (s->timeout > 0 && elapsed_seconds(&c->started) > s->timeout)) {
+                finish(s, c, true);
+                running--;
+            }
+        }
+    }
+}
+
+// Smallest operator count meeting the objectives, bisected for each seat count.
+// lo..hi-1 is still open, hi is the best feasible count found (operators_hi + 1 if none).
+static void bisect(search *s) {
+    int seat_values[MAX_SEAT_VALUES];
+    int lo[MAX_SEAT_VALUES], hi[MAX_SEAT_VALUES];
+    int n = 0;
+    for (int seats = s->seats_lo; seats <= s->seats_hi && n < MAX_SEAT_VALUES; seats += s->seats_step) {
+        seat_values[n] = seats;
+        lo[n] = s->operators_lo;
+        hi[n] = s->operators_hi + 1;
+        n++;
+    }
+
+    for (int round = 1; !interrupted; round++) {
+        int first = s->count;
+        for (int i = 0; i < n; i++) {
+            if (lo[i] >= hi[i]) continue;
+            int mid = lo[i] + (hi[i] - lo[i]) / 2;
+            if (find_candidate(s, mid, seat_values[i]) != NULL || s->count == MAX_CANDIDATES) continue;
+            candidate *c = &s->candidates[s->count++];
+            memset(c, 0, sizeof(*c));
+            c->operators = mid;
+            c->seats     = seat_values[i];
+        }
+        if (s->count == first) break;
+
+        printf(PREFIX " Round %d: %d candidates\n", round, s->count - first);
+        run_batch(s, first);
+
+        // Narrow every seat count on the candidates of this round
+        for (int k = first; k < s->count; k++) {
+            const candidate *c = &s->candidates[k];
+            if (!c->finished) continue;
+            for (int i = 0; i < n; i++) {
+                if (seat_values[i] == c->seats) {
+                    if (c->feasible) { if (c->operators < hi[i]) hi[i] = c->operators; }
+                    else if (c->operators >= lo[i]) lo[i] = c->operators + 1;
+                } else if (seat_values[i] < c->seats && !c->feasible && c->ran) {
+                    // Fewer seats do not help: that many operators miss there too
+                    if (c->operators >= lo[i]) lo[i] = c->operators + 1;
+                }
+                if (lo[i] > hi[i]) lo[i] = hi[i];
+            }
+        }
+    }
+}
+
+// No other feasible candidate is as good on operators, seats and p90 wait, and better on one
+static bool on_frontier(const search *s, const candidate *c) {
+    for (int i = 0; i < s->count; i++) {
+        const candidate *o = &s->candidates[i];
+        if (o == c || !o->feasible) continue;
+        bool as_good = o->operators <= c->operators && o->seats <= c->seats && o->p90_wait <= c->p90_wait;
+        bool better  = o->operators <  c->operators || o->seats <  c->seats || o->p90_wait <  c->p90_wait;
+        if (as_good && better) return false;
+    }
+    return true;
+}
+
+static void report(const search *s) {
+    printf("\n" PREFIX " === Candidates (p90 wait <= %d min, failed <= %.1f%%, no explode) ===\n",
+           s->slo.p90_wait, s->slo.max_failed_pct);
+    printf("%9s %5s %8s %8s %8s %8s %9s\n", "operators", "seats", "p90", "failed%", "explode", "meets", "wall(s)");
+    for (int i = 0; i < s->count; i++) {
+        const candidate *c = &s->candidates[i];
+        if (!c->ran) {
+            printf("%9d %5d %8s\n", c->operators, c->seats, c->timed_out ? "timeout" : "n/a");
+            continue;
+        }
+        printf("%9d %5d %8d %8.1f %8s %8s %9.1f\n", c->operators, c->seats, c->p90_wait, c->failed_pct,
+               c->explode ? "yes" : "no", c->feasible ? "yes" : "no", c->wall_seconds);
+    }
+
+    printf("\n" PREFIX " === Pareto frontier (operators, seats, p90 wait) ===\n");
+    const candidate *best = NULL;
+    for (int i = 0; i < s->count; i++) {
+        const candidate *c = &s->candidates[i];
+        if (!c->feasible || !on_frontier(s, c)) continue;
+        printf(PREFIX " %2d operators, %2d seats: p90 wait %d min, failed %.1f%%\n",
+               c->operators, c->seats, c->p90_wait, c->failed_pct);
+        if (best == NULL || c->operators + c->seats < best->operators + best->seats ||
+            (c->operators + c->seats == best->operators + best->seats && c->p90_wait < best->p90_wait)) {
+            best = c;
+        }
+    }
+
+    if (best == NULL) {
+        printf(PREFIX " No candidate meets the objectives, widen --operators or --seats\n");
+    } else {
+        printf(PREFIX " Fewest operators + seats: %d operators, %d seats\n", best->operators, best->seats);
+    }
+}
+
+static void write_results(const search *s) {
+    char filename[MAX_PATH_LENGTH + 32];
+    FILE *fp = open_csv("search", filename, sizeof(filename));
+    if (fp == NULL) return;
+
+    fprintf(fp, "Operators,Seats,P90Wait(minutes),FailedPct,Explode,TimedOut,Meets,Pareto,WallTime(s)\n");
+    for (int i = 0; i < s->count; i++) {
+        const candidate *c = &s->candidates[i];
+        if (!c->finished) continue;
+        fprintf(fp, "%d,%d,%d,%.2f,%d,%d,%d,%d,%.2f\n", c->operators, c->seats,
+                c->ran ? c->p90_wait : -1, c->failed_pct, c->explode, c->timed_out,
+                c->feasible, c->feasible && on_frontier(s, c), c->wall_seconds);
+    }
+    fclose(fp);
+    printf(PREFIX " Candidates written to %s\n", filename);
+}
+
+static bool parse_range(const char *arg, int *lo, int *hi) {
+    if (sscanf(arg, "%d:%d", lo, hi) == 2) return *lo > 0 && *lo <= *hi;
+    if (sscanf(arg, "%d", lo) == 1) {
+        *hi = *lo;
+        return *lo > 0;
+    }
+    return false;
+}
+
+static void usage(const char *prog) {
+    printf("usage: %s [--config FILE] [--operators LO:HI] [--seats LO:HI] [--seat-step N]\n"
+           "          [--p90-wait MINUTES] [--max-failed PCT] [--days N] [--jobs N]\n"
+           "          [--timeout SECONDS] [--set KEY=VALUE]... [--keep]\n", prog);
+}
+
+#ifndef UNIT_TEST
+int main(const int argc, const char *argv[]) {
+    static search s;
+    s.operators_lo = 1;
+    s.operators_hi = AUTOSCALE_MAX_OPERATORS;
+    s.seats_lo     = 5;
+    s.seats_hi     = MAX_WORKER_SEATS;
+    s.seats_step   = 5;
+    s.jobs         = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    s.timeout      = 600;
+    s.slo.p90_wait       = 30;
+    s.slo.max_failed_pct = 100.0; // Off unless --max-failed
+
+    for (int i = 1; i < argc; i++) {
+        bool ok = true;
+        if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            s.config_file = argv[++i];
+        } else if (strcmp(argv[i], "--operators") == 0 && i + 1 < argc) {
+            ok = parse_range(argv[++i], &s.operators_lo, &s.operators_hi) &&
+                 s.operators_hi <= MAX_OPERATOR_STATES;
+        } else if (strcmp(argv[i], "--seats") == 0 && i + 1 < argc) {
+            ok = parse_range(argv[++i], &s.seats_lo, &s.seats_hi) && s.seats_hi <= MAX_WORKER_SEATS;
+        } else if (strcmp(argv[i], "--seat-step") == 0 && i + 1 < argc) {
+            s.seats_step = atoi(argv[++i]);
+            ok = s.seats_step > 0;
+        } else if (strcmp(argv[i], "--p90-wait") == 0 && i + 1 < argc) {
+            s.slo.p90_wait = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-failed") == 0 && i + 1 < argc) {
+            s.slo.max_failed_pct = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--days") == 0 && i + 1 < argc) {
+            s.days = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            s.jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            s.timeout = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--set") == 0 && i + 1 < argc && s.n_settings < MAX_SETTINGS) {
+            s.settings[s.n_settings++] = argv[++i];
+        } else if (strcmp(argv[i], "--keep") == 0) {
+            s.keep = true;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (s.jobs < 1) s.jobs = 1;
+
+    if (access(DIRECTOR_PATH, X_OK) != 0) {
+        printf(PREFIX " %s not found, run make all from the repository root\n", DIRECTOR_PATH);
+        return EXIT_FAILURE;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_interrupt;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    printf(PREFIX " Operators %d-%d, seats %d-%d step %d, %d jobs\n",
+           s.operators_lo, s.operators_hi, s.seats_lo, s.seats_hi, s.seats_step, s.jobs);
+
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    bisect(&s);
+
+    report(&s);
+    write_results(&s);
+    printf(PREFIX " %d simulations in %.1fs\n", s.count, elapsed_seconds(&started));
+    return interrupted ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif  // UNIT_TEST
@@ -0,0 +1,155 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <poste.h>
+#include <stats.h>
+#include <shared_mem.h>
+#include <config_shm.h>
+
+#define PREFIX "\e[1;37m[POSTE TOP]:\e[0m"
+
+#define CLEAR_SCREEN "\033[H\033[2J"
+
+// Live monitor of a running simulation, like top.
+// Both segments are mapped read-only: counters come from a seqlock snapshot,
+// so the monitor never takes stats_lock and never slows the hot path down.
+// Seats are read without stations_lock, each field is read atomically but
+// a refresh may mix seats from before and after a concurrent change.
+
+typedef struct S_poste_stats     poste_stats;
+typedef struct S_poste_stations  poste_stations;
+
+struct S_seat_usage {
+    int assigned;  // Seats serving the service today
+    int staffed;   // Of which with an operator
+    int busy;      // Of which with a user being served
+};
+
+typedef struct S_seat_usage seat_usage;
+
+static volatile sig_atomic_t running = 1;
+
+static void on_interrupt(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+static void count_seats(const poste_stations *stations, seat_usage usage[NUM_SERVICE_TYPES]) {
+    memset(usage, 0, sizeof(seat_usage) * NUM_SERVICE_TYPES);
+    for (int i = 0; i < g_config.num_worker_seats && i < MAX_WORKER_SEATS; i++) {
+        const struct S_worker_seat *seat = &stations->NOF_WORKER_SEATS[i];
+        if (seat->service_id < 0 || seat->service_id >= NUM_SERVICE_TYPES) continue;
+
+        usage[seat->service_id].assigned++;
+        if (seat->operator_status == OCCUPIED) usage[seat->service_id].staffed++;
+        if (seat->user_status == OCCUPIED)     usage[seat->service_id].busy++;
+    }
+}
+
+static double average(double total, int count) {
+    return count > 0 ? total / count : 0.0;
+}
+
+static void draw(const struct S_stats_snapshot *snap, const seat_usage usage[NUM_SERVICE_TYPES], double interval) {
+    printf(CLEAR_SCREEN);
+    printf(PREFIX " day %d  %02d:%02d  (shift %02d:00-%02d:00, refresh %.1fs)\n\n",
+           snap->current_day, snap->current_minute / 60, snap->current_minute % 60,
+           g_config.worker_shift_open, g_config.worker_shift_close, interval);
+
+    printf("%-40s %7s %7s %6s %7s %9s %9s %6s %7s %5s\n",
+           "Service (today)", "served", "failed", "late", "waiting", "avg wait", "avg serv", "seats", "staffed", "busy");
+
+    seat_usage total_usage = {0};
+    int total_waiting = 0;
+    for (int i = 0; i < NUM_SERVICE_TYPES; i++) {
+        const struct S_service_stats *svc = &snap->today.services[i];
+        printf("%-40s %7d %7d %6d %7d %9.2f %9.2f %6d %7d %5d\n",
+               services[i], svc->served_users, svc->failed_services, svc->late_users, snap->waiting_users[i],
+               average(svc->total_wait_time, svc->total_requests),
+               average(svc->total_service_time, svc->total_requests),
+               usage[i].assigned, usage[i].staffed, usage[i].busy);
+
+        total_usage.assigned += usage[i].assigned;
+        total_usage.staffed  += usage[i].staffed;
+        total_usage.busy     += usage[i].busy;
+        total_waiting        += snap->waiting_users[i];
+    }
+
+    const struct S_service_stats *today = &snap->today.global;
+    printf("%-40s %7d %7d %6d %7d %9.2f %9.2f %6d %7d %5d\n\n", "Total",
+           today->served_users, today->failed_services, snap->today.late_users, total_waiting,
+           average(today->total_wait_time, today->total_requests),
+           average(today->total_service_time, today->total_requests),
+           total_usage.assigned, total_usage.staffed, total_usage.busy);
+
+    printf("Operators active today: %d   pauses today: %d\n",
+           snap->today.active_operators, snap->today.total_pauses);
+    printf("Simulation: served %d, failed %d, late %d, pauses %d\n",
+           snap->simulation_global.served_users, snap->simulation_global.failed_services,
+           snap->simulation_global.late_users, snap->total_simulation_pauses);
+    fflush(stdout);
+}
+
+#ifndef UNIT_TEST
+int main(const int argc, const char *argv[]) {
+    double interval = 1.0;
+    int iterations = 0; // 0 -> until interrupted
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            interval = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else {
+            printf("usage: %s [--interval SECONDS] [--iterations N]\n", argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (interval <= 0.0) interval = 1.0;
+
+    const poste_stats *stats = attach_shared_memory(SHM_STATS_NAME, SHM_STATS_SIZE, PROT_READ);
+    const poste_stations *stations = attach_shared_memory(SHM_STATIONS_NAME, SHM_STATIONS_SIZE, PROT_READ);
+    if (stats == NULL || stations == NULL) {
+        printf(PREFIX " Shared memory not found, is the simulation running?\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!config_shm_attach()) {
+        // Copy the path, load_config takes a mutable string
+        char config_file[MAX_PATH_LENGTH];
+        memcpy(config_file, stats->configuration_file, MAX_PATH_LENGTH);
+        config_file[MAX_PATH_LENGTH - 1] = '\0';
+        load_config(config_file);
+    }
+
+    signal(SIGINT, on_interrupt);
+    signal(SIGTERM, on_interrupt);
+
+    struct timespec pause = {
+        .tv_sec  = (time_t)interval,
+        .tv_nsec = (long)((interval - (time_t)interval) * 1e9)
+    };
+
+    struct S_stats_snapshot snap;
+    seat_usage usage[NUM_SERVICE_TYPES];
+    for (int n = 0; running && (iterations == 0 || n < iterations); n++) {
+        config_shm_refresh();
+        stats_snapshot(stats, &snap);
+        count_seats(stations, usage);
+        draw(&snap, usage, interval);
+
+        if (iterations == 0 || n + 1 < iterations) nanosleep(&pause, NULL);
+    }
+
+    detach_shared_memory(SHM_STATS_SIZE, (void *)stats);
+    detach_shared_memory(SHM_STATIONS_SIZE, (void *)stations);
+    return EXIT_SUCCESS;
+}
+#endif  // UNIT_TEST
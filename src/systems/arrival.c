@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <arrival.h>
+
+// Uniform in [0, 1)
+static double uniform(void) {
+    return rand() / ((double)RAND_MAX + 1.0);
+}
+
+bool alias_build(struct S_alias_table *table, const double weights[], int n) {
+    if (n < 1 || n > ALIAS_MAX_SIZE) return false;
+
+    double total = 0.0;
+    for (int i = 0; i < n; i++) {
+        if (weights[i] > 0) total += weights[i];
+    }
+    if (total <= 0.0) return false;
+
+    // Weights scaled to an average of 1, split into those under and over it
+    double scaled[ALIAS_MAX_SIZE];
+    int small[ALIAS_MAX_SIZE], large[ALIAS_MAX_SIZE];
+    int n_small = 0, n_large = 0;
+    for (int i = 0; i < n; i++) {
+        scaled[i] = (weights[i] > 0 ? weights[i] : 0.0) * n / total;
+        if (scaled[i] < 1.0) small[n_small++] = i;
+        else                 large[n_large++] = i;
+    }
+
+    // Every small column is topped up to 1 by a large one
+    while (n_small > 0 && n_large > 0) {
+        int s = small[--n_small];
+        int l = large[--n_large];
+        table->prob[s]  = scaled[s];
+        table->alias[s] = l;
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) small[n_small++] = l;
+        else                 large[n_large++] = l;
+    }
+    // What is left is 1 up to rounding
+    while (n_large > 0) {
+        int l = large[--n_large];
+        table->prob[l]  = 1.0;
+        table->alias[l] = l;
+    }
+    while (n_small > 0) {
+        int s = small[--n_small];
+        table->prob[s]  = 1.0;
+        table->alias[s] = s;
+    }
+
+    table->size = n;
+    return true;
+}
+
+int alias_sample(const struct S_alias_table *table, double u) {
+    double x = u * table->size;
+    int i = (int)x;
+    if (i >= table->size) i = table->size - 1;
+    return x - i < table->prob[i] ? i : table->alias[i];
+}
+
+static bool mix_set(const int mix[NUM_SERVICE_TYPES]) {
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        if (mix[s] > 0) return true;
+    }
+    return false;
+}
+
+// Weight of an hour of the shift, the last one given goes on
+static int profile_weight(const struct poste_config *config, int hour) {
+    if (hour >= config->num_profile_hours) hour = config->num_profile_hours - 1;
+    return config->arrival_profile[hour];
+}
+
+int arrival_service(void) {
+    static struct S_alias_table table;
+    static int built_mix[NUM_SERVICE_TYPES];
+    static bool built = false;
+
+    if (!mix_set(g_config.service_mix)) return rand() % NUM_SERVICE_TYPES;
+
+    // Built again after a config reload changes the mix
+    if (!built || memcmp(built_mix, g_config.service_mix, sizeof(built_mix)) != 0) {
+        double weights[NUM_SERVICE_TYPES];
+        for (int s = 0; s < NUM_SERVICE_TYPES; s++) weights[s] = g_config.service_mix[s];
+        alias_build(&table, weights, NUM_SERVICE_TYPES);
+        memcpy(built_mix, g_config.service_mix, sizeof(built_mix));
+        built = true;
+    }
+    return alias_sample(&table, uniform());
+}
+
+int arrival_walk_in(int shift_start, int window) {
+    static struct S_alias_table table;
+    static int built_profile[MAX_PROFILE_HOURS];
+    static int built_hours = 0;
+    static int built_window = 0;
+    static bool usable = false;
+
+    if (window < 1) window = 1;
+    if (g_config.num_profile_hours == 0) return shift_start + (rand() % window) + 1;
+
+    // One bucket per hour of the window, the last one maybe shorter. Built
+    // again when the window or the profile changes.
+    int hours = (window + 59) / 60;
+    if (hours > ALIAS_MAX_SIZE) hours = ALIAS_MAX_SIZE;
+    if (window != built_window || g_config.num_profile_hours != built_hours ||
+        memcmp(built_profile, g_config.arrival_profile, sizeof(built_profile)) != 0) {
+        double weights[ALIAS_MAX_SIZE];
+        for (int h = 0; h < hours; h++) {
+            int length = window - h * 60 < 60 ? window - h * 60 : 60;
+            weights[h] = (double)profile_weight(&g_config, h) * length;
+        }
+        usable = alias_build(&table, weights, hours);
+        built_window = window;
+        built_hours  = g_config.num_profile_hours;
+        memcpy(built_profile, g_config.arrival_profile, sizeof(built_profile));
+    }
+    if (!usable) return shift_start + (rand() % window) + 1; // Every hour left weighs 0
+
+    int hour = alias_sample(&table, uniform());
+    int length = window - hour * 60 < 60 ? window - hour * 60 : 60;
+    return shift_start + hour * 60 + (int)(uniform() * length) + 1;
+}
+
+void arrival_service_shares(const struct poste_config *config, double shares[NUM_SERVICE_TYPES]) {
+    double total = 0.0;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) total += config->service_mix[s];
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        shares[s] = total > 0 ? config->service_mix[s] / total : 1.0 / NUM_SERVICE_TYPES;
+    }
+}
+
+int arrival_hour_shares(const struct poste_config *config, double shares[MAX_PROFILE_HOURS]) {
+    int hours = config->worker_shift_close - config->worker_shift_open;
+    if (hours < 1) return 0;
+    if (hours > MAX_PROFILE_HOURS) hours = MAX_PROFILE_HOURS;
+
+    double total = 0.0;
+    for (int h = 0; h < hours; h++) {
+        shares[h] = config->num_profile_hours > 0 ? profile_weight(config, h) : 1.0;
+        total += shares[h];
+    }
+    for (int h = 0; h < hours; h++) {
+        shares[h] = total > 0 ? shares[h] / total : 1.0 / hours;
+    }
+    return hours;
+}
@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+
+#include <branch.h>
+#include <comunications.h>
+#include <utilization.h>
+
+const char *branch_routing_names[] = { "distance", "load" };
+
+void branch_shm_name(const char *name, int branch, char *out, size_t size) {
+    if (branch == 0) {
+        snprintf(out, size, "%s", name);
+    } else {
+        snprintf(out, size, "%s_b%d", name, branch);
+    }
+}
+
+int branch_ticket_proj_id(int branch) {
+    return PROJ_ID + branch;
+}
+
+double branch_position(int branch, int num_branches) {
+    return (branch + 0.5) / num_branches;
+}
+
+double branch_user_home(int index) {
+    double home = (index + 1) * 0.6180339887498949; // Golden ratio, fractional part
+    return home - (long)home;
+}
+
+int branch_nearest(double home, int num_branches) {
+    int branch = (int)(home * num_branches);
+    if (branch < 0) branch = 0;
+    if (branch >= num_branches) branch = num_branches - 1;
+    return branch;
+}
+
+int branch_region(int branch, int num_branches, int num_regions) {
+    if (num_regions > num_branches) num_regions = num_branches;
+    if (num_regions < 1) num_regions = 1;
+    return branch * num_regions / num_branches;
+}
+
+int branch_operators(int branch, int num_operators, int num_branches) {
+    return num_operators / num_branches + (branch < num_operators % num_branches ? 1 : 0);
+}
+
+int branch_users(int branch, int num_users, int num_branches) {
+    int users = 0;
+    for (int i = 0; i < num_users; i++) {
+        if (branch_nearest(branch_user_home(i), num_branches) == branch) users++;
+    }
+    return users;
+}
+
+double branch_load(struct S_poste_stats *stats, struct S_poste_stations *stations) {
+    int waiting = 0;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        waiting += __atomic_load_n(&stats->waiting_users[s], __ATOMIC_RELAXED);
+    }
+
+    int staffed = 0;
+    shm_mutex_lock(&stations->stations_lock);
+    for (int i = 0; i < g_config.num_worker_seats && i < MAX_WORKER_SEATS; i++) {
+        if (stations->NOF_WORKER_SEATS[i].operator_status == OCCUPIED) staffed++;
+    }
+    shm_mutex_unlock(&stations->stations_lock);
+
+    if (staffed == 0) return -1.0;
+    return (double)(waiting + 1) / staffed;
+}
+
+int branch_route(BRANCH_POLICY routing, double home, int num_branches, const double load[]) {
+    int nearest = branch_nearest(home, num_branches);
+    if (routing != BRANCH_ROUTING_LOAD) return nearest;
+
+    int best = -1;
+    double best_cost = 0.0;
+    for (int b = 0; b < num_branches; b++) {
+        if (load[b] < 0) continue;
+        double distance = home - branch_position(b, num_branches);
+        if (distance < 0) distance = -distance;
+        double cost = distance * num_branches + load[b];
+        if (best == -1 || cost < best_cost) {
+            best = b;
+            best_cost = cost;
+        }
+    }
+    return best != -1 ? best : nearest;
+}
+
+static void add_service(struct S_service_stats *total, const struct S_service_stats *branch) {
+    total->served_users       += branch->served_users;
+    total->failed_services    += branch->failed_services;
+    total->total_wait_time    += branch->total_wait_time;
+    total->total_service_time += branch->total_service_time;
+    total->total_requests     += branch->total_requests;
+    total->late_users         += branch->late_users;
+}
+
+static void add_utilization(struct S_utilization *total, const struct S_utilization *branch) {
+    for (int i = 0; i < MAX_WORKER_SEATS; i++) {
+        total->seats[i].seated_minutes += branch->seats[i].seated_minutes;
+        total->seats[i].busy_minutes   += branch->seats[i].busy_minutes;
+        total->seats[i].services       += branch->seats[i].services;
+    }
+    for (int i = 0; i < MAX_OPERATOR_STATES && branch->operators[i].pid != 0; i++) {
+        const struct S_operator_utilization *from = &branch->operators[i];
+        struct S_operator_utilization *op = utilization_operator(total, from->pid, from->service);
+        if (op == NULL) continue;
+        op->seated_minutes += from->seated_minutes;
+        op->busy_minutes   += from->busy_minutes;
+        op->services       += from->services;
+    }
+    total->untracked_operators += branch->untracked_operators;
+}
+
+void branch_stats_add(struct S_poste_stats *total, const struct S_poste_stats *branch) {
+    if (branch->current_day > total->current_day) {
+        total->current_day    = branch->current_day;
+        total->current_minute = branch->current_minute;
+    }
+    if (total->configuration_file[0] == '\0') {
+        memcpy(total->configuration_file, branch->configuration_file, MAX_PATH_LENGTH);
+    }
+    total->messages_sent += __atomic_load_n(&branch->messages_sent, __ATOMIC_RELAXED);
+
+    add_service(&total->simulation_global, &branch->simulation_global);
+    add_service(&total->today.global, &branch->today.global);
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        add_service(&total->simulation_services[s], &branch->simulation_services[s]);
+        add_service(&total->today.services[s], &branch->today.services[s]);
+        total->waiting_users[s] += branch->waiting_users[s];
+    }
+    total->today.active_operators += branch->today.active_operators;
+    total->today.total_pauses     += branch->today.total_pauses;
+    total->today.late_users       += branch->today.late_users;
+    add_utilization(&total->today.usage, &branch->today.usage);
+    add_utilization(&total->simulation_usage, &branch->simulation_usage);
+
+    for (int i = 0; i < WAIT_HISTOGRAM_BINS; i++) {
+        total->wait_histogram[i] += branch->wait_histogram[i];
+    }
+    total->total_active_operators  += branch->total_active_operators;
+    total->total_simulation_pauses += branch->total_simulation_pauses;
+    total->trace_delayed           += branch->trace_delayed;
+    total->trace_delay_minutes     += branch->trace_delay_minutes;
+}
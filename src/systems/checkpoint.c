@@ -0,0 +1,90 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+
+#include <checkpoint.h>
+
+// Written before the payload, rejects files of another version or build
+struct S_checkpoint_header {
+    char magic[8];
+    int version;
+    size_t checkpoint_size;
+    size_t extra_size;
+};
+
+void checkpoint_capture(struct S_checkpoint *ck,
+                        struct S_poste_stats *stats,
+                        struct S_poste_stations *stations) {
+    shm_mutex_lock(&stats->stats_lock);
+    memcpy(&ck->stats, stats, sizeof(ck->stats));
+    shm_mutex_unlock(&stats->stats_lock);
+
+    shm_mutex_lock(&stations->stations_lock);
+    memcpy(&ck->stations, stations, sizeof(ck->stations));
+    shm_mutex_unlock(&stations->stations_lock);
+}
+
+bool checkpoint_write(const char *path, const struct S_checkpoint *ck,
+                      const void *extra, size_t extra_size) {
+    char tmp_path[MAX_PATH_LENGTH + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        perror("fopen");
+        return false;
+    }
+
+    struct S_checkpoint_header header = {0};
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version         = CHECKPOINT_VERSION;
+    header.checkpoint_size = sizeof(*ck);
+    header.extra_size      = extra_size;
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(ck, sizeof(*ck), 1, fp) == 1 &&
+              (extra_size == 0 || fwrite(extra, extra_size, 1, fp) == 1);
+    if (fclose(fp) != 0) ok = false;
+
+    if (!ok || rename(tmp_path, path) != 0) {
+        perror("checkpoint_write");
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+bool checkpoint_read(const char *path, struct S_checkpoint *ck,
+                     void *extra, size_t extra_size) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) return false;
+
+    struct S_checkpoint_header header;
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1 &&
+              memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == CHECKPOINT_VERSION &&
+              header.checkpoint_size == sizeof(*ck) &&
+              header.extra_size == extra_size &&
+              fread(ck, sizeof(*ck), 1, fp) == 1 &&
+              (extra_size == 0 || fread(extra, extra_size, 1, fp) == 1);
+
+    fclose(fp);
+    return ok;
+}
+
+void checkpoint_restore(const struct S_checkpoint *ck,
+                        struct S_poste_stats *stats,
+                        struct S_poste_stations *stations) {
+    memcpy(stats, &ck->stats, sizeof(*stats));
+    stats->stats_seq = 0;
+    stats->messages_sent = 0; // Counted per run, like its wall time
+    memset(stats->waiting_users, 0, sizeof(stats->waiting_users));
+
+    memcpy(stations, &ck->stations, sizeof(*stations));
+    memset(stations->NOF_WORKER_SEATS, 0, sizeof(stations->NOF_WORKER_SEATS));
+    memset(stations->operator_skills, 0, sizeof(stations->operator_skills));
+    memset(stations->operator_states, 0, sizeof(stations->operator_states));
+    memset(stations->operator_queue, 0, sizeof(stations->operator_queue));
+    memset(stations->user_queue, 0, sizeof(stations->user_queue));
+}
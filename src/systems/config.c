@@ -5,7 +5,7 @@
 
 #include <config.h>
 
-#define MAX_LINE_LEN 128
+#define MAX_LINE_LEN 256 // Room for an arrival_profile of 24 hours
 
 char *services[NUM_SERVICE_TYPES] = {
     "Invio e ritiro pacchi",
@@ -37,9 +37,42 @@ struct poste_config g_config = {
     .worker_shift_close = WORKER_SHIFT_CLOSE,
     .explode_max = EXPLODE_MAX,
     .max_n_requests = MAX_N_REQUESTS,
-    .nof_pause = NOF_PAUSE
+    .nof_pause = NOF_PAUSE,
+    .autoscale = AUTOSCALE,
+    .autoscale_min_operators = AUTOSCALE_MIN_OPERATORS,
+    .autoscale_max_operators = AUTOSCALE_MAX_OPERATORS,
+    .autoscale_cooldown = AUTOSCALE_COOLDOWN,
+    .autoscale_queue_high = AUTOSCALE_QUEUE_HIGH,
+    .seat_policy = SEAT_ALLOCATION,
+    .time_warp = TIME_WARP,
+    .fast_forward_closed = FAST_FORWARD_CLOSED,
+    .checkpoint = CHECKPOINT,
+    .sample_interval = SAMPLE_INTERVAL,
+    .usage_interval = USAGE_INTERVAL,
+    .num_branches = NUM_BRANCHES,
+    .num_regions = NUM_REGIONS,
+    .branch_routing = BRANCH_ROUTING,
+    .ticket_bundle = TICKET_BUNDLE,
+    .ramp_spawn_rate = RAMP_SPAWN_RATE
 };
 
+// Parses a comma separated list of weights >= 0 into out, returns how many
+// were read or -1 if the list is malformed
+static int parse_weights(const char *val, int out[], int max) {
+    int count = 0;
+    const char *p = val;
+    while (*p != '\0') {
+        char *end;
+        long w = strtol(p, &end, 10);
+        if (end == p || w < 0 || w > 1000000 || count == max) return -1;
+        out[count++] = (int)w;
+        if (*end == ',') end++;
+        else if (*end != '\0') return -1;
+        p = end;
+    }
+    return count;
+}
+
 // Load configuration from a file or set default values
 void load_config(char *config_file_path) {
     // Load configuration from a file or
@@ -124,6 +157,96 @@ void load_config(char *config_file_path) {
             iv = atoi(val);
             if (iv > 0) g_config.nof_pause = iv;
         }
+        else if (strcmp(key, "autoscale") == 0) {
+            iv = atoi(val);
+            if (iv >= 0) g_config.autoscale = iv;
+        }
+        else if (strcmp(key, "autoscale_min_operators") == 0) {
+            iv = atoi(val);
+            if (iv > 0) g_config.autoscale_min_operators = iv;
+        }
+        else if (strcmp(key, "autoscale_max_operators") == 0) {
+            iv = atoi(val);
+            if (iv > 0) g_config.autoscale_max_operators = iv;
+        }
+        else if (strcmp(key, "autoscale_cooldown") == 0) {
+            iv = atoi(val);
+            if (iv >= 0) g_config.autoscale_cooldown = iv;
+        }
+        else if (strcmp(key, "autoscale_queue_high") == 0) {
+            iv = atoi(val);
+            if (iv > 0) g_config.autoscale_queue_high = iv;
+        }
+        else if (strcmp(key, "time_warp") == 0) {
+            iv = atoi(val);
+            if (iv >= 0) g_config.time_warp = iv;
+        }
+        else if (strcmp(key, "fast_forward_closed") == 0) {
+            iv = atoi(val);
+            if (iv >= 0) g_config.fast_forward_closed = iv;
+        }
+        else if (strcmp(key, "checkpoint") == 0) {
+            iv = atoi(val);
+            if (iv >= 0) g_config.checkpoint = iv;
+        }
+        else if (strcmp(key, "sample_interval") == 0) {
+            iv = atoi(val);
+            if (iv >= 0) g_config.sample_interval = iv;
+        }
+        else if (strcmp(key, "usage_interval") == 0) {
+            iv = atoi(val);
+            if (iv >= 0) g_config.usage_interval = iv;
+        }
+        else if (strcmp(key, "num_branches") == 0) {
+            iv = atoi(val);
+            if (iv > 0 && iv <= MAX_BRANCHES) g_config.num_branches = iv;
+        }
+        else if (strcmp(key, "num_regions") == 0) {
+            iv = atoi(val);
+            if (iv > 0) g_config.num_regions = iv;
+        }
+        else if (strcmp(key, "branch_routing") == 0) {
+            if      (strcmp(val, "distance") == 0) g_config.branch_routing = 0;
+            else if (strcmp(val, "load") == 0)     g_config.branch_routing = 1;
+            else {
+                iv = atoi(val);
+                if (iv == 0 || iv == 1) g_config.branch_routing = iv;
+            }
+        }
+        else if (strcmp(key, "ticket_bundle") == 0) {
+            iv = atoi(val);
+            if (iv == 0 || iv == 1) g_config.ticket_bundle = iv;
+        }
+        else if (strcmp(key, "ramp_spawn_rate") == 0) {
+            iv = atoi(val);
+            if (iv > 0) g_config.ramp_spawn_rate = iv;
+        }
+        else if (strcmp(key, "arrival_profile") == 0) {
+            int hours[MAX_PROFILE_HOURS];
+            int n = parse_weights(val, hours, MAX_PROFILE_HOURS);
+            if (n > 0) {
+                memset(g_config.arrival_profile, 0, sizeof(g_config.arrival_profile));
+                memcpy(g_config.arrival_profile, hours, n * sizeof(int));
+                g_config.num_profile_hours = n;
+            }
+        }
+        else if (strcmp(key, "service_mix") == 0) {
+            int mix[NUM_SERVICE_TYPES];
+            if (parse_weights(val, mix, NUM_SERVICE_TYPES) == NUM_SERVICE_TYPES) {
+                memcpy(g_config.service_mix, mix, sizeof(mix));
+            }
+        }
+        else if (strcmp(key, "trace_file") == 0) {
+            if (strlen(val) < TRACE_PATH_LENGTH) strcpy(g_config.trace_file, val);
+        }
+        else if (strcmp(key, "seat_policy") == 0) {
+            if      (strcmp(val, "random") == 0) g_config.seat_policy = 0;
+            else if (strcmp(val, "demand") == 0) g_config.seat_policy = 1;
+            else {
+                iv = atoi(val);
+                if (iv == 0 || iv == 1) g_config.seat_policy = iv;
+            }
+        }
         // unrecognized keys are ignored
     }
 
@@ -0,0 +1,99 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <config_shm.h>
+#include <shared_mem.h>
+
+// Process local: the mapped segment and the version last seen
+static struct S_config_segment *segment = NULL;
+static unsigned int loaded_version = 0;
+
+static void fill_services(struct S_service_params params[NUM_SERVICE_TYPES]) {
+    memset(params, 0, sizeof(struct S_service_params) * NUM_SERVICE_TYPES);
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        params[s].duration = services_duration[s];
+    }
+}
+
+// --- Director side ---
+
+struct S_config_segment *config_shm_create(int *open_shm, int *open_shm_index) {
+    segment = init_shared_memory(SHM_CONFIG_NAME, SHM_CONFIG_SIZE, open_shm, open_shm_index);
+    memset(segment, 0, SHM_CONFIG_SIZE);
+    loaded_version = 0;
+    config_shm_publish();
+    return segment;
+}
+
+bool config_shm_publish(void) {
+    if (segment == NULL) return false;
+
+    struct S_service_params params[NUM_SERVICE_TYPES];
+    fill_services(params);
+
+    // Only the director writes, it can compare without the seqlock
+    if (loaded_version != 0 &&
+        memcmp(&segment->config, &g_config, sizeof(g_config)) == 0 &&
+        memcmp(segment->services, params, sizeof(params)) == 0) {
+        return false;
+    }
+
+    __atomic_store_n(&segment->version, loaded_version + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&segment->config, &g_config, sizeof(g_config));
+    memcpy(segment->services, params, sizeof(params));
+    loaded_version += 2;
+    __atomic_store_n(&segment->version, loaded_version, __ATOMIC_RELEASE);
+    return true;
+}
+
+// --- Children side ---
+
+// Copies the segment into g_config, retrying while the director rewrites it
+static void load_segment(void) {
+    struct poste_config config;
+    struct S_service_params params[NUM_SERVICE_TYPES];
+    unsigned int begin, end;
+
+    do {
+        begin = __atomic_load_n(&segment->version, __ATOMIC_ACQUIRE);
+        if (begin & 1) {
+            sched_yield();
+            continue;
+        }
+        memcpy(&config, &segment->config, sizeof(config));
+        memcpy(params, segment->services, sizeof(params));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        end = __atomic_load_n(&segment->version, __ATOMIC_RELAXED);
+    } while ((begin & 1) || begin != end);
+
+    g_config = config;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        services_duration[s] = params[s].duration;
+    }
+    loaded_version = begin;
+}
+
+bool config_shm_attach(void) {
+    if (segment == NULL) {
+        segment = attach_shared_memory(SHM_CONFIG_NAME, SHM_CONFIG_SIZE, PROT_READ);
+        if (segment == NULL) return false;
+    }
+    load_segment();
+    return true;
+}
+
+bool config_shm_refresh(void) {
+    if (segment == NULL) return false;
+    if (__atomic_load_n(&segment->version, __ATOMIC_ACQUIRE) == loaded_version) return false;
+
+    load_segment();
+    return true;
+}
+
+unsigned int config_shm_version(void) {
+    return loaded_version;
+}
@@ -0,0 +1,60 @@
+#include <erlang.h>
+#include <arrival.h>
+
+double erlang_c(int servers, double offered_load) {
+    if (servers <= 0 || offered_load >= servers) return 1.0;
+    if (offered_load <= 0.0) return 0.0;
+
+    // Erlang B by recurrence, stable for any number of servers
+    double b = 1.0;
+    for (int k = 1; k <= servers; k++) {
+        b = offered_load * b / (k + offered_load * b);
+    }
+
+    double rho = offered_load / servers;
+    return b / (1.0 - rho * (1.0 - b));
+}
+
+void erlang_predict(double arrival_rate, double service_minutes, int seats,
+                    struct S_queue_prediction *out) {
+    out->seats        = seats;
+    out->arrival_rate = arrival_rate;
+    out->offered_load = arrival_rate * service_minutes;
+    out->utilization  = seats > 0 ? out->offered_load / seats : 0.0;
+    out->stable       = seats > 0 ? out->offered_load < seats : arrival_rate <= 0.0;
+    out->p_wait       = erlang_c(seats, out->offered_load);
+
+    if (arrival_rate <= 0.0) {
+        out->mean_wait = 0.0;
+    } else if (!out->stable) {
+        out->mean_wait = -1.0; // Grows until closing time
+    } else {
+        double service_rate = 1.0 / service_minutes;
+        out->mean_wait = out->p_wait / (seats * service_rate - arrival_rate);
+    }
+
+    out->mean_wait_mg = out->mean_wait > 0.0 ? out->mean_wait * (1.0 + ERLANG_SERVICE_CV2) / 2.0
+                                             : out->mean_wait;
+    out->mean_queue   = out->mean_wait_mg > 0.0 ? arrival_rate * out->mean_wait_mg : 0.0;
+}
+
+void erlang_daily_requests(const struct poste_config *config, double requests[NUM_SERVICE_TYPES]) {
+    // rand() % p_serv_max >= p_serv_min, rand() % max_n_requests + 1
+    double p_go = 0.0;
+    if (config->p_serv_max > 0 && config->p_serv_max > config->p_serv_min) {
+        long min = config->p_serv_min > 0 ? config->p_serv_min : 0;
+        p_go = (double)(config->p_serv_max - min) / config->p_serv_max;
+    }
+    double per_user = (config->max_n_requests + 1) / 2.0;
+
+    double shares[NUM_SERVICE_TYPES];
+    arrival_service_shares(config, shares);
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        requests[s] = config->num_users * p_go * per_user * shares[s];
+    }
+}
+
+int erlang_open_minutes(const struct poste_config *config) {
+    int minutes = (config->worker_shift_close - config->worker_shift_open) * 60;
+    return minutes > 0 ? minutes : 0;
+}
@@ -0,0 +1,118 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <frame.h>
+
+void frame_reset(struct S_frame *frame) {
+    frame->length = 0;
+}
+
+bool frame_add(struct S_frame *frame, int kind, const void *payload, size_t size) {
+    if (size > UINT16_MAX || frame->length + RECORD_HEADER_SIZE + size > FRAME_MAX_SIZE) return false;
+
+    uint16_t header[2] = { (uint16_t)kind, (uint16_t)size };
+    memcpy(frame->data + frame->length, header, RECORD_HEADER_SIZE);
+    if (size > 0) memcpy(frame->data + frame->length + RECORD_HEADER_SIZE, payload, size);
+    frame->length += RECORD_HEADER_SIZE + size;
+    return true;
+}
+
+bool frame_next(const struct S_frame *frame, size_t *cursor, int *kind, const void **payload, size_t *size) {
+    if (*cursor + RECORD_HEADER_SIZE > frame->length) return false;
+
+    uint16_t header[2];
+    memcpy(header, frame->data + *cursor, RECORD_HEADER_SIZE);
+    if (*cursor + RECORD_HEADER_SIZE + header[1] > frame->length) return false; // Truncated
+
+    *kind    = header[0];
+    *size    = header[1];
+    *payload = frame->data + *cursor + RECORD_HEADER_SIZE;
+    *cursor += RECORD_HEADER_SIZE + header[1];
+    return true;
+}
+
+// send without SIGPIPE if the broker went away, the caller gets EPIPE
+static int write_all(int fd, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    while (size > 0) {
+        ssize_t n = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        bytes += n;
+        size  -= n;
+    }
+    return 0;
+}
+
+int frame_write(int fd, const struct S_frame *frame) {
+    // Length and records in one call, the peer wakes up once per frame
+    struct iovec iov[2] = {
+        { .iov_base = (void *)&frame->length, .iov_len = FRAME_HEADER_SIZE },
+        { .iov_base = (void *)frame->data,    .iov_len = frame->length }
+    };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+    ssize_t n;
+    do {
+        n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) return -1;
+
+    // Rest of a short write
+    if ((size_t)n < FRAME_HEADER_SIZE) {
+        if (write_all(fd, (const unsigned char *)&frame->length + n, FRAME_HEADER_SIZE - n) < 0) return -1;
+        n = FRAME_HEADER_SIZE;
+    }
+    return write_all(fd, frame->data + (n - FRAME_HEADER_SIZE), frame->length - (n - FRAME_HEADER_SIZE));
+}
+
+// Reads exactly size bytes. Returns 1, 0 on end of file, -1 with errno.
+// Interrupted before the first byte only if interruptible.
+static int read_all(int fd, void *data, size_t size, bool interruptible) {
+    unsigned char *bytes = data;
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = read(fd, bytes + done, size - done);
+        if (n == 0) return 0;
+        if (n < 0) {
+            if (errno == EINTR && !(interruptible && done == 0)) continue;
+            return -1;
+        }
+        done += n;
+    }
+    return 1;
+}
+
+int frame_read(int fd, struct S_frame *frame) {
+    int r = read_all(fd, &frame->length, FRAME_HEADER_SIZE, true);
+    if (r <= 0) return r;
+    if (frame->length > FRAME_MAX_SIZE) {
+        errno = EPROTO;
+        return -1;
+    }
+    r = read_all(fd, frame->data, frame->length, false);
+    if (r == 0) {
+        errno = EPROTO; // Closed in the middle of a frame
+        return -1;
+    }
+    return r;
+}
+
+long frame_parse(const unsigned char *buffer, size_t len, struct S_frame *frame) {
+    if (len < FRAME_HEADER_SIZE) return 0;
+
+    uint32_t length;
+    memcpy(&length, buffer, FRAME_HEADER_SIZE);
+    if (length > FRAME_MAX_SIZE) return -1;
+    if (len < FRAME_HEADER_SIZE + length) return 0;
+
+    frame->length = length;
+    memcpy(frame->data, buffer + FRAME_HEADER_SIZE, length);
+    return FRAME_HEADER_SIZE + length;
+}
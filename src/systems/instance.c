@@ -0,0 +1,95 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/stat.h>
+
+#include <instance.h>
+#include <poste.h>
+
+bool instance_valid(const char *instance) {
+    size_t length = strlen(instance);
+    if (length > MAX_INSTANCE_LENGTH) return false;
+    for (size_t i = 0; i < length; i++) {
+        if (!isalnum((unsigned char)instance[i]) && instance[i] != '_' && instance[i] != '-') return false;
+    }
+    return true;
+}
+
+const char *poste_instance(void) {
+    const char *instance = getenv(POSTE_INSTANCE_ENV);
+    if (instance == NULL) return "";
+    if (!instance_valid(instance)) {
+        fprintf(stderr, "Invalid " POSTE_INSTANCE_ENV " '%s': use letters, digits, '_' and '-'\n", instance);
+        exit(EXIT_FAILURE);
+    }
+    return instance;
+}
+
+void instance_shm_name(const char *instance, const char *name, char *out, size_t size) {
+    if (instance[0] == '\0') snprintf(out, size, "%s", name);
+    else                     snprintf(out, size, "%s_%s", name, instance);
+}
+
+static void make_dir(const char *path) {
+    if (mkdir(path, 0755) == -1 && errno != EEXIST) perror("mkdir for output directory");
+}
+
+void instance_output_dir(const char *instance, char *out, size_t size) {
+    make_dir(CSV_FILE_PATH);
+    if (instance[0] == '\0') {
+        snprintf(out, size, "%s", CSV_FILE_PATH);
+        return;
+    }
+    snprintf(out, size, "%s%s/", CSV_FILE_PATH, instance);
+    make_dir(out);
+}
+
+key_t instance_key(const char *instance, const char *path, int proj_id) {
+    if (instance[0] == '\0') return ftok(path, proj_id);
+
+    char dir[MAX_PATH_LENGTH];
+    char key_file[MAX_PATH_LENGTH + 64];
+    const char *base = strrchr(path, '/');
+    instance_output_dir(instance, dir, sizeof(dir));
+    snprintf(key_file, sizeof(key_file), "%s%s.key", dir, base != NULL ? base + 1 : path);
+
+    // ftok needs an existing file, the first process of the instance creates it
+    int fd = open(key_file, O_CREAT | O_RDONLY, 0644);
+    if (fd >= 0) close(fd);
+    return ftok(key_file, proj_id);
+}
+
+key_t poste_key(const char *path, int proj_id) {
+    return instance_key(poste_instance(), path, proj_id);
+}
+
+FILE *open_csv(const char *name, char *filename, size_t size) {
+    char dir[MAX_PATH_LENGTH];
+    int counter = 0;
+    FILE *fp = NULL;
+
+    instance_output_dir(poste_instance(), dir, sizeof(dir));
+
+    do {
+        if (counter == 0)
+            snprintf(filename, size, "%s%s.csv", dir, name);
+        else
+            snprintf(filename, size, "%s%s_%d.csv", dir, name, counter);
+
+        fp = fopen(filename, "r");
+        if (fp) {
+            fclose(fp);
+            counter++;
+        }
+    } while (fp != NULL);
+
+    fp = fopen(filename, "w");
+    if (!fp) perror("fopen for CSV");
+    return fp;
+}
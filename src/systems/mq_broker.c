@@ -0,0 +1,508 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <mq_broker.h>
+#include <frame.h>
+#include <msg_queue.h>
+#include <shared_mem.h>
+#include <branch.h>
+#include <stats.h>
+
+#define BROKER_BACKLOG 128
+#define BROKER_POLL_MS 200 // How often the stop flag is checked when idle
+#define READ_CHUNK     65536
+#define QUEUE_BYTES    16384 // MSGMNB, when /proc does not tell
+
+struct S_message {
+    struct S_message *next;
+    long mtype;
+    size_t length;
+    unsigned char data[];
+};
+
+struct S_queue {
+    int id;
+    key_t key;
+    struct S_message *first;
+    struct S_message *last;
+    size_t bytes;    // In the messages queued
+    size_t messages;
+};
+
+struct S_client {
+    int fd;
+    unsigned char *buffer; // Bytes received and not parsed yet
+    size_t length;
+    size_t capacity;
+    bool parked;                // Waiting in a receive
+    struct S_mq_receive wait;   // The receive it waits in
+    unsigned long long parked_at; // Receives are served in the order they parked
+    struct S_frame *held;       // Frame stopped at a send to a full queue
+    size_t held_cursor;         // Record of that send
+    int failed_sends;           // Told with the next reply
+    int send_error;
+};
+
+typedef struct S_message  message;
+typedef struct S_queue    queue;
+typedef struct S_client   client;
+typedef struct S_mq_reply mq_reply;
+
+static queue *queues = NULL;
+static int num_queues = 0;
+static int next_queue_id = 1;
+
+static client *clients = NULL;
+static int num_clients = 0;
+
+static size_t queue_bytes = QUEUE_BYTES;
+static bool room_made = false; // A message left a queue, held frames may go on
+
+static unsigned long long park_counter = 0;
+static struct S_mq_broker_counters *counters = NULL;
+static struct S_poste_stats *branch_stats[MAX_BRANCHES];
+
+static struct S_frame in_frame;
+static struct S_frame out_frame;
+
+static queue *find_queue(int id) {
+    for (int i = 0; i < num_queues; i++) {
+        if (queues[i].id == id) return &queues[i];
+    }
+    return NULL;
+}
+
+// As msgrcv: 0 any type, > 0 that type, < 0 any type up to -want
+static bool type_matches(long want, long mtype) {
+    if (want == 0) return true;
+    if (want > 0)  return mtype == want;
+    return mtype <= -want;
+}
+
+// Message a receive takes from the queue, with the one before it
+static message *find_message(queue *q, long want, message **before) {
+    message *found = NULL, *prev = NULL;
+    *before = NULL;
+    for (message *m = q->first; m != NULL; prev = m, m = m->next) {
+        if (!type_matches(want, m->mtype)) continue;
+        if (want >= 0) {
+            *before = prev;
+            return m;
+        }
+        if (found == NULL || m->mtype < found->mtype) { // Lowest type first
+            found = m;
+            *before = prev;
+            if (m->mtype == 1) break; // Types start at 1, none is lower
+        }
+    }
+    return found;
+}
+
+static void unlink_message(queue *q, message *m, message *before) {
+    if (before != NULL) before->next = m->next;
+    else                q->first = m->next;
+    if (q->last == m)   q->last = before;
+    q->bytes -= m->length;
+    q->messages--;
+    room_made = true;
+}
+
+// The bound of every queue, as msgsnd bounds a new System V queue
+static void read_queue_bytes(void) {
+    FILE *fp = fopen("/proc/sys/kernel/msgmnb", "r");
+    if (fp == NULL) return;
+    unsigned long value;
+    if (fscanf(fp, "%lu", &value) == 1 && value > 0) queue_bytes = value;
+    fclose(fp);
+}
+
+// Replies to a client in a frame of its own. False if the client is gone.
+static bool reply(client *c, int result, int error, long mtype, const void *data, size_t length) {
+    unsigned char record[sizeof(mq_reply) + MQ_MAX_MESSAGE];
+    mq_reply header = {
+        .result = result, .error = error, .mtype = mtype,
+        .failed_sends = c->failed_sends, .send_error = c->send_error
+    };
+    c->failed_sends = 0;
+    memcpy(record, &header, sizeof(header));
+    if (length > 0) memcpy(record + sizeof(header), data, length);
+
+    frame_reset(&out_frame);
+    frame_add(&out_frame, MQ_RECORD_REPLY, record, sizeof(header) + length);
+    return frame_write(c->fd, &out_frame) == 0;
+}
+
+// Hands a message to a receive, E2BIG if it does not fit. True if taken.
+static bool deliver(client *c, const struct S_mq_receive *want, long mtype, const void *data, size_t length) {
+    if (length > (size_t)want->length) {
+        reply(c, -1, E2BIG, 0, NULL, 0);
+        return false;
+    }
+    reply(c, (int)length, 0, mtype, data, length);
+    return true;
+}
+
+// --- Records ---
+
+static void handle_open(client *c, const struct S_mq_open *req) {
+    queue *q = NULL;
+    if (req->key != IPC_PRIVATE) {
+        for (int i = 0; i < num_queues; i++) {
+            if (queues[i].key == req->key) q = &queues[i];
+        }
+    }
+    if (q != NULL) {
+        if ((req->flags & IPC_CREAT) && (req->flags & IPC_EXCL)) {
+            reply(c, -1, EEXIST, 0, NULL, 0);
+        } else {
+            reply(c, q->id, 0, 0, NULL, 0);
+        }
+        return;
+    }
+    if (!(req->flags & IPC_CREAT)) {
+        reply(c, -1, ENOENT, 0, NULL, 0);
+        return;
+    }
+
+    queue *grown = realloc(queues, (num_queues + 1) * sizeof(queue));
+    if (grown == NULL) {
+        reply(c, -1, ENOMEM, 0, NULL, 0);
+        return;
+    }
+    queues = grown;
+    queues[num_queues] = (queue){ .id = next_queue_id++, .key = req->key };
+    reply(c, queues[num_queues].id, 0, 0, NULL, 0);
+    num_queues++;
+}
+
+// False if the queue is full: the send waits, as msgsnd would
+static bool handle_send(client *c, const struct S_mq_send *req, const unsigned char *data, size_t length) {
+    queue *q = find_queue(req->qid);
+    if (q == NULL) {
+        // Removed meanwhile, as msgsnd would fail with EIDRM
+        c->failed_sends++;
+        c->send_error = EIDRM;
+        counters->failed_sends++;
+        return true;
+    }
+
+    // Parked receives found nothing they take in the queue, so only this
+    // message can wake one: the one parked first gets it
+    client *first = NULL;
+    for (int i = 0; i < num_clients; i++) {
+        client *c = &clients[i];
+        if (!c->parked || c->wait.qid != req->qid || !type_matches(c->wait.mtype, req->mtype)) continue;
+        if (first == NULL || c->parked_at < first->parked_at) first = c;
+    }
+    if (first != NULL) {
+        first->parked = false;
+        if (deliver(first, &first->wait, req->mtype, data, length)) {
+            counters->messages++;
+            return true;
+        }
+    }
+
+    // As msgsnd, the messages count against the bound like bytes
+    if (q->bytes + length > queue_bytes || q->messages + 1 > queue_bytes) return false;
+    message *m = malloc(sizeof(message) + length);
+    if (m == NULL) return false;
+    counters->messages++;
+    m->next   = NULL;
+    m->mtype  = req->mtype;
+    m->length = length;
+    memcpy(m->data, data, length);
+    if (q->last != NULL) q->last->next = m;
+    else                 q->first = m;
+    q->last = m;
+    q->bytes += length;
+    q->messages++;
+    return true;
+}
+
+static void handle_receive(client *c, const struct S_mq_receive *req) {
+    queue *q = find_queue(req->qid);
+    if (q == NULL) {
+        reply(c, -1, EINVAL, 0, NULL, 0);
+        return;
+    }
+
+    message *before;
+    message *m = find_message(q, req->mtype, &before);
+    if (m != NULL) {
+        if (deliver(c, req, m->mtype, m->data, m->length)) {
+            unlink_message(q, m, before);
+            free(m);
+        }
+        return;
+    }
+    if (req->flags & IPC_NOWAIT) {
+        reply(c, -1, ENOMSG, 0, NULL, 0);
+        return;
+    }
+
+    c->parked    = true;
+    c->wait      = *req;
+    c->parked_at = park_counter++;
+}
+
+static void handle_cancel(client *c) {
+    // Answered even if the receive was served meanwhile, the client reads
+    // replies until this one
+    c->parked = false;
+    reply(c, -1, EINTR, 0, NULL, 0);
+}
+
+static void handle_close(client *c, const struct S_mq_close *req) {
+    queue *q = find_queue(req->qid);
+    if (q == NULL) {
+        reply(c, -1, EINVAL, 0, NULL, 0);
+        return;
+    }
+
+    for (message *m = q->first, *next; m != NULL; m = next) {
+        next = m->next;
+        free(m);
+    }
+    for (int i = 0; i < num_clients; i++) {
+        if (clients[i].parked && clients[i].wait.qid == req->qid) {
+            clients[i].parked = false;
+            reply(&clients[i], -1, EIDRM, 0, NULL, 0);
+        }
+    }
+    *q = queues[--num_queues];
+    room_made = true; // Sends held for it fail now
+    reply(c, 0, 0, 0, NULL, 0);
+}
+
+static void handle_stats(const struct S_stats_update *update) {
+    int branch = update->branch;
+    if (branch < 0 || branch >= MAX_BRANCHES) return;
+
+    // Attached on first use, the director has created the segments by then
+    if (branch_stats[branch] == NULL) {
+        char name[64];
+        branch_shm_name(SHM_STATS_NAME, branch, name, sizeof(name));
+        branch_stats[branch] = attach_shared_memory(name, SHM_STATS_SIZE, PROT_READ | PROT_WRITE);
+        if (branch_stats[branch] == NULL) return;
+    }
+    stats_apply(branch_stats[branch], update);
+    counters->stats_updates++;
+}
+
+// Handles the records of frame from *cursor. False if it stopped at a send
+// to a full queue, with *cursor on that send.
+static bool handle_frame(client *c, const struct S_frame *frame, size_t *cursor) {
+    if (*cursor == 0) counters->frames++;
+
+    int kind;
+    const void *payload;
+    size_t size;
+    size_t at = *cursor;
+    while (frame_next(frame, cursor, &kind, &payload, &size)) {
+        switch (kind) {
+            case MQ_RECORD_OPEN:
+                if (size == sizeof(struct S_mq_open)) {
+                    struct S_mq_open req;
+                    memcpy(&req, payload, sizeof(req));
+                    handle_open(c, &req);
+                }
+                break;
+            case MQ_RECORD_SEND:
+                if (size >= sizeof(struct S_mq_send)) {
+                    struct S_mq_send req;
+                    memcpy(&req, payload, sizeof(req));
+                    if (!handle_send(c, &req, (const unsigned char *)payload + sizeof(req), size - sizeof(req))) {
+                        *cursor = at;
+                        return false;
+                    }
+                }
+                break;
+            case MQ_RECORD_RECEIVE:
+                if (size == sizeof(struct S_mq_receive) && !c->parked) {
+                    struct S_mq_receive req;
+                    memcpy(&req, payload, sizeof(req));
+                    handle_receive(c, &req);
+                }
+                break;
+            case MQ_RECORD_CANCEL:
+                handle_cancel(c);
+                break;
+            case MQ_RECORD_CLOSE:
+                if (size == sizeof(struct S_mq_close)) {
+                    struct S_mq_close req;
+                    memcpy(&req, payload, sizeof(req));
+                    handle_close(c, &req);
+                }
+                break;
+            case MQ_RECORD_STATS:
+                if (size == sizeof(struct S_stats_update)) {
+                    struct S_stats_update update;
+                    memcpy(&update, payload, sizeof(update));
+                    handle_stats(&update);
+                }
+                break;
+            default:
+                break; // Unknown records are skipped
+        }
+        counters->records++;
+        at = *cursor;
+    }
+    return true;
+}
+
+// --- Clients ---
+
+static bool add_client(int fd) {
+    client *grown = realloc(clients, (num_clients + 1) * sizeof(client));
+    if (grown == NULL) return false;
+    clients = grown;
+    clients[num_clients++] = (client){ .fd = fd };
+    counters->clients++;
+    return true;
+}
+
+static void remove_client(int index) {
+    close(clients[index].fd);
+    free(clients[index].buffer);
+    free(clients[index].held);
+    clients[index] = clients[--num_clients];
+}
+
+// Handles the frame held at a full queue, then every complete frame
+// received, until one stops at a full queue. False if the client breaks
+// the protocol.
+static bool serve_client(client *c) {
+    if (c->held != NULL) {
+        if (!handle_frame(c, c->held, &c->held_cursor)) return true;
+        free(c->held);
+        c->held = NULL;
+    }
+
+    size_t used = 0;
+    for (;;) {
+        long taken = frame_parse(c->buffer + used, c->length - used, &in_frame);
+        if (taken < 0) return false; // Not our protocol
+        if (taken == 0) break;
+        used += taken;
+        size_t cursor = 0;
+        if (!handle_frame(c, &in_frame, &cursor)) {
+            // Not read from any more until a receive makes room
+            c->held = malloc(sizeof(struct S_frame));
+            if (c->held == NULL) return false;
+            memcpy(c->held, &in_frame, sizeof(struct S_frame));
+            c->held_cursor = cursor;
+            counters->waits++;
+            break;
+        }
+    }
+    memmove(c->buffer, c->buffer + used, c->length - used);
+    c->length -= used;
+    return true;
+}
+
+// Reads what the client sent and handles every complete frame.
+// False once the client is gone.
+static bool read_client(client *c) {
+    if (c->capacity - c->length < READ_CHUNK) {
+        unsigned char *grown = realloc(c->buffer, c->length + READ_CHUNK);
+        if (grown == NULL) return false;
+        c->buffer   = grown;
+        c->capacity = c->length + READ_CHUNK;
+    }
+
+    ssize_t n = read(c->fd, c->buffer + c->length, c->capacity - c->length);
+    if (n < 0) return errno == EINTR || errno == EAGAIN;
+    if (n == 0) return false;
+    c->length += n;
+    return serve_client(c);
+}
+
+// Gives the frames held at a full queue another go once a message left one,
+// until none of them gets further
+static void serve_held(void) {
+    while (room_made) {
+        room_made = false;
+        // From the last one, removing a client moves the last client in its place
+        for (int i = num_clients - 1; i >= 0; i--) {
+            if (clients[i].held != NULL && !serve_client(&clients[i])) remove_client(i);
+        }
+    }
+}
+
+int mq_broker_run(const char *path, volatile sig_atomic_t *stop, struct S_mq_broker_counters *out) {
+    static struct S_mq_broker_counters own;
+    counters = out != NULL ? out : &own;
+    read_queue_bytes();
+
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) return -1;
+    unlink(path); // Left by a broker that was killed
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listener, BROKER_BACKLOG) < 0) {
+        int saved = errno;
+        close(listener);
+        errno = saved;
+        return -1;
+    }
+
+    struct pollfd *fds = NULL;
+    while (!*stop) {
+        struct pollfd *grown = realloc(fds, (num_clients + 1) * sizeof(struct pollfd));
+        if (grown == NULL) break;
+        fds = grown;
+        fds[0] = (struct pollfd){ .fd = listener, .events = POLLIN };
+        for (int i = 0; i < num_clients; i++) {
+            // A client held at a full queue is only watched for hangups
+            fds[i + 1] = (struct pollfd){ .fd = clients[i].fd, .events = clients[i].held != NULL ? 0 : POLLIN };
+        }
+
+        int polled = num_clients;
+        int ready = poll(fds, polled + 1, BROKER_POLL_MS);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // From the last one, removing a client moves the last client in its place
+        for (int i = polled - 1; i >= 0; i--) {
+            if (fds[i + 1].revents == 0) continue;
+            if (!read_client(&clients[i])) remove_client(i);
+        }
+        serve_held();
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listener, NULL, NULL);
+            if (fd >= 0 && !add_client(fd)) close(fd);
+        }
+    }
+
+    free(fds);
+    while (num_clients > 0) remove_client(num_clients - 1);
+    for (int i = 0; i < num_queues; i++) {
+        for (message *m = queues[i].first, *next; m != NULL; m = next) {
+            next = m->next;
+            free(m);
+        }
+    }
+    num_queues = 0;
+    close(listener);
+    unlink(path);
+    return 0;
+}
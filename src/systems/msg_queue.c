@@ -1,26 +1,231 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "msg_queue.h"
 #include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <frame.h>
+#include <mq_broker.h>
+
+static unsigned long long *sent_counter = NULL;
+static unsigned long long failed_sends = 0;
+static int send_error = 0;
+
+// --- Socket transport, see mq_broker.h ---
+
+static int transport = -1; // -1 not chosen yet, 0 native, 1 broker
+static char broker_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static int broker_fd = -1;
+static pid_t broker_pid = 0; // A forked child opens its own connection
+static bool flush_registered = false;
+
+static struct S_frame out_frame; // Records not written yet
+static struct S_frame in_frame;
+
+typedef struct S_mq_reply mq_reply;
 
+void mq_transport(const char *path) {
+    if (broker_fd >= 0 && broker_pid == getpid()) {
+        mq_flush();
+        close(broker_fd);
+    }
+    broker_fd = -1;
+    frame_reset(&out_frame);
+
+    transport = path != NULL;
+    if (path != NULL) {
+        strncpy(broker_path, path, sizeof(broker_path) - 1);
+        broker_path[sizeof(broker_path) - 1] = '\0';
+    }
+}
+
+bool mq_is_remote(void) {
+    if (transport < 0) {
+        const char *path = getenv(MQ_SOCKET_ENV);
+        mq_transport(path != NULL && path[0] != '\0' ? path : NULL);
+    }
+    return transport == 1;
+}
+
+static bool broker_connect(void) {
+    if (broker_fd >= 0 && broker_pid == getpid()) return true;
+
+    if (broker_fd >= 0) {
+        // Inherited across fork: the records held belong to the parent
+        close(broker_fd);
+        broker_fd = -1;
+        frame_reset(&out_frame);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    strcpy(addr.sun_path, broker_path);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return false;
+    }
+
+    broker_fd  = fd;
+    broker_pid = getpid();
+    if (!flush_registered) {
+        atexit(mq_flush); // Updates held when the process returns from main
+        flush_registered = true;
+    }
+    return true;
+}
+
+static int flush_frame(void) {
+    if (out_frame.length == 0) return 0;
+    int ret = frame_write(broker_fd, &out_frame);
+    frame_reset(&out_frame);
+    return ret;
+}
+
+bool mq_post(int kind, const void *data, size_t size) {
+    if (!broker_connect()) return false;
+    if (frame_add(&out_frame, kind, data, size)) return true;
+    return flush_frame() == 0 && frame_add(&out_frame, kind, data, size);
+}
+
+void mq_flush(void) {
+    if (transport != 1 || broker_fd < 0 || broker_pid != getpid()) return;
+    flush_frame();
+}
+
+// Waits for the REPLY record. Returns 0, -1 with errno if the broker is gone,
+// or -1 with EINTR if a signal came first and interruptible is set.
+static int await_reply(mq_reply *reply, void *buffer, size_t length, bool interruptible) {
+    for (;;) {
+        // poll is never restarted after a signal, as msgrcv
+        struct pollfd pfd = { .fd = broker_fd, .events = POLLIN };
+        if (poll(&pfd, 1, -1) < 0) {
+            if (errno == EINTR && !interruptible) continue;
+            return -1;
+        }
+
+        int r = frame_read(broker_fd, &in_frame);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) {
+            if (r == 0) errno = ECONNRESET;
+            return -1;
+        }
+
+        size_t cursor = 0;
+        int kind;
+        const void *payload;
+        size_t size;
+        if (!frame_next(&in_frame, &cursor, &kind, &payload, &size) ||
+            kind != MQ_RECORD_REPLY || size < sizeof(mq_reply)) {
+            errno = EPROTO;
+            return -1;
+        }
+        memcpy(reply, payload, sizeof(mq_reply));
+        size -= sizeof(mq_reply);
+        if (reply->failed_sends > 0) {
+            // Counted as sent when they were posted
+            failed_sends += reply->failed_sends;
+            send_error    = reply->send_error;
+            if (sent_counter != NULL) __atomic_fetch_sub(sent_counter, reply->failed_sends, __ATOMIC_RELAXED);
+        }
+        if (buffer != NULL) memcpy(buffer, (const unsigned char *)payload + sizeof(mq_reply), size < length ? size : length);
+        return 0;
+    }
+}
+
+// Sends a record with what is held and returns the reply's result
+static int remote_call(int kind, const void *data, size_t size) {
+    mq_reply reply;
+    if (!mq_post(kind, data, size) || flush_frame() < 0 ||
+        await_reply(&reply, NULL, 0, false) < 0) return -1;
+    if (reply.result < 0) errno = reply.error;
+    return reply.result;
+}
+
+static ssize_t remote_receive(mq_id msqid, long mtype, void *buffer, size_t length, int flags) {
+    struct S_mq_receive req = { .qid = msqid, .mtype = mtype, .length = (int32_t)length, .flags = flags };
+    if (!mq_post(MQ_RECORD_RECEIVE, &req, sizeof(req)) || flush_frame() < 0) return -1;
+
+    mq_reply reply;
+    if (await_reply(&reply, buffer, length, true) == 0) {
+        if (reply.result < 0) errno = reply.error;
+        return reply.result;
+    }
+    if (errno != EINTR) return -1;
+
+    // Interrupted: take the receive back. The broker may have served it
+    // already, then the message comes before the answer to the cancel.
+    ssize_t result = -1;
+    int error = EINTR;
+    if (!mq_post(MQ_RECORD_CANCEL, NULL, 0) || flush_frame() < 0) return -1;
+    for (;;) {
+        if (await_reply(&reply, buffer, length, false) < 0) return -1;
+        if (reply.result == -1 && reply.error == EINTR) break;
+        result = reply.result;
+        error  = reply.error;
+    }
+    if (result < 0) errno = error;
+    return result;
+}
+
+// --- API ---
+
+void mq_count_sends(unsigned long long *counter) {
+    sent_counter = counter;
+}
+
+unsigned long long mq_failed_sends(int *error) {
+    if (error != NULL) *error = send_error;
+    return failed_sends;
+}
 
 mq_id mq_open(key_t key, int flags, int perms) {
+    if (mq_is_remote()) {
+        struct S_mq_open req = { .key = key, .flags = flags };
+        return remote_call(MQ_RECORD_OPEN, &req, sizeof(req));
+    }
     return msgget(key, flags | perms);
 }
 
 int mq_send(mq_id msqid, long mtype, const void *data, size_t length) {
+    if (mq_is_remote()) {
+        if (length > MQ_MAX_MESSAGE) {
+            errno = EINVAL;
+            return -1;
+        }
+        unsigned char record[sizeof(struct S_mq_send) + MQ_MAX_MESSAGE];
+        struct S_mq_send req = { .qid = msqid, .mtype = mtype };
+        memcpy(record, &req, sizeof(req));
+        memcpy(record + sizeof(req), data, length);
+        if (!mq_post(MQ_RECORD_SEND, record, sizeof(req) + length)) return -1;
+        if (sent_counter != NULL) __atomic_fetch_add(sent_counter, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+
     struct {
         long mtype;
-        char mtext[4096];
+        char mtext[MQ_MAX_MESSAGE];
     } msg;
     msg.mtype = mtype;
     memcpy(msg.mtext, data, length);
-    return msgsnd(msqid, &msg, length, 0);
+    int ret = msgsnd(msqid, &msg, length, 0);
+    if (ret == 0 && sent_counter != NULL) __atomic_fetch_add(sent_counter, 1, __ATOMIC_RELAXED);
+    return ret;
 }
 
 ssize_t mq_receive(mq_id msqid, long mtype, void *buffer, size_t length, int flags) {
+    if (mq_is_remote()) return remote_receive(msqid, mtype, buffer, length, flags);
+
     struct {
         long mtype;
-        char mtext[4096];
+        char mtext[MQ_MAX_MESSAGE];
     } msg;
     ssize_t ret = msgrcv(msqid, &msg, length, mtype, flags);
     if (ret >= 0) {
@@ -30,5 +235,9 @@ ssize_t mq_receive(mq_id msqid, long mtype, void *buffer, size_t length, int fla
 }
 
 int mq_close(mq_id msqid) {
+    if (mq_is_remote()) {
+        struct S_mq_close req = { .qid = msqid };
+        return remote_call(MQ_RECORD_CLOSE, &req, sizeof(req));
+    }
     return msgctl(msqid, IPC_RMID, NULL);
 }
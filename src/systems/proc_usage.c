@@ -0,0 +1,68 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <proc_usage.h>
+
+static double timeval_seconds(struct timeval tv) {
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+void role_usage_add_rusage(struct S_role_usage *usage, const struct rusage *ru) {
+    usage->processes++;
+    usage->user_seconds += timeval_seconds(ru->ru_utime);
+    usage->sys_seconds  += timeval_seconds(ru->ru_stime);
+    if (ru->ru_maxrss > usage->max_rss_kb) usage->max_rss_kb = ru->ru_maxrss; // KB on Linux
+    usage->rss_kb_total         += ru->ru_maxrss;
+    usage->voluntary_switches   += ru->ru_nvcsw;
+    usage->involuntary_switches += ru->ru_nivcsw;
+}
+
+bool proc_sample_read(pid_t pid, struct S_proc_sample *out) {
+    char path[64];
+    char line[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) return false;
+    bool read = fgets(line, sizeof(line), fp) != NULL;
+    fclose(fp);
+    if (!read) return false;
+
+    // The command name may hold spaces and parentheses, fields restart after the last ')'
+    char *fields = strrchr(line, ')');
+    if (fields == NULL) return false;
+
+    unsigned long utime, stime;
+    long rss_pages;
+    // state ppid pgrp session tty_nr tpgid flags minflt cminflt majflt cmajflt
+    // utime stime cutime cstime priority nice num_threads itrealvalue starttime vsize rss
+    if (sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu "
+                           "%*d %*d %*d %*d %*d %*d %*u %*u %ld",
+               &utime, &stime, &rss_pages) != 3) {
+        return false;
+    }
+
+    long ticks = sysconf(_SC_CLK_TCK);
+    out->cpu_seconds = (double)(utime + stime) / ticks;
+    out->rss_kb      = rss_pages * (sysconf(_SC_PAGESIZE) / 1024);
+    return true;
+}
+
+void role_usage_add_sample(struct S_role_usage *usage, int alive, long long rss_kb, double cpu_percent) {
+    usage->samples++;
+    if (alive > usage->peak_alive)             usage->peak_alive = alive;
+    if (rss_kb > usage->peak_rss_kb)           usage->peak_rss_kb = rss_kb;
+    if (cpu_percent > usage->peak_cpu_percent) usage->peak_cpu_percent = cpu_percent;
+}
+
+double role_usage_cpu_ms_per_process(const struct S_role_usage *usage) {
+    if (usage->processes == 0) return 0.0;
+    return 1000.0 * (usage->user_seconds + usage->sys_seconds) / usage->processes;
+}
+
+double role_usage_avg_rss_kb(const struct S_role_usage *usage) {
+    if (usage->processes == 0) return 0.0;
+    return (double)usage->rss_kb_total / usage->processes;
+}
@@ -0,0 +1,188 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ramp.h>
+
+#define MINUTES_PER_DAY 1440
+#define MAX_LINE_LEN 256
+
+const char *ramp_state_names[] = { "pending", "running", "done", "rejected" };
+
+int ramp_minute(int day, int minute) {
+    return day * MINUTES_PER_DAY + minute;
+}
+
+static const char *skip_blanks(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    return p;
+}
+
+int ramp_parse_step(const char *line, struct S_ramp_step *step) {
+    line = skip_blanks(line);
+    if (*line == '\0' || *line == '#') return 0;
+
+    int hours, minutes, users, used = 0;
+    char sign;
+    if (sscanf(line, "%d %d:%d %c%d%n", &step->day, &hours, &minutes, &sign, &users, &used) != 5) return -1;
+    if ((sign != '+' && sign != '-') || users <= 0 || hours < 0 || hours >= 24 || minutes < 0 || minutes >= 60) {
+        return -1;
+    }
+    step->minute = hours * 60 + minutes;
+    step->users  = sign == '-' ? -users : users;
+    step->over   = 0;
+
+    const char *rest = line + used;
+    int over;
+    if (sscanf(rest, " over %d%n", &over, &used) == 1) {
+        if (over < 0 || step->users < 0) return -1; // Retirements all happen at the end of the day
+        step->over = over;
+        rest += used;
+    }
+    rest = skip_blanks(rest);
+    return *rest == '\0' || *rest == '#' ? 1 : -1;
+}
+
+int ramp_read_file(const char *path, struct S_ramp_step steps[RAMP_MAX_STEPS], int *bad_line) {
+    *bad_line = 0;
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) return -1;
+
+    char line[MAX_LINE_LEN];
+    int count = 0;
+    int number = 0;
+    struct S_ramp_step step;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        number++;
+        int parsed = ramp_parse_step(line, &step);
+        if (parsed == 0) continue;
+        if (parsed < 0 || count == RAMP_MAX_STEPS) {
+            *bad_line = number;
+            fclose(fp);
+            return -1;
+        }
+        steps[count++] = step;
+    }
+    fclose(fp);
+    return count;
+}
+
+bool ramp_step_valid(const struct S_ramp_step *step) {
+    return step->day >= 1 &&
+           step->minute >= 0 && step->minute < MINUTES_PER_DAY &&
+           step->users != 0 && abs(step->users) <= RAMP_MAX_USERS &&
+           step->over >= 0 && step->over <= MINUTES_PER_DAY &&
+           (step->users > 0 || step->over == 0);
+}
+
+int ramp_submit(struct S_ramp_schedule *schedule, const struct S_ramp_step steps[], int n) {
+    if (n < 1 || schedule->count + n > RAMP_MAX_STEPS) return -1;
+
+    int first = schedule->count;
+    for (int i = 0; i < n; i++) {
+        struct S_ramp_status *status = &schedule->steps[schedule->count++];
+        status->step     = steps[i];
+        status->state    = ramp_step_valid(&steps[i]) ? RAMP_PENDING : RAMP_REJECTED;
+        status->done     = 0;
+        status->started  = -1;
+        status->finished = -1;
+    }
+    return first;
+}
+
+// Steps whose minute has come start running, late ones included
+static void start_due(struct S_ramp_schedule *schedule, int now) {
+    for (int i = 0; i < schedule->count; i++) {
+        struct S_ramp_status *status = &schedule->steps[i];
+        if (status->state == RAMP_PENDING && ramp_minute(status->step.day, status->step.minute) <= now) {
+            status->state   = RAMP_RUNNING;
+            status->started = now;
+        }
+    }
+}
+
+int ramp_spawns(struct S_ramp_schedule *schedule, int now, int spawn_rate) {
+    start_due(schedule, now);
+
+    int total = 0;
+    for (int i = 0; i < schedule->count; i++) {
+        struct S_ramp_status *status = &schedule->steps[i];
+        if (status->state != RAMP_RUNNING || status->step.users < 0) continue;
+
+        // Evenly over what is left of the window, or at the director's pace
+        int remaining = status->step.users - status->done;
+        int quota = remaining;
+        if (status->step.over > 0) {
+            int left = status->started + status->step.over - now;
+            if (left > 1) quota = (remaining + left - 1) / left;
+        } else if (quota > spawn_rate) {
+            quota = spawn_rate;
+        }
+
+        status->done += quota;
+        total += quota;
+        if (status->done == status->step.users) {
+            status->state    = RAMP_DONE;
+            status->finished = now;
+        }
+    }
+    schedule->spawned += total;
+    return total;
+}
+
+int ramp_retirements(struct S_ramp_schedule *schedule, int now, int present) {
+    start_due(schedule, now);
+
+    int total = 0;
+    for (int i = 0; i < schedule->count; i++) {
+        struct S_ramp_status *status = &schedule->steps[i];
+        if (status->state != RAMP_RUNNING || status->step.users > 0) continue;
+
+        // Never more than the users still there
+        int retire = -status->step.users;
+        if (retire > present - total) retire = present - total;
+        status->done     = retire;
+        status->state    = RAMP_DONE;
+        status->finished = now;
+        total += retire;
+    }
+    schedule->retired += total;
+    return total;
+}
+
+int ramp_next_minute(const struct S_ramp_schedule *schedule, int now) {
+    int next = INT_MAX;
+    for (int i = 0; i < schedule->count; i++) {
+        const struct S_ramp_status *status = &schedule->steps[i];
+        int at;
+        if (status->state == RAMP_PENDING) {
+            at = ramp_minute(status->step.day, status->step.minute);
+            if (at <= now) at = now + 1;
+        } else if (status->state == RAMP_RUNNING && status->step.users > 0) {
+            at = now + 1;  // Spawning every minute until done
+        } else {
+            continue;      // Done, or retiring with the next day
+        }
+        if (at < next) next = at;
+    }
+    return next;
+}
+
+void ramp_describe(const struct S_ramp_status *status, char *buffer, size_t size) {
+    const struct S_ramp_step *step = &status->step;
+    char over[32] = "";
+    char finished[32] = "";
+    if (step->over > 0) snprintf(over, sizeof(over), " over %d min", step->over);
+    if (status->finished >= 0) {
+        snprintf(finished, sizeof(finished), ", at day %d %02d:%02d",
+                 status->finished / MINUTES_PER_DAY, status->finished % MINUTES_PER_DAY / 60,
+                 status->finished % 60);
+    }
+    snprintf(buffer, size, "day %d %02d:%02d %+d%s: %s, %d/%d %s%s",
+             step->day, step->minute / 60, step->minute % 60, step->users, over,
+             ramp_state_names[status->state], status->done, abs(step->users),
+             step->users > 0 ? "spawned" : "retired", finished);
+}
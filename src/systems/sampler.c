@@ -0,0 +1,114 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <semaphore.h>
+
+#include <sampler.h>
+#include <shared_mem.h>
+
+struct S_sample_ring *sampler_create(int interval, int *open_shm, int *open_shm_index) {
+    struct S_sample_ring *ring = init_shared_memory(SHM_SAMPLES_NAME, SHM_SAMPLES_SIZE,
+                                                    open_shm, open_shm_index);
+    memset(ring, 0, SHM_SAMPLES_SIZE);
+    ring->interval = interval;
+    return ring;
+}
+
+void sampler_take(struct S_sample *sample, int day, int minute,
+                  struct S_poste_stats *stats, struct S_poste_stations *stations) {
+    memset(sample, 0, sizeof(*sample));
+    sample->day    = day;
+    sample->minute = minute;
+
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        sample->waiting[s] = __atomic_load_n(&stats->waiting_users[s], __ATOMIC_RELAXED);
+    }
+
+    shm_mutex_lock(&stations->stations_lock);
+    for (int i = 0; i < g_config.num_worker_seats && i < MAX_WORKER_SEATS; i++) {
+        struct S_worker_seat *seat = &stations->NOF_WORKER_SEATS[i];
+        if (seat->operator_status != OCCUPIED) continue;
+        sample->staffed[seat->service_id]++;
+        if (seat->user_status == OCCUPIED) sample->serving[seat->service_id]++;
+    }
+    memcpy(sample->operators, stations->operator_skills, sizeof(sample->operators));
+    shm_mutex_unlock(&stations->stations_lock);
+}
+
+static void append(struct S_sample_ring *ring, const struct S_sample *sample, int minute) {
+    unsigned int head = ring->head;
+    struct S_sample *slot = &ring->samples[head % SAMPLER_RING_SIZE];
+    *slot = *sample;
+    slot->minute = minute;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+bool sampler_due(const struct S_sample_ring *ring, int minute) {
+    return ring->interval > 0 && minute % ring->interval == 0;
+}
+
+void sampler_record(struct S_sample_ring *ring, const struct S_sample *sample) {
+    append(ring, sample, sample->minute);
+}
+
+void sampler_skip(struct S_sample_ring *ring, const struct S_sample *sample, int from, int to) {
+    for (int minute = from; minute < to; minute++) {
+        if (sampler_due(ring, minute)) append(ring, sample, minute);
+    }
+}
+
+static void summarize(struct S_sample_summary *summary, const struct S_sample *sample) {
+    int hour = (sample->minute / 60) % 24;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        summary->hour_waiting[hour] += sample->waiting[s];
+        summary->hour_staffed[hour] += sample->staffed[s];
+        if (sample->waiting[s] > summary->peak_waiting[s]) {
+            summary->peak_waiting[s] = sample->waiting[s];
+            summary->peak_day[s]     = sample->day;
+            summary->peak_minute[s]  = sample->minute;
+            summary->peak_staffed[s] = sample->staffed[s];
+        }
+    }
+    summary->hour_samples[hour]++;
+}
+
+int sampler_drain(struct S_sample_ring *ring, FILE *fp, struct S_sample_summary *summary) {
+    unsigned int head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (head - summary->drained > SAMPLER_RING_SIZE) {
+        summary->lost   += head - summary->drained - SAMPLER_RING_SIZE;
+        summary->drained = head - SAMPLER_RING_SIZE;
+    }
+
+    if (fp != NULL && ftell(fp) == 0) {
+        fprintf(fp, "Day,Minute,Service,Waiting,StaffedSeats,ServingSeats,Operators\n");
+    }
+
+    int written = 0;
+    for (; summary->drained != head; summary->drained++) {
+        const struct S_sample *sample = &ring->samples[summary->drained % SAMPLER_RING_SIZE];
+        summarize(summary, sample);
+        if (fp != NULL) {
+            for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+                fprintf(fp, "%d,%d,%s,%d,%d,%d,%d\n", sample->day, sample->minute, services[s],
+                        sample->waiting[s], sample->staffed[s], sample->serving[s],
+                        sample->operators[s]);
+            }
+        }
+        written++;
+    }
+    return written;
+}
+
+int sampler_peak_hour(const struct S_sample_summary *summary) {
+    int peak = -1;
+    double peak_avg = -1.0;
+    for (int h = 0; h < 24; h++) {
+        if (summary->hour_samples[h] == 0) continue;
+        double avg = summary->hour_waiting[h] / summary->hour_samples[h];
+        if (avg > peak_avg) {
+            peak = h;
+            peak_avg = avg;
+        }
+    }
+    return peak;
+}
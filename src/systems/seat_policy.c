@@ -0,0 +1,159 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <seat_policy.h>
+
+const char *seat_policy_names[] = {
+    "random",
+    "demand"
+};
+
+void seat_policy_demand(const struct S_service_stats history[NUM_SERVICE_TYPES],
+                        int days, double demand[NUM_SERVICE_TYPES]) {
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        demand[s] = days > 0 ?
+            (double)(history[s].total_requests + history[s].failed_services) / days : 0.0;
+    }
+}
+
+// Minutes of work a service is expected to need in a day.
+// Services whose users waited longer than a service time get up to twice the weight.
+static void service_loads(const struct S_service_stats history[NUM_SERVICE_TYPES],
+                          double load[NUM_SERVICE_TYPES]) {
+    bool has_history = false;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        if (history[s].total_requests + history[s].failed_services > 0) has_history = true;
+    }
+
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        if (!has_history) {
+            // First day, every service is requested as often
+            load[s] = services_duration[s];
+            continue;
+        }
+
+        double requests   = history[s].total_requests + history[s].failed_services;
+        double congestion = 0.0;
+        if (history[s].total_requests > 0) {
+            congestion = history[s].total_wait_time / history[s].total_requests / services_duration[s];
+            if (congestion > 1.0) congestion = 1.0;
+        }
+        load[s] = requests * services_duration[s] * (1.0 + congestion);
+    }
+}
+
+// D'Hondt: the next seat goes to the highest load per seat, among the
+// services below their cap (cap == NULL for no cap). -1 if none is eligible.
+static int next_service(const double load[NUM_SERVICE_TYPES],
+                        const int counts[NUM_SERVICE_TYPES],
+                        const int *cap) {
+    int best = -1;
+    double best_quotient = 0.0;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        if (load[s] <= 0.0) continue;
+        if (cap != NULL && counts[s] >= cap[s]) continue;
+
+        double quotient = load[s] / (counts[s] + 1);
+        if (best == -1 || quotient > best_quotient) {
+            best = s;
+            best_quotient = quotient;
+        }
+    }
+    return best;
+}
+
+static void allocate_by_demand(const struct S_service_stats history[NUM_SERVICE_TYPES],
+                               const int skills[NUM_SERVICE_TYPES],
+                               int num_seats,
+                               int seat_services[]) {
+    double load[NUM_SERVICE_TYPES];
+    int counts[NUM_SERVICE_TYPES] = {0};
+    int seat = 0;
+
+    service_loads(history, load);
+
+    // One seat to every requested service somebody can staff, heaviest first,
+    // so no staffed service fails just for missing a seat
+    int ones[NUM_SERVICE_TYPES];
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        ones[s] = skills[s] > 0 ? 1 : 0;
+    }
+    while (seat < num_seats) {
+        int s = next_service(load, counts, ones);
+        if (s == -1) break;
+        counts[s]++;
+        seat_services[seat++] = s;
+    }
+
+    // Then in proportion to the load, never more seats than operators that know the service
+    while (seat < num_seats) {
+        int s = next_service(load, counts, skills);
+        if (s == -1) break;
+        counts[s]++;
+        seat_services[seat++] = s;
+    }
+
+    // Operators are all seated: the rest still follows the load, for late joiners
+    while (seat < num_seats) {
+        int s = next_service(load, counts, NULL);
+        if (s == -1) s = rand() % NUM_SERVICE_TYPES; // No load at all
+        counts[s]++;
+        seat_services[seat++] = s;
+    }
+}
+
+void allocate_seats(SEAT_POLICY policy,
+                    const struct S_service_stats history[NUM_SERVICE_TYPES],
+                    const int skills[NUM_SERVICE_TYPES],
+                    int num_seats,
+                    int seat_services[]) {
+    if (policy == SEAT_POLICY_DEMAND) {
+        allocate_by_demand(history, skills, num_seats, seat_services);
+        return;
+    }
+
+    for (int i = 0; i < num_seats; i++) {
+        seat_services[i] = rand() % NUM_SERVICE_TYPES;
+    }
+}
+
+// Users a service can serve with a given number of seats
+static double service_capacity(int seats, int skills, double demand, int open_minutes, int s) {
+    int staffed = seats < skills ? seats : skills;
+    double capacity = (double)staffed * open_minutes / services_duration[s];
+    return capacity < demand ? capacity : demand;
+}
+
+double seat_policy_expected_served(const int seat_counts[NUM_SERVICE_TYPES],
+                                   const int skills[NUM_SERVICE_TYPES],
+                                   const double demand[NUM_SERVICE_TYPES],
+                                   int open_minutes) {
+    double served = 0.0;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        served += service_capacity(seat_counts[s], skills[s], demand[s], open_minutes, s);
+    }
+    return served;
+}
+
+double seat_policy_expected_served_random(int num_seats,
+                                          const int skills[NUM_SERVICE_TYPES],
+                                          const double demand[NUM_SERVICE_TYPES],
+                                          int open_minutes) {
+    // Seats of each service are Binomial(num_seats, 1/NUM_SERVICE_TYPES),
+    // the expectation is a sum over the services of the marginals
+    const double p = 1.0 / NUM_SERVICE_TYPES;
+    double served = 0.0;
+
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        double pmf = 1.0; // P(k = 0) = (1 - p)^n
+        for (int i = 0; i < num_seats; i++) pmf *= 1.0 - p;
+
+        for (int k = 0; k <= num_seats; k++) {
+            served += pmf * service_capacity(k, skills[s], demand[s], open_minutes, s);
+            // P(k + 1) from P(k)
+            pmf *= (double)(num_seats - k) / (k + 1) * p / (1.0 - p);
+        }
+    }
+    return served;
+}
@@ -0,0 +1,74 @@
+#include <semaphore.h>
+
+#include <seat_queue.h>
+#include <sim_clock.h>
+
+void seat_queue_offer(struct S_poste_stations *stations, int seat) {
+    struct S_worker_seat *s = &stations->NOF_WORKER_SEATS[seat];
+
+    if (s->operator_status == FREE) {
+        pid_t pid = sim_queue_wake(&stations->operator_queue[s->service_id], seat);
+        if (pid != 0) {
+            s->operator_process = pid;
+            s->operator_status  = OCCUPIED;
+        }
+    }
+    if (s->operator_status == OCCUPIED && s->user_status == FREE) {
+        pid_t pid = sim_queue_wake(&stations->user_queue[s->service_id], seat);
+        if (pid != 0) {
+            s->user_status  = OCCUPIED;
+            s->user_process = pid;
+        }
+    }
+}
+
+bool seat_queue_lock(struct S_poste_stations *stations) {
+    bool recovered = shm_mutex_lock(&stations->stations_lock);
+    if (recovered) {
+        for (int i = 0; i < NUM_SERVICE_TYPES; i++) {
+            sim_queue_repair(&stations->operator_queue[i]);
+            sim_queue_repair(&stations->user_queue[i]);
+        }
+    }
+    return recovered;
+}
+
+int seat_queue_forget(struct S_poste_stations *stations, pid_t pid, pid_t seated[MAX_WORKER_SEATS]) {
+    for (int i = 0; i < NUM_SERVICE_TYPES; i++) {
+        sim_queue_remove(&stations->operator_queue[i], pid);
+        sim_queue_remove(&stations->user_queue[i], pid);
+    }
+
+    int n_seated = 0;
+    for (int i = 0; i < MAX_WORKER_SEATS; i++) {
+        struct S_worker_seat *s = &stations->NOF_WORKER_SEATS[i];
+        if (s->operator_status != FREE && s->operator_process == pid) {
+            if (s->user_status == OCCUPIED && s->user_process != 0) seated[n_seated++] = s->user_process;
+            s->operator_status  = FREE;
+            s->operator_process = 0;
+            s->user_status      = FREE;
+            s->user_process     = 0;
+        } else if (s->user_status == OCCUPIED && s->user_process == pid) {
+            s->user_status  = FREE;
+            s->user_process = 0;
+        } else {
+            continue;
+        }
+        seat_queue_offer(stations, i);
+    }
+    return n_seated;
+}
+
+int seat_queue_wait(struct S_poste_stations *stations, struct S_actor_queue *queue, int minutes) {
+    if (!sim_queue_push(queue)) {
+        shm_mutex_unlock(&stations->stations_lock);
+        sim_sleep_minutes(1);
+        seat_queue_lock(stations);
+        return -1;
+    }
+
+    shm_mutex_unlock(&stations->stations_lock);
+    sim_queue_wait(minutes);
+    seat_queue_lock(stations);
+    return sim_queue_leave(queue);
+}
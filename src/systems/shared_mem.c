@@ -9,9 +9,14 @@
 #include <unistd.h>  // declares ftruncate
 
 #include <shared_mem.h>
+#include <instance.h>
+
+#define MAX_SHM_NAME 96
 
 void* init_shared_memory(const char *name, size_t size, int *open_shm, int *open_shm_index) {
-    int shm_info = shm_open(name, O_CREAT|O_RDWR, 0666);
+    char instance_name[MAX_SHM_NAME];
+    instance_shm_name(poste_instance(), name, instance_name, sizeof(instance_name));
+    int shm_info = shm_open(instance_name, O_CREAT|O_RDWR, 0666);
     ftruncate(shm_info, size);
     void *shared_info = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, shm_info, 0);
 
@@ -31,5 +36,30 @@ void cleanup_shared_memory(const char *name, size_t size, int shm_info, void* sh
     munmap(shared_info, size);
     close(shm_info);
     
-    shm_unlink(name);
-}
\ No newline at end of file
+    char instance_name[MAX_SHM_NAME];
+    instance_shm_name(poste_instance(), name, instance_name, sizeof(instance_name));
+    shm_unlink(instance_name);
+}
+
+void* attach_shared_memory(const char *name, size_t size, int prot) {
+    char instance_name[MAX_SHM_NAME];
+    instance_shm_name(poste_instance(), name, instance_name, sizeof(instance_name));
+    int shm_info = shm_open(instance_name, (prot & PROT_WRITE) ? O_RDWR : O_RDONLY, 0);
+    if (shm_info < 0) {
+        return NULL;
+    }
+
+    void *shared_info = mmap(NULL, size, prot, MAP_SHARED, shm_info, 0);
+    close(shm_info); // The mapping stays valid after the descriptor is closed
+
+    if (shared_info == MAP_FAILED) {
+        perror("mmap");
+        return NULL;
+    }
+
+    return shared_info;
+}
+
+void detach_shared_memory(size_t size, void* shared_info) {
+    munmap(shared_info, size);
+}
@@ -0,0 +1,94 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <shm_mutex.h>
+
+#define ESTIMATE_SHIFT 3 // spin_estimate holds the average times 8
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("pause");
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+int shm_mutex_init(struct S_shm_mutex *m) {
+    memset(m, 0, sizeof(*m));
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    int ret = pthread_mutex_init(&m->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    // Spinning only helps while the holder runs on another core
+    m->spin = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+    return ret;
+}
+
+bool shm_mutex_lock(struct S_shm_mutex *m) {
+    bool contended = false, slept = false;
+    int spins = 0;
+
+    int ret = pthread_mutex_trylock(&m->mutex);
+    if (ret == EBUSY) {
+        contended = true;
+        if (m->spin) {
+            // Racy read, it is only a hint
+            int limit = 2 * (__atomic_load_n(&m->spin_estimate, __ATOMIC_RELAXED) >> ESTIMATE_SHIFT) + 10;
+            if (limit > SHM_MUTEX_MAX_SPINS) limit = SHM_MUTEX_MAX_SPINS;
+            while (ret == EBUSY && spins < limit) {
+                cpu_relax();
+                spins++;
+                ret = pthread_mutex_trylock(&m->mutex);
+            }
+        }
+        if (ret == EBUSY) {
+            slept = true;
+            ret = pthread_mutex_lock(&m->mutex);
+        }
+    }
+
+    bool recovered = ret == EOWNERDEAD;
+    if (recovered) {
+        pthread_mutex_consistent(&m->mutex);
+    } else if (ret != 0) {
+        fprintf(stderr, "pthread_mutex_lock: %s\n", strerror(ret));
+        exit(EXIT_FAILURE);
+    }
+
+    // Held from here on
+    m->counters.acquisitions++;
+    if (contended) m->counters.contended++;
+    if (contended && !slept) {
+        // Only spins that got the lock: a sleep says nothing about how long to spin.
+        // A 1/8 moving average kept scaled, so small gaps still move it both ways.
+        __atomic_store_n(&m->spin_estimate, m->spin_estimate + spins - (m->spin_estimate >> ESTIMATE_SHIFT),
+                         __ATOMIC_RELAXED);
+    }
+    if (slept)     m->counters.sleeps++;
+    if (recovered) m->counters.recoveries++;
+    return recovered;
+}
+
+void shm_mutex_unlock(struct S_shm_mutex *m) {
+    pthread_mutex_unlock(&m->mutex);
+}
+
+void shm_mutex_destroy(struct S_shm_mutex *m) {
+    pthread_mutex_destroy(&m->mutex);
+}
+
+void shm_mutex_counters(struct S_shm_mutex *m, struct S_lock_counters *out) {
+    shm_mutex_lock(m);
+    *out = m->counters;
+    out->acquisitions--; // Not this one
+    shm_mutex_unlock(m);
+}
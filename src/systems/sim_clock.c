@@ -0,0 +1,463 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include <sim_clock.h>
+#include <shared_mem.h>
+#include <msg_queue.h>
+
+#define IDLE_POLL_MIN_NS 10000L    // Director polls for idle actors from 10us...
+#define IDLE_POLL_MAX_NS 1000000L  // ...backing off up to 1ms
+
+// Process local: the mapped segment and the slot of this process
+static struct S_sim_clock  *sim_clock = NULL;
+static struct S_actor_slot *own_slot  = NULL;
+static int own_role = -1;
+
+static long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Real-time sleep that survives signals
+static void sleep_nanos(long long nanos) {
+    struct timespec t = {
+        .tv_sec  = nanos / 1000000000LL,
+        .tv_nsec = nanos % 1000000000LL
+    };
+    while (nanosleep(&t, &t) != 0 && errno == EINTR);
+}
+
+// Adds a lag of this process to the histogram of its role
+static void record_lag(long long lag_ns) {
+    if (sim_clock == NULL || own_role < 0) return;
+    if (lag_ns < 0) lag_ns = 0;
+
+    struct S_lag_histogram *lag = &sim_clock->lag[own_role];
+    unsigned long long ns = (unsigned long long)lag_ns;
+    int bucket = 0;
+    while (bucket < LAG_BUCKETS - 1 && (1ULL << bucket) * 1000 <= ns) bucket++;
+
+    __atomic_add_fetch(&lag->samples, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&lag->total_ns, ns, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&lag->buckets[bucket], 1, __ATOMIC_RELAXED);
+    if (lag_ns * 10 > g_config.minute_duration) __atomic_add_fetch(&lag->late, 1, __ATOMIC_RELAXED);
+
+    unsigned long long max = __atomic_load_n(&lag->max_ns, __ATOMIC_RELAXED);
+    while (ns > max && !__atomic_compare_exchange_n(&lag->max_ns, &max, ns, true,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+// Real-time sleep of an actor, late by what the kernel overshot
+static void actor_sleep_nanos(long long nanos) {
+    long long due = monotonic_ns() + nanos;
+    sleep_nanos(nanos);
+    record_lag(monotonic_ns() - due);
+}
+
+// Actors keep their slot state up to date
+static bool clock_tracking(void) {
+    return sim_clock != NULL && (sim_clock->time_warp || sim_clock->fast_forward_closed);
+}
+
+// --- Slot table, under slots_lock ---
+
+static struct S_actor_slot *find_slot(pid_t pid) {
+    for (int i = 0; i < sim_clock->n_slots; i++) {
+        if (sim_clock->actors[i].pid == pid) return &sim_clock->actors[i];
+    }
+    return NULL;
+}
+
+static struct S_actor_slot *acquire_slot(pid_t pid) {
+    struct S_actor_slot *slot = find_slot(pid);
+    if (slot != NULL) return slot;
+
+    for (int i = 0; i < MAX_ACTORS; i++) {
+        if (sim_clock->actors[i].pid != 0) continue;
+
+        slot = &sim_clock->actors[i];
+        slot->pid = pid;
+        slot->handoff = -1;
+        __atomic_store_n(&slot->state, ACTOR_RUNNING, __ATOMIC_SEQ_CST);
+        if (i >= sim_clock->n_slots) {
+            __atomic_store_n(&sim_clock->n_slots, i + 1, __ATOMIC_SEQ_CST);
+        }
+        return slot;
+    }
+
+    __atomic_store_n(&sim_clock->overflow, 1, __ATOMIC_SEQ_CST);
+    return NULL;
+}
+
+static void release_slot(struct S_actor_slot *slot) {
+    __atomic_store_n(&slot->state, ACTOR_FREE, __ATOMIC_SEQ_CST);
+    slot->pid = 0;
+}
+
+// --- Director side ---
+
+struct S_sim_clock *sim_clock_create(bool time_warp, bool fast_forward_closed,
+                                     int *open_shm, int *open_shm_index) {
+    sim_clock = init_shared_memory(SHM_CLOCK_NAME, SHM_CLOCK_SIZE, open_shm, open_shm_index);
+    memset(sim_clock, 0, SHM_CLOCK_SIZE);
+
+    sim_clock->time_warp = time_warp;
+    sim_clock->fast_forward_closed = fast_forward_closed;
+    sem_init(&sim_clock->slots_lock, 1, 1);
+    for (int i = 0; i < MAX_ACTORS; i++) {
+        sem_init(&sim_clock->actors[i].wake, 1, 0);
+    }
+    return sim_clock;
+}
+
+void sim_actor_register(pid_t pid) {
+    if (sim_clock == NULL) return;
+
+    sem_wait(&sim_clock->slots_lock);
+    acquire_slot(pid);
+    sem_post(&sim_clock->slots_lock);
+}
+
+void sim_actor_forget(pid_t pid) {
+    if (sim_clock == NULL) return;
+
+    sem_wait(&sim_clock->slots_lock);
+    struct S_actor_slot *slot = find_slot(pid);
+    if (slot != NULL) {
+        // Woken by sim_queue_wake, died before taking the value
+        if (slot->handoff >= 0) sim_drop_wakeups(1);
+        release_slot(slot);
+    }
+    sem_post(&sim_clock->slots_lock);
+}
+
+void sim_clock_publish(int now) {
+    if (sim_clock == NULL) return;
+
+    __atomic_store_n(&sim_clock->now, now, __ATOMIC_SEQ_CST);
+    if (!clock_tracking()) return;
+
+    long long published = monotonic_ns();
+    int n_slots = __atomic_load_n(&sim_clock->n_slots, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < n_slots; i++) {
+        struct S_actor_slot *slot = &sim_clock->actors[i];
+        int expected = ACTOR_SLEEPING;
+        if (__atomic_load_n(&slot->wake_minute, __ATOMIC_SEQ_CST) <= now &&
+            __atomic_compare_exchange_n(&slot->state, &expected, ACTOR_RUNNING, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+            // Marked running before the post, the director cannot warp past it
+            __atomic_store_n(&slot->woken_ns, published, __ATOMIC_SEQ_CST);
+            sem_post(&slot->wake);
+        }
+    }
+}
+
+// Nobody running, nothing in flight, nobody overdue. Fills the earliest wakeup.
+static bool actors_idle(int *next_wake) {
+    if (__atomic_load_n(&sim_clock->overflow, __ATOMIC_SEQ_CST)) return false;
+    // pending first: a receiver marks itself running before taking its message off pending
+    if (__atomic_load_n(&sim_clock->pending, __ATOMIC_SEQ_CST) != 0) return false;
+
+    int now = __atomic_load_n(&sim_clock->now, __ATOMIC_SEQ_CST);
+    int n_slots = __atomic_load_n(&sim_clock->n_slots, __ATOMIC_SEQ_CST);
+    int earliest = INT_MAX;
+
+    for (int i = 0; i < n_slots; i++) {
+        struct S_actor_slot *slot = &sim_clock->actors[i];
+        int state = __atomic_load_n(&slot->state, __ATOMIC_SEQ_CST);
+
+        if (state == ACTOR_RUNNING) return false;
+        if (state == ACTOR_SLEEPING) {
+            int wake = __atomic_load_n(&slot->wake_minute, __ATOMIC_SEQ_CST);
+            if (wake <= now) return false; // About to wake up on its own
+            if (wake < earliest) earliest = wake;
+        }
+    }
+
+    *next_wake = earliest;
+    return true;
+}
+
+bool sim_clock_wait_idle(long timeout_ns, bool jump, int *next_wake) {
+    if (!jump || !clock_tracking()) {
+        sleep_nanos(timeout_ns);
+        return false;
+    }
+
+    long long deadline = monotonic_ns() + timeout_ns;
+    long slice = IDLE_POLL_MIN_NS;
+    while (true) {
+        if (actors_idle(next_wake)) return true;
+
+        long long left = deadline - monotonic_ns();
+        if (left <= 0) return false;
+
+        sleep_nanos(left < slice ? left : slice);
+        if (slice < IDLE_POLL_MAX_NS) slice *= 2;
+    }
+}
+
+// --- Actor side ---
+
+bool sim_clock_attach(void) {
+    if (sim_clock == NULL) {
+        sim_clock = attach_shared_memory(SHM_CLOCK_NAME, SHM_CLOCK_SIZE, PROT_READ | PROT_WRITE);
+    }
+    return sim_clock != NULL;
+}
+
+void sim_actor_join(ACTOR_ROLE role) {
+    if (sim_clock == NULL) return;
+    own_role = role;
+
+    sem_wait(&sim_clock->slots_lock);
+    own_slot = acquire_slot(getpid());
+    sem_post(&sim_clock->slots_lock);
+}
+
+void sim_actor_leave(void) {
+    if (sim_clock == NULL || own_slot == NULL) return;
+
+    sem_wait(&sim_clock->slots_lock);
+    release_slot(own_slot);
+    sem_post(&sim_clock->slots_lock);
+    own_slot = NULL;
+}
+
+bool sim_time_warp(void) {
+    return own_slot != NULL && clock_tracking();
+}
+
+void sim_sleep_minutes(int minutes) {
+    if (minutes <= 0) return;
+    mq_flush(); // What this process sent must reach the broker before it sleeps
+
+    if (!sim_time_warp()) {
+        actor_sleep_nanos((long long)minutes * g_config.minute_duration);
+        return;
+    }
+
+    int wake = __atomic_load_n(&sim_clock->now, __ATOMIC_SEQ_CST) + minutes;
+    __atomic_store_n(&own_slot->woken_ns, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&own_slot->wake_minute, wake, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&own_slot->state, ACTOR_SLEEPING, __ATOMIC_SEQ_CST);
+
+    while (__atomic_load_n(&sim_clock->now, __ATOMIC_SEQ_CST) < wake) {
+        if (sem_wait(&own_slot->wake) != 0 && errno != EINTR) break;
+    }
+
+    __atomic_store_n(&own_slot->state, ACTOR_RUNNING, __ATOMIC_SEQ_CST);
+    long long woken = __atomic_load_n(&own_slot->woken_ns, __ATOMIC_SEQ_CST);
+    if (woken != 0) record_lag(monotonic_ns() - woken);
+}
+
+long long sim_sleep_nanos(long long nanos) {
+    mq_flush();
+    if (!sim_time_warp() || !sim_clock->time_warp) {
+        actor_sleep_nanos(nanos);
+        return nanos;
+    }
+
+    // Rounded to the nearest simulated minute, at least one
+    long long minutes = (nanos + g_config.minute_duration / 2) / g_config.minute_duration;
+    if (minutes < 1) minutes = 1;
+    sim_sleep_minutes((int)minutes);
+    return minutes * g_config.minute_duration;
+}
+
+double sim_lag_percentile_us(const struct S_lag_histogram *lag, double fraction) {
+    unsigned long long seen = 0;
+    for (int b = 0; b < LAG_BUCKETS; b++) {
+        seen += lag->buckets[b];
+        if (seen > 0 && seen >= fraction * lag->samples) return (double)(1ULL << b);
+    }
+    return 0.0;
+}
+
+void sim_block(void) {
+    mq_flush();
+    if (!sim_time_warp()) return;
+    __atomic_store_n(&own_slot->state, ACTOR_BLOCKED, __ATOMIC_SEQ_CST);
+}
+
+void sim_unblock(bool consumed) {
+    if (!sim_time_warp()) return;
+    __atomic_store_n(&own_slot->state, ACTOR_RUNNING, __ATOMIC_SEQ_CST);
+    if (consumed) {
+        __atomic_sub_fetch(&sim_clock->pending, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+void sim_received(void) {
+    if (!sim_time_warp()) return;
+    __atomic_sub_fetch(&sim_clock->pending, 1, __ATOMIC_SEQ_CST);
+}
+
+void sim_drop_wakeups(int n) {
+    if (!clock_tracking()) return;
+    __atomic_sub_fetch(&sim_clock->pending, n, __ATOMIC_SEQ_CST);
+}
+
+void sim_expect_wakeups(int n) {
+    if (!clock_tracking()) return;
+    __atomic_add_fetch(&sim_clock->pending, n, __ATOMIC_SEQ_CST);
+}
+
+int sim_reply(mq_id qid, pid_t pid, const void *data, size_t length) {
+    sim_expect_wakeups(1);
+    if (mq_send(qid, pid, data, length) < 0) {
+        int saved = errno;
+        sim_expect_wakeups(-1);
+        errno = saved;
+        return -1;
+    }
+    // A zombie still counts as alive, its reaper drains the queue after waiting
+    if (kill(pid, 0) < 0 && errno == ESRCH) {
+        char message[MQ_MAX_MESSAGE];
+        if (mq_receive(qid, pid, message, sizeof(message), IPC_NOWAIT) >= 0) sim_drop_wakeups(1);
+    }
+    return 0;
+}
+
+// --- Actor queues ---
+
+static struct S_actor_slot *queue_slot(int index) {
+    return index > 0 ? &sim_clock->actors[index - 1] : NULL;
+}
+
+static void queue_unlink(struct S_actor_queue *queue, struct S_actor_slot *slot) {
+    struct S_actor_slot *prev = queue_slot(slot->prev);
+    struct S_actor_slot *next = queue_slot(slot->next);
+    if (prev != NULL) prev->next = slot->next;
+    else              queue->first = slot->next;
+    if (next != NULL) next->prev = slot->prev;
+    else              queue->last = slot->prev;
+    queue->length--;
+
+    slot->next = slot->prev = 0;
+    __atomic_store_n(&slot->queued, 0, __ATOMIC_SEQ_CST);
+}
+
+bool sim_queue_push(struct S_actor_queue *queue) {
+    if (sim_clock == NULL || own_slot == NULL) return false;
+
+    int index = (int)(own_slot - sim_clock->actors) + 1;
+    own_slot->next = 0;
+    own_slot->prev = queue->last;
+    own_slot->handoff = -1;
+    if (queue->last != 0) queue_slot(queue->last)->next = index;
+    else                  queue->first = index;
+    queue->last = index;
+    queue->length++;
+    __atomic_store_n(&own_slot->queued, 1, __ATOMIC_SEQ_CST);
+    return true;
+}
+
+pid_t sim_queue_wake(struct S_actor_queue *queue, int value) {
+    if (queue->first == 0) return 0;
+
+    struct S_actor_slot *slot = queue_slot(queue->first);
+    pid_t pid = slot->pid;
+    slot->handoff = value;
+    queue_unlink(queue, slot);
+
+    // Accounted until the actor takes the value, the director cannot warp past it
+    sim_expect_wakeups(1);
+    int expected = ACTOR_SLEEPING;
+    __atomic_compare_exchange_n(&slot->state, &expected, ACTOR_RUNNING, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    sem_post(&slot->wake);
+    return pid;
+}
+
+int sim_queue_leave(struct S_actor_queue *queue) {
+    if (own_slot == NULL) return -1;
+
+    if (__atomic_load_n(&own_slot->queued, __ATOMIC_SEQ_CST)) {
+        queue_unlink(queue, own_slot);
+        return -1;
+    }
+    sim_received();
+    int value = own_slot->handoff;
+    own_slot->handoff = -1;
+    return value;
+}
+
+bool sim_queue_remove(struct S_actor_queue *queue, pid_t pid) {
+    if (sim_clock == NULL) return false;
+
+    int index = queue->first;
+    for (int steps = 0; index > 0 && index <= MAX_ACTORS && steps < MAX_ACTORS; steps++) {
+        struct S_actor_slot *slot = queue_slot(index);
+        if (slot->pid == pid) {
+            queue_unlink(queue, slot);
+            return true;
+        }
+        index = slot->next;
+    }
+    return false;
+}
+
+void sim_queue_repair(struct S_actor_queue *queue) {
+    if (sim_clock == NULL) return;
+
+    // The holder may have died halfway through a push or an unlink: follow
+    // next from first, never more than MAX_ACTORS steps
+    int first = 0, last = 0, length = 0;
+    int index = queue->first;
+    for (int steps = 0; index > 0 && index <= MAX_ACTORS && steps < MAX_ACTORS; steps++) {
+        struct S_actor_slot *slot = queue_slot(index);
+        int next = slot->next;
+        bool alive = slot->pid != 0 && !(kill(slot->pid, 0) != 0 && errno == ESRCH);
+        if (alive && __atomic_load_n(&slot->queued, __ATOMIC_SEQ_CST)) {
+            slot->prev = last;
+            slot->next = 0;
+            if (last != 0) queue_slot(last)->next = index;
+            else           first = index;
+            last = index;
+            length++;
+        }
+        index = next;
+    }
+    queue->first  = first;
+    queue->last   = last;
+    queue->length = length;
+}
+
+void sim_queue_wait(int minutes) {
+    if (own_slot == NULL || minutes <= 0) return;
+    mq_flush();
+
+    // A wake token may be left over from an earlier wait: check queued around every wakeup
+    if (!sim_time_warp()) {
+        long long deadline = (long long)minutes * g_config.minute_duration;
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        deadline += ts.tv_nsec;
+        ts.tv_sec  += deadline / 1000000000LL;
+        ts.tv_nsec  = deadline % 1000000000LL;
+
+        while (__atomic_load_n(&own_slot->queued, __ATOMIC_SEQ_CST)) {
+            if (sem_timedwait(&own_slot->wake, &ts) != 0) break; // Timed out or signal
+        }
+        return;
+    }
+
+    int wake = __atomic_load_n(&sim_clock->now, __ATOMIC_SEQ_CST) + minutes;
+    __atomic_store_n(&own_slot->wake_minute, wake, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&own_slot->state, ACTOR_SLEEPING, __ATOMIC_SEQ_CST);
+
+    while (__atomic_load_n(&own_slot->queued, __ATOMIC_SEQ_CST) &&
+           __atomic_load_n(&sim_clock->now, __ATOMIC_SEQ_CST) < wake) {
+        if (sem_wait(&own_slot->wake) != 0 && errno == EINTR) break;
+    }
+
+    __atomic_store_n(&own_slot->state, ACTOR_RUNNING, __ATOMIC_SEQ_CST);
+}
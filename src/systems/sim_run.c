@@ -0,0 +1,133 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+#include <sys/mman.h>
+
+#include <sim_run.h>
+#include <poste.h>
+#include <comunications.h>
+#include <instance.h>
+#include <config_shm.h>
+#include <sim_clock.h>
+#include <sampler.h>
+#include <branch.h>
+
+pid_t sim_run_launch(const char *instance, const char *config_path, bool keep_log) {
+    char dir[MAX_PATH_LENGTH];
+    char log_path[MAX_PATH_LENGTH + 32];
+    instance_output_dir(instance, dir, sizeof(dir));
+    snprintf(log_path, sizeof(log_path), "%sdirettore.log", dir);
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        setpgid(0, 0); // One group per run, killed as a whole
+        setenv(POSTE_INSTANCE_ENV, instance, 1);
+        int log = open(keep_log ? log_path : "/dev/null", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log >= 0) {
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+            close(log);
+        }
+        execl(DIRECTOR_PATH, DIRECTOR_PATH, "--config", config_path, (char *)NULL);
+        perror("execl failed");
+        _exit(EXIT_FAILURE);
+    }
+
+    setpgid(pid, pid);
+    return pid;
+}
+
+void sim_run_cleanup(const char *instance, bool keep) {
+    const char *segments[] = { SHM_STATS_NAME, SHM_STATIONS_NAME, SHM_CONFIG_NAME,
+                               SHM_CLOCK_NAME, SHM_SAMPLES_NAME };
+    char name[128];
+    for (size_t i = 0; i < sizeof(segments) / sizeof(segments[0]); i++) {
+        instance_shm_name(instance, segments[i], name, sizeof(name));
+        shm_unlink(name);
+    }
+
+    const char *keys[] = { KEY_TICKET_MSG, KEY_NEW_USERS };
+    const int proj_ids[] = { PROJ_ID, proj_ID_USERS };
+    for (int i = 0; i < 2; i++) {
+        int qid = msgget(instance_key(instance, keys[i], proj_ids[i]), 0);
+        if (qid >= 0) msgctl(qid, IPC_RMID, NULL);
+    }
+
+    // Segments and ticket queues of the other branches, if the run had any
+    for (int b = 1; b < MAX_BRANCHES; b++) {
+        char branch_name[64];
+        branch_shm_name(SHM_STATS_NAME, b, branch_name, sizeof(branch_name));
+        instance_shm_name(instance, branch_name, name, sizeof(name));
+        shm_unlink(name);
+        branch_shm_name(SHM_STATIONS_NAME, b, branch_name, sizeof(branch_name));
+        instance_shm_name(instance, branch_name, name, sizeof(name));
+        shm_unlink(name);
+        int qid = msgget(instance_key(instance, KEY_TICKET_MSG, branch_ticket_proj_id(b)), 0);
+        if (qid >= 0) msgctl(qid, IPC_RMID, NULL);
+    }
+
+    if (keep) return;
+
+    char dir[MAX_PATH_LENGTH];
+    char path[MAX_PATH_LENGTH + 300];
+    instance_output_dir(instance, dir, sizeof(dir));
+    DIR *d = opendir(dir);
+    if (d == NULL) return;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s%s", dir, entry->d_name);
+        unlink(path);
+    }
+    closedir(d);
+    rmdir(dir);
+}
+
+FILE *sim_run_results(const char *instance) {
+    char dir[MAX_PATH_LENGTH];
+    char path[MAX_PATH_LENGTH + 32];
+    instance_output_dir(instance, dir, sizeof(dir));
+    snprintf(path, sizeof(path), "%sfinal_stats.csv", dir);
+    return fopen(path, "r");
+}
+
+bool sim_run_copy_config(const char *config_file, FILE *out) {
+    if (config_file == NULL) return true;
+
+    FILE *in = fopen(config_file, "r");
+    if (in == NULL) {
+        perror("fopen for --config");
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), in) != NULL) fputs(line, out);
+    fclose(in);
+    fputc('\n', out);
+    return true;
+}
+
+int csv_split_fields(char *line, char *fields[], int max) {
+    line[strcspn(line, "\r\n")] = '\0';
+    int n = 0;
+    char *field = line;
+    while (n < max) {
+        fields[n++] = field;
+        char *comma = strchr(field, ',');
+        if (comma == NULL) break;
+        *comma = '\0';
+        field = comma + 1;
+    }
+    return n;
+}
@@ -0,0 +1,139 @@
+#include <string.h>
+#include <sched.h>
+
+#include <stats.h>
+#include <msg_queue.h>
+#include <mq_broker.h>
+#include <utilization.h>
+
+void stats_write_begin(struct S_poste_stats *stats) {
+    if (shm_mutex_lock(&stats->stats_lock) && (stats->stats_seq & 1)) {
+        // The last writer died mid-update: close it, or readers would retry forever
+        __atomic_store_n(&stats->stats_seq, stats->stats_seq + 1, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&stats->stats_seq, stats->stats_seq + 1, __ATOMIC_RELAXED);
+    // The odd sequence must be visible before any counter changes
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void stats_write_end(struct S_poste_stats *stats) {
+    __atomic_store_n(&stats->stats_seq, stats->stats_seq + 1, __ATOMIC_RELEASE);
+    shm_mutex_unlock(&stats->stats_lock);
+}
+
+void stats_apply(struct S_poste_stats *stats, const struct S_stats_update *update) {
+    int service = update->service;
+    if (service < 0 || service >= NUM_SERVICE_TYPES) service = 0;
+
+    // Service counters move for the run and the day, overall and for the service
+    struct S_service_stats *counters[] = {
+        &stats->simulation_global, &stats->simulation_services[service],
+        &stats->today.global, &stats->today.services[service]
+    };
+    const int num_counters = sizeof(counters) / sizeof(counters[0]);
+
+    stats_write_begin(stats);
+    switch ((STATS_UPDATE)update->kind) {
+        case STATS_SERVED:
+            for (int i = 0; i < num_counters; i++) {
+                counters[i]->served_users++;
+                counters[i]->total_wait_time    += update->wait_time;
+                counters[i]->total_service_time += update->minutes;
+            }
+            break;
+        case STATS_FAILED:
+            for (int i = 0; i < num_counters; i++) counters[i]->failed_services++;
+            break;
+        case STATS_WAITING:
+            stats->waiting_users[service] += update->delta;
+            break;
+        case STATS_SEAT_WAIT: {
+            int minutes = update->delta;
+            if (minutes < 0) minutes = 0;
+            if (minutes >= WAIT_HISTOGRAM_BINS) minutes = WAIT_HISTOGRAM_BINS - 1;
+            stats->wait_histogram[minutes]++;
+            break;
+        }
+        case STATS_LATE:
+            stats->today.late_users++;
+            stats->simulation_global.late_users++;
+            stats->simulation_services[service].late_users++;
+            break;
+        case STATS_REQUEST:
+            for (int i = 0; i < num_counters; i++) counters[i]->total_requests++;
+            break;
+        case STATS_PAUSE:
+            stats->total_simulation_pauses++;
+            stats->today.total_pauses++;
+            break;
+        case STATS_BUSY:
+            utilization_add_busy(&stats->today.usage, update->seat, update->pid, service, update->minutes);
+            utilization_add_busy(&stats->simulation_usage, update->seat, update->pid, service, update->minutes);
+            break;
+        case STATS_SEATED:
+            utilization_add_seated(&stats->today.usage, update->seat, update->pid, service, update->minutes);
+            utilization_add_seated(&stats->simulation_usage, update->seat, update->pid, service, update->minutes);
+            break;
+        case STATS_ACTIVE_OPERATOR:
+            stats->total_active_operators++;
+            stats->today.active_operators++;
+            break;
+        case STATS_TRACE_DELAYED:
+            stats->trace_delayed++;
+            stats->trace_delay_minutes += update->delta;
+            break;
+    }
+    stats_write_end(stats);
+}
+
+void stats_update(struct S_poste_stats *stats, struct S_stats_update update) {
+    if (mq_is_remote()) {
+        update.branch = stats->branch;
+        if (mq_post(MQ_RECORD_STATS, &update, sizeof(update))) return;
+    }
+    stats_apply(stats, &update); // Broker unreachable: the segment is still shared
+}
+
+void stats_snapshot(const struct S_poste_stats *stats, struct S_stats_snapshot *snap) {
+    unsigned int begin, end;
+    do {
+        begin = __atomic_load_n(&stats->stats_seq, __ATOMIC_ACQUIRE);
+        if (begin & 1) {
+            // Writer in progress, critical sections are short
+            sched_yield();
+            continue;
+        }
+
+        memcpy(&snap->simulation_global, &stats->simulation_global, sizeof(snap->simulation_global));
+        memcpy(snap->simulation_services, stats->simulation_services, sizeof(snap->simulation_services));
+        memcpy(&snap->today, &stats->today, sizeof(snap->today));
+        snap->total_active_operators  = stats->total_active_operators;
+        snap->total_simulation_pauses = stats->total_simulation_pauses;
+        snap->current_day             = stats->current_day;
+        snap->current_minute          = stats->current_minute;
+        memcpy(snap->waiting_users, stats->waiting_users, sizeof(snap->waiting_users));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        end = __atomic_load_n(&stats->stats_seq, __ATOMIC_RELAXED);
+    } while ((begin & 1) || begin != end);
+}
+
+int stats_wait_count(const int histogram[WAIT_HISTOGRAM_BINS]) {
+    int count = 0;
+    for (int i = 0; i < WAIT_HISTOGRAM_BINS; i++) count += histogram[i];
+    return count;
+}
+
+int stats_wait_percentile(const int histogram[WAIT_HISTOGRAM_BINS], double fraction) {
+    int count = stats_wait_count(histogram);
+    if (count == 0) return -1;
+
+    // Smallest bin holding the ceil(fraction * count)-th request
+    double rank = fraction * count;
+    int seen = 0;
+    for (int i = 0; i < WAIT_HISTOGRAM_BINS; i++) {
+        seen += histogram[i];
+        if (seen >= rank && seen > 0) return i;
+    }
+    return WAIT_HISTOGRAM_BINS - 1;
+}
@@ -0,0 +1,264 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <trace.h>
+
+#define MINUTES_PER_DAY 1440
+
+// An arrival of the CSV, before the days are made relative
+struct S_trace_arrival {
+    int day;
+    int minute;
+    int service;
+};
+
+typedef struct S_trace_arrival trace_arrival;
+
+static void skip_blanks(const char **p, const char *end) {
+    while (*p < end && (**p == ' ' || **p == '\t')) (*p)++;
+}
+
+// Reads digits at *p, at most 9 of them. False if there is none.
+static bool parse_number(const char **p, const char *end, int *value) {
+    skip_blanks(p, end);
+    int digits = 0;
+    *value = 0;
+    while (*p < end && **p >= '0' && **p <= '9' && digits < 9) {
+        *value = *value * 10 + (**p - '0');
+        (*p)++;
+        digits++;
+    }
+    skip_blanks(p, end);
+    return digits > 0 && (*p == end || **p < '0' || **p > '9');
+}
+
+static bool expect(const char **p, const char *end, char c) {
+    if (*p == end || **p != c) return false;
+    (*p)++;
+    return true;
+}
+
+// Parses the line from p to end (its '\n' excluded): 1 for an arrival, 0
+// for a line to skip, -1 if malformed. The file is mapped, nothing past end
+// may be read.
+static int parse_line(const char *p, const char *end, bool header_allowed, trace_arrival *out) {
+    skip_blanks(&p, end);
+    if (p == end || *p == '#' || *p == '\r') return 0;
+    if (*p < '0' || *p > '9') return header_allowed ? 0 : -1;
+
+    int hours, minutes;
+    if (!parse_number(&p, end, &out->day) || !expect(&p, end, ',')) return -1;
+    if (!parse_number(&p, end, &minutes)) return -1;
+    if (p < end && *p == ':') {
+        hours = minutes;
+        p++;
+        if (!parse_number(&p, end, &minutes) || hours >= 24 || minutes >= 60) return -1;
+        minutes += hours * 60;
+    }
+    out->minute = minutes;
+    if (!expect(&p, end, ',') || !parse_number(&p, end, &out->service)) return -1;
+
+    if (p < end && *p == '\r') p++;
+    if (p < end && *p != '#') return -1;
+    if (out->minute >= MINUTES_PER_DAY || out->service >= NUM_SERVICE_TYPES) return -1;
+    return 1;
+}
+
+static int compare_arrivals(const void *a, const void *b) {
+    const trace_arrival *x = a, *y = b;
+    if (x->day != y->day)       return x->day < y->day ? -1 : 1;
+    if (x->minute != y->minute) return x->minute < y->minute ? -1 : 1;
+    return x->service - y->service;
+}
+
+// Maps a whole file read only, NULL if it is missing or empty
+static void *map_file(const char *path, size_t *size, int advice) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+    posix_madvise(map, (size_t)st.st_size, advice);
+    *size = (size_t)st.st_size;
+    return map;
+}
+
+bool trace_is_binary(const char *path) {
+    char magic[sizeof(((struct S_trace_header *)0)->magic)];
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) return false;
+    bool binary = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) &&
+                  memcmp(magic, TRACE_MAGIC, sizeof(magic)) == 0;
+    fclose(fp);
+    return binary;
+}
+
+// Writes the sorted arrivals as a binary trace, through a temporary file so
+// a reader never maps a half written one
+static bool write_binary(const char *output, const trace_arrival *arrivals, int count) {
+    struct S_trace_header header = {0};
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version   = TRACE_VERSION;
+    header.first_day = arrivals[0].day;
+    header.days      = (uint32_t)(arrivals[count - 1].day - arrivals[0].day + 1);
+    header.records   = (uint32_t)count;
+
+    uint32_t *day_start = calloc(header.days + 1, sizeof(uint32_t));
+    struct S_trace_record *records = malloc((size_t)count * sizeof(struct S_trace_record));
+    if (day_start == NULL || records == NULL) {
+        free(day_start);
+        free(records);
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        day_start[arrivals[i].day - header.first_day + 1]++;
+        records[i] = (struct S_trace_record){ (uint16_t)arrivals[i].minute, (uint8_t)arrivals[i].service, 0 };
+    }
+    for (uint32_t d = 1; d <= header.days; d++) day_start[d] += day_start[d - 1];
+
+    char tmp_path[MAX_PATH_LENGTH + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", output);
+    FILE *fp = fopen(tmp_path, "wb");
+    bool ok = fp != NULL &&
+              fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(day_start, sizeof(uint32_t), header.days + 1, fp) == header.days + 1 &&
+              fwrite(records, sizeof(struct S_trace_record), (size_t)count, fp) == (size_t)count;
+    if (fp != NULL && fclose(fp) != 0) ok = false;
+    if (ok) ok = rename(tmp_path, output) == 0;
+    else if (fp != NULL) unlink(tmp_path);
+
+    free(day_start);
+    free(records);
+    return ok;
+}
+
+bool trace_compile(const char *source, const char *output, struct S_trace_info *info) {
+    memset(info, 0, sizeof(*info));
+    size_t size;
+    const char *text = map_file(source, &size, POSIX_MADV_SEQUENTIAL);
+    if (text == NULL) return false;
+    const char *end = text + size;
+
+    // One arrival at most per line
+    size_t lines = 1;
+    for (const char *p = text; (p = memchr(p, '\n', (size_t)(end - p))) != NULL; p++) lines++;
+    trace_arrival *arrivals = malloc(lines * sizeof(trace_arrival));
+    if (arrivals == NULL) {
+        munmap((void *)text, size);
+        return false;
+    }
+
+    int count = 0;
+    int line = 0;
+    bool sorted = true;
+    for (const char *p = text; p < end; ) {
+        const char *eol = memchr(p, '\n', (size_t)(end - p));
+        if (eol == NULL) eol = end;
+        line++;
+        int parsed = parse_line(p, eol, count == 0 && info->skipped_lines == 0, &arrivals[count]);
+        if (parsed > 0) {
+            if (count > 0 && compare_arrivals(&arrivals[count - 1], &arrivals[count]) > 0) sorted = false;
+            count++;
+        } else if (parsed < 0) {
+            if (info->skipped_lines++ == 0) info->first_skipped = line;
+        }
+        p = eol + 1;
+    }
+    munmap((void *)text, size);
+
+    // Recorded logs come in order, sorted only if they are not
+    if (!sorted) qsort(arrivals, (size_t)count, sizeof(trace_arrival), compare_arrivals);
+    bool ok = count > 0 && arrivals[count - 1].day - arrivals[0].day < TRACE_MAX_DAYS &&
+              write_binary(output, arrivals, count);
+    free(arrivals);
+    return ok;
+}
+
+bool trace_open(const char *path, struct S_trace *trace) {
+    memset(trace, 0, sizeof(*trace));
+    size_t size;
+    void *map = map_file(path, &size, POSIX_MADV_RANDOM);
+    if (map == NULL) return false;
+
+    const struct S_trace_header *header = map;
+    bool ok = size >= sizeof(*header) &&
+              memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) == 0 &&
+              header->version == TRACE_VERSION &&
+              header->days > 0 && header->days <= TRACE_MAX_DAYS &&
+              size == sizeof(*header) + (header->days + 1) * sizeof(uint32_t) +
+                      (size_t)header->records * sizeof(struct S_trace_record);
+    const uint32_t *day_start = (const uint32_t *)(header + 1);
+    if (ok) {
+        ok = day_start[0] == 0 && day_start[header->days] == header->records;
+        for (uint32_t d = 0; ok && d < header->days; d++) ok = day_start[d] <= day_start[d + 1];
+    }
+    if (!ok) {
+        munmap(map, size);
+        return false;
+    }
+
+    trace->map       = map;
+    trace->size      = size;
+    trace->header    = header;
+    trace->day_start = day_start;
+    trace->records   = (const struct S_trace_record *)(day_start + header->days + 1);
+    return true;
+}
+
+void trace_close(struct S_trace *trace) {
+    if (trace->map != NULL) munmap(trace->map, trace->size);
+    memset(trace, 0, sizeof(*trace));
+}
+
+void trace_info(const struct S_trace *trace, struct S_trace_info *info) {
+    info->records         = (int)trace->header->records;
+    info->days            = (int)trace->header->days;
+    info->first_day       = trace->header->first_day;
+    info->busiest_day     = 0;
+    info->busiest_records = 0;
+    for (uint32_t d = 0; d < trace->header->days; d++) {
+        int records = (int)(trace->day_start[d + 1] - trace->day_start[d]);
+        if (records > info->busiest_records) {
+            info->busiest_records = records;
+            info->busiest_day     = (int)d + 1;
+        }
+    }
+}
+
+void trace_deal(const struct S_trace *trace, int day, int user, int users, struct S_trace_cursor *cursor) {
+    *cursor = (struct S_trace_cursor){ trace->records, 0, 0, 1 };
+    if (day < 1 || (uint32_t)day > trace->header->days || user < 0 || user >= users) return;
+    cursor->next   = trace->day_start[day - 1] + (uint32_t)user;
+    cursor->end    = trace->day_start[day];
+    cursor->stride = (uint32_t)users;
+}
+
+const struct S_trace_record *trace_next(struct S_trace_cursor *cursor) {
+    while (cursor->next < cursor->end) {
+        const struct S_trace_record *record = &cursor->records[cursor->next];
+        cursor->next += cursor->stride;
+        // A binary trace given as is was not checked record by record
+        if (record->minute < MINUTES_PER_DAY && record->service < NUM_SERVICE_TYPES) return record;
+    }
+    return NULL;
+}
+
+int trace_after_close(const struct S_trace *trace, int close_minute) {
+    int count = 0;
+    for (uint32_t i = 0; i < trace->header->records; i++) {
+        if (trace->records[i].minute >= close_minute) count++;
+    }
+    return count;
+}
@@ -0,0 +1,59 @@
+#include <utilization.h>
+
+struct S_operator_utilization *utilization_operator(struct S_utilization *usage, pid_t pid, int service) {
+    struct S_operator_utilization *free_slot = NULL;
+    for (int i = 0; i < MAX_OPERATOR_STATES; i++) {
+        struct S_operator_utilization *op = &usage->operators[i];
+        if (op->pid == pid) return op;
+        if (op->pid == 0) {
+            free_slot = op;
+            break; // Slots are never released, the rest is free too
+        }
+    }
+
+    if (free_slot == NULL) {
+        usage->untracked_operators++;
+        return NULL;
+    }
+    free_slot->pid     = pid;
+    free_slot->service = service;
+    return free_slot;
+}
+
+void utilization_add_busy(struct S_utilization *usage, int seat, pid_t pid, int service, double minutes) {
+    if (seat >= 0 && seat < MAX_WORKER_SEATS) {
+        usage->seats[seat].busy_minutes += minutes;
+        usage->seats[seat].services++;
+    }
+
+    struct S_operator_utilization *op = utilization_operator(usage, pid, service);
+    if (op != NULL) {
+        op->busy_minutes += minutes;
+        op->services++;
+    }
+}
+
+void utilization_add_seated(struct S_utilization *usage, int seat, pid_t pid, int service, double minutes) {
+    if (minutes < 0) minutes = 0; // Released after the day rolled over
+    if (seat >= 0 && seat < MAX_WORKER_SEATS) {
+        usage->seats[seat].seated_minutes += minutes;
+    }
+
+    struct S_operator_utilization *op = utilization_operator(usage, pid, service);
+    if (op != NULL) op->seated_minutes += minutes;
+}
+
+void utilization_service_totals(const struct S_utilization *usage, int service,
+                                double *busy_minutes, double *seated_minutes) {
+    *busy_minutes   = 0.0;
+    *seated_minutes = 0.0;
+    for (int i = 0; i < MAX_OPERATOR_STATES && usage->operators[i].pid != 0; i++) {
+        if (usage->operators[i].service != service) continue;
+        *busy_minutes   += usage->operators[i].busy_minutes;
+        *seated_minutes += usage->operators[i].seated_minutes;
+    }
+}
+
+double utilization_percent(double busy_minutes, double available_minutes) {
+    return available_minutes > 0 ? 100.0 * busy_minutes / available_minutes : 0.0;
+}
@@ -5,14 +5,26 @@
 #include <stdlib.h>
 #include <time.h>
 #include <errno.h>
+#include <signal.h>
 #include <string.h>
 #include <comunications.h>
 #include <poste.h>
+#include <utente.h>
 #include <shared_mem.h>
+#include <instance.h>
+#include <stats.h>
+#include <sim_clock.h>
+#include <config_shm.h>
+#include <seat_queue.h>
+#include <branch.h>
+#include <arrival.h>
+#include <trace.h>
 
 // TYPES
 typedef struct S_ticket_request    ticket_request;
 typedef struct S_ticket_response   ticket_response;
+typedef struct S_ticket_bundle_request  ticket_bundle_request;
+typedef struct S_ticket_bundle_response ticket_bundle_response;
 typedef struct S_service_request   service_request;
 typedef struct S_service_done      service_done;
 typedef struct S_poste_stats       poste_stats;
@@ -21,9 +33,25 @@ typedef struct S_poste_stations    poste_stations;
 typedef struct S_worker_seat       worker_seat;
 
 #define PREFIX "\033[32m[UTENTE(%d)]:\033[0m"
+#define WALK_IN_DRAWS 100 // Draws for a walk-in after the minute a user joined, then uniform
 
 static bool been_late_today = false;
 
+// Segments and ticket queue of a branch of the run, see branch.h
+struct S_branch_office {
+    poste_stats *stats;
+    poste_stations *stations;
+    mq_id qid;
+};
+
+static struct S_branch_office branches[MAX_BRANCHES];
+static double home = 0.0;  // Where the user lives on the line of the branches
+static int home_branch = 0; // Nearest branch, the user waits on its events
+static struct S_trace trace; // Mapped when replaying a trace (see trace.h)
+
+// Set by SIGUSR1 when the director retires this user (see ramp.h)
+static volatile sig_atomic_t retire_requested = 0;
+
 // Send a ticket request returns 0 on failure and 1 on success
 int send_ticket_request(mq_id qid, int service) {
     ticket_request req;
@@ -33,7 +61,9 @@ int send_ticket_request(mq_id qid, int service) {
     printf(PREFIX " Sending ticket request (service_id=%d)\n", getpid(), req.service_id);
     fflush(stdout);
 
+    sim_expect_wakeups(1);
     if (mq_send(qid, MSG_TYPE_TICKET_REQUEST, &req, sizeof(req)) < 0) {
+        sim_expect_wakeups(-1);
         fprintf(stderr, PREFIX " ERROR mq_send request: %s\n", getpid(), strerror(errno));
         fflush(stderr);
         return 0;
@@ -44,7 +74,9 @@ int send_ticket_request(mq_id qid, int service) {
 // Wait for ticket response
 ticket_response await_ticket_response(mq_id qid) {
     ticket_response res;
+    sim_block();
     ssize_t n = mq_receive(qid, getpid(), &res, sizeof(res), 0);
+    sim_unblock(n >= 0);
 
     if (n < 0) {
         if (errno == EINTR) {
@@ -61,6 +93,47 @@ ticket_response await_ticket_response(mq_id qid) {
     return res;
 }
 
+// Takes a ticket for every service of the list in one round trip with the
+// ticket generator, tickets[i] for service_list[i]. False if it failed.
+bool request_ticket_bundle(mq_id qid, const int service_list[], int n_services, int tickets[]) {
+    if (n_services < 1 || n_services > MAX_N_REQUESTS_COMPILE) return false;
+
+    ticket_bundle_request req;
+    req.sender_pid = getpid();
+    req.count = n_services;
+    memcpy(req.service_ids, service_list, n_services * sizeof(int));
+
+    printf(PREFIX " Sending ticket bundle request for %d services\n", getpid(), n_services);
+    fflush(stdout);
+
+    sim_expect_wakeups(1);
+    if (mq_send(qid, MSG_TYPE_TICKET_BUNDLE_REQUEST, &req, TICKET_BUNDLE_SIZE(n_services)) < 0) {
+        sim_expect_wakeups(-1);
+        fprintf(stderr, PREFIX " ERROR mq_send bundle request: %s\n", getpid(), strerror(errno));
+        fflush(stderr);
+        return false;
+    }
+
+    // The answer is on its way: a signal must not leave it behind on the queue
+    ticket_bundle_response res;
+    ssize_t n;
+    do {
+        sim_block();
+        n = mq_receive(qid, getpid(), &res, sizeof(res), 0);
+        sim_unblock(n >= 0);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0 || res.count != n_services) {
+        fprintf(stderr, PREFIX " ERROR ticket bundle: %s\n", getpid(), n < 0 ? strerror(errno) : "refused");
+        fflush(stderr);
+        return false;
+    }
+    memcpy(tickets, res.ticket_numbers, n_services * sizeof(int));
+    printf(PREFIX " Received %d tickets, from %d to %d\n", getpid(), n_services, tickets[0], tickets[n_services - 1]);
+    fflush(stdout);
+    return true;
+}
+
 // Send service request returns 0 on failure and 1 on success
 int send_service_request(mq_id qid, int ticket_number, pid_t operator_pid) {
     service_request req;
@@ -71,7 +144,9 @@ int send_service_request(mq_id qid, int ticket_number, pid_t operator_pid) {
     printf(PREFIX " Sending service request for ticket %d to operator %d, msg_type=%ld\n", getpid(), ticket_number, operator_pid, mtype);
     fflush(stdout);
 
+    sim_expect_wakeups(1);
     if (mq_send(qid, mtype, &req, sizeof(req)) < 0) {
+        sim_expect_wakeups(-1);
         fprintf(stderr, PREFIX " ERROR mq_send service request: %s\n", getpid(), strerror(errno));
         fflush(stderr);
         return 0;
@@ -82,7 +157,9 @@ int send_service_request(mq_id qid, int ticket_number, pid_t operator_pid) {
 // Wait for service done
 service_done await_service_done(mq_id qid) {
     service_done res;
+    sim_block();
     ssize_t n = mq_receive(qid, getpid(), &res, sizeof(res), 0);
+    sim_unblock(n >= 0);
     if (n < 0) {
         if (errno == EINTR) {
             printf(PREFIX " mq_receive interrupted, retrying\n", getpid());
@@ -107,12 +184,14 @@ bool will_go_to_poste(void) {
 int generate_service_list(int list[MAX_N_REQUESTS_COMPILE]) {
     int max = (rand() % g_config.max_n_requests) + 1;
     for (int i = 0; i < max; i++) {
-        list[i] = rand() % NUM_SERVICE_TYPES;
+        list[i] = arrival_service();
     }
     return max;
 }
 
-int generate_walk_in_time(int num_requests) {
+// Walk-in minute after minute after, drawn again until it is for a user that
+// joined the open poste. Returns -1 if no walk-in is left today.
+int generate_walk_in_time(int num_requests, int after) {
     int shift_start = g_config.worker_shift_open * 60;     // in minutes
     int shift_end   = g_config.worker_shift_close * 60;    // in minutes
 
@@ -124,66 +203,51 @@ int generate_walk_in_time(int num_requests) {
     if (max_time < 1) {
         max_time = 1;  // fallback to earliest possible time
     }
-    
-    int walk_in = shift_start + (rand() % max_time) + 1;
+
+    int latest = shift_start + max_time;
+    if (after >= latest) return -1;
+
+    int walk_in;
+    for (int draws = 1; (walk_in = arrival_walk_in(shift_start, max_time)) <= after; draws++) {
+        if (draws == WALK_IN_DRAWS) return after + 1 + rand() % (latest - after);
+    }
     return walk_in;
 }
 
 
 void update_fails_stats(poste_stats *shared_stats, int service_id) {
-    sem_wait(&shared_stats->stats_lock);
-    shared_stats->simulation_global.failed_services+=1;
-    shared_stats->simulation_services[service_id].failed_services+=1;
-    shared_stats->today.global.failed_services+=1;
-    shared_stats->today.services[service_id].failed_services+=1;
-    sem_post(&shared_stats->stats_lock);
+    stats_update(shared_stats, (struct S_stats_update){ .kind = STATS_FAILED, .service = service_id });
 }
 
 void update_success_stats(poste_stats *shared_stats, int service_id, double wait_time, double service_time) {
-    sem_wait(&shared_stats->stats_lock);
-    shared_stats->simulation_global.served_users++;
-    shared_stats->simulation_global.total_wait_time += wait_time;
-    shared_stats->simulation_global.total_service_time += service_time;
-    shared_stats->simulation_services[service_id].served_users++;
-    shared_stats->simulation_services[service_id].total_wait_time += wait_time;
-    shared_stats->simulation_services[service_id].total_service_time += service_time;
-    shared_stats->today.global.served_users++;
-    shared_stats->today.services[service_id].served_users++;
-    shared_stats->today.services[service_id].total_wait_time += wait_time;
-    shared_stats->today.services[service_id].total_service_time += service_time;
-    shared_stats->today.global.total_wait_time += wait_time;
-    shared_stats->today.global.total_service_time += service_time;
-    sem_post(&shared_stats->stats_lock);
+    stats_update(shared_stats, (struct S_stats_update){
+        .kind = STATS_SERVED, .service = service_id, .wait_time = wait_time, .minutes = service_time
+    });
+}
+
+// Function that tracks how many users are waiting for a seat of a service
+void update_waiting_stats(poste_stats *shared_stats, int service_id, int delta) {
+    stats_update(shared_stats, (struct S_stats_update){ .kind = STATS_WAITING, .service = service_id, .delta = delta });
+}
+
+// Function that counts a request in the ticket-to-seat wait histogram
+void update_seat_wait_stats(poste_stats *shared_stats, int minutes) {
+    stats_update(shared_stats, (struct S_stats_update){ .kind = STATS_SEAT_WAIT, .delta = minutes });
 }
 
 // Busy-wait until appointed walk-in time
 void busy_wait_until_walk_in(int walk_in_time, poste_stats *shared_stats) {
-    struct timespec t1 = { .tv_sec = 0, .tv_nsec = g_config.minute_duration * 5 };
-    struct timespec t2;
     while (shared_stats->current_minute < walk_in_time) {
-        if (nanosleep(&t1, &t2) != 0) {
-            printf(PREFIX " Sleep was interrupted.\n", getpid());
-            exit(EXIT_FAILURE);
-        }
+        sim_sleep_minutes(5);
     }
 }
 
 // Function that handles users that remains late
 void handle_late_users(poste_stats *shared_stats, int service_id) {
-    sem_wait(&shared_stats->stats_lock);
+    if (been_late_today) return;
+    been_late_today = true;
 
-    if (been_late_today) {
-        sem_post(&shared_stats->stats_lock);
-        return;
-    }
-    else {
-        been_late_today = true;
-    }
-
-    shared_stats->today.late_users++;
-    shared_stats->simulation_global.late_users++;
-    shared_stats->simulation_services[service_id].late_users++;
-    sem_post(&shared_stats->stats_lock);
+    stats_update(shared_stats, (struct S_stats_update){ .kind = STATS_LATE, .service = service_id });
     printf(PREFIX " Late user, incrementing late users count\n", getpid());
     fflush(stdout);
 }
@@ -194,7 +258,7 @@ void handle_late_users(poste_stats *shared_stats, int service_id) {
 int find_valid_seats(poste_stations *shared_stations, int service_id, int valid_seats[MAX_WORKER_SEATS]) {
     int count = 0;
 
-    sem_wait(&shared_stations->stations_lock);
+    seat_queue_lock(shared_stations);
     for (int i = 0; i < g_config.num_worker_seats; i++) {
         if (shared_stations->NOF_WORKER_SEATS[i].service_id == service_id &&
             shared_stations->NOF_WORKER_SEATS[i].operator_status == OCCUPIED ) {
@@ -202,7 +266,7 @@ int find_valid_seats(poste_stations *shared_stations, int service_id, int valid_
             valid_seats[count++] = i;
         }
     }
-    sem_post(&shared_stations->stations_lock);
+    shm_mutex_unlock(&shared_stations->stations_lock);
 
     return count;
 }
@@ -212,15 +276,16 @@ int find_valid_seats(poste_stations *shared_stations, int service_id, int valid_
 int attempt_take_seat(poste_stations *shared_stations, int valid_seats[MAX_WORKER_SEATS], int n_valid_seats) {
     int current_seat = -1;
 
-    sem_wait(&shared_stations->stations_lock);
+    seat_queue_lock(shared_stations);
     for (int i = 0; i < n_valid_seats; i++) {
         if (shared_stations->NOF_WORKER_SEATS[valid_seats[i]].user_status == FREE) {
             current_seat = valid_seats[i];
-            shared_stations->NOF_WORKER_SEATS[valid_seats[i]].user_status = OCCUPIED;
+            shared_stations->NOF_WORKER_SEATS[valid_seats[i]].user_status  = OCCUPIED;
+            shared_stations->NOF_WORKER_SEATS[valid_seats[i]].user_process = getpid();
             break;
         }
     }
-    sem_post(&shared_stations->stations_lock);
+    shm_mutex_unlock(&shared_stations->stations_lock);
 
     if (current_seat != -1) {
         printf(PREFIX " Took seat %d\n", getpid(), current_seat);
@@ -230,12 +295,59 @@ int attempt_take_seat(poste_stations *shared_stations, int valid_seats[MAX_WORKE
     return current_seat;
 }
 
-// Function that handles the service process
-void handle_service(int service_id, mq_id qid, poste_stats *stats, poste_stations *stations) {
+// Function that frees the user side of a seat and hands it to the next user waiting for it
+void release_user_seat(poste_stations *shared_stations, int seat_index) {
+    seat_queue_lock(shared_stations);
+    shared_stations->NOF_WORKER_SEATS[seat_index].user_status  = FREE;
+    shared_stations->NOF_WORKER_SEATS[seat_index].user_process = 0;
+    seat_queue_offer(shared_stations, seat_index);
+    shm_mutex_unlock(&shared_stations->stations_lock);
+}
+
+// Function that waits for a staffed seat of the service until the shift closes
+// Returns the index of the seat taken, or -1 if the shift closed first
+int wait_for_seat(poste_stats *shared_stats, poste_stations *shared_stations, int service_id) {
+    int current_seat = -1;
+
+    seat_queue_lock(shared_stations);
+    while (current_seat == -1) {
+        // Any seat staffed since the ticket counts, not only the ones seen then
+        for (int i = 0; i < g_config.num_worker_seats; i++) {
+            worker_seat *seat = &shared_stations->NOF_WORKER_SEATS[i];
+            if (seat->service_id == service_id && seat->operator_status == OCCUPIED && seat->user_status == FREE) {
+                seat->user_status  = OCCUPIED;
+                seat->user_process = getpid();
+                current_seat = i;
+                break;
+            }
+        }
+        if (current_seat != -1) break;
+
+        int minutes_left = g_config.worker_shift_close * 60 - shared_stats->current_minute;
+        if (minutes_left <= 0) break;
+        current_seat = seat_queue_wait(shared_stations, &shared_stations->user_queue[service_id], minutes_left);
+    }
+    shm_mutex_unlock(&shared_stations->stations_lock);
+
+    if (current_seat != -1) {
+        printf(PREFIX " Took seat %d after waiting\n", getpid(), current_seat);
+        fflush(stdout);
+    }
+    return current_seat;
+}
+
+// Function that handles the service process, returns how the request ended
+service_outcome handle_service(int service_id, mq_id qid, poste_stats *stats, poste_stations *stations) {
     // send ticket, await response
-    if (!send_ticket_request(qid, service_id)) return;
+    if (!send_ticket_request(qid, service_id)) return SERVICE_FAILED;
     ticket_response tres = await_ticket_response(qid);
-    if (tres.ticket_number < 0) return;
+    if (tres.ticket_number < 0) return SERVICE_FAILED;
+    return serve_ticket(service_id, tres.ticket_number, qid, stats, stations);
+}
+
+// Seat and service for a ticket already taken, the seat wait counts from now
+service_outcome serve_ticket(int service_id, int ticket_number, mq_id qid, poste_stats *stats, poste_stations *stations) {
+    int ticket_minute = stats->current_minute;
 
     // find an operator for the service
     int valid_seats[MAX_WORKER_SEATS];
@@ -244,84 +356,125 @@ void handle_service(int service_id, mq_id qid, poste_stats *stats, poste_station
         printf(PREFIX " No operators available for service %s, failed...\n", getpid(), services[service_id]);
         fflush(stdout);
         update_fails_stats(stats, service_id);
-        return;
+        return SERVICE_FAILED;
     }
 
     // Attempt to take a seat
     int current_seat = attempt_take_seat(stations, valid_seats, n_valid_seats);
-    while (current_seat == -1) {
-        // Wait 5 minutes
-        struct timespec t1 = { .tv_sec = 0, .tv_nsec = g_config.minute_duration * 5 };
-        struct timespec t2;
-        if (nanosleep(&t1, &t2) != 0) {
-            printf(PREFIX " Sleep was interrupted.\n", getpid());
-            exit(EXIT_FAILURE);
-        }
+    if (current_seat == -1) {
+        // Queued until a seat is handed over, or the shift closes
+        update_waiting_stats(stats, service_id, 1);
+        current_seat = wait_for_seat(stats, stations, service_id);
+        update_waiting_stats(stats, service_id, -1);
 
-        // Check if shift finished while waiting
-        if (stats->current_minute >= g_config.worker_shift_close * 60) {
+        if (current_seat == -1) {
             printf(PREFIX " Shift ended while waiting for a seat, they made me late, add a explode counter\n", getpid());
             fflush(stdout);
 
+            update_seat_wait_stats(stats, stats->current_minute - ticket_minute);
             handle_late_users(stats, service_id);
             update_fails_stats(stats, service_id);
 
-            return;
+            return SERVICE_LATE;
         }
-
-        // Wait for a seat to become available
-        sem_trywait(&stations->stations_freed_event);
-        current_seat = attempt_take_seat(stations, valid_seats, n_valid_seats);
     }
 
     // Seat found, now we can send the service request
+    update_seat_wait_stats(stats, stats->current_minute - ticket_minute);
     pid_t op_pid = stations->NOF_WORKER_SEATS[current_seat].operator_process;
 
     int start_wait = stats->current_minute;
 
     // send to operator and await done
-    if (!send_service_request(qid, tres.ticket_number, op_pid)) {
+    if (!send_service_request(qid, ticket_number, op_pid)) {
         update_fails_stats(stats, service_id);
-        return;
+        return SERVICE_FAILED;
     }
     service_done dres = await_service_done(qid);
     if (dres.ticket_number < 0) {
         update_fails_stats(stats, service_id);
-        return;
+        return SERVICE_FAILED;
     }
 
     // update stats
     int wait_time = stats->current_minute - start_wait;
     update_success_stats(stats, dres.service_id, wait_time, dres.service_time);
 
+    // Release seat that was taken, late or not: its operator leaves it only
+    // once the user side is free
+    release_user_seat(stations, current_seat);
+
     if (stats->current_minute >= g_config.worker_shift_close * 60) {
         printf(PREFIX " Shift ended while waiting for a ticket to finish, they made me late, add a explode counter\n", getpid());
         fflush(stdout);
 
         handle_late_users(stats, service_id);
+    }
+    return SERVICE_SERVED;
+}
 
-        return;
+// Waits for an event posted by the director, idle for the time warp.
+// Returns false once the director retired the user: it is retired at the
+// start of a day, no longer counted in the tokens posted, so a token taken
+// after that belongs to the users still there and is handed back.
+static bool wait_event(sem_t *event) {
+    if (retire_requested) return false;
+    bool taken;
+    sim_block();
+    while (!(taken = sem_wait(event) == 0) && errno == EINTR && !retire_requested);
+    sim_unblock(taken);
+    if (taken && retire_requested) {
+        sim_expect_wakeups(1);
+        sem_post(event);
+        return false;
     }
+    return taken;
+}
+
+// Function that picks the branch to visit, as the user walks in
+static int choose_branch(void) {
+    if (g_config.num_branches <= 1) return 0;
 
-    // Release seat that was taken
-    sem_wait(&stations->stations_lock);
-    stations->NOF_WORKER_SEATS[current_seat].user_status = FREE;
-    sem_post(&stations->stations_lock);
-    sem_post(&stations->stations_freed_event);
+    double load[MAX_BRANCHES];
+    for (int b = 0; b < g_config.num_branches; b++) {
+        load[b] = g_config.branch_routing == BRANCH_ROUTING_LOAD ?
+                  branch_load(branches[b].stats, branches[b].stations) : 0.0;
+    }
+    return branch_route(g_config.branch_routing, home, g_config.num_branches, load);
 }
 
-void day_loop(poste_stats *shared_stats, poste_stations *shared_stations, mq_id qid) {
+// A user that joined the open poste was not counted in its open event, it
+// walks in after the minute it joined
+void day_loop(bool joined_open) {
     int service_list[MAX_N_REQUESTS_COMPILE];
     int n_services = generate_service_list(service_list);
-    int walk_in_time = generate_walk_in_time(n_services);
+    int walk_in_time = generate_walk_in_time(n_services, joined_open ? branches[home_branch].stats->current_minute : 0);
+    if (walk_in_time < 0) {
+        printf(PREFIX " Joined too late to go to the poste today\n", getpid());
+        fflush(stdout);
+        return;
+    }
 
     printf(PREFIX " Generated service list with %d services, walk-in time at %02d:%02d\n", getpid(), n_services, walk_in_time / 60, walk_in_time % 60);
     fflush(stdout);
 
     // Wait for the poste to open
-    sem_wait(&shared_stats->open_poste_event);
+    if (!joined_open) wait_event(&branches[home_branch].stats->open_poste_event);
     // Then wait for the walk in time
-    busy_wait_until_walk_in(walk_in_time, shared_stats);
+    busy_wait_until_walk_in(walk_in_time, branches[home_branch].stats);
+
+    int visited = choose_branch();
+    if (visited != home_branch) {
+        printf(PREFIX " Going to branch %d instead of branch %d\n", getpid(), visited, home_branch);
+        fflush(stdout);
+    }
+    poste_stats *shared_stats = branches[visited].stats;
+    poste_stations *shared_stations = branches[visited].stations;
+
+    // Every ticket of the day at once, one ticket per service if that fails
+    int tickets[MAX_N_REQUESTS_COMPILE];
+    bool bundled = g_config.ticket_bundle &&
+                   request_ticket_bundle(branches[visited].qid, service_list, n_services, tickets);
 
     for (int i = 0; i < n_services; i++) {
         // Check if shift finished while waiting
@@ -334,64 +487,174 @@ void day_loop(poste_stats *shared_stats, poste_stations *shared_stations, mq_id
 
             return;
         }
-        handle_service(service_list[i], qid, shared_stats, shared_stations);
+        if (bundled) {
+            serve_ticket(service_list[i], tickets[i], branches[visited].qid, shared_stats, shared_stations);
+        } else {
+            handle_service(service_list[i], branches[visited].qid, shared_stats, shared_stations);
+        }
     }
 }
 
-#ifndef UNIT_TEST
-int main() {
-    int open_shm[2] = {};
-    int open_shm_index = 0;
+// Sleeps until minute of the day, to the minute
+static void wait_until_minute(int minute, poste_stats *shared_stats) {
+    while (shared_stats->current_minute < minute) {
+        sim_sleep_minutes(minute - shared_stats->current_minute);
+    }
+}
 
-    key_t key = ftok(KEY_TICKET_MSG, PROJ_ID);
-    if (key == -1) {
-        fprintf(stderr, PREFIX " ERROR ftok: %s\n", getpid(), strerror(errno));
-        fflush(stderr);
-        return 1;
+// Replays the arrivals of the trace dealt to this user today, each one a
+// customer walking in for one service. A user that joined the open poste
+// skips the arrivals before it joined.
+void trace_day(int index, bool joined_open) {
+    poste_stats *home_stats = branches[home_branch].stats;
+    struct S_trace_cursor cursor;
+    trace_deal(&trace, home_stats->current_day, index, g_config.trace_users, &cursor);
+    int joined = joined_open ? home_stats->current_minute : 0;
+
+    // The director posts an open token for every user, taken even on a day
+    // without arrivals
+    if (!joined_open) wait_event(&home_stats->open_poste_event);
+
+    int open  = g_config.worker_shift_open * 60;
+    int close = g_config.worker_shift_close * 60;
+    const struct S_trace_record *arrival;
+    while ((arrival = trace_next(&cursor)) != NULL && arrival->minute < close) {
+        if (arrival->minute < joined) continue;
+        // Still busy with the previous customer past this one's arrival
+        int due = arrival->minute > open ? arrival->minute : open;
+        int late = home_stats->current_minute - due;
+        if (late > 0) {
+            stats_update(home_stats, (struct S_stats_update){ .kind = STATS_TRACE_DELAYED, .delta = late });
+        }
+        wait_until_minute(arrival->minute, home_stats);
+
+        int visited = choose_branch();
+        poste_stats *shared_stats = branches[visited].stats;
+        printf(PREFIX " Replaying arrival at %02d:%02d for %s at branch %d\n", getpid(),
+               arrival->minute / 60, arrival->minute % 60, services[arrival->service], visited);
+        fflush(stdout);
+
+        been_late_today = false; // Every arrival is a customer of its own
+        if (shared_stats->current_minute >= close) {
+            handle_late_users(shared_stats, arrival->service);
+            update_fails_stats(shared_stats, arrival->service);
+            continue;
+        }
+        handle_service(arrival->service, branches[visited].qid, shared_stats, branches[visited].stations);
     }
-    mq_id qid = mq_open(key, 0, 0666);
-    if (qid < 0) {
-        fprintf(stderr, PREFIX " ERROR mq_open: %s\n", getpid(), strerror(errno));
-        fflush(stderr);
-        exit(EXIT_FAILURE);
+}
+
+#ifndef UNIT_TEST
+static void on_retire(int sig) {
+    (void)sig;
+    retire_requested = 1;
+}
+
+int main(int argc, char *argv[]) {
+    int open_shm[2 * MAX_BRANCHES] = {};
+    int open_shm_index = 0;
+    int index = -1; // Order the director started the user in, sets its home
+    bool join_day  = false; // Added during a day: its day_update event is posted already
+    bool join_open = false; // Added while the poste is open: its open event too
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--index") == 0 && i + 1 < argc) {
+            index = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--join-day") == 0) {
+            join_day = true;
+        } else if (strcmp(argv[i], "--join") == 0) {
+            join_day = join_open = true;
+        }
     }
 
     poste_stats *shared_stats = (poste_stats*) init_shared_memory(
         SHM_STATS_NAME, SHM_STATS_SIZE, open_shm, &open_shm_index);
+    mq_count_sends(&shared_stats->messages_sent);
 
-    poste_stations *shared_stations = (poste_stations*) init_shared_memory(
-        SHM_STATIONS_NAME, SHM_STATIONS_SIZE, open_shm, &open_shm_index);
-    
-    load_config(shared_stats->configuration_file);
+    if (!config_shm_attach()) load_config(shared_stats->configuration_file);
 
     srand((unsigned)getpid());
+    home = index >= 0 ? branch_user_home(index) : (double)rand() / ((double)RAND_MAX + 1.0);
+    home_branch = branch_nearest(home, g_config.num_branches);
+
+    // Every branch, the user may walk to any of them
+    for (int b = 0; b < g_config.num_branches; b++) {
+        char stats_name[64], stations_name[64];
+        branch_shm_name(SHM_STATS_NAME, b, stats_name, sizeof(stats_name));
+        branch_shm_name(SHM_STATIONS_NAME, b, stations_name, sizeof(stations_name));
+        branches[b].stats = b == 0 ? shared_stats : (poste_stats*) init_shared_memory(
+            stats_name, SHM_STATS_SIZE, open_shm, &open_shm_index);
+        branches[b].stations = (poste_stations*) init_shared_memory(
+            stations_name, SHM_STATIONS_SIZE, open_shm, &open_shm_index);
+
+        key_t key = poste_key(KEY_TICKET_MSG, branch_ticket_proj_id(b));
+        if (key == -1) {
+            fprintf(stderr, PREFIX " ERROR poste_key: %s\n", getpid(), strerror(errno));
+            fflush(stderr);
+            return 1;
+        }
+        branches[b].qid = mq_open(key, 0, 0666);
+        if (branches[b].qid < 0) {
+            fprintf(stderr, PREFIX " ERROR mq_open: %s\n", getpid(), strerror(errno));
+            fflush(stderr);
+            exit(EXIT_FAILURE);
+        }
+    }
+    shared_stats = branches[home_branch].stats;
 
-    sem_wait(&shared_stats->day_update_event);
+    if (g_config.trace_file[0] != '\0' && !trace_open(g_config.trace_file, &trace)) {
+        fprintf(stderr, PREFIX " ERROR cannot map the trace %s\n", getpid(), g_config.trace_file);
+        fflush(stderr);
+        exit(EXIT_FAILURE);
+    }
 
-    while (true) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_retire;
+    sigaction(SIGUSR1, &sa, NULL);
+
+    sim_clock_attach();
+    sim_actor_join(ACTOR_USER);
+
+    bool staying = join_day || wait_event(&shared_stats->day_update_event);
+
+    while (staying) {
         printf(PREFIX " Starting the day\n", getpid());
         fflush(stdout);
-        sleep(1);
+        config_shm_refresh(); // Reloaded by the director since yesterday
+        if (!sim_time_warp()) sleep(1);
 
         been_late_today = false;
 
-        if (will_go_to_poste()) {
+        if (trace.map != NULL) {
+            trace_day(index, join_open);
+        } else if (will_go_to_poste()) {
             printf(PREFIX " Going to the poste today.\n", getpid());
             fflush(stdout);
-            day_loop(shared_stats, shared_stations, qid);
+            day_loop(join_open);
         } else {
             printf(PREFIX " Decided not to go to the poste today.\n", getpid());
             fflush(stdout);
+
+            // The director posts an open token for every user, take it anyway
+            // so unused tokens do not pile up day after day
+            if (!join_open) wait_event(&shared_stats->open_poste_event);
         }
+        join_open = false;
 
         printf(PREFIX " Waiting for next day signal\n", getpid());
         fflush(stdout);
-        sem_wait(&shared_stats->day_update_event);
+        staying = wait_event(&shared_stats->day_update_event);
+        if (!staying) break;
         printf(PREFIX " Next day signal received\n", getpid());
         fflush(stdout);
-        sleep(1);
+        if (!sim_time_warp()) sleep(1);
     }
 
+    printf(PREFIX " Retired by the director, going home\n", getpid());
+    fflush(stdout);
+
+    sim_actor_leave();
     return EXIT_SUCCESS;
 }
 #endif // UNIT_TEST
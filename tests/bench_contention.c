@@ -0,0 +1,427 @@
+#define _GNU_SOURCE
+
+// Contention benchmark for the shared stats and stations segments.
+// Forks N synthetic workers that hammer the real hot paths of utente.c and
+// operatore.c (compiled with -DUNIT_TEST) against the real /poste_stats and
+// /poste_stations segments, sweeping N from 1 to the number of cores.
+//
+// The user, operator and stats objects are compiled with shm_mutex_lock and
+// shm_mutex_unlock redirected to bench_mutex_lock/bench_mutex_unlock, so wait
+// and hold times of stats_lock and stations_lock are measured inside the
+// unmodified functions. The share of contended acquisitions comes from the
+// counters of the locks themselves.
+//
+// With --clock-readers R, R more processes spin on current_minute like users
+// waiting for their walk-in time, and the benchmark reports how many reads
+// per second each one gets: every counter update that shares a cache line
+// with the clock turns those reads into cross-core misses. Build with
+// BENCH_LAYOUT=-DPOSTE_PACKED_LAYOUT to compare against the packed layout.
+//
+// Do not run while a simulation is active: the segments are shared by name.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include <poste.h>
+#include <shared_mem.h>
+#include <utente.h>
+#include <operatore.h>
+
+#define PREFIX "[BENCH]"
+
+#define DEFAULT_OPS 20000
+#define MAX_BENCH_WORKERS 256
+
+typedef struct S_poste_stats      poste_stats;
+typedef struct S_poste_stations   poste_stations;
+
+enum BENCH_LOCKS {
+    LOCK_STATS,
+    LOCK_STATIONS,
+    NUM_BENCH_LOCKS
+};
+
+static const char *LOCK_NAMES[NUM_BENCH_LOCKS] = {
+    "stats_lock",
+    "stations_lock"
+};
+
+// Per worker results, written by the child and summed by the parent
+struct S_worker_result {
+    long long acquisitions[NUM_BENCH_LOCKS];
+    long long wait_ns[NUM_BENCH_LOCKS];
+    long long hold_ns[NUM_BENCH_LOCKS];
+    int served[NUM_SERVICE_TYPES];
+    int failed[NUM_SERVICE_TYPES];
+    int requests[NUM_SERVICE_TYPES];
+};
+
+struct S_bench_shared {
+    sem_t ready;  // Posted by every worker once attached
+    sem_t start;  // Posted by the parent to release all workers at once
+    int stop;     // Set by the parent when the workers are done, stops the clock readers
+    struct S_worker_result results[MAX_BENCH_WORKERS];
+    long long clock_reads[MAX_BENCH_WORKERS];
+};
+
+typedef struct S_worker_result worker_result;
+typedef struct S_bench_shared  bench_shared;
+
+// Process local instrumentation state
+static struct S_shm_mutex *tracked_locks[NUM_BENCH_LOCKS];
+static long long hold_start[NUM_BENCH_LOCKS];
+static worker_result *current_result = NULL;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int tracked_index(struct S_shm_mutex *m) {
+    for (int i = 0; i < NUM_BENCH_LOCKS; i++) {
+        if (tracked_locks[i] == m) return i;
+    }
+    return -1;
+}
+
+// Replacement for shm_mutex_lock inside the benchmarked objects
+bool bench_mutex_lock(struct S_shm_mutex *m) {
+    long long t0 = now_ns();
+    bool recovered = shm_mutex_lock(m);
+    long long t1 = now_ns();
+
+    int k = tracked_index(m);
+    if (k != -1 && current_result != NULL) {
+        current_result->acquisitions[k]++;
+        current_result->wait_ns[k] += t1 - t0;
+        hold_start[k] = t1;
+    }
+    return recovered;
+}
+
+// Replacement for shm_mutex_unlock inside the benchmarked objects
+void bench_mutex_unlock(struct S_shm_mutex *m) {
+    int k = tracked_index(m);
+    if (k != -1 && current_result != NULL) {
+        current_result->hold_ns[k] += now_ns() - hold_start[k];
+    }
+    shm_mutex_unlock(m);
+}
+
+// Resets both segments to a known state before each run
+static void reset_segments(poste_stats *stats, poste_stations *stations) {
+    memset(stats, 0, SHM_STATS_SIZE);
+    memset(stations, 0, SHM_STATIONS_SIZE);
+
+    shm_mutex_init(&stats->stats_lock);
+    shm_mutex_init(&stations->stations_lock);
+
+    // First half of the seats is staffed for the whole run (used by users),
+    // the second half is taken and released by the operator workers
+    for (int i = 0; i < g_config.num_worker_seats; i++) {
+        stations->NOF_WORKER_SEATS[i].service_id = i % NUM_SERVICE_TYPES;
+        if (i < g_config.num_worker_seats / 2) {
+            stations->NOF_WORKER_SEATS[i].operator_status  = OCCUPIED;
+            stations->NOF_WORKER_SEATS[i].operator_process = 1;
+        }
+    }
+}
+
+// One user cycle: find a staffed seat, take it, update the stats and release it
+static void user_cycle(poste_stats *stats, poste_stations *stations, worker_result *res) {
+    int service_id = rand() % NUM_SERVICE_TYPES;
+    int valid_seats[MAX_WORKER_SEATS];
+
+    int n_valid_seats = find_valid_seats(stations, service_id, valid_seats);
+    int seat = n_valid_seats > 0 ? attempt_take_seat(stations, valid_seats, n_valid_seats) : -1;
+    if (seat == -1) {
+        update_fails_stats(stats, service_id);
+        res->failed[service_id]++;
+        return;
+    }
+
+    update_success_stats(stats, service_id, 1.0, 2.0);
+    res->served[service_id]++;
+    release_user_seat(stations, seat);
+}
+
+// One operator cycle: take a free seat of its service, count a request and release it
+static void operator_cycle(poste_stats *stats, poste_stations *stations, int service_id, worker_result *res) {
+    shm_mutex_lock(&stations->stations_lock);
+    int seat = find_seat(stations, service_id);
+    if (seat != -1) {
+        take_seat(stations, seat);
+    }
+    shm_mutex_unlock(&stations->stations_lock);
+
+    update_requests_stats(stats, service_id);
+    res->requests[service_id]++;
+
+    if (seat != -1) {
+        release_seat(stations, seat);
+    }
+}
+
+static void worker(int id, int ops, bench_shared *shared, poste_stats *stats, poste_stations *stations) {
+    // The hot paths print on every call, keep the report readable
+    if (freopen("/dev/null", "w", stdout) == NULL) {
+        _exit(EXIT_FAILURE);
+    }
+
+    srand((unsigned)(id + 1));
+    current_result = &shared->results[id];
+    memset(current_result, 0, sizeof(*current_result));
+
+    sem_post(&shared->ready);
+    sem_wait(&shared->start);
+
+    int is_operator = id % 2 == 1;
+    int service_id = (id / 2) % NUM_SERVICE_TYPES;
+    for (int i = 0; i < ops; i++) {
+        if (is_operator) {
+            operator_cycle(stats, stations, service_id, current_result);
+        } else {
+            user_cycle(stats, stations, current_result);
+        }
+    }
+
+    fflush(stdout);
+    _exit(EXIT_SUCCESS);
+}
+
+// Spins on the simulated clock until the workers are done, like busy_wait_until_walk_in without the sleep
+static void clock_reader(int id, bench_shared *shared, poste_stats *stats) {
+    long long reads = 0;
+
+    sem_post(&shared->ready);
+    sem_wait(&shared->start);
+
+    while (!__atomic_load_n(&shared->stop, __ATOMIC_RELAXED)) {
+        for (int i = 0; i < 1024; i++) {
+            (void)__atomic_load_n(&stats->current_minute, __ATOMIC_RELAXED); // Atomic loads are never elided
+        }
+        reads += 1024;
+    }
+
+    shared->clock_reads[id] = reads;
+    _exit(EXIT_SUCCESS);
+}
+
+// Checks that the counters in shared memory add up to what the workers did
+static int check_counters(poste_stats *stats, poste_stations *stations, worker_result *total) {
+    int ok = 1;
+    int served = 0, failed = 0, requests = 0;
+
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        served   += total->served[s];
+        failed   += total->failed[s];
+        requests += total->requests[s];
+
+        if (stats->simulation_services[s].served_users    != total->served[s] ||
+            stats->simulation_services[s].failed_services != total->failed[s] ||
+            stats->simulation_services[s].total_requests  != total->requests[s] ||
+            stats->today.services[s].served_users         != total->served[s] ||
+            stats->today.services[s].failed_services      != total->failed[s] ||
+            stats->today.services[s].total_requests       != total->requests[s] ||
+            stats->simulation_services[s].total_wait_time    != (double)total->served[s] ||
+            stats->simulation_services[s].total_service_time != 2.0 * total->served[s]) {
+            fprintf(stderr, PREFIX " counter mismatch on service %s\n", services[s]);
+            ok = 0;
+        }
+    }
+
+    if (stats->simulation_global.served_users    != served ||
+        stats->simulation_global.failed_services != failed ||
+        stats->simulation_global.total_requests  != requests ||
+        stats->today.global.served_users         != served ||
+        stats->today.global.failed_services      != failed ||
+        stats->today.global.total_requests       != requests) {
+        fprintf(stderr, PREFIX " global counter mismatch\n");
+        ok = 0;
+    }
+
+    // Every cycle releases what it took
+    for (int i = 0; i < g_config.num_worker_seats; i++) {
+        SEAT_STATUS expected = i < g_config.num_worker_seats / 2 ? OCCUPIED : FREE;
+        if (stations->NOF_WORKER_SEATS[i].user_status != FREE ||
+            stations->NOF_WORKER_SEATS[i].operator_status != expected) {
+            fprintf(stderr, PREFIX " seat %d left in an inconsistent state\n", i);
+            ok = 0;
+        }
+    }
+
+    return ok;
+}
+
+static int run(int n_workers, int n_readers, int ops, bench_shared *shared, poste_stats *stats, poste_stations *stations) {
+    reset_segments(stats, stations);
+    sem_init(&shared->ready, 1, 0);
+    sem_init(&shared->start, 1, 0);
+    shared->stop = 0;
+
+    // Children must not inherit buffered output
+    fflush(stdout);
+
+    pid_t children[MAX_BENCH_WORKERS];
+    for (int i = 0; i < n_workers; i++) {
+        children[i] = fork();
+        if (children[i] < 0) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (children[i] == 0) {
+            worker(i, ops, shared, stats, stations);
+        }
+    }
+
+    pid_t readers[MAX_BENCH_WORKERS];
+    for (int i = 0; i < n_readers; i++) {
+        readers[i] = fork();
+        if (readers[i] < 0) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (readers[i] == 0) {
+            clock_reader(i, shared, stats);
+        }
+    }
+
+    for (int i = 0; i < n_workers + n_readers; i++) sem_wait(&shared->ready);
+
+    long long t0 = now_ns();
+    for (int i = 0; i < n_workers + n_readers; i++) sem_post(&shared->start);
+
+    int all_exited = 1;
+    for (int i = 0; i < n_workers; i++) {
+        int status;
+        waitpid(children[i], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) all_exited = 0;
+    }
+    long long elapsed = now_ns() - t0;
+
+    __atomic_store_n(&shared->stop, 1, __ATOMIC_RELAXED);
+    long long clock_reads = 0;
+    for (int i = 0; i < n_readers; i++) {
+        int status;
+        waitpid(readers[i], &status, 0);
+        clock_reads += shared->clock_reads[i];
+    }
+
+    worker_result total;
+    memset(&total, 0, sizeof(total));
+    for (int i = 0; i < n_workers; i++) {
+        for (int k = 0; k < NUM_BENCH_LOCKS; k++) {
+            total.acquisitions[k] += shared->results[i].acquisitions[k];
+            total.wait_ns[k]      += shared->results[i].wait_ns[k];
+            total.hold_ns[k]      += shared->results[i].hold_ns[k];
+        }
+        for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+            total.served[s]   += shared->results[i].served[s];
+            total.failed[s]   += shared->results[i].failed[s];
+            total.requests[s] += shared->results[i].requests[s];
+        }
+    }
+
+    int ok = all_exited && check_counters(stats, stations, &total);
+    long long total_ops = (long long)n_workers * ops;
+
+    printf("%7d %10lld %9.3f %12.0f", n_workers, total_ops, elapsed / 1e9, total_ops / (elapsed / 1e9));
+    for (int k = 0; k < NUM_BENCH_LOCKS; k++) {
+        long long acq = total.acquisitions[k] > 0 ? total.acquisitions[k] : 1;
+        const struct S_lock_counters *c = &tracked_locks[k]->counters;
+        printf(" %10.0f %10.0f %6.1f", (double)total.wait_ns[k] / acq, (double)total.hold_ns[k] / acq,
+               c->acquisitions > 0 ? 100.0 * c->contended / c->acquisitions : 0.0);
+    }
+    if (n_readers > 0) {
+        printf(" %12.1f", clock_reads / (elapsed / 1e9) / n_readers / 1e6);
+    }
+    printf(" %6s\n", ok ? "OK" : "FAIL");
+    fflush(stdout);
+
+    sem_destroy(&shared->ready);
+    sem_destroy(&shared->start);
+    return ok;
+}
+
+int main(const int argc, const char *argv[]) {
+    int ops = DEFAULT_OPS;
+    int max_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int n_readers = 0;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--ops") == 0) {
+            ops = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--max-workers") == 0) {
+            max_workers = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--seats") == 0) {
+            g_config.num_worker_seats = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--clock-readers") == 0) {
+            n_readers = atoi(argv[i + 1]);
+        }
+    }
+
+    if (ops < 1) ops = DEFAULT_OPS;
+    if (max_workers < 1) max_workers = 1;
+    if (max_workers > MAX_BENCH_WORKERS) max_workers = MAX_BENCH_WORKERS;
+    if (n_readers < 0) n_readers = 0;
+    if (n_readers > MAX_BENCH_WORKERS) n_readers = MAX_BENCH_WORKERS;
+    if (g_config.num_worker_seats < 2 || g_config.num_worker_seats > MAX_WORKER_SEATS) {
+        g_config.num_worker_seats = NUM_WORKER_SEATS;
+    }
+
+    int open_shm[2];
+    int open_shm_index = 0;
+    poste_stats *stats = init_shared_memory(SHM_STATS_NAME, SHM_STATS_SIZE, open_shm, &open_shm_index);
+    poste_stations *stations = init_shared_memory(SHM_STATIONS_NAME, SHM_STATIONS_SIZE, open_shm, &open_shm_index);
+
+    bench_shared *shared = mmap(NULL, sizeof(bench_shared), PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+
+    tracked_locks[LOCK_STATS]    = &stats->stats_lock;
+    tracked_locks[LOCK_STATIONS] = &stations->stations_lock;
+
+#ifdef POSTE_PACKED_LAYOUT
+    const char *layout = "packed";
+#else
+    const char *layout = "cache-line aligned";
+#endif
+    printf(PREFIX " %d ops per worker, %d seats, sweeping 1..%d workers (odd workers act as operators)\n",
+           ops, g_config.num_worker_seats, max_workers);
+    printf(PREFIX " %s layout: stats segment %zu bytes, stations segment %zu bytes, %d clock readers\n",
+           layout, SHM_STATS_SIZE, SHM_STATIONS_SIZE, n_readers);
+    printf("%7s %10s %9s %12s", "workers", "ops", "secs", "ops/s");
+    for (int k = 0; k < NUM_BENCH_LOCKS; k++) {
+        printf(" %28s", LOCK_NAMES[k]);
+    }
+    if (n_readers > 0) printf(" %12s", "clock reads");
+    printf(" %6s\n", "check");
+    printf("%7s %10s %9s %12s", "", "", "", "");
+    for (int k = 0; k < NUM_BENCH_LOCKS; k++) {
+        printf(" %10s %10s %6s", "wait(ns)", "hold(ns)", "cont%");
+    }
+    if (n_readers > 0) printf(" %12s", "(M/s/reader)");
+    printf("\n");
+
+    int ok = 1;
+    for (int n = 1; n <= max_workers; n++) {
+        ok &= run(n, n_readers, ops, shared, stats, stations);
+    }
+
+    munmap(shared, sizeof(bench_shared));
+    cleanup_shared_memory(SHM_STATS_NAME, SHM_STATS_SIZE, open_shm[0], stats);
+    cleanup_shared_memory(SHM_STATIONS_NAME, SHM_STATIONS_SIZE, open_shm[1], stations);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,196 @@
+#define _POSIX_C_SOURCE 200809L
+
+// Transport benchmark: the msg_queue.h API on System V queues against the
+// socket transport through a poste_broker (see mq_broker.h), on the message
+// patterns of the simulation.
+//
+//  - round trip: a user sending a request and waiting for the answer, one
+//    message each way, as ticket and service requests go
+//  - one way: a burst of messages drained by another process, as the
+//    director's queue or a busy ticket generator see them
+//  - stats: counter updates from a user or operator until they show in the
+//    segment, applied in place on the native path and sent in frames to the
+//    broker on the socket path
+//
+// The broker is forked by the benchmark on a socket in the output directory
+// of the instance (POSTE_INSTANCE, "bench_transport" if unset).
+
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <poste.h>
+#include <msg_queue.h>
+#include <mq_broker.h>
+#include <shared_mem.h>
+#include <instance.h>
+#include <stats.h>
+
+#define PREFIX "[BENCH]"
+
+#define DEFAULT_OPS 20000
+#define MSG_PING 1
+#define MSG_STOP 2 // After every ping, the echo takes the lowest type first
+#define MSG_PONG 3
+
+struct S_transport_result {
+    double round_trip_us;
+    double one_way_rate;
+    double stats_rate;
+};
+
+typedef struct S_transport_result transport_result;
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_term(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Child answering every ping with a pong until told to stop. With reply
+// false it only counts, and answers once at the stop.
+static pid_t start_echo(mq_id qid, bool reply) {
+    pid_t pid = fork();
+    if (pid != 0) return pid;
+
+    int value;
+    for (;;) {
+        ssize_t n = mq_receive(qid, -MSG_STOP, &value, sizeof(value), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            _exit(1);
+        }
+        if (value < 0) break; // Stop
+        if (reply && mq_send(qid, MSG_PONG, &value, sizeof(value)) < 0) _exit(1);
+    }
+    mq_send(qid, MSG_PONG, &value, sizeof(value));
+    mq_flush();
+    _exit(0);
+}
+
+static bool stop_echo(mq_id qid, pid_t echo) {
+    int value = -1;
+    mq_send(qid, MSG_STOP, &value, sizeof(value));
+    bool ok = mq_receive(qid, MSG_PONG, &value, sizeof(value), 0) == sizeof(value);
+    int status;
+    waitpid(echo, &status, 0);
+    return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static bool run(int ops, struct S_poste_stats *stats, transport_result *result) {
+    mq_id qid = mq_open(IPC_PRIVATE, IPC_CREAT, 0600);
+    if (qid < 0) {
+        perror("mq_open");
+        return false;
+    }
+    bool ok = true;
+
+    // Round trips
+    pid_t echo = start_echo(qid, true);
+    long long t0 = now_ns();
+    for (int i = 0; i < ops; i++) {
+        int value = i;
+        mq_send(qid, MSG_PING, &value, sizeof(value));
+        ok &= mq_receive(qid, MSG_PONG, &value, sizeof(value), 0) == sizeof(value) && value == i;
+    }
+    result->round_trip_us = (now_ns() - t0) / 1e3 / ops;
+    ok &= stop_echo(qid, echo);
+
+    // One way, timed until the receiver has drained them all
+    echo = start_echo(qid, false);
+    t0 = now_ns();
+    for (int i = 0; i < ops; i++) {
+        mq_send(qid, MSG_PING, &i, sizeof(i));
+    }
+    ok &= stop_echo(qid, echo);
+    result->one_way_rate = ops / ((now_ns() - t0) / 1e9);
+    mq_close(qid);
+
+    // Stats updates, timed until the last one shows in the segment
+    memset(stats, 0, SHM_STATS_SIZE);
+    shm_mutex_init(&stats->stats_lock);
+    t0 = now_ns();
+    for (int i = 0; i < ops; i++) {
+        stats_update(stats, (struct S_stats_update){ .kind = STATS_REQUEST, .service = i % NUM_SERVICE_TYPES });
+    }
+    mq_flush();
+    while (__atomic_load_n(&stats->simulation_global.total_requests, __ATOMIC_ACQUIRE) < ops) sched_yield();
+    result->stats_rate = ops / ((now_ns() - t0) / 1e9);
+    ok &= stats->simulation_global.total_requests == ops;
+    shm_mutex_destroy(&stats->stats_lock);
+
+    return ok;
+}
+
+static void print_result(const char *name, const transport_result *r, bool ok) {
+    printf("%9s %14.2f %14.0f %14.0f %6s\n", name, r->round_trip_us, r->one_way_rate, r->stats_rate, ok ? "OK" : "FAIL");
+}
+
+int main(const int argc, const char *argv[]) {
+    int ops = DEFAULT_OPS;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--ops") == 0) {
+            ops = atoi(argv[i + 1]);
+        }
+    }
+    if (ops < 1) ops = DEFAULT_OPS;
+
+    // Segments and socket of their own, away from a running simulation
+    setenv(POSTE_INSTANCE_ENV, "bench_transport", 0);
+    char path[MAX_PATH_LENGTH + 16];
+    instance_output_dir(poste_instance(), path, MAX_PATH_LENGTH);
+    strcat(path, "broker.sock");
+
+    int open_shm[1];
+    int open_shm_index = 0;
+    struct S_poste_stats *stats = init_shared_memory(SHM_STATS_NAME, SHM_STATS_SIZE, open_shm, &open_shm_index);
+
+    pid_t broker = fork();
+    if (broker == 0) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = on_term;
+        sigaction(SIGTERM, &sa, NULL);
+        _exit(mq_broker_run(path, &stop, NULL) == 0 ? 0 : 1);
+    }
+    struct timespec pause = { 0, 10000000L };
+    for (int i = 0; i < 200 && access(path, F_OK) != 0; i++) nanosleep(&pause, NULL);
+
+    printf(PREFIX " %d ops per pattern, broker on %s\n", ops, path);
+    printf("%9s %14s %14s %14s %6s\n", "transport", "round trip", "one way", "stats", "check");
+    printf("%9s %14s %14s %14s %6s\n", "", "(us)", "(msgs/s)", "(updates/s)", "");
+
+    transport_result native, socket;
+    mq_transport(NULL);
+    bool ok = run(ops, stats, &native);
+    print_result("native", &native, ok);
+
+    mq_transport(path);
+    bool ok_socket = run(ops, stats, &socket);
+    print_result("socket", &socket, ok_socket);
+    mq_transport(NULL);
+
+    printf(PREFIX " socket/native: round trip x%.2f, one way x%.2f, stats x%.2f\n",
+           socket.round_trip_us / native.round_trip_us,
+           socket.one_way_rate / native.one_way_rate,
+           socket.stats_rate / native.stats_rate);
+
+    kill(broker, SIGTERM);
+    waitpid(broker, NULL, 0);
+    cleanup_shared_memory(SHM_STATS_NAME, SHM_STATS_SIZE, open_shm[0], stats);
+
+    return ok && ok_socket ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,125 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arrival.h>
+#include <erlang.h>
+#include <poste.h>
+
+#define DRAWS 60000
+#define TEST_CONFIG CSV_FILE_PATH "test_arrival.conf"
+
+static double fraction(int count, int total) {
+    return (double)count / total;
+}
+
+int main(void) {
+    printf("\n[TEST] Starting arrival profile tests...\n");
+
+    // ---- Alias tables ----
+    printf("[STEP] Building alias tables...\n");
+    struct S_alias_table table;
+    double weights[4] = { 1.0, 2.0, 3.0, 4.0 };
+    assert(alias_build(&table, weights, 4));
+    int counts[4] = {0};
+    for (int k = 0; k < 4000; k++) counts[alias_sample(&table, k / 4000.0)]++; // Evenly spread u
+    for (int i = 0; i < 4; i++) assert(abs(counts[i] - 400 * (i + 1)) <= 1);
+
+    double zeros[3] = { 0.0, 5.0, 0.0 };
+    assert(alias_build(&table, zeros, 3));
+    for (int k = 0; k < 300; k++) assert(alias_sample(&table, k / 300.0) == 1);
+    double none[2] = { 0.0, 0.0 };
+    assert(!alias_build(&table, none, 2));
+    assert(!alias_build(&table, weights, 0));
+    printf("[OK] Every index drawn exactly in proportion to its weight.\n");
+
+    // ---- Service mix ----
+    printf("[STEP] Drawing services...\n");
+    srand(42);
+    int services_drawn[NUM_SERVICE_TYPES] = {0};
+    for (int i = 0; i < DRAWS; i++) services_drawn[arrival_service()]++;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) assert(services_drawn[s] > 0); // Unset: uniform
+
+    int mix[NUM_SERVICE_TYPES] = { 6, 1, 1, 1, 1, 0 };
+    memcpy(g_config.service_mix, mix, sizeof(mix));
+    memset(services_drawn, 0, sizeof(services_drawn));
+    for (int i = 0; i < DRAWS; i++) services_drawn[arrival_service()]++;
+    assert(fabs(fraction(services_drawn[0], DRAWS) - 0.6) < 0.02);
+    assert(fabs(fraction(services_drawn[1], DRAWS) - 0.1) < 0.02);
+    assert(services_drawn[5] == 0);
+
+    double shares[MAX_PROFILE_HOURS];
+    arrival_service_shares(&g_config, shares);
+    assert(shares[0] == 0.6 && shares[5] == 0.0);
+    g_config.num_users = 100;
+    double requests[NUM_SERVICE_TYPES];
+    erlang_daily_requests(&g_config, requests);
+    assert(requests[0] == 6 * requests[1] && requests[5] == 0.0);
+    memset(g_config.service_mix, 0, sizeof(g_config.service_mix));
+    printf("[OK] Services follow the mix, the planner sees the same shares.\n");
+
+    // ---- Arrival profile ----
+    printf("[STEP] Drawing walk-in times with a lunch peak...\n");
+    g_config.worker_shift_open = 8;
+    g_config.worker_shift_close = 20;
+    int shift_start = 8 * 60;
+    int window = 12 * 60 - 50; // As generate_walk_in_time with 10 requests
+
+    int hours_drawn[12] = {0};
+    for (int i = 0; i < DRAWS; i++) {
+        int minute = arrival_walk_in(shift_start, window);
+        assert(minute > shift_start && minute <= shift_start + window);
+        hours_drawn[(minute - 1 - shift_start) / 60]++;
+    }
+    for (int h = 0; h < 12; h++) assert(hours_drawn[h] > 0); // Unset: flat
+
+    int profile[6] = { 1, 1, 1, 1, 8, 1 }; // 12:00 peak, then 1 until closing
+    memcpy(g_config.arrival_profile, profile, sizeof(profile));
+    g_config.num_profile_hours = 6;
+    memset(hours_drawn, 0, sizeof(hours_drawn));
+    for (int i = 0; i < DRAWS; i++) {
+        int minute = arrival_walk_in(shift_start, window);
+        assert(minute > shift_start && minute <= shift_start + window);
+        hours_drawn[(minute - 1 - shift_start) / 60]++;
+    }
+    // 8 x 60 minutes out of 4 x 60 + 480 + 6 x 60 + 10 before the margin
+    assert(fabs(fraction(hours_drawn[4], DRAWS) - 480.0 / 1090.0) < 0.02);
+    assert(fabs(fraction(hours_drawn[0], DRAWS) - 60.0 / 1090.0) < 0.01);
+    assert(hours_drawn[11] < hours_drawn[10]); // Only 10 minutes of it before the margin
+
+    int hours = arrival_hour_shares(&g_config, shares);
+    assert(hours == 12);
+    double total = 0.0;
+    for (int h = 0; h < hours; h++) total += shares[h];
+    assert(fabs(total - 1.0) < 1e-9);
+    assert(fabs(shares[4] - 8.0 / 19.0) < 1e-9);
+
+    memset(g_config.arrival_profile, 0, sizeof(g_config.arrival_profile)); // Every weight 0: flat again
+    for (int i = 0; i < 1000; i++) {
+        int minute = arrival_walk_in(shift_start, window);
+        assert(minute > shift_start && minute <= shift_start + window);
+    }
+    assert(arrival_walk_in(shift_start, 1) == shift_start + 1);
+    printf("[OK] The peak hour gets its share, the margin cuts the last hour.\n");
+
+    // ---- Configuration ----
+    printf("[STEP] Reading the profile and the mix from a config file...\n");
+    FILE *fp = fopen(TEST_CONFIG, "w");
+    assert(fp != NULL);
+    fprintf(fp, "arrival_profile = 2,3,5,9,12,6\n");
+    fprintf(fp, "service_mix = 1,2\n"); // Not one weight per service: ignored
+    fclose(fp);
+    g_config.num_profile_hours = 0;
+    load_config(TEST_CONFIG);
+    assert(g_config.num_profile_hours == 6 && g_config.arrival_profile[4] == 12);
+    assert(g_config.service_mix[0] == 0);
+    unlink(TEST_CONFIG);
+    printf("[OK] Comma separated weights parsed, malformed lists ignored.\n");
+
+    printf("[TEST] All arrival profile tests passed successfully!\n\n");
+    return 0;
+}
@@ -0,0 +1,125 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <branch.h>
+#include <poste.h>
+
+typedef struct S_poste_stats    poste_stats;
+typedef struct S_poste_stations poste_stations;
+
+int main(void) {
+    printf("\n[TEST] Starting branch tests...\n");
+
+    // ---- Names and layout ----
+    printf("[STEP] Naming and placing branches...\n");
+    char name[64];
+    branch_shm_name(SHM_STATS_NAME, 0, name, sizeof(name));
+    assert(strcmp(name, "/poste_stats") == 0);
+    branch_shm_name(SHM_STATS_NAME, 3, name, sizeof(name));
+    assert(strcmp(name, "/poste_stats_b3") == 0);
+    assert(branch_ticket_proj_id(0) != branch_ticket_proj_id(1));
+
+    for (int b = 0; b < 4; b++) {
+        assert(branch_nearest(branch_position(b, 4), 4) == b);
+    }
+    assert(branch_nearest(0.0, 4) == 0 && branch_nearest(0.999, 4) == 3);
+    assert(branch_region(0, 6, 2) == 0 && branch_region(2, 6, 2) == 0);
+    assert(branch_region(3, 6, 2) == 1 && branch_region(5, 6, 2) == 1);
+    assert(branch_region(2, 3, 10) == 2); // Never more regions than branches
+    printf("[OK] Segment names, positions and regions.\n");
+
+    // ---- Operators and users spread over the branches ----
+    printf("[STEP] Spreading 10 operators and 1000 users over 4 branches...\n");
+    int operators = 0, users = 0;
+    for (int b = 0; b < 4; b++) {
+        int o = branch_operators(b, 10, 4);
+        int u = branch_users(b, 1000, 4);
+        assert(o == 2 || o == 3);
+        assert(u > 230 && u < 270); // Homes cover the line evenly
+        operators += o;
+        users += u;
+    }
+    assert(operators == 10 && users == 1000);
+    for (int i = 0; i < 1000; i++) {
+        double home = branch_user_home(i);
+        assert(home >= 0.0 && home < 1.0);
+    }
+    assert(branch_users(0, 1000, 1) == 1000);
+    printf("[OK] Every operator and user has exactly one branch.\n");
+
+    // ---- Routing ----
+    printf("[STEP] Routing a user between 3 branches...\n");
+    double home = branch_position(0, 3);
+    double load[3] = { 4.0, 1.0, 0.5 };
+    assert(branch_route(BRANCH_ROUTING_DISTANCE, home, 3, load) == 0);
+    assert(branch_route(BRANCH_ROUTING_LOAD, home, 3, load) == 1); // 1 hop + 1.0 beats 0 hops + 4.0
+    load[0] = 1.5;
+    assert(branch_route(BRANCH_ROUTING_LOAD, home, 3, load) == 0); // Not worth a hop
+    load[0] = -1.0;
+    assert(branch_route(BRANCH_ROUTING_LOAD, home, 3, load) == 1); // Nobody seated at home
+    double closed[3] = { -1.0, -1.0, -1.0 };
+    assert(branch_route(BRANCH_ROUTING_LOAD, home, 3, closed) == 0);
+    printf("[OK] Nearest branch unless another one is a hop per waiting user better.\n");
+
+    // ---- Live load ----
+    printf("[STEP] Reading the load of a branch...\n");
+    poste_stats *stats = calloc(1, sizeof(poste_stats));
+    poste_stations *stations = calloc(1, sizeof(poste_stations));
+    assert(stats != NULL && stations != NULL);
+    assert(shm_mutex_init(&stations->stations_lock) == 0);
+    assert(branch_load(stats, stations) < 0);
+    stations->NOF_WORKER_SEATS[0].operator_status = OCCUPIED;
+    stations->NOF_WORKER_SEATS[1].operator_status = OCCUPIED;
+    stats->waiting_users[0] = 2;
+    stats->waiting_users[3] = 3;
+    assert(branch_load(stats, stations) == 3.0); // (5 waiting + 1) / 2 seats
+    shm_mutex_destroy(&stations->stations_lock);
+    printf("[OK] Users waiting per staffed seat.\n");
+
+    // ---- Totals over branches ----
+    printf("[STEP] Adding up two branches...\n");
+    poste_stats *other = calloc(1, sizeof(poste_stats));
+    poste_stats *total = calloc(1, sizeof(poste_stats));
+    assert(other != NULL && total != NULL);
+    strcpy(stats->configuration_file, "configs/a.conf");
+    stats->current_day = 3;
+    stats->messages_sent = 100;
+    stats->simulation_global.served_users = 7;
+    stats->simulation_services[2].total_wait_time = 12.5;
+    stats->today.late_users = 1;
+    stats->wait_histogram[4] = 2;
+    stats->simulation_usage.seats[0].busy_minutes = 30;
+    stats->simulation_usage.operators[0] = (struct S_operator_utilization){ .pid = 10, .service = 1, .busy_minutes = 30, .services = 3 };
+    other->current_day = 3;
+    other->messages_sent = 50;
+    other->simulation_global.served_users = 5;
+    other->simulation_services[2].total_wait_time = 7.5;
+    other->today.late_users = 2;
+    other->wait_histogram[4] = 1;
+    other->simulation_usage.seats[0].busy_minutes = 10;
+    other->simulation_usage.operators[0] = (struct S_operator_utilization){ .pid = 20, .service = 2, .busy_minutes = 10, .services = 1 };
+
+    branch_stats_add(total, stats);
+    branch_stats_add(total, other);
+    assert(strcmp(total->configuration_file, "configs/a.conf") == 0 && total->current_day == 3);
+    assert(total->messages_sent == 150);
+    assert(total->simulation_global.served_users == 12);
+    assert(total->simulation_services[2].total_wait_time == 20.0);
+    assert(total->today.late_users == 3);
+    assert(total->wait_histogram[4] == 3);
+    assert(total->simulation_usage.seats[0].busy_minutes == 40);
+    assert(total->simulation_usage.operators[0].pid == 10 && total->simulation_usage.operators[1].pid == 20);
+    assert(total->simulation_usage.operators[1].services == 1);
+    printf("[OK] Counters summed, operators of both branches listed.\n");
+
+    free(stats);
+    free(stations);
+    free(other);
+    free(total);
+
+    printf("[TEST] All branch tests passed successfully!\n\n");
+    return 0;
+}
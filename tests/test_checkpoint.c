@@ -0,0 +1,94 @@
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <poste.h>
+#include <checkpoint.h>
+
+typedef struct S_poste_stats    poste_stats;
+typedef struct S_poste_stations poste_stations;
+typedef struct S_checkpoint     checkpoint;
+
+// Stands for the director state written after the segments
+struct S_test_extra {
+    int spawned;
+    double expected;
+};
+
+int main(void) {
+    printf("\n[TEST] Starting checkpoint tests...\n");
+
+    static poste_stats stats;
+    static poste_stations stations;
+    shm_mutex_init(&stats.stats_lock);
+    shm_mutex_init(&stations.stations_lock);
+
+    // ---- Capture a day's end ----
+    printf("[STEP] Capturing the segments...\n");
+    stats.current_day = 4;
+    stats.simulation_global.served_users = 123;
+    stats.simulation_services[2].total_wait_time = 45.5;
+    stats.waiting_users[1] = 3;
+    stations.NOF_WORKER_SEATS[0].operator_process = 42;
+    stations.operator_skills[3] = 2;
+    stations.operator_states[0] = (struct S_operator_state){ .pid = 42, .service = 3, .pauses_done = 2 };
+    stations.operator_states[7] = (struct S_operator_state){ .pid = 43, .service = 3, .pauses_done = 0 };
+
+    static checkpoint ck;
+    ck.day  = 4;
+    ck.seed = 1234u;
+    ck.config = g_config;
+    ck.config.num_users = 77;
+    checkpoint_capture(&ck, &stats, &stations);
+    assert(ck.stats.simulation_global.served_users == 123);
+    assert(ck.stations.operator_states[7].pid == 43);
+    printf("[OK] Segments captured.\n");
+
+    // ---- Round trip through a file ----
+    printf("[STEP] Writing and reading the checkpoint...\n");
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/test_checkpoint_%d.bin", getpid());
+    struct S_test_extra extra = { .spawned = 5, .expected = 6.25 };
+    assert(checkpoint_write(path, &ck, &extra, sizeof(extra)));
+
+    static checkpoint loaded;
+    struct S_test_extra loaded_extra = {0};
+    assert(checkpoint_read(path, &loaded, &loaded_extra, sizeof(loaded_extra)));
+    assert(loaded.day == 4 && loaded.seed == 1234u);
+    assert(loaded.config.num_users == 77);
+    assert(loaded.stats.simulation_services[2].total_wait_time == 45.5);
+    assert(loaded.stations.operator_states[0].pauses_done == 2);
+    assert(loaded_extra.spawned == 5 && loaded_extra.expected == 6.25);
+    printf("[OK] Checkpoint read back unchanged.\n");
+
+    // ---- Incompatible files are refused ----
+    printf("[STEP] Testing rejected checkpoints...\n");
+    assert(!checkpoint_read(path, &loaded, &loaded_extra, sizeof(loaded_extra) + 1));
+    assert(!checkpoint_read("/tmp/does_not_exist.bin", &loaded, NULL, 0));
+
+    FILE *fp = fopen(path, "r+b");
+    assert(fp != NULL);
+    fputc('X', fp); // Corrupts the magic
+    fclose(fp);
+    assert(!checkpoint_read(path, &loaded, &loaded_extra, sizeof(loaded_extra)));
+    remove(path);
+    printf("[OK] Wrong size, missing file and bad magic are refused.\n");
+
+    // ---- Restore into fresh segments ----
+    printf("[STEP] Restoring into fresh segments...\n");
+    static poste_stats fresh_stats;
+    static poste_stations fresh_stations;
+    checkpoint_restore(&ck, &fresh_stats, &fresh_stations);
+    assert(fresh_stats.current_day == 4);
+    assert(fresh_stats.simulation_global.served_users == 123);
+    assert(fresh_stats.waiting_users[1] == 0);
+    assert(fresh_stats.stats_seq == 0);
+    assert(fresh_stations.NOF_WORKER_SEATS[0].operator_process == 0);
+    assert(fresh_stations.operator_skills[3] == 0);
+    assert(fresh_stations.operator_states[0].pid == 0);
+    printf("[OK] Counters restored, seats and operators left to the respawned actors.\n");
+
+    printf("[TEST] All checkpoint tests passed successfully!\n\n");
+    return 0;
+}
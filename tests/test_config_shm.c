@@ -0,0 +1,64 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <poste.h>
+#include <shared_mem.h>
+#include <config_shm.h>
+
+int main(void) {
+    printf("\n[TEST] Starting config segment tests...\n");
+
+    int open_shm[1];
+    int open_shm_index = 0;
+
+    // ---- Director publishes the config it loaded ----
+    printf("[STEP] Creating the config segment...\n");
+    g_config.num_users = 12;
+    struct S_config_segment *segment = config_shm_create(open_shm, &open_shm_index);
+    assert(segment->config.num_users == 12);
+    assert(segment->services[0].duration == services_duration[0]);
+    assert(config_shm_version() == 2);
+    assert(!config_shm_publish()); // Nothing changed, same version
+    assert(config_shm_version() == 2);
+    printf("[OK] Config published as version 2, unchanged config not republished.\n");
+
+    // ---- A child sees the new version after a reload ----
+    printf("[STEP] Publishing a change to a running child...\n");
+    int go[2];
+    assert(pipe(go) == 0);
+
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        char c;
+        close(go[1]);
+        if (read(go[0], &c, 1) != 1) _exit(1);
+        if (!config_shm_refresh()) _exit(2);
+        if (g_config.num_users != 99 || services_duration[0] != 13) _exit(3);
+        if (config_shm_version() != 4) _exit(4);
+        if (config_shm_refresh()) _exit(5); // Already up to date
+        _exit(0);
+    }
+
+    close(go[0]);
+    g_config.num_users = 99;
+    services_duration[0] = 13;
+    assert(config_shm_publish());
+    assert(config_shm_version() == 4);
+    assert(write(go[1], "x", 1) == 1);
+    close(go[1]);
+
+    int status;
+    waitpid(child, &status, 0);
+    assert(WIFEXITED(status));
+    printf("       child exit code %d\n", WEXITSTATUS(status));
+    assert(WEXITSTATUS(status) == 0);
+    printf("[OK] Child reloaded version 4 with the new values.\n");
+
+    cleanup_shared_memory(SHM_CONFIG_NAME, SHM_CONFIG_SIZE, open_shm[0], segment);
+
+    printf("[TEST] All config segment tests passed successfully!\n\n");
+    return 0;
+}
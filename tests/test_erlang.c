@@ -0,0 +1,61 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <poste.h>
+#include <erlang.h>
+
+#define NEAR(a, b) ((a) - (b) < 1e-3 && (b) - (a) < 1e-3)
+
+int main(void) {
+    printf("\n[TEST] Starting Erlang C planner tests...\n");
+
+    // ---- Erlang C against known values ----
+    printf("[STEP] Testing the probability of waiting...\n");
+    assert(NEAR(erlang_c(1, 0.5), 0.5));      // M/M/1: rho
+    assert(NEAR(erlang_c(2, 1.0), 1.0 / 3.0));
+    assert(NEAR(erlang_c(10, 8.0), 0.409));
+    assert(erlang_c(3, 3.0) == 1.0);          // Unstable
+    assert(erlang_c(3, 0.0) == 0.0);
+    printf("[OK] Erlang C matches the tables.\n");
+
+    // ---- One service ----
+    printf("[STEP] Testing a prediction...\n");
+    struct S_queue_prediction p;
+    erlang_predict(1.0 / 10.0, 10.0, 2, &p); // 6 requests an hour, 10 minutes each
+    assert(p.stable && NEAR(p.offered_load, 1.0) && NEAR(p.utilization, 0.5));
+    assert(NEAR(p.p_wait, 1.0 / 3.0));
+    assert(NEAR(p.mean_wait, (1.0 / 3.0) / (2.0 / 10.0 - 1.0 / 10.0)));
+    assert(NEAR(p.mean_wait_mg, p.mean_wait * (1.0 + 1.0 / 12.0) / 2.0));
+    assert(NEAR(p.mean_queue, p.mean_wait_mg / 10.0));
+
+    erlang_predict(1.0, 10.0, 3, &p);
+    assert(!p.stable && p.mean_wait < 0.0 && p.p_wait == 1.0);
+    erlang_predict(0.0, 10.0, 0, &p);
+    assert(p.stable && p.mean_wait == 0.0 && p.mean_queue == 0.0);
+    printf("[OK] Load, utilization, waits and queue are consistent.\n");
+
+    // ---- Demand from the user behaviour ----
+    printf("[STEP] Testing the daily requests...\n");
+    struct poste_config config = g_config;
+    config.num_users = 5;
+    config.p_serv_min = 20;
+    config.p_serv_max = 100;
+    config.max_n_requests = 10;
+    double requests[NUM_SERVICE_TYPES];
+    erlang_daily_requests(&config, requests);
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        assert(NEAR(requests[s], 5 * 0.8 * 5.5 / NUM_SERVICE_TYPES));
+    }
+
+    config.p_serv_min = 100; // Nobody goes
+    erlang_daily_requests(&config, requests);
+    assert(requests[0] == 0.0);
+
+    config.worker_shift_open = 8;
+    config.worker_shift_close = 20;
+    assert(erlang_open_minutes(&config) == 720);
+    printf("[OK] Requests per day follow p_serv and max_n_requests.\n");
+
+    printf("[TEST] All Erlang C planner tests passed successfully!\n\n");
+    return 0;
+}
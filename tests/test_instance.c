@@ -0,0 +1,99 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <poste.h>
+#include <shared_mem.h>
+#include <comunications.h>
+#include <instance.h>
+#include <stats.h>
+
+#define TEST_SEGMENT "/poste_test_instance"
+
+int main(void) {
+    printf("\n[TEST] Starting instance isolation tests...\n");
+
+    // ---- Names ----
+    printf("[STEP] Testing instance names...\n");
+    char name[96];
+    instance_shm_name("", SHM_STATS_NAME, name, sizeof(name));
+    assert(strcmp(name, "/poste_stats") == 0);
+    instance_shm_name("a1", SHM_STATS_NAME, name, sizeof(name));
+    assert(strcmp(name, "/poste_stats_a1") == 0);
+    assert(instance_valid("run-2_b") && instance_valid(""));
+    assert(!instance_valid("../x") && !instance_valid("a b"));
+    printf("[OK] Segments are suffixed with the instance, bad names refused.\n");
+
+    // ---- Output directories and keys ----
+    printf("[STEP] Testing directories and keys...\n");
+    char dir[MAX_PATH_LENGTH];
+    instance_output_dir("", dir, sizeof(dir));
+    assert(strcmp(dir, CSV_FILE_PATH) == 0);
+    instance_output_dir("test_a", dir, sizeof(dir));
+    assert(strcmp(dir, CSV_FILE_PATH "test_a/") == 0);
+    struct stat st;
+    assert(stat(dir, &st) == 0 && S_ISDIR(st.st_mode));
+
+    key_t plain = instance_key("", KEY_TICKET_MSG, PROJ_ID);
+    key_t a = instance_key("test_a", KEY_TICKET_MSG, PROJ_ID);
+    key_t b = instance_key("test_b", KEY_TICKET_MSG, PROJ_ID);
+    assert(plain != -1 && a != -1 && b != -1);
+    assert(a != b && a != plain && b != plain);
+    assert(a == instance_key("test_a", KEY_TICKET_MSG, PROJ_ID)); // Stable across processes
+    printf("[OK] Each instance has its own directory and message queue keys.\n");
+
+    // ---- Segments of two instances do not overlap ----
+    printf("[STEP] Testing segments of two instances...\n");
+    int open_shm[2];
+    int open_shm_index = 0;
+    setenv(POSTE_INSTANCE_ENV, "test_a", 1);
+    int *seg_a = init_shared_memory(TEST_SEGMENT, sizeof(int), open_shm, &open_shm_index);
+    *seg_a = 1;
+    setenv(POSTE_INSTANCE_ENV, "test_b", 1);
+    int *seg_b = init_shared_memory(TEST_SEGMENT, sizeof(int), open_shm, &open_shm_index);
+    *seg_b = 2;
+    assert(*seg_a == 1);
+
+    setenv(POSTE_INSTANCE_ENV, "test_a", 1);
+    int *again = attach_shared_memory(TEST_SEGMENT, sizeof(int), PROT_READ);
+    assert(again != NULL && *again == 1);
+    detach_shared_memory(sizeof(int), again);
+    unsetenv(POSTE_INSTANCE_ENV);
+    assert(attach_shared_memory(TEST_SEGMENT, sizeof(int), PROT_READ) == NULL);
+
+    cleanup_shared_memory(TEST_SEGMENT, sizeof(int), open_shm[0], seg_a);
+    setenv(POSTE_INSTANCE_ENV, "test_b", 1);
+    cleanup_shared_memory(TEST_SEGMENT, sizeof(int), open_shm[1], seg_b);
+    unsetenv(POSTE_INSTANCE_ENV);
+    printf("[OK] Same segment name, one segment per instance.\n");
+
+    // ---- Wait percentiles ----
+    printf("[STEP] Testing wait percentiles...\n");
+    int histogram[WAIT_HISTOGRAM_BINS] = {0};
+    assert(stats_wait_percentile(histogram, 0.9) == -1);
+    histogram[0] = 50;
+    histogram[10] = 40;
+    histogram[45] = 10;
+    assert(stats_wait_count(histogram) == 100);
+    assert(stats_wait_percentile(histogram, 0.5) == 0);
+    assert(stats_wait_percentile(histogram, 0.9) == 10);
+    assert(stats_wait_percentile(histogram, 0.99) == 45);
+    printf("[OK] p50, p90 and p99 read from the histogram.\n");
+
+    char key_file[MAX_PATH_LENGTH + 32];
+    const char *instances[] = { "test_a", "test_b" };
+    for (int i = 0; i < 2; i++) {
+        instance_output_dir(instances[i], dir, sizeof(dir));
+        snprintf(key_file, sizeof(key_file), "%sticket.key", dir);
+        unlink(key_file);
+        rmdir(dir);
+    }
+
+    printf("[TEST] All instance isolation tests passed successfully!\n\n");
+    return 0;
+}
@@ -0,0 +1,220 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <poste.h>
+#include <frame.h>
+#include <msg_queue.h>
+#include <mq_broker.h>
+#include <shared_mem.h>
+#include <stats.h>
+#include <instance.h>
+
+#define TEST_INSTANCE "test_mq_socket"
+#define TEST_KEY      4242
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig) {
+    if (sig == SIGTERM) stop = 1;
+}
+
+static void pause_ms(long ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static pid_t start_broker(const char *path) {
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = on_signal;
+        sigaction(SIGTERM, &sa, NULL);
+        _exit(mq_broker_run(path, &stop, NULL) == 0 ? 0 : 1);
+    }
+    // Connected as soon as the socket is there
+    for (int i = 0; i < 200 && access(path, F_OK) != 0; i++) pause_ms(10);
+    assert(access(path, F_OK) == 0);
+    return pid;
+}
+
+int main(void) {
+    printf("\n[TEST] Starting socket transport tests...\n");
+    setenv("POSTE_INSTANCE", TEST_INSTANCE, 1);
+
+    // ---- Frames ----
+    printf("[STEP] Packing records in a frame...\n");
+    static struct S_frame frame, parsed;
+    frame_reset(&frame);
+    int value = 7;
+    assert(frame_add(&frame, 3, &value, sizeof(value)));
+    assert(frame_add(&frame, 4, NULL, 0));
+    static unsigned char big[FRAME_MAX_SIZE];
+    assert(!frame_add(&frame, 5, big, FRAME_MAX_SIZE - RECORD_HEADER_SIZE)); // Does not fit any more
+    assert(frame.length == 2 * RECORD_HEADER_SIZE + sizeof(value));
+
+    size_t cursor = 0;
+    int kind;
+    const void *payload;
+    size_t size;
+    assert(frame_next(&frame, &cursor, &kind, &payload, &size) && kind == 3 && size == sizeof(int));
+    assert(*(const int *)payload == 7);
+    assert(frame_next(&frame, &cursor, &kind, &payload, &size) && kind == 4 && size == 0);
+    assert(!frame_next(&frame, &cursor, &kind, &payload, &size));
+
+    // Through a socket pair, read back whole and cut in pieces
+    int pair[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+    assert(frame_write(pair[0], &frame) == 0);
+    assert(frame_read(pair[1], &parsed) == 1 && parsed.length == frame.length);
+    assert(memcmp(parsed.data, frame.data, frame.length) == 0);
+    unsigned char wire[64];
+    memcpy(wire, &frame.length, FRAME_HEADER_SIZE);
+    memcpy(wire + FRAME_HEADER_SIZE, frame.data, frame.length);
+    assert(frame_parse(wire, 3, &parsed) == 0);
+    assert(frame_parse(wire, FRAME_HEADER_SIZE + frame.length - 1, &parsed) == 0);
+    assert(frame_parse(wire, FRAME_HEADER_SIZE + frame.length, &parsed) == (long)(FRAME_HEADER_SIZE + frame.length));
+    close(pair[0]);
+    assert(frame_read(pair[1], &parsed) == 0); // Peer closed
+    close(pair[1]);
+    printf("[OK] Records come back in order, partial frames wait for the rest.\n");
+
+    // ---- Queues through the broker ----
+    printf("[STEP] Sending and receiving through a broker...\n");
+    char path[MAX_PATH_LENGTH];
+    snprintf(path, sizeof(path), "%s%s/broker.sock", CSV_FILE_PATH, TEST_INSTANCE);
+    char dir[MAX_PATH_LENGTH];
+    instance_output_dir(TEST_INSTANCE, dir, sizeof(dir));
+    pid_t broker = start_broker(path);
+    mq_transport(path);
+    assert(mq_is_remote());
+
+    assert(mq_open(TEST_KEY, 0, 0666) == -1 && errno == ENOENT);
+    mq_id qid = mq_open(TEST_KEY, IPC_CREAT, 0666);
+    assert(qid >= 0);
+    assert(mq_open(TEST_KEY, 0, 0666) == qid);
+    assert(mq_open(TEST_KEY, IPC_CREAT | IPC_EXCL, 0666) == -1 && errno == EEXIST);
+
+    unsigned long long sent = 0;
+    mq_count_sends(&sent);
+    int a = 1, b = 2, c = 3, out = 0;
+    assert(mq_send(qid, 5, &a, sizeof(a)) == 0);
+    assert(mq_send(qid, 2, &b, sizeof(b)) == 0);
+    assert(mq_send(qid, 9, &c, sizeof(c)) == 0);
+    assert(sent == 3);
+    mq_count_sends(NULL);
+
+    assert(mq_receive(qid, 9, &out, sizeof(out), 0) == sizeof(int) && out == 3);   // That type
+    assert(mq_receive(qid, -6, &out, sizeof(out), 0) == sizeof(int) && out == 2);  // Lowest type up to 6
+    char small[2];
+    assert(mq_receive(qid, 0, small, sizeof(small), 0) == -1 && errno == E2BIG); // Stays queued
+    assert(mq_receive(qid, 0, &out, sizeof(out), 0) == sizeof(int) && out == 1);
+    assert(mq_receive(qid, 0, &out, sizeof(out), IPC_NOWAIT) == -1 && errno == ENOMSG);
+    printf("[OK] Types matched as msgrcv, held sends arrive before the receive.\n");
+
+    // ---- Blocking receives ----
+    printf("[STEP] Waking a receive parked in the broker...\n");
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        // Connects on its own, the parent's connection is not shared
+        int got = 0;
+        ssize_t n = mq_receive(qid, 7, &got, sizeof(got), 0);
+        _exit(n == sizeof(got) && got == 77 ? 0 : 1);
+    }
+    pause_ms(100);
+    int reply = 77;
+    assert(mq_send(qid, 7, &reply, sizeof(reply)) == 0);
+    mq_flush();
+    int status;
+    assert(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGALRM, &sa, NULL);
+    alarm(1);
+    assert(mq_receive(qid, 8, &out, sizeof(out), 0) == -1 && errno == EINTR);
+    assert(mq_send(qid, 8, &reply, sizeof(reply)) == 0); // Not taken by the cancelled receive
+    assert(mq_receive(qid, 8, &out, sizeof(out), IPC_NOWAIT) == sizeof(int) && out == 77);
+    printf("[OK] Parked receives are served, a signal cancels them.\n");
+
+    // ---- Stats updates ----
+    printf("[STEP] Applying stats updates in the broker...\n");
+    int open_shm[1], open_shm_index = 0;
+    struct S_poste_stats *stats = init_shared_memory(SHM_STATS_NAME, SHM_STATS_SIZE, open_shm, &open_shm_index);
+    memset(stats, 0, SHM_STATS_SIZE);
+    assert(shm_mutex_init(&stats->stats_lock) == 0);
+    stats_update(stats, (struct S_stats_update){ .kind = STATS_SERVED, .service = 1, .wait_time = 2.0, .minutes = 3.0 });
+    stats_update(stats, (struct S_stats_update){ .kind = STATS_WAITING, .service = 1, .delta = 2 });
+    stats_update(stats, (struct S_stats_update){ .kind = STATS_SEAT_WAIT, .delta = 4 });
+    assert(stats->simulation_global.served_users == 0); // Held in the frame
+    assert(mq_open(TEST_KEY, 0, 0666) == qid);         // Flushed with the open, applied before it
+    assert(stats->simulation_global.served_users == 1);
+    assert(stats->today.services[1].total_wait_time == 2.0);
+    assert(stats->simulation_services[1].total_service_time == 3.0);
+    assert(stats->waiting_users[1] == 2 && stats->wait_histogram[4] == 1);
+    printf("[OK] Updates reach the segment in the order they were made.\n");
+
+    // ---- Full queues ----
+    printf("[STEP] Holding a send to a full queue...\n");
+    unsigned long bound = 16384; // As the broker reads it
+    FILE *fp = fopen("/proc/sys/kernel/msgmnb", "r");
+    if (fp != NULL) {
+        assert(fscanf(fp, "%lu", &bound) == 1);
+        fclose(fp);
+    }
+    int fitting = (int)(bound / MQ_MAX_MESSAGE);
+    child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        static char message[MQ_MAX_MESSAGE];
+        for (int i = 0; i <= fitting; i++) {
+            if (mq_send(qid, 3, message, sizeof(message)) != 0) _exit(1);
+        }
+        _exit(mq_open(TEST_KEY, 0, 0666) == qid ? 0 : 1); // Answered once the last send went in
+    }
+    pause_ms(200);
+    assert(waitpid(child, &status, WNOHANG) == 0);
+    static char taken[MQ_MAX_MESSAGE];
+    assert(mq_receive(qid, 3, taken, sizeof(taken), 0) == MQ_MAX_MESSAGE);
+    assert(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    int left = 0;
+    while (mq_receive(qid, 3, taken, sizeof(taken), IPC_NOWAIT) == MQ_MAX_MESSAGE) left++;
+    assert(left == fitting);
+    printf("[OK] The sender waits until a receive makes room, as msgsnd.\n");
+
+    // ---- Close ----
+    printf("[STEP] Removing the queue...\n");
+    assert(mq_close(qid) == 0);
+    assert(mq_receive(qid, 0, &out, sizeof(out), IPC_NOWAIT) == -1 && errno == EINVAL);
+    sent = 0;
+    mq_count_sends(&sent);
+    assert(mq_send(qid, 1, &a, sizeof(a)) == 0 && sent == 1); // Not known to fail yet
+    assert(mq_close(qid) == -1 && errno == EINVAL);
+    int error = 0;
+    assert(mq_failed_sends(&error) == 1 && error == EIDRM && sent == 0);
+    mq_count_sends(NULL);
+    printf("[OK] Closed queues are gone, sends to them are told with the next reply.\n");
+
+    mq_transport(NULL);
+    kill(broker, SIGTERM);
+    assert(waitpid(broker, &status, 0) == broker && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(access(path, F_OK) != 0); // Socket removed
+    shm_mutex_destroy(&stats->stats_lock);
+    cleanup_shared_memory(SHM_STATS_NAME, SHM_STATS_SIZE, open_shm[0], stats);
+    rmdir(dir);
+
+    printf("[TEST] All socket transport tests passed successfully!\n\n");
+    return 0;
+}
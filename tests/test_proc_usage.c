@@ -0,0 +1,82 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE // wait4
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <proc_usage.h>
+
+typedef struct S_role_usage  role_usage;
+typedef struct S_proc_sample proc_sample;
+
+#define CHILD_MEMORY (16 * 1024 * 1024)
+
+static double cpu_now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(void) {
+    printf("\n[TEST] Starting process usage tests...\n");
+
+    // ---- A live child read from /proc ----
+    printf("[STEP] Sampling a live child...\n");
+    int go[2], ready[2];
+    assert(pipe(go) == 0 && pipe(ready) == 0);
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        char *memory = malloc(CHILD_MEMORY);
+        memset(memory, 1, CHILD_MEMORY); // Resident, not only reserved
+        volatile double x = 0;
+        double started = cpu_now();
+        while (cpu_now() - started < 0.1) x += 1.0;
+        char c = 1;
+        assert(write(ready[1], &c, 1) == 1);
+        assert(read(go[0], &c, 1) == 1);
+        free(memory);
+        _exit(0);
+    }
+    char c;
+    assert(read(ready[0], &c, 1) == 1);
+
+    proc_sample s;
+    assert(proc_sample_read(pid, &s));
+    assert(s.rss_kb >= CHILD_MEMORY / 1024);
+    assert(s.cpu_seconds >= 0.05); // Clock ticks are coarse
+    printf("[OK] %ld KB resident, %.2f s of CPU.\n", s.rss_kb, s.cpu_seconds);
+
+    role_usage usage = {0};
+    role_usage_add_sample(&usage, 1, s.rss_kb, 40.0);
+    role_usage_add_sample(&usage, 3, 100, 90.0);
+    role_usage_add_sample(&usage, 2, 50, 10.0);
+    assert(usage.samples == 3 && usage.peak_alive == 3);
+    assert(usage.peak_rss_kb == s.rss_kb && usage.peak_cpu_percent == 90.0);
+
+    // ---- Its whole life from wait4 ----
+    printf("[STEP] Reaping the child with wait4...\n");
+    assert(write(go[1], &c, 1) == 1);
+    int status;
+    struct rusage ru;
+    assert(wait4(pid, &status, 0, &ru) == pid);
+    role_usage_add_rusage(&usage, &ru);
+    assert(usage.processes == 1);
+    assert(usage.user_seconds + usage.sys_seconds >= 0.09);
+    assert(usage.max_rss_kb >= CHILD_MEMORY / 1024);
+    assert(usage.voluntary_switches >= 1); // Blocked on the pipe
+    assert(role_usage_cpu_ms_per_process(&usage) >= 90.0);
+    assert(role_usage_avg_rss_kb(&usage) == usage.max_rss_kb);
+    assert(!proc_sample_read(pid, &s)); // Gone once reaped
+    printf("[OK] CPU, peak RSS and context switches of the reaped child counted.\n");
+
+    role_usage empty = {0};
+    assert(role_usage_cpu_ms_per_process(&empty) == 0.0 && role_usage_avg_rss_kb(&empty) == 0.0);
+
+    printf("[TEST] All process usage tests passed successfully!\n\n");
+    return 0;
+}
@@ -0,0 +1,116 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ramp.h>
+#include <poste.h>
+
+#define TEST_SCHEDULE CSV_FILE_PATH "test_ramp.txt"
+#define TEST_CONFIG   CSV_FILE_PATH "test_ramp.conf"
+
+static void write_file(const char *path, const char *text) {
+    FILE *fp = fopen(path, "w");
+    assert(fp != NULL);
+    fputs(text, fp);
+    fclose(fp);
+}
+
+int main(void) {
+    printf("\n[TEST] Starting load ramp tests...\n");
+
+    // ---- Parsing steps ----
+    printf("[STEP] Parsing steps...\n");
+    struct S_ramp_step step;
+    assert(ramp_parse_step("2 10:00 +500 over 120\n", &step) == 1);
+    assert(step.day == 2 && step.minute == 600 && step.users == 500 && step.over == 120);
+    assert(ramp_parse_step("  3 00:00 -300 # before the third day", &step) == 1);
+    assert(step.day == 3 && step.minute == 0 && step.users == -300 && step.over == 0);
+    assert(ramp_parse_step("# comment", &step) == 0);
+    assert(ramp_parse_step("   \r\n", &step) == 0);
+    assert(ramp_parse_step("2 10:00 500", &step) == -1);          // No sign
+    assert(ramp_parse_step("2 25:00 +5", &step) == -1);           // No such hour
+    assert(ramp_parse_step("2 10:00 +0", &step) == -1);
+    assert(ramp_parse_step("3 00:00 -300 over 60", &step) == -1); // Retirements are not spread
+    assert(ramp_parse_step("2 10:00 +5 soon", &step) == -1);
+
+    write_file(TEST_SCHEDULE, "# soak\n1 09:00 +5\n\n2 00:00 -2\n");
+    struct S_ramp_step steps[RAMP_MAX_STEPS];
+    int bad_line;
+    assert(ramp_read_file(TEST_SCHEDULE, steps, &bad_line) == 2 && bad_line == 0);
+    write_file(TEST_SCHEDULE, "1 09:00 +5\n1 9am +5\n");
+    assert(ramp_read_file(TEST_SCHEDULE, steps, &bad_line) == -1 && bad_line == 2);
+    assert(ramp_read_file(CSV_FILE_PATH "no_such_schedule.txt", steps, &bad_line) == -1 && bad_line == 0);
+    printf("[OK] Steps, comments and malformed lines told apart.\n");
+
+    // ---- Submitting ----
+    printf("[STEP] Submitting a schedule...\n");
+    struct S_ramp_schedule schedule;
+    memset(&schedule, 0, sizeof(schedule));
+    struct S_ramp_step submitted[4] = {
+        { 2, 600, 100, 10 },  // 100 users over 10 minutes
+        { 2, 600, 45, 0 },    // At the spawn rate
+        { 3, 0, -30, 0 },     // At the start of day 3
+        { 0, 600, 5, 0 }      // No day 0
+    };
+    assert(ramp_submit(&schedule, submitted, 4) == 0);
+    assert(schedule.steps[3].state == RAMP_REJECTED && schedule.steps[0].state == RAMP_PENDING);
+    assert(ramp_submit(&schedule, submitted, RAMP_MAX_STEPS) == -1);  // Does not fit
+    assert(schedule.count == 4);
+    printf("[OK] Invalid steps rejected, a schedule too long refused whole.\n");
+
+    // ---- Spawning ----
+    printf("[STEP] Spreading the spawns...\n");
+    int start = ramp_minute(2, 600);
+    assert(ramp_next_minute(&schedule, ramp_minute(2, 0)) == start);
+    assert(ramp_spawns(&schedule, start - 1, 20) == 0);
+    int spawned = 0;
+    for (int now = start; now < start + 10; now++) {
+        int spawns = ramp_spawns(&schedule, now, 20);
+        assert(spawns <= 10 + 20);
+        spawned += spawns;
+        if (now < start + 9) assert(ramp_next_minute(&schedule, now) == now + 1);
+    }
+    assert(spawned == 145 && schedule.spawned == 145);
+    assert(schedule.steps[0].state == RAMP_DONE && schedule.steps[0].finished == start + 9);
+    assert(schedule.steps[1].state == RAMP_DONE && schedule.steps[1].finished == start + 2); // 20, 20, 5
+    assert(ramp_next_minute(&schedule, start + 10) == ramp_minute(3, 0));
+    printf("[OK] 100 users over 10 minutes, 45 at 20 a minute.\n");
+
+    // ---- Retiring ----
+    printf("[STEP] Retiring at the start of a day...\n");
+    assert(ramp_retirements(&schedule, ramp_minute(2, 1439), 200) == 0);
+    assert(ramp_retirements(&schedule, ramp_minute(3, 0), 200) == 30);
+    assert(schedule.steps[2].state == RAMP_DONE && schedule.retired == 30);
+
+    struct S_ramp_step late[2] = { { 3, 720, -50, 0 }, { 3, 720, -50, 0 } };
+    assert(ramp_submit(&schedule, late, 2) == 4);
+    assert(ramp_spawns(&schedule, ramp_minute(3, 720), 20) == 0);
+    assert(schedule.steps[4].state == RAMP_RUNNING);                       // Until the day ends
+    assert(ramp_next_minute(&schedule, ramp_minute(3, 720)) == INT_MAX);  // Nothing before it
+    assert(ramp_retirements(&schedule, ramp_minute(4, 0), 70) == 70);      // Never more than present
+    assert(schedule.steps[4].done == 50 && schedule.steps[5].done == 20);
+    printf("[OK] Retirements wait for the day to end and stop at the users present.\n");
+
+    // ---- Status lines ----
+    char line[RAMP_DESCRIBE_LENGTH];
+    ramp_describe(&schedule.steps[0], line, sizeof(line));
+    assert(strcmp(line, "day 2 10:00 +100 over 10 min: done, 100/100 spawned, at day 2 10:09") == 0);
+    ramp_describe(&schedule.steps[3], line, sizeof(line));
+    assert(strcmp(line, "day 0 10:00 +5: rejected, 0/5 spawned") == 0);
+
+    // ---- Configuration ----
+    printf("[STEP] Reading ramp_spawn_rate from a config file...\n");
+    write_file(TEST_CONFIG, "ramp_spawn_rate = 50\n");
+    load_config(TEST_CONFIG);
+    assert(g_config.ramp_spawn_rate == 50);
+    printf("[OK] ramp_spawn_rate parsed.\n");
+
+    unlink(TEST_SCHEDULE);
+    unlink(TEST_CONFIG);
+    printf("[TEST] All load ramp tests passed successfully!\n\n");
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <poste.h>
+#include <shared_mem.h>
+#include <sampler.h>
+
+typedef struct S_poste_stats    poste_stats;
+typedef struct S_poste_stations poste_stations;
+typedef struct S_sample         sample;
+typedef struct S_sample_summary sample_summary;
+
+static int count_lines(FILE *fp) {
+    int lines = 0, c;
+    rewind(fp);
+    while ((c = fgetc(fp)) != EOF) {
+        if (c == '\n') lines++;
+    }
+    return lines;
+}
+
+int main(void) {
+    printf("\n[TEST] Starting queue sampler tests...\n");
+
+    static poste_stats stats;
+    static poste_stations stations;
+    shm_mutex_init(&stations.stations_lock);
+
+    int open_shm[1];
+    int open_shm_index = 0;
+    struct S_sample_ring *ring = sampler_create(5, open_shm, &open_shm_index);
+
+    // ---- A sample reads the live queues and seats ----
+    printf("[STEP] Sampling queues and seats...\n");
+    g_config.num_worker_seats = 3;
+    stats.waiting_users[2] = 4;
+    stations.NOF_WORKER_SEATS[0] = (struct S_worker_seat){ .operator_status = OCCUPIED, .user_status = OCCUPIED, .service_id = 2 };
+    stations.NOF_WORKER_SEATS[1] = (struct S_worker_seat){ .operator_status = OCCUPIED, .user_status = FREE, .service_id = 2 };
+    stations.NOF_WORKER_SEATS[2] = (struct S_worker_seat){ .operator_status = FREE, .user_status = FREE, .service_id = 1 };
+    stations.operator_skills[2] = 3;
+
+    sample now;
+    sampler_take(&now, 1, 600, &stats, &stations);
+    assert(now.waiting[2] == 4 && now.staffed[2] == 2 && now.serving[2] == 1);
+    assert(now.staffed[1] == 0 && now.operators[2] == 3);
+    printf("[OK] Sample matches the segments.\n");
+
+    // ---- Only every interval minutes, and over jumps ----
+    printf("[STEP] Recording at the interval and over a jump...\n");
+    assert(sampler_due(ring, 600) && !sampler_due(ring, 601));
+    sampler_record(ring, &now);
+    sampler_skip(ring, &now, 601, 631); // 605 ... 630
+    assert(ring->head == 7);
+    assert(ring->samples[6].minute == 630 && ring->samples[6].waiting[2] == 4);
+    printf("[OK] 1 sampled + 6 jumped minutes recorded.\n");
+
+    // ---- Drain to CSV and summary ----
+    printf("[STEP] Draining to a CSV file...\n");
+    FILE *fp = tmpfile();
+    assert(fp != NULL);
+    sample_summary summary = {0};
+    assert(sampler_drain(ring, fp, &summary) == 7);
+    assert(sampler_drain(ring, fp, &summary) == 0);
+    assert(count_lines(fp) == 1 + 7 * NUM_SERVICE_TYPES);
+    assert(summary.peak_waiting[2] == 4 && summary.peak_minute[2] == 600 && summary.peak_staffed[2] == 2);
+    assert(summary.hour_samples[10] == 7);
+    assert(sampler_peak_hour(&summary) == 10);
+    fclose(fp);
+    printf("[OK] Header plus one row per service and sample, peak at 10:00.\n");
+
+    // ---- A full lap overwrites what was not drained ----
+    printf("[STEP] Overflowing the ring...\n");
+    now.minute = 900;
+    now.waiting[2] = 9;
+    for (int i = 0; i < SAMPLER_RING_SIZE + 10; i++) sampler_record(ring, &now);
+    assert(sampler_drain(ring, NULL, &summary) == SAMPLER_RING_SIZE);
+    assert(summary.lost == 10);
+    assert(summary.peak_waiting[2] == 9 && sampler_peak_hour(&summary) == 15);
+    printf("[OK] 10 samples counted as lost, peak moved to 15:00.\n");
+
+    cleanup_shared_memory(SHM_SAMPLES_NAME, SHM_SAMPLES_SIZE, open_shm[0], ring);
+
+    printf("[TEST] All queue sampler tests passed successfully!\n\n");
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poste.h>
+#include <seat_policy.h>
+
+typedef struct S_service_stats service_stats;
+
+static void count_seats(const int seat_services[], int num_seats, int counts[NUM_SERVICE_TYPES]) {
+    memset(counts, 0, sizeof(int) * NUM_SERVICE_TYPES);
+    for (int i = 0; i < num_seats; i++) {
+        assert(seat_services[i] >= 0 && seat_services[i] < NUM_SERVICE_TYPES);
+        counts[seat_services[i]]++;
+    }
+}
+
+int main(void) {
+    printf("\n[TEST] Starting seat policy tests...\n");
+
+    int seat_services[MAX_WORKER_SEATS];
+    int counts[NUM_SERVICE_TYPES];
+
+    // ---- First day: no history, one seat per skilled service ----
+    printf("[STEP] Testing demand allocation without history...\n");
+    service_stats empty[NUM_SERVICE_TYPES] = {0};
+    int all_skills[NUM_SERVICE_TYPES] = {2, 2, 2, 2, 2, 2};
+    allocate_seats(SEAT_POLICY_DEMAND, empty, all_skills, 12, seat_services);
+    count_seats(seat_services, 12, counts);
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        printf("       %s: %d seats\n", services[s], counts[s]);
+        assert(counts[s] >= 1 && counts[s] <= 2);
+    }
+    printf("[OK] Every service got a seat, none above its operators.\n");
+
+    // ---- Skewed demand: seats follow the load, capped by the skills ----
+    printf("[STEP] Testing demand allocation on skewed history...\n");
+    service_stats history[NUM_SERVICE_TYPES] = {0};
+    history[0].total_requests = 300; // Parcels, 10 minutes each
+    history[2].total_requests = 100; // Bancoposta, 6 minutes each
+    history[4].failed_services = 10; // Financial products, nobody served them
+    int skills[NUM_SERVICE_TYPES] = {10, 1, 10, 0, 1, 1};
+
+    allocate_seats(SEAT_POLICY_DEMAND, history, skills, 10, seat_services);
+    count_seats(seat_services, 10, counts);
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+        printf("       %s: %d seats (skills %d)\n", services[s], counts[s], skills[s]);
+    }
+    assert(counts[0] > counts[2]);      // Heaviest load gets the most seats
+    assert(counts[2] >= 1);
+    assert(counts[4] == 1);             // Failed demand is still demand
+    assert(counts[3] == 0);             // Nobody requested it, nobody knows it
+    assert(counts[4] <= skills[4]);
+    printf("[OK] Seats follow the load and the skills.\n");
+
+    // ---- Expected served users: demand beats random on skewed load ----
+    printf("[STEP] Testing expected served users...\n");
+    double demand[NUM_SERVICE_TYPES];
+    seat_policy_demand(history, 5, demand);
+    assert(demand[0] == 60.0 && demand[4] == 2.0);
+
+    int open_minutes = 12 * 60;
+    double served = seat_policy_expected_served(counts, skills, demand, open_minutes);
+    double served_random = seat_policy_expected_served_random(10, skills, demand, open_minutes);
+    printf("       demand policy: %.2f users/day, random seats: %.2f users/day\n", served, served_random);
+    assert(served >= served_random);
+
+    double total_demand = 0.0;
+    for (int s = 0; s < NUM_SERVICE_TYPES; s++) total_demand += demand[s];
+    assert(served <= total_demand + 1e-9);
+
+    // With no seats nobody is served, with no demand either
+    int no_seats[NUM_SERVICE_TYPES] = {0};
+    assert(seat_policy_expected_served(no_seats, skills, demand, open_minutes) == 0.0);
+    double no_demand[NUM_SERVICE_TYPES] = {0};
+    assert(seat_policy_expected_served_random(10, skills, no_demand, open_minutes) == 0.0);
+    printf("[OK] Expected served users are consistent.\n");
+
+    // ---- Random policy keeps every seat in range ----
+    printf("[STEP] Testing random allocation...\n");
+    allocate_seats(SEAT_POLICY_RANDOM, history, skills, MAX_WORKER_SEATS, seat_services);
+    count_seats(seat_services, MAX_WORKER_SEATS, counts);
+    printf("[OK] Random seats are valid services.\n");
+
+    printf("[TEST] All seat policy tests passed successfully!\n\n");
+    return 0;
+}
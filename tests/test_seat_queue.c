@@ -0,0 +1,276 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <poste.h>
+#include <shared_mem.h>
+#include <sim_clock.h>
+#include <seat_queue.h>
+#include <comunications.h>
+#include <operatore.h>
+#include <utente.h>
+
+typedef struct S_poste_stations poste_stations;
+typedef struct S_actor_queue    actor_queue;
+
+// Child queued for a seat, exits with the seat handed over + 1, 0 if none
+static pid_t spawn_waiter(poste_stations *stations, actor_queue *queue, int minutes) {
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        sim_actor_join(ACTOR_USER);
+        shm_mutex_lock(&stations->stations_lock);
+        int seat = seat_queue_wait(stations, queue, minutes);
+        shm_mutex_unlock(&stations->stations_lock);
+        _exit(seat + 1);
+    }
+    return pid;
+}
+
+static void wait_queued(poste_stations *stations, actor_queue *queue, int length) {
+    struct timespec t = { .tv_sec = 0, .tv_nsec = 1000000L };
+    while (true) {
+        shm_mutex_lock(&stations->stations_lock);
+        int queued = queue->length;
+        shm_mutex_unlock(&stations->stations_lock);
+        if (queued == length) return;
+        nanosleep(&t, NULL);
+    }
+}
+
+static int exit_code(pid_t pid) {
+    int status;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status));
+    return WEXITSTATUS(status);
+}
+
+int main(void) {
+    printf("\n[TEST] Starting seat queue tests...\n");
+
+    int open_shm[3];
+    int open_shm_index = 0;
+    struct S_sim_clock *clock = sim_clock_create(false, false, open_shm, &open_shm_index);
+    poste_stations *stations = init_shared_memory(SHM_STATIONS_NAME, SHM_STATIONS_SIZE, open_shm, &open_shm_index);
+    shm_mutex_init(&stations->stations_lock);
+    g_config.minute_duration = 1000000; // 1ms minutes
+    g_config.num_worker_seats = 2;
+    stations->NOF_WORKER_SEATS[0] = (struct S_worker_seat){ .operator_status = FREE, .user_status = FREE, .service_id = 2 };
+    stations->NOF_WORKER_SEATS[1] = (struct S_worker_seat){ .operator_status = FREE, .user_status = FREE, .service_id = 4 };
+
+    // ---- A freed seat goes to the first operator waiting for its service ----
+    printf("[STEP] Handing a seat to queued operators...\n");
+    actor_queue *operators = &stations->operator_queue[2];
+    pid_t first = spawn_waiter(stations, operators, 60000);
+    wait_queued(stations, operators, 1);
+    pid_t second = spawn_waiter(stations, operators, 60000);
+    wait_queued(stations, operators, 2);
+
+    shm_mutex_lock(&stations->stations_lock);
+    seat_queue_offer(stations, 1); // Other service, nobody wakes
+    assert(stations->NOF_WORKER_SEATS[1].operator_status == FREE && operators->length == 2);
+    seat_queue_offer(stations, 0);
+    assert(stations->NOF_WORKER_SEATS[0].operator_status == OCCUPIED);
+    assert(stations->NOF_WORKER_SEATS[0].operator_process == first);
+    assert(operators->length == 1);
+    shm_mutex_unlock(&stations->stations_lock);
+    assert(exit_code(first) == 1);
+
+    shm_mutex_lock(&stations->stations_lock);
+    stations->NOF_WORKER_SEATS[0].operator_status = FREE;
+    seat_queue_offer(stations, 0);
+    assert(stations->NOF_WORKER_SEATS[0].operator_process == second && operators->length == 0);
+    shm_mutex_unlock(&stations->stations_lock);
+    assert(exit_code(second) == 1);
+    printf("[OK] One operator woken per seat, first come first served.\n");
+
+    // ---- The user side of a staffed seat goes to the first user waiting ----
+    printf("[STEP] Handing a staffed seat to a queued user...\n");
+    actor_queue *users = &stations->user_queue[2];
+    stations->NOF_WORKER_SEATS[0].user_status = OCCUPIED;
+    pid_t user = spawn_waiter(stations, users, 60000);
+    wait_queued(stations, users, 1);
+
+    shm_mutex_lock(&stations->stations_lock);
+    stations->NOF_WORKER_SEATS[0].user_status = FREE;
+    seat_queue_offer(stations, 0);
+    assert(stations->NOF_WORKER_SEATS[0].user_status == OCCUPIED && users->length == 0);
+    shm_mutex_unlock(&stations->stations_lock);
+    assert(exit_code(user) == 1);
+    printf("[OK] Freed user side handed over to the waiting user.\n");
+
+    // ---- Nobody hands a seat: the wait ends after its minutes ----
+    printf("[STEP] Testing the wait deadline...\n");
+    pid_t late = spawn_waiter(stations, operators, 20);
+    assert(exit_code(late) == 0);
+    assert(operators->length == 0 && operators->first == 0 && operators->last == 0);
+
+    // Without a clock slot the caller polls: nothing is queued
+    shm_mutex_lock(&stations->stations_lock);
+    assert(seat_queue_wait(stations, operators, 20) == -1);
+    assert(operators->length == 0);
+    shm_mutex_unlock(&stations->stations_lock);
+    printf("[OK] Timed out waiters leave the queue, unregistered ones never join it.\n");
+
+    // ---- A process that died is taken out of the queues and seats ----
+    printf("[STEP] Forgetting processes that died...\n");
+    first = spawn_waiter(stations, operators, 60000);
+    wait_queued(stations, operators, 1);
+    second = spawn_waiter(stations, operators, 60000);
+    wait_queued(stations, operators, 2);
+    kill(first, SIGKILL);
+    waitpid(first, NULL, 0);
+
+    pid_t seated[MAX_WORKER_SEATS];
+    shm_mutex_lock(&stations->stations_lock);
+    assert(seat_queue_forget(stations, first, seated) == 0);
+    assert(operators->length == 1);
+    stations->NOF_WORKER_SEATS[0] = (struct S_worker_seat){ .operator_status = FREE, .user_status = FREE, .service_id = 2 };
+    seat_queue_offer(stations, 0);
+    assert(stations->NOF_WORKER_SEATS[0].operator_process == second && operators->length == 0);
+    shm_mutex_unlock(&stations->stations_lock);
+    assert(exit_code(second) == 1);
+
+    // Its operator gone, the user seated is reported and the seat freed
+    shm_mutex_lock(&stations->stations_lock);
+    stations->NOF_WORKER_SEATS[0].user_status  = OCCUPIED;
+    stations->NOF_WORKER_SEATS[0].user_process = 4242;
+    assert(seat_queue_forget(stations, second, seated) == 1 && seated[0] == 4242);
+    assert(stations->NOF_WORKER_SEATS[0].operator_status == FREE && stations->NOF_WORKER_SEATS[0].operator_process == 0);
+    assert(stations->NOF_WORKER_SEATS[0].user_status == FREE && stations->NOF_WORKER_SEATS[0].user_process == 0);
+    shm_mutex_unlock(&stations->stations_lock);
+
+    // A lock recovered from a dead holder: the queue is relinked without the dead
+    first = spawn_waiter(stations, operators, 60000);
+    wait_queued(stations, operators, 1);
+    second = spawn_waiter(stations, operators, 60000);
+    wait_queued(stations, operators, 2);
+    kill(first, SIGKILL);
+    waitpid(first, NULL, 0);
+    shm_mutex_lock(&stations->stations_lock);
+    operators->length = 5; // Half updated
+    sim_queue_repair(operators);
+    assert(operators->length == 1 && operators->first == operators->last);
+    seat_queue_offer(stations, 0);
+    assert(stations->NOF_WORKER_SEATS[0].operator_process == second);
+    shm_mutex_unlock(&stations->stations_lock);
+    assert(exit_code(second) == 1);
+    printf("[OK] Dead processes unlinked, their seats handed over again.\n");
+
+    // ---- Scheduling lag of the sleeps ----
+    printf("[STEP] Recording scheduling lags...\n");
+    assert(clock->lag[ACTOR_USER].samples == 0); // Queue waits end on a handoff, not at a planned time
+    pid_t sleeper = fork();
+    if (sleeper == 0) {
+        sim_actor_join(ACTOR_OPERATOR);
+        sim_sleep_minutes(2);
+        sim_sleep_nanos(500000);
+        _exit(0);
+    }
+    assert(exit_code(sleeper) == 0);
+    const struct S_lag_histogram *lag = &clock->lag[ACTOR_OPERATOR];
+    unsigned long long bucketed = 0;
+    for (int b = 0; b < LAG_BUCKETS; b++) bucketed += lag->buckets[b];
+    assert(lag->samples == 2 && bucketed == 2);
+    assert(lag->max_ns <= lag->total_ns && 2 * lag->max_ns >= lag->total_ns);
+    assert(sim_lag_percentile_us(lag, 1.0) * 1000 >= lag->max_ns);
+
+    // On the shared clock, from the director posting the wakeup: not the time it took to publish
+    clock->time_warp = 1;
+    sleeper = fork();
+    if (sleeper == 0) {
+        sim_actor_join(ACTOR_TICKET);
+        sim_sleep_minutes(3);
+        _exit(0);
+    }
+    bool sleeping = false;
+    struct timespec pause = { .tv_sec = 0, .tv_nsec = 1000000L };
+    while (!sleeping) {
+        for (int i = 0; i < clock->n_slots; i++) {
+            sleeping |= clock->actors[i].pid == sleeper &&
+                        __atomic_load_n(&clock->actors[i].state, __ATOMIC_SEQ_CST) == ACTOR_SLEEPING;
+        }
+        nanosleep(&pause, NULL);
+    }
+    pause.tv_nsec = 200000000L;
+    nanosleep(&pause, NULL);
+    sim_clock_publish(3);
+    assert(exit_code(sleeper) == 0);
+    assert(clock->lag[ACTOR_TICKET].samples == 1 && clock->lag[ACTOR_TICKET].max_ns < 200000000ULL);
+    clock->time_warp = 0;
+    printf("[OK] Real-time and shared-clock sleeps counted for their role.\n");
+
+    // ---- An operator leaving a seat a user holds ----
+    printf("[STEP] Leaving a seat while a user holds it...\n");
+    struct S_poste_stats *stats = init_shared_memory(SHM_STATS_NAME, SHM_STATS_SIZE, open_shm, &open_shm_index);
+    shm_mutex_init(&stats->stats_lock);
+    mq_id qid = mq_open(IPC_PRIVATE, IPC_CREAT, 0600);
+    assert(qid >= 0);
+    pid_t operator_pid = getpid();
+    stations->NOF_WORKER_SEATS[0] = (struct S_worker_seat){
+        .operator_process = operator_pid, .operator_status = OCCUPIED, .user_status = OCCUPIED, .service_id = 2
+    };
+
+    // Took the seat, sends its request once the operator is already leaving
+    pid_t holder = fork();
+    if (holder == 0) {
+        struct timespec t = { .tv_sec = 0, .tv_nsec = 20000000L };
+        nanosleep(&t, NULL);
+        struct S_service_request req = { getpid(), 42 };
+        long mtype = (MSG_TYPE_SERVICE_REQUEST MSG_TYPE_TICKET_REQUEST_MULT) + operator_pid;
+        if (mq_send(qid, mtype, &req, sizeof(req)) < 0) _exit(1);
+        struct S_service_done done;
+        if (mq_receive(qid, getpid(), &done, sizeof(done), 0) < 0 || done.ticket_number != 42) _exit(1);
+        shm_mutex_lock(&stations->stations_lock);
+        stations->NOF_WORKER_SEATS[0].user_status = FREE;
+        seat_queue_offer(stations, 0);
+        shm_mutex_unlock(&stations->stations_lock);
+        _exit(0);
+    }
+    user = spawn_waiter(stations, users, 200); // Must not get the seat of an operator leaving
+    wait_queued(stations, users, 1);
+
+    leave_seat(stats, stations, qid, 0, 2);
+    assert(exit_code(holder) == 0);
+    assert(stations->NOF_WORKER_SEATS[0].operator_status == FREE);
+    assert(stations->NOF_WORKER_SEATS[0].operator_process == 0);
+    assert(stations->NOF_WORKER_SEATS[0].user_status == FREE);
+    assert(exit_code(user) == 0);
+    assert(stats->today.services[2].total_requests == 1);
+    printf("[OK] The request sent meanwhile is served, nobody takes the closing seat.\n");
+
+    // ---- A service ending after closing ----
+    printf("[STEP] Leaving a seat whose service ends after closing...\n");
+    g_config.worker_shift_close = 12;
+    stats->current_minute = 11 * 60 + 59;
+    stations->NOF_WORKER_SEATS[0] = (struct S_worker_seat){
+        .operator_process = operator_pid, .operator_status = OCCUPIED, .user_status = FREE, .service_id = 2
+    };
+    holder = fork();
+    if (holder == 0) {
+        _exit(serve_ticket(2, 43, qid, stats, stations) == SERVICE_SERVED ? 0 : 1);
+    }
+    struct timespec t = { .tv_sec = 0, .tv_nsec = 1000000L };
+    while (__atomic_load_n(&stations->NOF_WORKER_SEATS[0].user_status, __ATOMIC_SEQ_CST) != OCCUPIED) nanosleep(&t, NULL);
+    stats->current_minute = 12 * 60; // Served from the closing minute on
+
+    leave_seat(stats, stations, qid, 0, 2);
+    assert(exit_code(holder) == 0);
+    assert(stations->NOF_WORKER_SEATS[0].operator_status == FREE);
+    assert(stations->NOF_WORKER_SEATS[0].user_status == FREE);
+    assert(stats->today.services[2].total_requests == 2);
+    assert(stats->today.late_users == 1);
+    assert(mq_close(qid) == 0);
+    printf("[OK] The late user frees its side, the operator leaves at once.\n");
+
+    cleanup_shared_memory(SHM_STATS_NAME, SHM_STATS_SIZE, open_shm[2], stats);
+    cleanup_shared_memory(SHM_STATIONS_NAME, SHM_STATIONS_SIZE, open_shm[1], stations);
+    cleanup_shared_memory(SHM_CLOCK_NAME, SHM_CLOCK_SIZE, open_shm[0], clock);
+
+    printf("[TEST] All seat queue tests passed successfully!\n\n");
+    return 0;
+}
@@ -0,0 +1,113 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <poste.h>
+#include <shm_mutex.h>
+#include <stats.h>
+
+typedef struct S_shm_mutex      shm_mutex;
+typedef struct S_poste_stats    poste_stats;
+typedef struct S_stats_snapshot snapshot;
+
+static void *shared_area(size_t size) {
+    void *area = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    assert(area != MAP_FAILED);
+    memset(area, 0, size);
+    return area;
+}
+
+static void reap(pid_t pid) {
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+}
+
+int main(void) {
+    printf("\n[TEST] Starting shared mutex tests...\n");
+
+    shm_mutex *m = shared_area(sizeof(shm_mutex));
+    assert(shm_mutex_init(m) == 0);
+
+    // ---- A holder that dies does not block the others ----
+    printf("[STEP] Testing owner death recovery...\n");
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        shm_mutex_lock(m);
+        _exit(0); // Dies holding it
+    }
+    reap(pid);
+    assert(shm_mutex_lock(m));
+    shm_mutex_unlock(m);
+    assert(!shm_mutex_lock(m)); // Consistent again
+    shm_mutex_unlock(m);
+    assert(m->counters.recoveries == 1 && m->counters.acquisitions == 3);
+    printf("[OK] Next locker takes it over and the mutex stays usable.\n");
+
+    // ---- Waiting for a busy mutex is counted ----
+    printf("[STEP] Testing contention counters...\n");
+    int *ready = shared_area(sizeof(int));
+    pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        shm_mutex_lock(m);
+        __atomic_store_n(ready, 1, __ATOMIC_RELEASE);
+        struct timespec hold = { .tv_sec = 0, .tv_nsec = 50000000L };
+        nanosleep(&hold, NULL);
+        shm_mutex_unlock(m);
+        _exit(0);
+    }
+    while (!__atomic_load_n(ready, __ATOMIC_ACQUIRE)) sched_yield();
+    assert(!shm_mutex_lock(m));
+    shm_mutex_unlock(m);
+    reap(pid);
+
+    struct S_lock_counters counters;
+    shm_mutex_counters(m, &counters);
+    assert(counters.acquisitions == 5);
+    assert(counters.contended == 1 && counters.sleeps == 1); // 50ms is past any spin
+    assert(counters.recoveries == 1);
+    printf("[OK] Contended and slept acquisitions counted.\n");
+    shm_mutex_destroy(m);
+
+    // ---- A writer dying inside the stats seqlock ----
+    printf("[STEP] Testing the stats seqlock after a writer death...\n");
+    poste_stats *stats = shared_area(sizeof(poste_stats));
+    assert(shm_mutex_init(&stats->stats_lock) == 0);
+    pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        stats_write_begin(stats);
+        stats->total_active_operators = 7;
+        _exit(0); // Sequence left odd
+    }
+    reap(pid);
+    assert(stats->stats_seq % 2 == 1);
+
+    stats_write_begin(stats);
+    stats->total_active_operators++;
+    stats_write_end(stats);
+    assert(stats->stats_seq % 2 == 0);
+
+    snapshot snap;
+    stats_snapshot(stats, &snap); // Returns instead of retrying forever
+    assert(snap.total_active_operators == 8);
+    assert(stats->stats_lock.counters.recoveries == 1);
+    shm_mutex_destroy(&stats->stats_lock);
+    printf("[OK] Sequence closed by the next writer, readers see a stable copy.\n");
+
+    munmap(stats, sizeof(poste_stats));
+    munmap(ready, sizeof(int));
+    munmap(m, sizeof(shm_mutex));
+
+    printf("[TEST] All shared mutex tests passed successfully!\n\n");
+    return 0;
+}
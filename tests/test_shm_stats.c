@@ -7,7 +7,8 @@
 #include <semaphore.h>
 #include <errno.h>
 #include <poste.h>
-#include <direttore.h>  
+#include <direttore.h>
+#include <shared_mem.h>
 
 typedef struct S_poste_stats poste_stats;
 
@@ -32,14 +33,14 @@ int main(void) {
     printf("[STEP] Initializing all values to a known state (0)\n");
     memset(p, 0, SHM_STATS_SIZE);
 
-    // Initialize semaphore inside SHM
-    printf("[STEP] Creating the semaphore in shared memory (pshared=1, value=1)...\n");
-    if (sem_init(&p->stats_lock, 1, 1) != 0) {
-        perror("[FAIL] sem_init");
+    // Initialize the lock inside SHM
+    printf("[STEP] Creating the robust process-shared mutex in shared memory...\n");
+    if (shm_mutex_init(&p->stats_lock) != 0) {
+        fprintf(stderr, "[FAIL] shm_mutex_init\n");
         cleanup_shared_memory(name, size, open_fds[0], p);
         exit(EXIT_FAILURE);
     }
-    printf("[OK] Semaphore initialized.\n");
+    printf("[OK] Mutex initialized.\n");
 
     // Memory must be zero-initialized
     printf("[STEP] Checking zero-initialization of shared memory...\n");
@@ -50,21 +51,18 @@ int main(void) {
     }
     printf("[OK] Memory zero-initialized.\n");
 
-    // Test semaphore locking/updating
-    printf("[STEP] Locking semaphore and updating current_day...\n");
-    if (sem_wait(&p->stats_lock) != 0) {
-        perror("[FAIL] sem_wait");
+    // Test mutex locking/updating
+    printf("[STEP] Locking the mutex and updating current_day...\n");
+    if (shm_mutex_lock(&p->stats_lock)) {
+        fprintf(stderr, "[FAIL] fresh mutex reported a dead owner\n");
         cleanup_shared_memory(name, size, open_fds[0], p);
         exit(EXIT_FAILURE);
     }
     p->current_day = 10;
-    if (sem_post(&p->stats_lock) != 0) {
-        perror("[FAIL] sem_post");
-        cleanup_shared_memory(name, size, open_fds[0], p);
-        exit(EXIT_FAILURE);
-    }
+    shm_mutex_unlock(&p->stats_lock);
     assert(p->current_day == 10);
-    printf("[OK] Semaphore works; current_day updated to %d.\n", p->current_day);
+    assert(p->stats_lock.counters.acquisitions == 1);
+    printf("[OK] Mutex works; current_day updated to %d.\n", p->current_day);
 
     // Cleanup
     printf("[STEP] Cleaning up shared memory...\n");
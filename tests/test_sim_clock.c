@@ -0,0 +1,232 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <poste.h>
+#include <shared_mem.h>
+#include <msg_queue.h>
+#include <sim_clock.h>
+
+typedef struct S_sim_clock  sim_clock;
+typedef struct S_actor_slot actor_slot;
+
+#define WAIT_NS 2000000L // How long the director waits for idle actors in these tests
+
+static actor_slot *slot_of(sim_clock *clock, pid_t pid) {
+    for (int i = 0; i < clock->n_slots; i++) {
+        if (clock->actors[i].pid == pid) return &clock->actors[i];
+    }
+    return NULL;
+}
+
+static void set_state(actor_slot *slot, int state, int wake_minute) {
+    __atomic_store_n(&slot->wake_minute, wake_minute, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&slot->state, state, __ATOMIC_SEQ_CST);
+}
+
+static int exit_code(pid_t pid) {
+    int status;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status));
+    return WEXITSTATUS(status);
+}
+
+// Waits until the actor of pid is in state, as the director sees it
+static void wait_state(sim_clock *clock, pid_t pid, int state) {
+    struct timespec t = { .tv_sec = 0, .tv_nsec = 1000000L };
+    while (true) {
+        actor_slot *slot = slot_of(clock, pid);
+        if (slot != NULL && __atomic_load_n(&slot->state, __ATOMIC_SEQ_CST) == state) return;
+        nanosleep(&t, NULL);
+    }
+}
+
+int main(void) {
+    printf("\n[TEST] Starting simulated clock tests...\n");
+
+    int open_shm[2];
+    int open_shm_index = 0;
+    sim_clock *clock = sim_clock_create(true, false, open_shm, &open_shm_index);
+    g_config.minute_duration = 1000000; // 1ms minutes
+    int next_wake = 0;
+
+    // ---- Nobody tracked: idle at once, nobody to wake ----
+    printf("[STEP] Waiting for idle actors on an empty clock...\n");
+    assert(sim_clock_wait_idle(WAIT_NS, true, &next_wake));
+    assert(next_wake == INT_MAX);
+    printf("[OK] Idle, no wakeup planned.\n");
+
+    // ---- A running actor blocks every jump ----
+    printf("[STEP] Blocking a jump with a running actor...\n");
+    sim_actor_register(1001); // Running until it joins, as the director registers children
+    actor_slot *a = slot_of(clock, 1001);
+    assert(a != NULL && a->state == ACTOR_RUNNING);
+    assert(!sim_clock_wait_idle(WAIT_NS, true, &next_wake));
+    printf("[OK] A running slot keeps the clock from jumping.\n");
+
+    // ---- Sleepers report the earliest wakeup, blocked actors none ----
+    printf("[STEP] Reporting the earliest wakeup...\n");
+    sim_actor_register(1002);
+    sim_actor_register(1003);
+    actor_slot *b = slot_of(clock, 1002);
+    actor_slot *c = slot_of(clock, 1003);
+    sim_clock_publish(10);
+    set_state(a, ACTOR_SLEEPING, 40);
+    set_state(b, ACTOR_SLEEPING, 25);
+    set_state(c, ACTOR_BLOCKED, 0);
+    assert(sim_clock_wait_idle(WAIT_NS, true, &next_wake));
+    assert(next_wake == 25);
+    printf("[OK] Earliest wakeup 25, the blocked actor adds none.\n");
+
+    // ---- Messages in flight block a jump until received ----
+    printf("[STEP] Blocking a jump with pending wakeups...\n");
+    sim_expect_wakeups(2);
+    assert(clock->pending == 2);
+    assert(!sim_clock_wait_idle(WAIT_NS, true, &next_wake));
+    sim_expect_wakeups(-1);
+    assert(!sim_clock_wait_idle(WAIT_NS, true, &next_wake));
+    sim_expect_wakeups(-1);
+    assert(sim_clock_wait_idle(WAIT_NS, true, &next_wake) && next_wake == 25);
+    printf("[OK] Idle again once pending is back to 0.\n");
+
+    // ---- A sleeper already due blocks a jump, publishing wakes it ----
+    printf("[STEP] Blocking a jump with an overdue sleeper...\n");
+    set_state(b, ACTOR_SLEEPING, 8); // Due before now, not woken yet
+    assert(!sim_clock_wait_idle(WAIT_NS, true, &next_wake));
+    sim_clock_publish(10);
+    assert(b->state == ACTOR_RUNNING && a->state == ACTOR_SLEEPING);
+    assert(!sim_clock_wait_idle(WAIT_NS, true, &next_wake));
+    set_state(b, ACTOR_SLEEPING, 25);
+    assert(sim_clock_wait_idle(WAIT_NS, true, &next_wake) && next_wake == 25);
+    printf("[OK] Overdue slot blocks the jump until the clock wakes it.\n");
+
+    // ---- No jump asked, or more actors than slots: just sleeps ----
+    printf("[STEP] Testing the cases that never jump...\n");
+    assert(!sim_clock_wait_idle(WAIT_NS, false, &next_wake));
+    clock->overflow = 1;
+    assert(!sim_clock_wait_idle(WAIT_NS, true, &next_wake));
+    clock->overflow = 0;
+
+    sim_actor_forget(1001);
+    sim_actor_forget(1002);
+    sim_actor_forget(1003);
+    assert(slot_of(clock, 1001) == NULL && a->state == ACTOR_FREE);
+    assert(sim_clock_wait_idle(WAIT_NS, true, &next_wake) && next_wake == INT_MAX);
+    printf("[OK] No jump when not asked or untracked, forgotten slots are free.\n");
+
+    // ---- An actor blocked on a receive, accounted by the sender ----
+    printf("[STEP] Accounting a wakeup through block and unblock...\n");
+    int pipe_fds[2];
+    assert(pipe(pipe_fds) == 0);
+    pid_t receiver = fork();
+    if (receiver == 0) {
+        sim_actor_join(ACTOR_USER);
+        char token;
+        sim_block();
+        ssize_t n = read(pipe_fds[0], &token, 1); // Stands for a message queue receive
+        sim_unblock(n == 1);
+        sim_sleep_minutes(30);
+        sim_actor_leave();
+        _exit(0);
+    }
+    wait_state(clock, receiver, ACTOR_BLOCKED);
+    assert(sim_clock_wait_idle(WAIT_NS, true, &next_wake) && next_wake == INT_MAX);
+    sim_expect_wakeups(1); // Sent: not idle until the receiver took it
+    assert(!sim_clock_wait_idle(WAIT_NS, true, &next_wake));
+    assert(write(pipe_fds[1], "x", 1) == 1);
+    wait_state(clock, receiver, ACTOR_SLEEPING);
+    assert(clock->pending == 0);
+    assert(sim_clock_wait_idle(WAIT_NS, true, &next_wake) && next_wake == 40);
+    sim_clock_publish(40);
+    assert(exit_code(receiver) == 0);
+    printf("[OK] Pending drops when the blocked actor takes its message.\n");
+
+    // ---- An actor that died with a message queued for it ----
+    printf("[STEP] Dropping the message of an actor that died...\n");
+    mq_id qid = mq_open(IPC_PRIVATE, IPC_CREAT, 0600);
+    assert(qid >= 0);
+    pid_t doomed = fork();
+    if (doomed == 0) {
+        sim_actor_join(ACTOR_USER);
+        sim_block();
+        pause(); // Killed before it receives
+        _exit(1);
+    }
+    wait_state(clock, doomed, ACTOR_BLOCKED);
+    int message = 7;
+    sim_expect_wakeups(1);
+    assert(mq_send(qid, doomed, &message, sizeof(message)) == 0);
+    kill(doomed, SIGKILL);
+    assert(waitpid(doomed, NULL, 0) == doomed);
+
+    // As the director forgets a child, without a slot of its own
+    while (mq_receive(qid, doomed, &message, sizeof(message), IPC_NOWAIT) >= 0) sim_drop_wakeups(1);
+    sim_actor_forget(doomed);
+    assert(clock->pending == 0);
+    assert(sim_clock_wait_idle(WAIT_NS, true, &next_wake) && next_wake == INT_MAX);
+    printf("[OK] The dropped message no longer holds the clock back.\n");
+
+    // ---- Answers and handoffs for an actor that died ----
+    printf("[STEP] Answering an actor that died...\n");
+    struct S_poste_stations *stations = init_shared_memory(SHM_STATIONS_NAME, SHM_STATIONS_SIZE, open_shm, &open_shm_index);
+    memset(stations, 0, SHM_STATIONS_SIZE);
+    struct S_actor_queue *queue = &stations->user_queue[0];
+    doomed = fork();
+    if (doomed == 0) {
+        sim_actor_join(ACTOR_USER);
+        sim_queue_push(queue);
+        sim_queue_wait(100000); // Killed before it is handed anything
+        _exit(1);
+    }
+    wait_state(clock, doomed, ACTOR_SLEEPING);
+    kill(doomed, SIGKILL);
+    assert(waitpid(doomed, NULL, 0) == doomed);
+
+    // Both come after the queue of the dead actor was drained
+    assert(sim_reply(qid, doomed, &message, sizeof(message)) == 0);
+    assert(clock->pending == 0);
+    assert(mq_receive(qid, 0, &message, sizeof(message), IPC_NOWAIT) == -1); // Taken back
+    assert(sim_queue_wake(queue, 3) == doomed && clock->pending == 1);
+    sim_actor_forget(doomed);
+    assert(clock->pending == 0);
+    assert(sim_clock_wait_idle(WAIT_NS, true, &next_wake) && next_wake == INT_MAX);
+    cleanup_shared_memory(SHM_STATIONS_NAME, SHM_STATIONS_SIZE, open_shm[1], stations);
+    assert(mq_close(qid) == 0);
+    printf("[OK] The answer is taken back, the seat handed over no longer counts.\n");
+
+    cleanup_shared_memory(SHM_CLOCK_NAME, SHM_CLOCK_SIZE, open_shm[0], clock);
+
+    // ---- Fast forward only: minutes jump, service times stay real ----
+    printf("[STEP] Testing the fast-forward-only clock...\n");
+    open_shm_index = 0;
+    clock = sim_clock_create(false, true, open_shm, &open_shm_index);
+    sim_clock_publish(100);
+    pid_t actor = fork();
+    if (actor == 0) {
+        sim_actor_join(ACTOR_OPERATOR);
+        sim_sleep_nanos(50LL * g_config.minute_duration); // Real time, running all along
+        sim_sleep_minutes(60);                            // On the shared clock
+        sim_actor_leave();
+        _exit(0);
+    }
+    wait_state(clock, actor, ACTOR_RUNNING);
+    assert(!sim_clock_wait_idle(WAIT_NS, true, &next_wake));
+    wait_state(clock, actor, ACTOR_SLEEPING);
+    assert(sim_clock_wait_idle(WAIT_NS, true, &next_wake));
+    assert(next_wake >= 160); // Slept from a minute at least 100
+    sim_clock_publish(next_wake);
+    assert(exit_code(actor) == 0);
+    assert(clock->lag[ACTOR_OPERATOR].samples == 2); // The real-time sleep and the clock one
+    printf("[OK] Sub-minute sleeps run in real time, minutes on the clock.\n");
+
+    cleanup_shared_memory(SHM_CLOCK_NAME, SHM_CLOCK_SIZE, open_shm[0], clock);
+
+    printf("[TEST] All simulated clock tests passed successfully!\n");
+    return 0;
+}
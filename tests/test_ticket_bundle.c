@@ -0,0 +1,80 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <comunications.h>
+#include <erogatore_ticket.h>
+#include <msg_queue.h>
+#include <utente.h>
+#include <poste.h>
+
+#define DISPENSED 4 // Requests the test sends the generator, bundles or not
+
+// Ticket generator answering `requests` requests, then gone
+static pid_t start_generator(mq_id qid, int requests) {
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        int ticket_counter = 0;
+        for (int i = 0; i < requests; i++) {
+            if (!dispense_ticket(qid, &ticket_counter)) _exit(1);
+        }
+        _exit(0);
+    }
+    return pid;
+}
+
+int main(void) {
+    printf("\n[TEST] Starting ticket bundle tests...\n");
+    mq_id qid = mq_open(IPC_PRIVATE, IPC_CREAT, 0600);
+    assert(qid >= 0);
+    pid_t generator = start_generator(qid, DISPENSED);
+
+    // ---- A bundle ----
+    printf("[STEP] Taking the tickets of a day in one request...\n");
+    int services_asked[3] = { 2, 0, 4 };
+    int tickets[MAX_N_REQUESTS_COMPILE];
+    unsigned long long sent = 0;
+    mq_count_sends(&sent);
+    assert(request_ticket_bundle(qid, services_asked, 3, tickets));
+    mq_count_sends(NULL);
+    assert(sent == 1);
+    assert(tickets[0] == 0 && tickets[1] == 1 && tickets[2] == 2);
+    printf("[OK] One message sent, tickets numbered in the order of the services.\n");
+
+    // ---- Single requests still served ----
+    printf("[STEP] Mixing single requests and bundles...\n");
+    struct S_ticket_request single = { getpid(), 1 };
+    assert(mq_send(qid, MSG_TYPE_TICKET_REQUEST, &single, sizeof(single)) == 0);
+    struct S_ticket_response response;
+    assert(mq_receive(qid, getpid(), &response, sizeof(response), 0) == sizeof(response));
+    assert(response.ticket_number == 3);
+
+    int full[MAX_N_REQUESTS_COMPILE];
+    for (int i = 0; i < MAX_N_REQUESTS_COMPILE; i++) full[i] = i % NUM_SERVICE_TYPES;
+    assert(request_ticket_bundle(qid, full, MAX_N_REQUESTS_COMPILE, tickets));
+    for (int i = 0; i < MAX_N_REQUESTS_COMPILE; i++) assert(tickets[i] == 4 + i);
+    printf("[OK] The counter runs on across single tickets and bundles of every size.\n");
+
+    // ---- Malformed bundles ----
+    printf("[STEP] Refusing a malformed bundle...\n");
+    assert(!request_ticket_bundle(qid, full, 0, tickets));                          // Never sent
+    assert(!request_ticket_bundle(qid, full, MAX_N_REQUESTS_COMPILE + 1, tickets)); // Never sent
+    struct S_ticket_bundle_request bad = { getpid(), 3, { 0 } };
+    assert(mq_send(qid, MSG_TYPE_TICKET_BUNDLE_REQUEST, &bad, TICKET_BUNDLE_SIZE(2)) == 0); // Count past the size
+    struct S_ticket_bundle_response refused;
+    assert(mq_receive(qid, getpid(), &refused, sizeof(refused), 0) == (ssize_t)TICKET_BUNDLE_SIZE(0));
+    assert(refused.count == 0);
+    printf("[OK] Counts out of range never leave the user, a bad size gets no ticket.\n");
+
+    int status;
+    assert(waitpid(generator, &status, 0) == generator);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(mq_close(qid) == 0);
+    printf("[TEST] All ticket bundle tests passed successfully!\n\n");
+    return 0;
+}
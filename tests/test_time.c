@@ -34,9 +34,13 @@ int main(void) {
     poste_stats stats = {0};
     poste_stations stations = {0};
 
-    printf("       Initializing semaphore inside poste_stats struct...\n");
-    if (sem_init(&stats.stats_lock, 0, 1) != 0) {
-        perror("[FAIL] sem_init");
+    printf("       Initializing the locks inside poste_stats and poste_stations structs...\n");
+    if (shm_mutex_init(&stats.stats_lock) != 0) {
+        fprintf(stderr, "[FAIL] shm_mutex_init\n");
+        exit(EXIT_FAILURE);
+    }
+    if (shm_mutex_init(&stations.stations_lock) != 0) {
+        fprintf(stderr, "[FAIL] shm_mutex_init\n");
         exit(EXIT_FAILURE);
     }
 
@@ -47,10 +51,9 @@ int main(void) {
     assert(stats.current_day == 3);
     printf("[OK] current_day updated correctly to %d.\n", stats.current_day);
 
-    printf("       Destroying semaphore...\n");
-    if (sem_destroy(&stats.stats_lock) != 0) {
-        perror("[WARN] sem_destroy");
-    }
+    printf("       Destroying the locks...\n");
+    shm_mutex_destroy(&stats.stats_lock);
+    shm_mutex_destroy(&stations.stations_lock);
 
     printf("[TEST] All time function tests passed successfully!\n\n");
     return 0;
@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <trace.h>
+#include <poste.h>
+
+#define TEST_CSV    CSV_FILE_PATH "test_trace.csv"
+#define TEST_BIN    CSV_FILE_PATH "test_trace.bin"
+#define TEST_CONFIG CSV_FILE_PATH "test_trace.conf"
+#define LARGE_DAYS  30
+#define LARGE_PER_DAY 5000
+#define USERS 7
+
+static void write_file(const char *path, const char *text) {
+    FILE *fp = fopen(path, "w");
+    assert(fp != NULL);
+    fputs(text, fp);
+    fclose(fp);
+}
+
+int main(void) {
+    printf("\n[TEST] Starting trace replay tests...\n");
+
+    // ---- Compiling a CSV ----
+    printf("[STEP] Compiling a recorded CSV...\n");
+    write_file(TEST_CSV,
+               "day,minute,service\n"
+               "# December, one branch\n"
+               "\n"
+               "5,600,1\n"
+               "5,08:30,0\r\n"       // HH:MM, CRLF
+               "5, 540 , 2\n"        // Same minute as 09:00, spaces around fields
+               "4,720,3\n"           // Out of order
+               "5,1500,1\n"          // Minute out of range
+               "5,700,9\n"           // No such service
+               "five,700,1\n"        // Not a header past the first arrival
+               "7,1230,4 # after closing\n"
+               "7,610,5");           // Day 6 missing, no final newline
+    assert(!trace_is_binary(TEST_CSV));
+
+    struct S_trace_info info;
+    assert(trace_compile(TEST_CSV, TEST_BIN, &info));
+    assert(info.skipped_lines == 3 && info.first_skipped == 8);
+    assert(trace_is_binary(TEST_BIN));
+
+    struct S_trace trace;
+    assert(trace_open(TEST_BIN, &trace));
+    trace_info(&trace, &info);
+    assert(info.records == 6 && info.days == 4 && info.first_day == 4);
+    assert(info.busiest_day == 2 && info.busiest_records == 3);
+    assert(trace_after_close(&trace, 20 * 60) == 1);
+    printf("[OK] Header and bad lines skipped, days made relative, records sorted.\n");
+
+    // ---- Dealing a day ----
+    printf("[STEP] Dealing the arrivals of a day to the users...\n");
+    struct S_trace_cursor cursor;
+    const struct S_trace_record *r;
+    trace_deal(&trace, 2, 0, 1, &cursor); // CSV day 5, one user takes them all
+    int expected[3][2] = { { 510, 0 }, { 540, 2 }, { 600, 1 } };
+    for (int i = 0; i < 3; i++) {
+        r = trace_next(&cursor);
+        assert(r != NULL && r->minute == expected[i][0] && r->service == expected[i][1]);
+    }
+    assert(trace_next(&cursor) == NULL);
+
+    trace_deal(&trace, 2, 1, 2, &cursor); // Second of two users: the 09:00 arrival only
+    r = trace_next(&cursor);
+    assert(r != NULL && r->minute == 540);
+    assert(trace_next(&cursor) == NULL);
+
+    trace_deal(&trace, 3, 0, 1, &cursor); // Missing from the CSV
+    assert(trace_next(&cursor) == NULL);
+    trace_deal(&trace, 5, 0, 1, &cursor); // Past the trace
+    assert(trace_next(&cursor) == NULL);
+    trace_deal(&trace, 2, 2, 2, &cursor); // Index past the users the trace is dealt to
+    assert(trace_next(&cursor) == NULL);
+    trace_close(&trace);
+    printf("[OK] Every user gets its share in time order, empty days are empty.\n");
+
+    // ---- A large trace ----
+    printf("[STEP] Compiling and dealing %d arrivals...\n", LARGE_DAYS * LARGE_PER_DAY);
+    FILE *fp = fopen(TEST_CSV, "w");
+    assert(fp != NULL);
+    for (int d = 1; d <= LARGE_DAYS; d++) {
+        for (int i = 0; i < LARGE_PER_DAY; i++) {
+            fprintf(fp, "%d,%d,%d\n", d, 480 + (i * 7) % 720, i % NUM_SERVICE_TYPES);
+        }
+    }
+    fclose(fp);
+    assert(trace_compile(TEST_CSV, TEST_BIN, &info) && info.skipped_lines == 0);
+    assert(trace_open(TEST_BIN, &trace));
+    trace_info(&trace, &info);
+    assert(info.records == LARGE_DAYS * LARGE_PER_DAY && info.days == LARGE_DAYS);
+
+    for (int day = 1; day <= LARGE_DAYS; day += LARGE_DAYS - 1) {
+        int dealt = 0;
+        int services_dealt[NUM_SERVICE_TYPES] = {0};
+        for (int u = 0; u < USERS; u++) {
+            int previous = -1;
+            trace_deal(&trace, day, u, USERS, &cursor);
+            while ((r = trace_next(&cursor)) != NULL) {
+                assert(r->minute >= previous);
+                previous = r->minute;
+                services_dealt[r->service]++;
+                dealt++;
+            }
+        }
+        assert(dealt == LARGE_PER_DAY);
+        for (int s = 0; s < NUM_SERVICE_TYPES; s++) {
+            assert(services_dealt[s] == LARGE_PER_DAY / NUM_SERVICE_TYPES + (s < LARGE_PER_DAY % NUM_SERVICE_TYPES));
+        }
+    }
+    trace_close(&trace);
+    printf("[OK] Every arrival dealt exactly once.\n");
+
+    // ---- Bad traces ----
+    printf("[STEP] Rejecting unusable traces...\n");
+    write_file(TEST_CSV, "day,minute,service\n# nothing recorded\n");
+    assert(!trace_compile(TEST_CSV, TEST_BIN, &info));
+    assert(!trace_compile(CSV_FILE_PATH "no_such_trace.csv", TEST_BIN, &info));
+
+    write_file(TEST_CSV, "1,600,1\n2,600,2\n");
+    assert(trace_compile(TEST_CSV, TEST_BIN, &info));
+    assert(truncate(TEST_BIN, sizeof(struct S_trace_header) + 4) == 0);
+    assert(!trace_open(TEST_BIN, &trace));
+    assert(!trace_open(TEST_CSV, &trace));
+    printf("[OK] Empty, missing and truncated traces refused.\n");
+
+    // ---- Configuration ----
+    printf("[STEP] Reading trace_file from a config file...\n");
+    write_file(TEST_CONFIG, "trace_file = ./tmp/december.csv\n");
+    load_config(TEST_CONFIG);
+    assert(strcmp(g_config.trace_file, "./tmp/december.csv") == 0);
+    printf("[OK] trace_file parsed.\n");
+
+    unlink(TEST_CSV);
+    unlink(TEST_BIN);
+    unlink(TEST_CONFIG);
+    printf("[TEST] All trace replay tests passed successfully!\n\n");
+    return 0;
+}
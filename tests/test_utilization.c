@@ -0,0 +1,62 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <poste.h>
+#include <utilization.h>
+
+typedef struct S_utilization utilization;
+
+int main(void) {
+    printf("\n[TEST] Starting utilization accounting tests...\n");
+
+    static utilization usage;
+
+    // ---- Busy and seated time per seat and per operator ----
+    printf("[STEP] Accounting two operators on two seats...\n");
+    utilization_add_busy(&usage, 0, 100, 2, 6.5);
+    utilization_add_busy(&usage, 0, 100, 2, 5.5);
+    utilization_add_busy(&usage, 3, 200, 4, 20.0);
+    utilization_add_seated(&usage, 0, 100, 2, 60.0);
+    utilization_add_seated(&usage, 3, 200, 4, 30.0);
+
+    assert(usage.seats[0].busy_minutes == 12.0 && usage.seats[0].services == 2);
+    assert(usage.seats[0].seated_minutes == 60.0);
+    assert(usage.seats[3].busy_minutes == 20.0 && usage.seats[3].services == 1);
+    assert(usage.seats[1].services == 0);
+
+    assert(usage.operators[0].pid == 100 && usage.operators[0].service == 2);
+    assert(usage.operators[0].busy_minutes == 12.0 && usage.operators[0].seated_minutes == 60.0);
+    assert(usage.operators[1].pid == 200 && usage.operators[1].services == 1);
+    assert(usage.operators[2].pid == 0);
+    printf("[OK] Seats and operators accounted separately.\n");
+
+    // ---- Per service totals and percentages ----
+    printf("[STEP] Testing service totals...\n");
+    double busy, seated;
+    utilization_service_totals(&usage, 2, &busy, &seated);
+    assert(busy == 12.0 && seated == 60.0);
+    assert(utilization_percent(busy, seated) == 20.0);
+    utilization_service_totals(&usage, 0, &busy, &seated);
+    assert(busy == 0.0 && seated == 0.0);
+    assert(utilization_percent(busy, seated) == 0.0);
+    printf("[OK] Service totals and percentages are consistent.\n");
+
+    // ---- Out of range seats and a full operator table ----
+    printf("[STEP] Testing bounds...\n");
+    utilization_add_busy(&usage, -1, 100, 2, 1.0);
+    utilization_add_busy(&usage, MAX_WORKER_SEATS, 100, 2, 1.0);
+    assert(usage.operators[0].services == 4);
+    utilization_add_seated(&usage, 0, 100, 2, -5.0);
+    assert(usage.seats[0].seated_minutes == 60.0);
+
+    for (int i = 2; i < MAX_OPERATOR_STATES; i++) {
+        assert(utilization_operator(&usage, 1000 + i, 0) != NULL);
+    }
+    assert(utilization_operator(&usage, 99999, 0) == NULL);
+    assert(usage.untracked_operators == 1);
+    assert(utilization_operator(&usage, 100, 2) == &usage.operators[0]);
+    printf("[OK] Bad seats ignored, full table counted as untracked.\n");
+
+    printf("[TEST] All utilization tests passed successfully!\n\n");
+    return 0;
+}